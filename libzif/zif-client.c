@@ -0,0 +1,502 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2013 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * SECTION:zif-client
+ * @short_description: Query stores loaded by a #ZifServer
+ *
+ * #ZifClient sends read-only queries to a #ZifServer running on the
+ * same machine, so that the stores do not have to be loaded in every
+ * process.
+ *
+ * The returned packages only have the package ID and summary set.
+ * If the server is not running or is busy then %ZIF_SERVER_ERROR_NO_SERVER
+ * or %ZIF_SERVER_ERROR_BUSY is returned, and the caller should fall back
+ * to loading the stores itself.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+
+#include "zif-client.h"
+#include "zif-depend.h"
+#include "zif-package-private.h"
+#include "zif-string.h"
+
+#define ZIF_CLIENT_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_CLIENT, ZifClientPrivate))
+
+struct _ZifClientPrivate
+{
+	gchar			*socket_path;
+};
+
+G_DEFINE_TYPE (ZifClient, zif_client, G_TYPE_OBJECT)
+
+/**
+ * zif_client_error_from_string:
+ **/
+static ZifServerError
+zif_client_error_from_string (const gchar *error_code)
+{
+	if (g_strcmp0 (error_code, "busy") == 0)
+		return ZIF_SERVER_ERROR_BUSY;
+	if (g_strcmp0 (error_code, "invalid") == 0)
+		return ZIF_SERVER_ERROR_INVALID;
+	return ZIF_SERVER_ERROR_FAILED;
+}
+
+/**
+ * zif_client_package_from_line:
+ **/
+static ZifPackage *
+zif_client_package_from_line (const gchar *line, GError **error)
+{
+	const gchar *data;
+	gboolean ret;
+	gchar **split;
+	ZifPackage *package = NULL;
+	ZifString *summary;
+
+	split = g_strsplit (line, "\t", 2);
+	if (g_strv_length (split) != 2) {
+		g_set_error (error,
+			     ZIF_SERVER_ERROR,
+			     ZIF_SERVER_ERROR_INVALID,
+			     "invalid package line: %s", line);
+		goto out;
+	}
+
+	/* only the id and summary are known */
+	package = zif_package_new ();
+	ret = zif_package_set_id (package, split[0], error);
+	if (!ret) {
+		g_object_unref (package);
+		package = NULL;
+		goto out;
+	}
+	data = strrchr (split[0], ';');
+	if (data != NULL && g_str_has_prefix (data + 1, "installed"))
+		zif_package_set_installed (package, TRUE);
+	summary = zif_string_new (split[1]);
+	zif_package_set_summary (package, summary);
+	zif_string_unref (summary);
+out:
+	g_strfreev (split);
+	return package;
+}
+
+/**
+ * zif_client_query:
+ **/
+static GPtrArray *
+zif_client_query (ZifClient *client,
+		  const gchar *command,
+		  gchar **args,
+		  ZifState *state,
+		  GError **error)
+{
+	gboolean ret;
+	gchar *line = NULL;
+	gchar **split = NULL;
+	GCancellable *cancellable;
+	GDataInputStream *input = NULL;
+	GError *error_local = NULL;
+	GPtrArray *array = NULL;
+	GPtrArray *array_tmp = NULL;
+	GSocketAddress *address = NULL;
+	GSocketClient *socket_client = NULL;
+	GSocketConnection *connection = NULL;
+	GString *request = NULL;
+	guint i;
+	guint len;
+	ZifPackage *package;
+
+	g_return_val_if_fail (ZIF_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (zif_state_valid (state), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* build request, which has to fit on one line */
+	request = g_string_new (command);
+	for (i = 0; args != NULL && args[i] != NULL; i++) {
+		if (strpbrk (args[i], "\t\n") != NULL) {
+			g_set_error (error,
+				     ZIF_SERVER_ERROR,
+				     ZIF_SERVER_ERROR_INVALID,
+				     "invalid search term: %s", args[i]);
+			goto out;
+		}
+		g_string_append_printf (request, "\t%s", args[i]);
+	}
+	g_string_append (request, "\n");
+
+	/* connect */
+	cancellable = zif_state_get_cancellable (state);
+	socket_client = g_socket_client_new ();
+	address = g_unix_socket_address_new (client->priv->socket_path);
+	connection = g_socket_client_connect (socket_client,
+					      G_SOCKET_CONNECTABLE (address),
+					      cancellable,
+					      &error_local);
+	if (connection == NULL) {
+		g_set_error (error,
+			     ZIF_SERVER_ERROR,
+			     ZIF_SERVER_ERROR_NO_SERVER,
+			     "failed to connect to %s: %s",
+			     client->priv->socket_path,
+			     error_local->message);
+		g_error_free (error_local);
+		goto out;
+	}
+
+	/* send request */
+	ret = g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (connection)),
+					 request->str,
+					 request->len,
+					 NULL,
+					 cancellable,
+					 error);
+	if (!ret)
+		goto out;
+
+	/* get status line */
+	input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (connection)));
+	line = g_data_input_stream_read_line (input, NULL, cancellable, error);
+	if (line == NULL) {
+		if (error != NULL && *error == NULL) {
+			g_set_error_literal (error,
+					     ZIF_SERVER_ERROR,
+					     ZIF_SERVER_ERROR_FAILED,
+					     "no reply from server");
+		}
+		goto out;
+	}
+	split = g_strsplit (line, "\t", 3);
+	if (g_strcmp0 (split[0], "error") == 0 && g_strv_length (split) == 3) {
+		g_set_error_literal (error,
+				     ZIF_SERVER_ERROR,
+				     zif_client_error_from_string (split[1]),
+				     split[2]);
+		goto out;
+	}
+	if (g_strcmp0 (split[0], "ok") != 0 || split[1] == NULL) {
+		g_set_error (error,
+			     ZIF_SERVER_ERROR,
+			     ZIF_SERVER_ERROR_INVALID,
+			     "invalid reply from server: %s", line);
+		goto out;
+	}
+
+	/* get each package */
+	len = g_ascii_strtoull (split[1], NULL, 10);
+	array_tmp = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; i < len; i++) {
+		g_free (line);
+		line = g_data_input_stream_read_line (input, NULL, cancellable, error);
+		if (line == NULL) {
+			if (error != NULL && *error == NULL) {
+				g_set_error (error,
+					     ZIF_SERVER_ERROR,
+					     ZIF_SERVER_ERROR_FAILED,
+					     "reply truncated at %i/%i packages",
+					     i, len);
+			}
+			goto out;
+		}
+		package = zif_client_package_from_line (line, error);
+		if (package == NULL)
+			goto out;
+		g_ptr_array_add (array_tmp, package);
+	}
+
+	/* success */
+	array = g_ptr_array_ref (array_tmp);
+out:
+	if (connection != NULL) {
+		g_io_stream_close (G_IO_STREAM (connection), NULL, NULL);
+		g_object_unref (connection);
+	}
+	if (input != NULL)
+		g_object_unref (input);
+	if (address != NULL)
+		g_object_unref (address);
+	if (socket_client != NULL)
+		g_object_unref (socket_client);
+	if (array_tmp != NULL)
+		g_ptr_array_unref (array_tmp);
+	if (request != NULL)
+		g_string_free (request, TRUE);
+	g_strfreev (split);
+	g_free (line);
+	return array;
+}
+
+/**
+ * zif_client_set_socket_path:
+ * @client: A #ZifClient
+ * @socket_path: A filename, e.g. "/var/run/zif-server.socket"
+ *
+ * Sets the UNIX socket the server is listening on.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_client_set_socket_path (ZifClient *client, const gchar *socket_path)
+{
+	g_return_if_fail (ZIF_IS_CLIENT (client));
+	g_free (client->priv->socket_path);
+	client->priv->socket_path = g_strdup (socket_path);
+}
+
+/**
+ * zif_client_is_available:
+ * @client: A #ZifClient
+ *
+ * Finds out if a server may be running, without connecting to it.
+ *
+ * Return value: %TRUE if the socket exists
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_client_is_available (ZifClient *client)
+{
+	g_return_val_if_fail (ZIF_IS_CLIENT (client), FALSE);
+	return g_file_test (client->priv->socket_path, G_FILE_TEST_EXISTS);
+}
+
+/**
+ * zif_client_resolve_full:
+ * @client: A #ZifClient
+ * @search: (array zero-terminated=1) (element-type utf8): The search terms, e.g. "gnome-power-manager"
+ * @flags: A bitfield of %ZifStoreResolveFlags, e.g. %ZIF_STORE_RESOLVE_FLAG_USE_NAME_ARCH
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Finds packages matching the search terms in the local and remote
+ * stores held by the server.
+ *
+ * Return value: (element-type ZifPackage) (transfer container): An array of #ZifPackage's
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_client_resolve_full (ZifClient *client,
+			 gchar **search,
+			 ZifStoreResolveFlags flags,
+			 ZifState *state,
+			 GError **error)
+{
+	gchar **args;
+	GPtrArray *array;
+	guint i;
+	guint len;
+
+	g_return_val_if_fail (search != NULL, NULL);
+
+	/* the flags are sent as the first argument */
+	len = g_strv_length (search);
+	args = g_new0 (gchar *, len + 2);
+	args[0] = g_strdup_printf ("%i", flags);
+	for (i = 0; i < len; i++)
+		args[i + 1] = g_strdup (search[i]);
+	array = zif_client_query (client, "resolve", args, state, error);
+	g_strfreev (args);
+	return array;
+}
+
+/**
+ * zif_client_what_provides:
+ * @client: A #ZifClient
+ * @depends: (element-type ZifDepend): An array of #ZifDepend's to search for
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Finds packages that provide the given depends.
+ *
+ * Return value: (element-type ZifPackage) (transfer container): An array of #ZifPackage's
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_client_what_provides (ZifClient *client,
+			  GPtrArray *depends,
+			  ZifState *state,
+			  GError **error)
+{
+	gchar **args;
+	GPtrArray *array;
+	guint i;
+	ZifDepend *depend;
+
+	g_return_val_if_fail (depends != NULL, NULL);
+
+	args = g_new0 (gchar *, depends->len + 1);
+	for (i = 0; i < depends->len; i++) {
+		depend = g_ptr_array_index (depends, i);
+		args[i] = zif_depend_to_string (depend);
+	}
+	array = zif_client_query (client, "what-provides", args, state, error);
+	g_strfreev (args);
+	return array;
+}
+
+/**
+ * zif_client_search_name:
+ * @client: A #ZifClient
+ * @search: (array zero-terminated=1) (element-type utf8): The search terms, e.g. "power"
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Find packages that match the package name in some part.
+ *
+ * Return value: (element-type ZifPackage) (transfer container): An array of #ZifPackage's
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_client_search_name (ZifClient *client,
+			gchar **search,
+			ZifState *state,
+			GError **error)
+{
+	return zif_client_query (client, "search-name", search, state, error);
+}
+
+/**
+ * zif_client_search_details:
+ * @client: A #ZifClient
+ * @search: (array zero-terminated=1) (element-type utf8): The search terms, e.g. "trouble"
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Find packages that match some detail about the package.
+ *
+ * Return value: (element-type ZifPackage) (transfer container): An array of #ZifPackage's
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_client_search_details (ZifClient *client,
+			   gchar **search,
+			   ZifState *state,
+			   GError **error)
+{
+	return zif_client_query (client, "search-details", search, state, error);
+}
+
+/**
+ * zif_client_search_file:
+ * @client: A #ZifClient
+ * @search: (array zero-terminated=1) (element-type utf8): The search terms, e.g. "/usr/bin/gnome-power-manager"
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Find packages that provide a specific filename.
+ *
+ * Return value: (element-type ZifPackage) (transfer container): An array of #ZifPackage's
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_client_search_file (ZifClient *client,
+			gchar **search,
+			ZifState *state,
+			GError **error)
+{
+	return zif_client_query (client, "search-file", search, state, error);
+}
+
+/**
+ * zif_client_get_updates:
+ * @client: A #ZifClient
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Gets the list of packages that can be updated to newer versions.
+ *
+ * Return value: (element-type ZifPackage) (transfer container): An array of the *new* #ZifPackage's
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_client_get_updates (ZifClient *client,
+			ZifState *state,
+			GError **error)
+{
+	return zif_client_query (client, "get-updates", NULL, state, error);
+}
+
+/**
+ * zif_client_finalize:
+ **/
+static void
+zif_client_finalize (GObject *object)
+{
+	ZifClient *client;
+	g_return_if_fail (ZIF_IS_CLIENT (object));
+	client = ZIF_CLIENT (object);
+
+	g_free (client->priv->socket_path);
+
+	G_OBJECT_CLASS (zif_client_parent_class)->finalize (object);
+}
+
+/**
+ * zif_client_class_init:
+ **/
+static void
+zif_client_class_init (ZifClientClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = zif_client_finalize;
+	g_type_class_add_private (klass, sizeof (ZifClientPrivate));
+}
+
+/**
+ * zif_client_init:
+ **/
+static void
+zif_client_init (ZifClient *client)
+{
+	client->priv = ZIF_CLIENT_GET_PRIVATE (client);
+	client->priv->socket_path = g_strdup (ZIF_SERVER_SOCKET_PATH);
+}
+
+/**
+ * zif_client_new:
+ *
+ * Return value: A new #ZifClient instance.
+ *
+ * Since: 0.3.7
+ **/
+ZifClient *
+zif_client_new (void)
+{
+	ZifClient *client;
+	client = g_object_new (ZIF_TYPE_CLIENT, NULL);
+	return ZIF_CLIENT (client);
+}
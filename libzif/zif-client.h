@@ -0,0 +1,96 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2013 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#if !defined (__ZIF_H_INSIDE__) && !defined (ZIF_COMPILATION)
+#error "Only <zif.h> can be included directly."
+#endif
+
+#ifndef __ZIF_CLIENT_H
+#define __ZIF_CLIENT_H
+
+#include <glib-object.h>
+
+#include "zif-server.h"
+#include "zif-state.h"
+#include "zif-store.h"
+
+G_BEGIN_DECLS
+
+#define ZIF_TYPE_CLIENT		(zif_client_get_type ())
+#define ZIF_CLIENT(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), ZIF_TYPE_CLIENT, ZifClient))
+#define ZIF_CLIENT_CLASS(k)	(G_TYPE_CHECK_CLASS_CAST((k), ZIF_TYPE_CLIENT, ZifClientClass))
+#define ZIF_IS_CLIENT(o)	(G_TYPE_CHECK_INSTANCE_TYPE ((o), ZIF_TYPE_CLIENT))
+#define ZIF_IS_CLIENT_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), ZIF_TYPE_CLIENT))
+#define ZIF_CLIENT_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), ZIF_TYPE_CLIENT, ZifClientClass))
+
+typedef struct _ZifClient		ZifClient;
+typedef struct _ZifClientPrivate	ZifClientPrivate;
+typedef struct _ZifClientClass		ZifClientClass;
+
+struct _ZifClient
+{
+	GObject			 parent;
+	ZifClientPrivate	*priv;
+};
+
+struct _ZifClientClass
+{
+	GObjectClass		 parent_class;
+	/* Padding for future expansion */
+	void (*_zif_reserved1) (void);
+	void (*_zif_reserved2) (void);
+	void (*_zif_reserved3) (void);
+	void (*_zif_reserved4) (void);
+};
+
+GType		 zif_client_get_type		(void);
+ZifClient	*zif_client_new			(void);
+void		 zif_client_set_socket_path	(ZifClient	*client,
+						 const gchar	*socket_path);
+gboolean	 zif_client_is_available	(ZifClient	*client);
+GPtrArray	*zif_client_resolve_full	(ZifClient	*client,
+						 gchar		**search,
+						 ZifStoreResolveFlags flags,
+						 ZifState	*state,
+						 GError		**error);
+GPtrArray	*zif_client_what_provides	(ZifClient	*client,
+						 GPtrArray	*depends,
+						 ZifState	*state,
+						 GError		**error);
+GPtrArray	*zif_client_search_name		(ZifClient	*client,
+						 gchar		**search,
+						 ZifState	*state,
+						 GError		**error);
+GPtrArray	*zif_client_search_details	(ZifClient	*client,
+						 gchar		**search,
+						 ZifState	*state,
+						 GError		**error);
+GPtrArray	*zif_client_search_file		(ZifClient	*client,
+						 gchar		**search,
+						 ZifState	*state,
+						 GError		**error);
+GPtrArray	*zif_client_get_updates		(ZifClient	*client,
+						 ZifState	*state,
+						 GError		**error);
+
+G_END_DECLS
+
+#endif /* __ZIF_CLIENT_H */
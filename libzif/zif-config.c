@@ -60,6 +60,8 @@ struct _ZifConfigPrivate
 	GHashTable		*hash_override;
 	GHashTable		*hash_default;
 	gchar			**basearch_list;
+	GHashTable		*hash_strv;
+	GPtrArray		*strv_stale;
 	GMutex			 mutex;
 };
 
@@ -179,6 +181,29 @@ out:
 	return ret;
 }
 
+/**
+ * zif_config_invalidate_strv:
+ *
+ * Invalidates the cached string arrays. The old values are kept until
+ * the object is finalized as callers do not own a reference.
+ **/
+static void
+zif_config_invalidate_strv (ZifConfig *config)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	g_mutex_lock (&config->priv->mutex);
+	g_hash_table_iter_init (&iter, config->priv->hash_strv);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_ptr_array_add (config->priv->strv_stale, value);
+		g_hash_table_iter_steal (&iter);
+		g_free (key);
+	}
+	g_mutex_unlock (&config->priv->mutex);
+}
+
 /**
  * zif_config_unload:
  **/
@@ -195,6 +220,7 @@ zif_config_unload (ZifConfig *config,
 	/* done */
 	g_debug ("unloading config");
 	config->priv->loaded = FALSE;
+	zif_config_invalidate_strv (config);
 out:
 	return ret;
 }
@@ -229,6 +255,7 @@ zif_config_unset (ZifConfig *config, const gchar *key, GError **error)
 
 	/* remove */
 	g_hash_table_remove (config->priv->hash_override, key);
+	zif_config_invalidate_strv (config);
 out:
 	return ret;
 }
@@ -367,6 +394,60 @@ out:
 	return split;
 }
 
+/**
+ * zif_config_get_strv_cached:
+ * @config: A #ZifConfig
+ * @key: A key name to retrieve, e.g. "ignore_file_dep_prefixes"
+ * @error: A #GError, or %NULL
+ *
+ * Gets a string array value like zif_config_get_strv(), but only splits
+ * the value the first time it is requested. This is useful for values
+ * that are checked many times in a tight loop.
+ *
+ * Return value: (element-type utf8) (transfer none): %NULL, or a string array
+ *
+ * Since: 0.3.7
+ **/
+gchar **
+zif_config_get_strv_cached (ZifConfig *config,
+			    const gchar *key,
+			    GError **error)
+{
+	gchar **split;
+	gchar **split_tmp;
+
+	g_return_val_if_fail (ZIF_IS_CONFIG (config), NULL);
+	g_return_val_if_fail (key != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* already split */
+	g_mutex_lock (&config->priv->mutex);
+	split = g_hash_table_lookup (config->priv->hash_strv, key);
+	g_mutex_unlock (&config->priv->mutex);
+	if (split != NULL)
+		goto out;
+
+	/* get string array */
+	split = zif_config_get_strv (config, key, error);
+	if (split == NULL)
+		goto out;
+
+	/* another thread may have got there first */
+	g_mutex_lock (&config->priv->mutex);
+	split_tmp = g_hash_table_lookup (config->priv->hash_strv, key);
+	if (split_tmp != NULL) {
+		g_strfreev (split);
+		split = split_tmp;
+	} else {
+		g_hash_table_insert (config->priv->hash_strv,
+				     g_strdup (key),
+				     split);
+	}
+	g_mutex_unlock (&config->priv->mutex);
+out:
+	return split;
+}
+
 /**
  * zif_config_get_uint:
  * @config: A #ZifConfig
@@ -722,6 +803,7 @@ zif_config_reset_default (ZifConfig *config, GError **error)
 	g_return_val_if_fail (ZIF_IS_CONFIG (config), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 	g_hash_table_remove_all (config->priv->hash_override);
+	zif_config_invalidate_strv (config);
 	return TRUE;
 }
 
@@ -795,6 +877,7 @@ zif_config_set_string (ZifConfig *config,
 	g_hash_table_insert (config->priv->hash_override,
 			     g_strdup (key),
 			     g_strdup (value));
+	zif_config_invalidate_strv (config);
 out:
 	return ret;
 }
@@ -894,6 +977,8 @@ zif_config_finalize (GObject *object)
 				     config->priv->monitor_changed_id);
 	g_object_unref (config->priv->monitor);
 	g_strfreev (config->priv->basearch_list);
+	g_hash_table_unref (config->priv->hash_strv);
+	g_ptr_array_unref (config->priv->strv_stale);
 	g_free (config->priv->filename);
 
 	G_OBJECT_CLASS (zif_config_parent_class)->finalize (object);
@@ -934,6 +1019,11 @@ zif_config_init (ZifConfig *config)
 							    g_free,
 							    g_free);
 	config->priv->basearch_list = NULL;
+	config->priv->hash_strv = g_hash_table_new_full (g_str_hash,
+							 g_str_equal,
+							 g_free,
+							 (GDestroyNotify) g_strfreev);
+	config->priv->strv_stale = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
 	config->priv->monitor = zif_monitor_new ();
 	config->priv->monitor_changed_id =
 		g_signal_connect (config->priv->monitor, "changed",
@@ -82,6 +82,9 @@ gchar		*zif_config_get_string		(ZifConfig	*config,
 gchar		**zif_config_get_strv		(ZifConfig	*config,
 						 const gchar	*key,
 						 GError		**error);
+gchar		**zif_config_get_strv_cached	(ZifConfig	*config,
+						 const gchar	*key,
+						 GError		**error);
 gboolean	 zif_config_get_boolean		(ZifConfig	*config,
 						 const gchar	*key,
 						 GError		**error);
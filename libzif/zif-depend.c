@@ -282,6 +282,38 @@ zif_depend_get_description (ZifDepend *depend)
 	return depend->priv->description;
 }
 
+/**
+ * zif_depend_get_memory_usage:
+ * @depend: A #ZifDepend
+ * @memory: A #ZifMemory to add the sizes to
+ *
+ * Adds the memory used by the depend to @memory. Depends that are
+ * shared between packages are only counted once.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_depend_get_memory_usage (ZifDepend *depend, ZifMemory *memory)
+{
+	GTypeQuery query;
+
+	g_return_if_fail (ZIF_IS_DEPEND (depend));
+	g_return_if_fail (ZIF_IS_MEMORY (memory));
+
+	if (!zif_memory_visit (memory, depend))
+		return;
+
+	g_type_query (G_OBJECT_TYPE (depend), &query);
+	zif_memory_add (memory,
+			ZIF_MEMORY_KIND_DEPENDS,
+			query.instance_size + sizeof (ZifDependPrivate));
+	zif_memory_add_string (memory,
+			       ZIF_MEMORY_KIND_DEPENDS,
+			       depend->priv->description);
+	zif_memory_add_zif_string (memory, depend->priv->name);
+	zif_memory_add_zif_string (memory, depend->priv->version);
+}
+
 /**
  * zif_depend_get_flag:
  * @depend: A #ZifDepend
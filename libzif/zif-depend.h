@@ -53,6 +53,7 @@ typedef enum {
 
 #include "zif-package.h"
 #include "zif-changeset.h"
+#include "zif-memory.h"
 
 struct _ZifDepend
 {
@@ -86,6 +87,8 @@ gboolean		 zif_depend_satisfies		(ZifDepend		*got,
 							 ZifDepend		*need);
 gint			 zif_depend_compare		(ZifDepend		*a,
 							 ZifDepend		*b);
+void			 zif_depend_get_memory_usage	(ZifDepend		*depend,
+							 ZifMemory		*memory);
 
 /* public getters */
 ZifDependFlag		 zif_depend_get_flag		(ZifDepend		*depend);
@@ -39,6 +39,7 @@
 #include "zif-state-private.h"
 #include "zif-md-metalink.h"
 #include "zif-md-mirrorlist.h"
+#include "zif-utils-private.h"
 
 #define ZIF_DOWNLOAD_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_DOWNLOAD, ZifDownloadPrivate))
 
@@ -657,6 +658,268 @@ out:
 	return ret;
 }
 
+/**
+ * zif_download_local_range:
+ **/
+static gboolean
+zif_download_local_range (const gchar *filename,
+			  guint64 offset,
+			  guint64 length,
+			  GByteArray *data,
+			  ZifState *state,
+			  GError **error)
+{
+	gboolean ret;
+	gsize bytes_read = 0;
+	guint old_len;
+	GCancellable *cancellable;
+	GFile *file;
+	GFileInputStream *stream = NULL;
+
+	/* open and seek to the start of the range */
+	file = g_file_new_for_path (filename);
+	cancellable = zif_state_get_cancellable (state);
+	stream = g_file_read (file, cancellable, error);
+	if (stream == NULL) {
+		ret = FALSE;
+		goto out;
+	}
+	ret = g_seekable_seek (G_SEEKABLE (stream), offset,
+			       G_SEEK_SET, cancellable, error);
+	if (!ret)
+		goto out;
+
+	/* read directly into the array */
+	old_len = data->len;
+	g_byte_array_set_size (data, old_len + length);
+	ret = g_input_stream_read_all (G_INPUT_STREAM (stream),
+				       data->data + old_len,
+				       length,
+				       &bytes_read,
+				       cancellable,
+				       error);
+	if (!ret) {
+		g_byte_array_set_size (data, old_len);
+		goto out;
+	}
+	if (bytes_read != length) {
+		g_byte_array_set_size (data, old_len);
+		ret = FALSE;
+		g_set_error (error,
+			     ZIF_DOWNLOAD_ERROR,
+			     ZIF_DOWNLOAD_ERROR_WRONG_SIZE,
+			     "only read %" G_GSIZE_FORMAT " of %" G_GUINT64_FORMAT " bytes from %s",
+			     bytes_read, length, filename);
+		goto out;
+	}
+out:
+	if (stream != NULL)
+		g_object_unref (stream);
+	g_object_unref (file);
+	return ret;
+}
+
+/**
+ * zif_download_file_range_got_chunk_cb:
+ **/
+static void
+zif_download_file_range_got_chunk_cb (SoupMessage *msg, SoupBuffer *chunk,
+				      ZifDownloadFlight *flight)
+{
+	GCancellable *cancellable;
+
+	/* cancelled? */
+	cancellable = zif_state_get_cancellable (flight->state);
+	if (g_cancellable_is_cancelled (cancellable)) {
+		g_debug ("cancelling range download on %p", cancellable);
+		soup_session_cancel_message (flight->download->priv->session,
+					     msg,
+					     SOUP_STATUS_CANCELLED);
+	}
+}
+
+/**
+ * zif_download_file_range:
+ * @download: A #ZifDownload
+ * @uri: Full remote URI
+ * @offset: The byte offset into the remote file
+ * @length: The number of bytes to get
+ * @data: A #GByteArray to append the downloaded data to
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Downloads part of a file using a HTTP Range request, or by reading part
+ * of the file from the local filesystem.
+ *
+ * If the server does not support Range requests then
+ * %ZIF_DOWNLOAD_ERROR_NO_SUPPORT is returned and the caller should fall
+ * back to downloading the whole file.
+ *
+ * Return value: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_download_file_range (ZifDownload *download,
+			 const gchar *uri,
+			 guint64 offset,
+			 guint64 length,
+			 GByteArray *data,
+			 ZifState *state,
+			 GError **error)
+{
+	gboolean ret = FALSE;
+	SoupURI *base_uri = NULL;
+	ZifDownloadFlight *flight = NULL;
+
+	g_return_val_if_fail (ZIF_IS_DOWNLOAD (download), FALSE);
+	g_return_val_if_fail (zif_state_valid (state), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (length > 0, FALSE);
+	g_return_val_if_fail (data != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* local file */
+	if (g_str_has_prefix (uri, "file://")) {
+		ret = zif_download_local_range (uri + 7, offset, length,
+						data, state, error);
+		goto out;
+	}
+	if (g_str_has_prefix (uri, "/")) {
+		ret = zif_download_local_range (uri, offset, length,
+						data, state, error);
+		goto out;
+	}
+
+	/* we only do ranges over HTTP */
+	if (!g_str_has_prefix (uri, "http://") &&
+	    !g_str_has_prefix (uri, "https://")) {
+		g_set_error (error,
+			     ZIF_DOWNLOAD_ERROR,
+			     ZIF_DOWNLOAD_ERROR_NO_SUPPORT,
+			     "cannot download a range from %s",
+			     uri);
+		goto out;
+	}
+
+	/* create session if it does not exist yet */
+	if (download->priv->session == NULL) {
+		ret = zif_download_setup_session (download, error);
+		if (!ret)
+			goto out;
+	}
+
+	/* save an instance of the state object */
+	flight = g_new0 (ZifDownloadFlight, 1);
+	flight->state = g_object_ref (state);
+	flight->download = g_object_ref (download);
+	flight->uri = g_path_get_basename (uri);
+	flight->timer = g_timer_new ();
+
+	base_uri = soup_uri_new (uri);
+	if (base_uri == NULL) {
+		ret = FALSE;
+		g_set_error (error,
+			     ZIF_DOWNLOAD_ERROR,
+			     ZIF_DOWNLOAD_ERROR_FAILED,
+			     "could not parse uri: %s",
+			     uri);
+		goto out;
+	}
+
+	/* GET part of the file */
+	flight->msg = soup_message_new_from_uri (SOUP_METHOD_GET, base_uri);
+	if (flight->msg == NULL) {
+		ret = FALSE;
+		g_set_error_literal (error,
+				     ZIF_DOWNLOAD_ERROR,
+				     ZIF_DOWNLOAD_ERROR_FAILED,
+				     "could not setup message");
+		goto out;
+	}
+	soup_message_headers_set_range (flight->msg->request_headers,
+					offset,
+					offset + length - 1);
+
+	/* already cancelled */
+	if (g_cancellable_is_cancelled (zif_state_get_cancellable (state))) {
+		ret = FALSE;
+		g_set_error_literal (error,
+				     ZIF_STATE_ERROR,
+				     ZIF_STATE_ERROR_CANCELLED,
+				     "cancelled before downloading range");
+		goto out;
+	}
+
+	/* we need to be able to cancel a large range */
+	g_signal_connect (flight->msg, "got-chunk",
+			  G_CALLBACK (zif_download_file_range_got_chunk_cb),
+			  flight);
+
+	/* send sync */
+	zif_state_action_start (state, ZIF_STATE_ACTION_DOWNLOADING, flight->uri);
+	soup_session_send_message (download->priv->session, flight->msg);
+
+	/* the server ignored the range and sent us everything */
+	if (flight->msg->status_code == SOUP_STATUS_OK) {
+		ret = FALSE;
+		g_set_error (error,
+			     ZIF_DOWNLOAD_ERROR,
+			     ZIF_DOWNLOAD_ERROR_NO_SUPPORT,
+			     "server does not support ranges for %s",
+			     uri);
+		goto out;
+	}
+	if (flight->msg->status_code == SOUP_STATUS_CANCELLED) {
+		ret = FALSE;
+		g_set_error_literal (error,
+				     ZIF_STATE_ERROR,
+				     ZIF_STATE_ERROR_CANCELLED,
+				     soup_status_get_phrase (flight->msg->status_code));
+		goto out;
+	}
+	if (flight->msg->status_code != SOUP_STATUS_PARTIAL_CONTENT) {
+		ret = FALSE;
+		g_set_error (error,
+			     ZIF_DOWNLOAD_ERROR,
+			     ZIF_DOWNLOAD_ERROR_WRONG_STATUS,
+			     "failed to get valid range response for %s: %s",
+			     uri,
+			     soup_status_get_phrase (flight->msg->status_code));
+		goto out;
+	}
+
+	/* we only asked for a single range */
+	if ((guint64) flight->msg->response_body->length != length) {
+		ret = FALSE;
+		g_set_error (error,
+			     ZIF_DOWNLOAD_ERROR,
+			     ZIF_DOWNLOAD_ERROR_WRONG_SIZE,
+			     "got %" G_GOFFSET_FORMAT " bytes when expecting %" G_GUINT64_FORMAT " from %s",
+			     flight->msg->response_body->length,
+			     length,
+			     uri);
+		goto out;
+	}
+	g_byte_array_append (data,
+			     (const guint8 *) flight->msg->response_body->data,
+			     length);
+	ret = TRUE;
+out:
+	if (flight != NULL) {
+		g_timer_destroy (flight->timer);
+		g_object_unref (flight->state);
+		g_object_unref (flight->download);
+		if (flight->msg != NULL)
+			g_object_unref (flight->msg);
+		g_free (flight->uri);
+		g_free (flight);
+	}
+	if (base_uri != NULL)
+		soup_uri_free (base_uri);
+	return ret;
+}
+
 /**
  * zif_download_set_proxy:
  * @download: A #ZifDownload
@@ -919,9 +1182,7 @@ zif_download_check_checksum (GFile *file,
 {
 	gboolean ret;
 	gchar *checksum_tmp = NULL;
-	gchar *data = NULL;
 	gchar *filename = NULL;
-	gsize len;
 
 	/* no data */
 	if (checksum == NULL) {
@@ -929,11 +1190,14 @@ zif_download_check_checksum (GFile *file,
 		goto out;
 	}
 
+	/* this is cached in an xattr, so re-checking an unchanged
+	 * file does not have to read it again */
 	filename = g_file_get_path (file);
-	ret = g_file_get_contents (filename, &data, &len, error);
-	if (!ret)
+	checksum_tmp = zif_file_get_checksum (filename, checksum_type, NULL, error);
+	if (checksum_tmp == NULL) {
+		ret = FALSE;
 		goto out;
-	checksum_tmp = g_compute_checksum_for_string (checksum_type, data, len);
+	}
 	ret = (g_strcmp0 (checksum_tmp, checksum) == 0);
 	if (!ret) {
 		g_set_error (error,
@@ -945,7 +1209,6 @@ zif_download_check_checksum (GFile *file,
 	}
 out:
 	g_free (checksum_tmp);
-	g_free (data);
 	g_free (filename);
 	return ret;
 }
@@ -1003,6 +1266,13 @@ zif_download_file_full (ZifDownload *download,
 						   G_FILE_QUERY_INFO_NONE,
 						   cancellable,
 						   error);
+		if (!ret)
+			goto out;
+
+		/* changing the mtime invalidates the cached checksum,
+		 * but we've just checked the contents are the same */
+		if (checksum != NULL)
+			zif_file_set_cached_checksum (filename, checksum_type, checksum);
 		goto out;
 	}
 
@@ -1251,6 +1521,85 @@ zif_download_location (ZifDownload *download, const gchar *location, const gchar
 	return zif_download_location_full (download, location, filename, 0, NULL, 0, NULL, state, error);
 }
 
+/**
+ * zif_download_location_range:
+ * @download: A #ZifDownload
+ * @location: Location to add on to the end of the pool URIs
+ * @offset: The byte offset into the remote file
+ * @length: The number of bytes to get
+ * @data: A #GByteArray to append the downloaded data to
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Downloads part of a file using the pool of download servers. Servers
+ * that fail are not removed from the pool, as the caller is expected to
+ * fall back to downloading the whole file using zif_download_location_full().
+ *
+ * Return value: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_download_location_range (ZifDownload *download,
+			     const gchar *location,
+			     guint64 offset,
+			     guint64 length,
+			     GByteArray *data,
+			     ZifState *state,
+			     GError **error)
+{
+	gboolean ret = FALSE;
+	gchar *uri_tmp;
+	GError *error_local = NULL;
+	GPtrArray *array;
+	guint i;
+	ZifDownloadItem *item;
+
+	g_return_val_if_fail (ZIF_IS_DOWNLOAD (download), FALSE);
+	g_return_val_if_fail (location != NULL, FALSE);
+	g_return_val_if_fail (zif_state_valid (state), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* nothing in the pool */
+	array = download->priv->array;
+	if (array->len == 0) {
+		g_set_error_literal (error,
+				     ZIF_DOWNLOAD_ERROR,
+				     ZIF_DOWNLOAD_ERROR_NO_LOCATIONS,
+				     "The download pool is empty");
+		goto out;
+	}
+
+	/* try each mirror in order */
+	for (i = 0; i < array->len; i++) {
+		item = g_ptr_array_index (array, i);
+		uri_tmp = g_build_filename (item->uri, location, NULL);
+		zif_state_reset (state);
+		ret = zif_download_file_range (download, uri_tmp,
+					       offset, length, data,
+					       state, &error_local);
+		g_free (uri_tmp);
+		if (ret)
+			break;
+
+		/* cancelled is always fatal */
+		if (error_local->domain == ZIF_STATE_ERROR &&
+		    error_local->code == ZIF_STATE_ERROR_CANCELLED) {
+			g_propagate_error (error, error_local);
+			goto out;
+		}
+		g_debug ("failed to download range from %s: %s",
+			 item->uri, error_local->message);
+		if (i == array->len - 1) {
+			g_propagate_error (error, error_local);
+			goto out;
+		}
+		g_clear_error (&error_local);
+	}
+out:
+	return ret;
+}
+
 /**
  * zif_download_location_get_size:
  * @download: A #ZifDownload
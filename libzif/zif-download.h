@@ -71,6 +71,7 @@ typedef enum {
 	ZIF_DOWNLOAD_ERROR_WRONG_SIZE,
 	ZIF_DOWNLOAD_ERROR_WRONG_CHECKSUM,
 	ZIF_DOWNLOAD_ERROR_NO_LOCATIONS,
+	ZIF_DOWNLOAD_ERROR_NO_SUPPORT,
 	ZIF_DOWNLOAD_ERROR_LAST
 } ZifDownloadError;
 
@@ -94,6 +95,13 @@ gboolean	 zif_download_file_full			(ZifDownload		*download,
 							 const gchar		*checksum,
 							 ZifState		*state,
 							 GError			**error);
+gboolean	 zif_download_file_range		(ZifDownload		*download,
+							 const gchar		*uri,
+							 guint64		 offset,
+							 guint64		 length,
+							 GByteArray		*data,
+							 ZifState		*state,
+							 GError			**error);
 
 /* multiple mirror support */
 gboolean	 zif_download_location_add_uri		(ZifDownload		*download,
@@ -119,6 +127,13 @@ gboolean	 zif_download_location_full		(ZifDownload		*download,
 							 const gchar		*checksum,
 							 ZifState		*state,
 							 GError			**error);
+gboolean	 zif_download_location_range		(ZifDownload		*download,
+							 const gchar		*location,
+							 guint64		 offset,
+							 guint64		 length,
+							 GByteArray		*data,
+							 ZifState		*state,
+							 GError			**error);
 guint		 zif_download_location_get_size		(ZifDownload		*download);
 void		 zif_download_location_clear		(ZifDownload		*download);
 
@@ -0,0 +1,476 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2011 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * SECTION:zif-file-list
+ * @short_description: Compact package file lists
+ *
+ * A #ZifFileList stores the files in a package as a directory name and
+ * a basename rather than as a full path for each file.
+ *
+ * The directory names are interned and so shared between all the
+ * packages, which means that common prefixes like /usr/share/locale/
+ * are only stored once. The basenames are packed into a single buffer
+ * per list. Full paths are only allocated when explicitly requested.
+ *
+ * The first call to zif_file_list_contains() builds a sorted index of
+ * the entries, so that each lookup is a binary search.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+#include <string.h>
+
+#include "zif-file-list.h"
+
+typedef struct {
+	const gchar	*dirname;
+	guint		 basename;
+} ZifFileListEntry;
+
+struct _ZifFileList {
+	gint		 count;
+	GArray		*entries;
+	GString		*basenames;
+	const gchar	*dirname_last;
+	GArray		*sorted;	/* entry indexes, built on demand */
+};
+
+/**
+ * zif_file_list_new: (skip)
+ *
+ * Creates a new empty file list.
+ *
+ * Return value: A new #ZifFileList, free with zif_file_list_unref()
+ *
+ * Since: 0.3.7
+ **/
+ZifFileList *
+zif_file_list_new (void)
+{
+	ZifFileList *list;
+	list = g_slice_new0 (ZifFileList);
+	list->count = 1;
+	list->entries = g_array_new (FALSE, FALSE, sizeof (ZifFileListEntry));
+	list->basenames = g_string_new ("");
+	return list;
+}
+
+/**
+ * zif_file_list_new_from_array: (skip)
+ * @files: (element-type utf8): An array of full paths
+ *
+ * Creates a new file list from an array of full paths.
+ *
+ * Return value: A new #ZifFileList, free with zif_file_list_unref()
+ *
+ * Since: 0.3.7
+ **/
+ZifFileList *
+zif_file_list_new_from_array (GPtrArray *files)
+{
+	guint i;
+	ZifFileList *list;
+
+	g_return_val_if_fail (files != NULL, NULL);
+
+	list = zif_file_list_new ();
+	for (i = 0; i < files->len; i++)
+		zif_file_list_add_filename (list, g_ptr_array_index (files, i));
+	return list;
+}
+
+/**
+ * zif_file_list_ref: (skip)
+ * @list: A #ZifFileList
+ *
+ * Increases the reference count on the list.
+ *
+ * Return value: A #ZifFileList
+ *
+ * Since: 0.3.7
+ **/
+ZifFileList *
+zif_file_list_ref (ZifFileList *list)
+{
+	g_return_val_if_fail (list != NULL, NULL);
+	g_atomic_int_inc (&list->count);
+	return list;
+}
+
+/**
+ * zif_file_list_unref: (skip)
+ * @list: A #ZifFileList
+ *
+ * Decreases the reference count on the list, and frees the data if
+ * it falls to zero.
+ *
+ * Return value: A #ZifFileList, or %NULL if the list was freed
+ *
+ * Since: 0.3.7
+ **/
+ZifFileList *
+zif_file_list_unref (ZifFileList *list)
+{
+	g_return_val_if_fail (list != NULL, NULL);
+	if (!g_atomic_int_dec_and_test (&list->count))
+		return list;
+	g_array_unref (list->entries);
+	g_string_free (list->basenames, TRUE);
+	if (list->sorted != NULL)
+		g_array_unref (list->sorted);
+	g_slice_free (ZifFileList, list);
+	return NULL;
+}
+
+/**
+ * zif_file_list_add: (skip)
+ * @list: A #ZifFileList
+ * @dirname: The directory name including the trailing '/', e.g. "/usr/bin/"
+ * @basename: The file name, e.g. "zif"
+ *
+ * Adds a file to the list.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_file_list_add (ZifFileList *list,
+		   const gchar *dirname,
+		   const gchar *basename)
+{
+	ZifFileListEntry entry;
+
+	g_return_if_fail (list != NULL);
+	g_return_if_fail (dirname != NULL);
+	g_return_if_fail (basename != NULL);
+
+	/* files are normally added a directory at a time, so only
+	 * intern the name when it changes */
+	if (list->dirname_last == NULL ||
+	    (dirname != list->dirname_last &&
+	     strcmp (dirname, list->dirname_last) != 0))
+		list->dirname_last = g_intern_string (dirname);
+
+	/* the sorted index is out of date */
+	if (list->sorted != NULL) {
+		g_array_unref (list->sorted);
+		list->sorted = NULL;
+	}
+
+	entry.dirname = list->dirname_last;
+	entry.basename = list->basenames->len;
+	g_string_append_len (list->basenames, basename, strlen (basename) + 1);
+	g_array_append_val (list->entries, entry);
+}
+
+/**
+ * zif_file_list_add_filename: (skip)
+ * @list: A #ZifFileList
+ * @filename: A full path, e.g. "/usr/bin/zif"
+ *
+ * Adds a file to the list, splitting the path into a directory name
+ * and a basename.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_file_list_add_filename (ZifFileList *list, const gchar *filename)
+{
+	const gchar *tmp;
+	gchar *dirname;
+
+	g_return_if_fail (list != NULL);
+	g_return_if_fail (filename != NULL);
+
+	tmp = strrchr (filename, '/');
+	if (tmp == NULL) {
+		zif_file_list_add (list, "", filename);
+		return;
+	}
+	dirname = g_strndup (filename, tmp - filename + 1);
+	zif_file_list_add (list, dirname, tmp + 1);
+	g_free (dirname);
+}
+
+/**
+ * zif_file_list_get_length: (skip)
+ * @list: A #ZifFileList
+ *
+ * Gets the number of files in the list.
+ *
+ * Return value: The number of files
+ *
+ * Since: 0.3.7
+ **/
+guint
+zif_file_list_get_length (ZifFileList *list)
+{
+	g_return_val_if_fail (list != NULL, 0);
+	return list->entries->len;
+}
+
+/**
+ * zif_file_list_get_dirname: (skip)
+ * @list: A #ZifFileList
+ * @idx: The index of the file
+ *
+ * Gets the directory name of a file in the list.
+ *
+ * Return value: An interned string, e.g. "/usr/bin/"
+ *
+ * Since: 0.3.7
+ **/
+const gchar *
+zif_file_list_get_dirname (ZifFileList *list, guint idx)
+{
+	g_return_val_if_fail (list != NULL, NULL);
+	g_return_val_if_fail (idx < list->entries->len, NULL);
+	return g_array_index (list->entries, ZifFileListEntry, idx).dirname;
+}
+
+/**
+ * zif_file_list_get_basename: (skip)
+ * @list: A #ZifFileList
+ * @idx: The index of the file
+ *
+ * Gets the basename of a file in the list.
+ *
+ * Return value: A string owned by the list, e.g. "zif"
+ *
+ * Since: 0.3.7
+ **/
+const gchar *
+zif_file_list_get_basename (ZifFileList *list, guint idx)
+{
+	guint offset;
+	g_return_val_if_fail (list != NULL, NULL);
+	g_return_val_if_fail (idx < list->entries->len, NULL);
+	offset = g_array_index (list->entries, ZifFileListEntry, idx).basename;
+	return list->basenames->str + offset;
+}
+
+/**
+ * zif_file_list_get_filename: (skip)
+ * @list: A #ZifFileList
+ * @idx: The index of the file
+ *
+ * Gets the full path of a file in the list.
+ *
+ * Return value: A new string, free with g_free()
+ *
+ * Since: 0.3.7
+ **/
+gchar *
+zif_file_list_get_filename (ZifFileList *list, guint idx)
+{
+	g_return_val_if_fail (list != NULL, NULL);
+	g_return_val_if_fail (idx < list->entries->len, NULL);
+	return g_strconcat (zif_file_list_get_dirname (list, idx),
+			    zif_file_list_get_basename (list, idx),
+			    NULL);
+}
+
+/**
+ * zif_file_list_compare:
+ *
+ * Orders entries by the interned dirname pointer, and then by basename.
+ **/
+static gint
+zif_file_list_compare (ZifFileList *list,
+		       const gchar *dirname,
+		       const gchar *basename,
+		       guint idx)
+{
+	ZifFileListEntry *entry;
+
+	entry = &g_array_index (list->entries, ZifFileListEntry, idx);
+	if (dirname != entry->dirname)
+		return dirname < entry->dirname ? -1 : 1;
+	return strcmp (basename, list->basenames->str + entry->basename);
+}
+
+/**
+ * zif_file_list_sort_cb:
+ **/
+static gint
+zif_file_list_sort_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	ZifFileList *list = (ZifFileList *) user_data;
+	ZifFileListEntry *entry;
+
+	entry = &g_array_index (list->entries, ZifFileListEntry, *((const guint *) a));
+	return zif_file_list_compare (list,
+				      entry->dirname,
+				      list->basenames->str + entry->basename,
+				      *((const guint *) b));
+}
+
+/**
+ * zif_file_list_get_sorted:
+ *
+ * Builds the sorted index if required. Lists can be shared between
+ * threads, so if two threads race then only one index is kept.
+ **/
+static GArray *
+zif_file_list_get_sorted (ZifFileList *list)
+{
+	GArray *sorted;
+	guint i;
+
+	sorted = g_atomic_pointer_get (&list->sorted);
+	if (sorted != NULL)
+		return sorted;
+
+	sorted = g_array_sized_new (FALSE, FALSE, sizeof (guint), list->entries->len);
+	for (i = 0; i < list->entries->len; i++)
+		g_array_append_val (sorted, i);
+	g_qsort_with_data (sorted->data, sorted->len, sizeof (guint),
+			   zif_file_list_sort_cb, list);
+	if (!g_atomic_pointer_compare_and_exchange (&list->sorted, NULL, sorted)) {
+		g_array_unref (sorted);
+		sorted = g_atomic_pointer_get (&list->sorted);
+	}
+	return sorted;
+}
+
+/**
+ * zif_file_list_contains: (skip)
+ * @list: A #ZifFileList
+ * @filename: A full path, e.g. "/usr/bin/zif"
+ *
+ * Finds out if the list contains a file, without building the full
+ * path for each entry.
+ *
+ * Return value: %TRUE if the file is in the list
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_file_list_contains (ZifFileList *list, const gchar *filename)
+{
+	const gchar *basename;
+	const gchar *dirname;
+	const gchar *tmp;
+	gchar *dirname_tmp;
+	gint rc;
+	GArray *sorted;
+	GQuark quark;
+	guint high;
+	guint low;
+	guint mid;
+
+	g_return_val_if_fail (list != NULL, FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+
+	/* nothing to search */
+	if (list->entries->len == 0)
+		return FALSE;
+
+	/* split the path */
+	tmp = strrchr (filename, '/');
+	if (tmp == NULL) {
+		dirname_tmp = g_strdup ("");
+		basename = filename;
+	} else {
+		dirname_tmp = g_strndup (filename, tmp - filename + 1);
+		basename = tmp + 1;
+	}
+
+	/* if the directory name was never interned then no list can
+	 * contain it, otherwise we can just compare pointers */
+	quark = g_quark_try_string (dirname_tmp);
+	g_free (dirname_tmp);
+	if (quark == 0)
+		return FALSE;
+	dirname = g_quark_to_string (quark);
+
+	/* binary search */
+	sorted = zif_file_list_get_sorted (list);
+	low = 0;
+	high = sorted->len;
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		rc = zif_file_list_compare (list, dirname, basename,
+					    g_array_index (sorted, guint, mid));
+		if (rc == 0)
+			return TRUE;
+		if (rc < 0)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	return FALSE;
+}
+
+/**
+ * zif_file_list_to_array: (skip)
+ * @list: A #ZifFileList
+ *
+ * Gets the full path of every file in the list.
+ *
+ * Return value: (element-type utf8) (transfer full): A new array of
+ * strings, free with g_ptr_array_unref()
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_file_list_to_array (ZifFileList *list)
+{
+	GPtrArray *array;
+	guint i;
+
+	g_return_val_if_fail (list != NULL, NULL);
+
+	array = g_ptr_array_new_full (list->entries->len, g_free);
+	for (i = 0; i < list->entries->len; i++)
+		g_ptr_array_add (array, zif_file_list_get_filename (list, i));
+	return array;
+}
+
+/**
+ * zif_file_list_get_size: (skip)
+ * @list: A #ZifFileList
+ *
+ * Gets the number of bytes used by the list. The directory names are
+ * shared between all lists and are not included.
+ *
+ * Return value: the size in bytes
+ *
+ * Since: 0.3.7
+ **/
+gsize
+zif_file_list_get_size (ZifFileList *list)
+{
+	gsize size;
+
+	g_return_val_if_fail (list != NULL, 0);
+
+	size = sizeof (ZifFileList);
+	size += sizeof (GString) + list->basenames->allocated_len;
+	size += 5 * sizeof (gpointer);
+	size += list->entries->len * sizeof (ZifFileListEntry);
+	if (list->sorted != NULL)
+		size += list->sorted->len * sizeof (guint);
+	return size;
+}
@@ -0,0 +1,58 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2011 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#if !defined (__ZIF_H_INSIDE__) && !defined (ZIF_COMPILATION)
+#error "Only <zif.h> can be included directly."
+#endif
+
+#ifndef __ZIF_FILE_LIST_H
+#define __ZIF_FILE_LIST_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ZifFileList	ZifFileList;
+
+ZifFileList	*zif_file_list_new		(void);
+ZifFileList	*zif_file_list_new_from_array	(GPtrArray	*files);
+ZifFileList	*zif_file_list_ref		(ZifFileList	*list);
+ZifFileList	*zif_file_list_unref		(ZifFileList	*list);
+void		 zif_file_list_add		(ZifFileList	*list,
+						 const gchar	*dirname,
+						 const gchar	*basename);
+void		 zif_file_list_add_filename	(ZifFileList	*list,
+						 const gchar	*filename);
+guint		 zif_file_list_get_length	(ZifFileList	*list);
+const gchar	*zif_file_list_get_dirname	(ZifFileList	*list,
+						 guint		 idx);
+const gchar	*zif_file_list_get_basename	(ZifFileList	*list,
+						 guint		 idx);
+gchar		*zif_file_list_get_filename	(ZifFileList	*list,
+						 guint		 idx);
+gboolean	 zif_file_list_contains		(ZifFileList	*list,
+						 const gchar	*filename);
+GPtrArray	*zif_file_list_to_array		(ZifFileList	*list);
+gsize		 zif_file_list_get_size		(ZifFileList	*list);
+
+G_END_DECLS
+
+#endif /* __ZIF_FILE_LIST_H */
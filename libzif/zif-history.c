@@ -39,6 +39,7 @@
 #include "zif-history.h"
 #include "zif-monitor.h"
 #include "zif-package-private.h"
+#include "zif-sql-stats-private.h"
 #include "zif-utils-private.h"
 
 #define ZIF_HISTORY_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_HISTORY, ZifHistoryPrivate))
@@ -140,6 +141,9 @@ zif_history_load (ZifHistory *history, GError **error)
 	sqlite3_exec (history->priv->db,
 		      "PRAGMA synchronous=OFF",
 		      NULL, NULL, NULL);
+	zif_sql_stats_attach (history->priv->db,
+			      "history",
+			      history->priv->filename);
 
 	/* check transactions */
 	rc = sqlite3_exec (history->priv->db,
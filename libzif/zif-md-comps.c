@@ -98,6 +98,8 @@ struct _ZifMdCompsPrivate
 	gboolean			 loaded;
 	GPtrArray			*array_groups;		/* stored as ZifMdCompsGroupData */
 	GPtrArray			*array_categories;	/* stored as ZifMdCompsCategoryData */
+	GHashTable			*hash_groups;		/* id:ZifMdCompsGroupData */
+	GHashTable			*hash_categories;	/* id:ZifMdCompsCategoryData */
 	/* for parser */
 	ZifMdCompsSection		 section;
 	ZifMdCompsSectionGroup		 section_group;
@@ -272,8 +274,15 @@ zif_md_comps_parser_end_element (GMarkupParseContext *context, const gchar *elem
 	if (g_strcmp0 (element_name, "group") == 0) {
 		comps->priv->section = ZIF_MD_COMPS_SECTION_UNKNOWN;
 
-		/* add to array */
+		/* add to array, and index by id; first one wins */
 		g_ptr_array_add (comps->priv->array_groups, comps->priv->group_data_temp);
+		if (comps->priv->group_data_temp->id != NULL &&
+		    g_hash_table_lookup (comps->priv->hash_groups,
+					 comps->priv->group_data_temp->id) == NULL) {
+			g_hash_table_insert (comps->priv->hash_groups,
+					     comps->priv->group_data_temp->id,
+					     comps->priv->group_data_temp);
+		}
 
 		if (FALSE)
 		g_debug ("added GROUP '%s' name:%s, desc:%s, visible:%i, list=%p",
@@ -291,8 +300,15 @@ zif_md_comps_parser_end_element (GMarkupParseContext *context, const gchar *elem
 	if (g_strcmp0 (element_name, "category") == 0) {
 		comps->priv->section = ZIF_MD_COMPS_SECTION_UNKNOWN;
 
-		/* add to array */
+		/* add to array, and index by id; first one wins */
 		g_ptr_array_add (comps->priv->array_categories, comps->priv->category_data_temp);
+		if (comps->priv->category_data_temp->id != NULL &&
+		    g_hash_table_lookup (comps->priv->hash_categories,
+					 comps->priv->category_data_temp->id) == NULL) {
+			g_hash_table_insert (comps->priv->hash_categories,
+					     comps->priv->category_data_temp->id,
+					     comps->priv->category_data_temp);
+		}
 
 		if (FALSE)
 		g_debug ("added CATEGORY '%s' name:%s, desc:%s, list=%p",
@@ -568,22 +584,16 @@ out:
 static ZifCategory *
 zif_md_comps_get_category_for_group (ZifMdComps *md, const gchar *group_id)
 {
-	guint i;
-	guint len;
 	ZifCategory *category = NULL;
 	ZifMdCompsGroupData *data;
 
 	/* find group matching group_id */
-	len = md->priv->array_groups->len;
-	for (i = 0; i < len; i++) {
-		data = g_ptr_array_index (md->priv->array_groups, i);
-		if (g_strcmp0 (group_id, data->id) == 0) {
-			category = zif_category_new ();
-			zif_category_set_id (category, data->id);
-			zif_category_set_name (category, data->name);
-			zif_category_set_summary (category, data->description);
-			break;
-		}
+	data = g_hash_table_lookup (md->priv->hash_groups, group_id);
+	if (data != NULL) {
+		category = zif_category_new ();
+		zif_category_set_id (category, data->id);
+		zif_category_set_name (category, data->name);
+		zif_category_set_summary (category, data->description);
 	}
 	return category;
 }
@@ -606,9 +616,7 @@ zif_md_comps_get_groups_for_category (ZifMdComps *md, const gchar *category_id,
 				      ZifState *state, GError **error)
 {
 	GPtrArray *array = NULL;
-	guint i;
 	guint j;
-	guint len;
 	gboolean ret;
 	GError *error_local = NULL;
 	const ZifMdCompsCategoryData *data;
@@ -631,27 +639,21 @@ zif_md_comps_get_groups_for_category (ZifMdComps *md, const gchar *category_id,
 		}
 	}
 
-	/* get categories */
-	len = md->priv->array_categories->len;
-	for (i = 0; i < len; i++) {
-		data = g_ptr_array_index (md->priv->array_categories, i);
-
-		/* category matches */
-		if (g_strcmp0 (category_id, data->id) == 0) {
-			array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-			for (j = 0; j < data->grouplist->len; j++) {
-				id = g_ptr_array_index (data->grouplist, j);
-				/* find group matching group_id */
-				category = zif_md_comps_get_category_for_group (md, id);
-				if (category == NULL)
-					continue;
-
-				/* add */
-				zif_category_set_parent_id (category, category_id);
-				zif_md_comps_category_set_icon (category);
-				g_ptr_array_add (array, category);
-			}
-			break;
+	/* get category */
+	data = g_hash_table_lookup (md->priv->hash_categories, category_id);
+	if (data != NULL) {
+		array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+		for (j = 0; j < data->grouplist->len; j++) {
+			id = g_ptr_array_index (data->grouplist, j);
+			/* find group matching group_id */
+			category = zif_md_comps_get_category_for_group (md, id);
+			if (category == NULL)
+				continue;
+
+			/* add */
+			zif_category_set_parent_id (category, category_id);
+			zif_md_comps_category_set_icon (category);
+			g_ptr_array_add (array, category);
 		}
 	}
 
@@ -682,9 +684,7 @@ zif_md_comps_get_packages_for_group (ZifMdComps *md, const gchar *group_id,
 				     ZifState *state, GError **error)
 {
 	GPtrArray *array = NULL;
-	guint i;
 	guint j;
-	guint len;
 	gboolean ret;
 	GError *error_local = NULL;
 	const ZifMdCompsGroupData *data;
@@ -715,18 +715,12 @@ zif_md_comps_get_packages_for_group (ZifMdComps *md, const gchar *group_id,
 		group_id_child = group_id;
 
 	/* get packages in this group */
-	len = md->priv->array_groups->len;
-	for (i = 0; i < len; i++) {
-		data = g_ptr_array_index (md->priv->array_groups, i);
-
-		/* category matches */
-		if (g_strcmp0 (group_id_child, data->id) == 0) {
-			array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_free);
-			for (j = 0; j < data->packagelist->len; j++) {
-				packagename = g_ptr_array_index (data->packagelist, j);
-				g_ptr_array_add (array, g_strdup (packagename));
-			}
-			break;
+	data = g_hash_table_lookup (md->priv->hash_groups, group_id_child);
+	if (data != NULL) {
+		array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_free);
+		for (j = 0; j < data->packagelist->len; j++) {
+			packagename = g_ptr_array_index (data->packagelist, j);
+			g_ptr_array_add (array, g_strdup (packagename));
 		}
 	}
 
@@ -751,6 +745,8 @@ zif_md_comps_finalize (GObject *object)
 	g_return_if_fail (ZIF_IS_MD_COMPS (object));
 	md = ZIF_MD_COMPS (object);
 
+	g_hash_table_unref (md->priv->hash_groups);
+	g_hash_table_unref (md->priv->hash_categories);
 	g_ptr_array_unref (md->priv->array_groups);
 	g_ptr_array_unref (md->priv->array_categories);
 
@@ -789,6 +785,8 @@ zif_md_comps_init (ZifMdComps *md)
 	md->priv->category_data_temp = NULL;
 	md->priv->array_groups = g_ptr_array_new_with_free_func ((GDestroyNotify) zif_md_comps_group_data_free);
 	md->priv->array_categories = g_ptr_array_new_with_free_func ((GDestroyNotify) zif_md_comps_category_data_free);
+	md->priv->hash_groups = g_hash_table_new (g_str_hash, g_str_equal);
+	md->priv->hash_categories = g_hash_table_new (g_str_hash, g_str_equal);
 }
 
 /**
@@ -32,6 +32,7 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 #include <glib.h>
 
 #include "zif-delta-private.h"
@@ -69,6 +70,8 @@ struct _ZifMdDeltaPrivate
 {
 	gboolean			 loaded;
 	GHashTable			*hash_newpackages;		/* value as GPtrArray */
+	GHashTable			*hash_deltas;			/* key is update+installed, value as ZifDelta */
+	GHashTable			*hash_installed_names;		/* key is name, or %NULL for no filter */
 	/* for parser */
 	ZifMdDeltaXml			 section;
 	ZifMdDeltaXmlNewpackage		 section_newpackage;
@@ -78,10 +81,33 @@ struct _ZifMdDeltaPrivate
 	ZifPackage			*package_temp;
 	gchar				*name_temp;
 	gchar				*arch_temp;
+	gchar				*package_id_temp;
 };
 
 G_DEFINE_TYPE (ZifMdDelta, zif_md_delta, ZIF_TYPE_MD)
 
+/**
+ * zif_md_delta_get_key:
+ *
+ * Builds a key from the full update package-id and the NEVRA of the
+ * installed package-id, ignoring the data section of the latter.
+ **/
+static gchar *
+zif_md_delta_get_key (const gchar *package_id_update,
+		      const gchar *package_id_installed)
+{
+	const gchar *tmp;
+	gsize len;
+
+	tmp = strrchr (package_id_installed, ';');
+	if (tmp != NULL)
+		len = tmp - package_id_installed;
+	else
+		len = strlen (package_id_installed);
+	return g_strdup_printf ("%s\t%.*s", package_id_update,
+				(gint) len, package_id_installed);
+}
+
 /**
  * zif_md_delta_parser_start_element:
  **/
@@ -92,6 +118,7 @@ zif_md_delta_parser_start_element (GMarkupParseContext *context, const gchar *el
 {
 	guint i;
 	gchar *package_id = NULL;
+	gchar *key;
 	ZifMdDelta *delta = user_data;
 	const gchar *name = NULL;
 	guint epoch = 0;
@@ -126,6 +153,15 @@ zif_md_delta_parser_start_element (GMarkupParseContext *context, const gchar *el
 					arch = attribute_values[i];
 			}
 
+			/* required so we can construct a full package id for the deltas */
+			delta->priv->name_temp = g_strdup (name);
+			delta->priv->arch_temp = g_strdup (arch);
+
+			/* a delta can never be applied if nothing is installed */
+			if (delta->priv->hash_installed_names != NULL &&
+			    g_hash_table_lookup (delta->priv->hash_installed_names, name) == NULL)
+				goto out;
+
 			/* use this as the key for the hash table */
 			package_id = zif_package_id_from_nevra (name, epoch, version, release, arch,
 								zif_md_get_id (ZIF_MD(delta)));
@@ -133,11 +169,9 @@ zif_md_delta_parser_start_element (GMarkupParseContext *context, const gchar *el
 
 			/* we carry this around so we can add deltas to it */
 			delta->priv->array_temp = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-			g_hash_table_insert (delta->priv->hash_newpackages, g_strdup (package_id), delta->priv->array_temp);
-
-			/* required so we can construct a full package id for the deltas */
-			delta->priv->name_temp = g_strdup (name);
-			delta->priv->arch_temp = g_strdup (arch);
+			g_hash_table_insert (delta->priv->hash_newpackages, package_id, delta->priv->array_temp);
+			delta->priv->package_id_temp = g_strdup (package_id);
+			package_id = NULL;
 			goto out;
 		}
 
@@ -152,6 +186,10 @@ zif_md_delta_parser_start_element (GMarkupParseContext *context, const gchar *el
 				delta->priv->section_newpackage = ZIF_MD_DELTA_XML_NEWPACKAGE_DELTA;
 				delta->priv->delta_temp = zif_delta_new ();
 
+				/* skipped newpackage, so just parse and discard */
+				if (delta->priv->array_temp == NULL)
+					goto out;
+
 				/* find the package-id */
 				for (i = 0; attribute_names[i] != NULL; i++) {
 					if (g_strcmp0 (attribute_names[i], "oldepoch") == 0)
@@ -170,6 +208,15 @@ zif_md_delta_parser_start_element (GMarkupParseContext *context, const gchar *el
 				g_ptr_array_add (delta->priv->array_temp, delta->priv->delta_temp);
 				g_debug ("adding delta package_id=%s", package_id);
 
+				/* index by the update and installed NEVRA */
+				key = zif_md_delta_get_key (delta->priv->package_id_temp, package_id);
+				if (g_hash_table_lookup (delta->priv->hash_deltas, key) == NULL) {
+					g_hash_table_insert (delta->priv->hash_deltas, key,
+							     delta->priv->delta_temp);
+				} else {
+					g_free (key);
+				}
+
 				goto out;
 			}
 
@@ -237,8 +284,10 @@ zif_md_delta_parser_end_element (GMarkupParseContext *context, const gchar *elem
 				delta->priv->array_temp = NULL;
 				g_free (delta->priv->name_temp);
 				g_free (delta->priv->arch_temp);
+				g_free (delta->priv->package_id_temp);
 				delta->priv->name_temp = NULL;
 				delta->priv->arch_temp = NULL;
+				delta->priv->package_id_temp = NULL;
 				goto out;
 			}
 
@@ -253,6 +302,8 @@ zif_md_delta_parser_end_element (GMarkupParseContext *context, const gchar *elem
 				/* end of delta */
 				if (g_strcmp0 (element_name, "delta") == 0) {
 					delta->priv->section_newpackage = ZIF_MD_DELTA_XML_NEWPACKAGE_UNKNOWN;
+					if (delta->priv->array_temp == NULL)
+						g_object_unref (delta->priv->delta_temp);
 					delta->priv->delta_temp = NULL;
 					goto out;
 				}
@@ -483,7 +534,7 @@ zif_md_delta_search_for_package (ZifMdDelta *md,
 				 const gchar *package_id_installed,
 				 ZifState *state, GError **error)
 {
-	guint i;
+	gchar *key = NULL;
 	ZifDelta *delta = NULL;
 	ZifDelta *delta_tmp;
 	GPtrArray *array = NULL;
@@ -500,24 +551,52 @@ zif_md_delta_search_for_package (ZifMdDelta *md,
 		goto out;
 
 	/* find the installed package */
-	for (i = 0; i < array->len; i++) {
-		delta_tmp = g_ptr_array_index (array, i);
-		if (zif_package_id_compare_nevra (zif_delta_get_id (delta_tmp),
-		                                  package_id_installed)) {
-			delta = g_object_ref (delta_tmp);
-			break;
-		}
-	}
-
-	/* nothing found */
-	if (delta == NULL) {
+	key = zif_md_delta_get_key (package_id_update, package_id_installed);
+	delta_tmp = g_hash_table_lookup (md->priv->hash_deltas, key);
+	if (delta_tmp == NULL) {
 		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED,
 			     "could not find installed package: %s", package_id_installed);
+		goto out;
 	}
+	delta = g_object_ref (delta_tmp);
 out:
+	g_free (key);
 	return delta;
 }
 
+/**
+ * zif_md_delta_set_installed_names:
+ * @md: A #ZifMdDelta
+ * @names: (allow-none): The names of all installed packages, or %NULL
+ *
+ * Sets the names of the installed packages so that deltas for packages
+ * that are not installed are not parsed when the metadata is loaded.
+ * This has to be called before the metadata is loaded to have any effect.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_md_delta_set_installed_names (ZifMdDelta *md, gchar **names)
+{
+	guint i;
+
+	g_return_if_fail (ZIF_IS_MD_DELTA (md));
+
+	if (md->priv->hash_installed_names != NULL) {
+		g_hash_table_unref (md->priv->hash_installed_names);
+		md->priv->hash_installed_names = NULL;
+	}
+	if (names == NULL)
+		return;
+	md->priv->hash_installed_names = g_hash_table_new_full (g_str_hash, g_str_equal,
+								g_free, NULL);
+	for (i = 0; names[i] != NULL; i++) {
+		g_hash_table_insert (md->priv->hash_installed_names,
+				     g_strdup (names[i]),
+				     GINT_TO_POINTER (1));
+	}
+}
+
 /**
  * zif_md_delta_finalize:
  **/
@@ -530,7 +609,10 @@ zif_md_delta_finalize (GObject *object)
 	g_return_if_fail (ZIF_IS_MD_DELTA (object));
 	md = ZIF_MD_DELTA (object);
 
+	g_hash_table_unref (md->priv->hash_deltas);
 	g_hash_table_unref (md->priv->hash_newpackages);
+	if (md->priv->hash_installed_names != NULL)
+		g_hash_table_unref (md->priv->hash_installed_names);
 
 	G_OBJECT_CLASS (zif_md_delta_parent_class)->finalize (object);
 }
@@ -564,7 +646,10 @@ zif_md_delta_init (ZifMdDelta *md)
 	md->priv->section_newpackage_delta = ZIF_MD_DELTA_XML_NEWPACKAGE_DELTA_UNKNOWN;
 	md->priv->delta_temp = NULL;
 	md->priv->array_temp = NULL;
+	md->priv->package_id_temp = NULL;
+	md->priv->hash_installed_names = NULL;
 	md->priv->hash_newpackages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+	md->priv->hash_deltas = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 }
 
 /**
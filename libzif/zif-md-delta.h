@@ -69,6 +69,8 @@ ZifDelta	*zif_md_delta_search_for_package 	(ZifMdDelta		*md,
 							 const gchar		*package_id_installed,
 							 ZifState		*state,
 							 GError			**error);
+void		 zif_md_delta_set_installed_names	(ZifMdDelta		*md,
+							 gchar			**names);
 
 G_END_DECLS
 
@@ -40,6 +40,7 @@
 #include "zif-md-filelists-sql.h"
 #include "zif-md.h"
 #include "zif-package-remote.h"
+#include "zif-sql-stats-private.h"
 #include "zif-state-private.h"
 
 #define ZIF_MD_FILELISTS_SQL_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_MD_FILELISTS_SQL, ZifMdFilelistsSqlPrivate))
@@ -110,6 +111,7 @@ zif_md_filelists_sql_load (ZifMd *md, ZifState *state, GError **error)
 
 	/* we don't need to keep syncing */
 	sqlite3_exec (filelists->priv->db, "PRAGMA synchronous=OFF", NULL, NULL, NULL);
+	zif_sql_stats_attach (filelists->priv->db, "filelists_db", filename);
 	filelists->priv->loaded = TRUE;
 out:
 	return filelists->priv->loaded;
@@ -421,6 +423,30 @@ out:
 	return array;
 }
 
+/**
+ * zif_md_filelists_sql_get_memory_usage:
+ **/
+static void
+zif_md_filelists_sql_get_memory_usage (ZifMd *md, ZifMemory *memory)
+{
+	gint highwater = 0;
+	gint used = 0;
+	ZifMdFilelistsSql *md_filelists_sql = ZIF_MD_FILELISTS_SQL (md);
+
+	if (md_filelists_sql->priv->db == NULL)
+		return;
+
+	/* page cache and prepared statements */
+	sqlite3_db_status (md_filelists_sql->priv->db,
+			   SQLITE_DBSTATUS_CACHE_USED,
+			   &used, &highwater, FALSE);
+	zif_memory_add (memory, ZIF_MEMORY_KIND_MD, used);
+	sqlite3_db_status (md_filelists_sql->priv->db,
+			   SQLITE_DBSTATUS_STMT_USED,
+			   &used, &highwater, FALSE);
+	zif_memory_add (memory, ZIF_MEMORY_KIND_MD, used);
+}
+
 /**
  * zif_md_filelists_sql_finalize:
  **/
@@ -451,6 +477,7 @@ zif_md_filelists_sql_class_init (ZifMdFilelistsSqlClass *klass)
 	/* map */
 	md_class->load = zif_md_filelists_sql_load;
 	md_class->unload = zif_md_filelists_sql_unload;
+	md_class->get_memory_usage = zif_md_filelists_sql_get_memory_usage;
 	md_class->search_file = zif_md_filelists_sql_search_file;
 	md_class->get_files = zif_md_filelists_sql_get_files;
 	g_type_class_add_private (klass, sizeof (ZifMdFilelistsSqlPrivate));
@@ -25,6 +25,11 @@
  *
  * Provide access to the filelists_xml repo metadata.
  * This object is a subclass of #ZifMd
+ *
+ * The XML file is only parsed once, a chunk at a time, and the files are
+ * written to an on-disk SQLite index next to the uncompressed file. The
+ * index records the checksum of the XML it was built from and is reused
+ * by all processes until the metadata changes.
  */
 
 typedef enum {
@@ -52,16 +57,21 @@ typedef enum {
 #include <sqlite3.h>
 #include <gio/gio.h>
 
-#include "zif-config.h"
 #include "zif-md-filelists-xml.h"
 #include "zif-md.h"
-#include "zif-package-private.h"
-#include "zif-package-remote.h"
+#include "zif-md-private.h"
+#include "zif-package.h"
+#include "zif-sql-stats-private.h"
 #include "zif-state-private.h"
-#include "zif-string.h"
 
 #define ZIF_MD_FILELISTS_XML_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_MD_FILELISTS_XML, ZifMdFilelistsXmlPrivate))
 
+/* bump this if the index schema changes */
+#define ZIF_MD_FILELISTS_XML_INDEX_VERSION	1
+
+/* the size of each chunk passed to the XML parser */
+#define ZIF_MD_FILELISTS_XML_CHUNK_SIZE		(32 * 1024)
+
 /**
  * ZifMdFilelistsXmlPrivate:
  *
@@ -73,11 +83,11 @@ struct _ZifMdFilelistsXmlPrivate
 	ZifMdFilelistsXmlSection	 section;
 	ZifMdFilelistsXmlSectionList	 section_list;
 	ZifMdFilelistsXmlSectionListPackage	section_list_package;
-	ZifPackage			*package_temp;
-	GPtrArray			*array;
-	GPtrArray			*array_temp;
-	ZifConfig			*config;
-	ZifPackageCompareMode		 compare_mode;
+	sqlite3				*db;
+	sqlite3				*db_build;
+	sqlite3_stmt			*stmt_package;
+	sqlite3_stmt			*stmt_file;
+	sqlite3_int64			 pkgkey_temp;
 };
 
 G_DEFINE_TYPE (ZifMdFilelistsXml, zif_md_filelists_xml, ZIF_TYPE_MD)
@@ -92,6 +102,22 @@ zif_md_filelists_xml_unload (ZifMd *md, ZifState *state, GError **error)
 	return ret;
 }
 
+/**
+ * zif_md_filelists_xml_set_sql_error:
+ **/
+static void
+zif_md_filelists_xml_set_sql_error (ZifMdFilelistsXml *filelists_xml,
+				    const gchar *action,
+				    GError **error)
+{
+	g_set_error (error,
+		     ZIF_MD_ERROR,
+		     ZIF_MD_ERROR_BAD_SQL,
+		     "SQL error (failed to %s): %s",
+		     action,
+		     sqlite3_errmsg (filelists_xml->priv->db_build));
+}
+
 /**
  * zif_md_filelists_xml_parser_start_element:
  **/
@@ -103,9 +129,10 @@ zif_md_filelists_xml_parser_start_element (GMarkupParseContext *context,
 					   gpointer user_data,
 					   GError **error)
 {
+	gint rc;
 	guint i;
 	ZifMdFilelistsXml *filelists_xml = user_data;
-	ZifString *tmp;
+	sqlite3_stmt *stmt = filelists_xml->priv->stmt_package;
 
 	g_return_if_fail (ZIF_IS_MD_FILELISTS_XML (filelists_xml));
 
@@ -129,18 +156,22 @@ zif_md_filelists_xml_parser_start_element (GMarkupParseContext *context,
 
 			if (g_strcmp0 (element_name, "package") == 0) {
 				filelists_xml->priv->section_list = ZIF_MD_FILELISTS_XML_SECTION_LIST_PACKAGE;
-				filelists_xml->priv->package_temp = ZIF_PACKAGE (zif_package_remote_new ());
-				zif_package_set_compare_mode (filelists_xml->priv->package_temp,
-							      filelists_xml->priv->compare_mode);
-				filelists_xml->priv->array_temp = g_ptr_array_new_with_free_func (g_free);
 				for (i = 0; attribute_names[i] != NULL; i++) {
 					if (g_strcmp0 (attribute_names[i], "pkgid") == 0) {
-						tmp = zif_string_new (attribute_values[i]);
-						zif_package_set_pkgid (filelists_xml->priv->package_temp,
-								       tmp);
-						zif_string_unref (tmp);
+						sqlite3_bind_text (stmt, 1, attribute_values[i], -1, SQLITE_TRANSIENT);
+						break;
 					}
 				}
+
+				/* add the package and save the key for the files */
+				rc = sqlite3_step (stmt);
+				sqlite3_reset (stmt);
+				sqlite3_clear_bindings (stmt);
+				if (rc != SQLITE_DONE) {
+					zif_md_filelists_xml_set_sql_error (filelists_xml, "add package", error);
+					goto out;
+				}
+				filelists_xml->priv->pkgkey_temp = sqlite3_last_insert_rowid (filelists_xml->priv->db_build);
 				goto out;
 			}
 
@@ -211,11 +242,7 @@ zif_md_filelists_xml_parser_end_element (GMarkupParseContext *context, const gch
 
 				/* end of list */
 				if (g_strcmp0 (element_name, "package") == 0) {
-					zif_package_set_files (filelists_xml->priv->package_temp, filelists_xml->priv->array_temp);
-					zif_package_set_provides_files (filelists_xml->priv->package_temp, filelists_xml->priv->array_temp);
-					g_ptr_array_add (filelists_xml->priv->array, filelists_xml->priv->package_temp);
-					filelists_xml->priv->package_temp = NULL;
-					filelists_xml->priv->array_temp = NULL;
+					filelists_xml->priv->pkgkey_temp = 0;
 					filelists_xml->priv->section_list = ZIF_MD_FILELISTS_XML_SECTION_LIST_UNKNOWN;
 					goto out;
 				}
@@ -244,6 +271,40 @@ out:
 	return;
 }
 
+/**
+ * zif_md_filelists_xml_add_file:
+ **/
+static void
+zif_md_filelists_xml_add_file (ZifMdFilelistsXml *filelists_xml,
+			       const gchar *text,
+			       gsize text_len,
+			       GError **error)
+{
+	const gchar *basename;
+	gint rc;
+	gsize dirname_len = 0;
+	sqlite3_stmt *stmt = filelists_xml->priv->stmt_file;
+
+	/* split into a dirname with the trailing slash, and a basename,
+	 * the same as #ZifFileList so lookups can use either */
+	basename = g_strrstr_len (text, text_len, "/");
+	if (basename == NULL) {
+		basename = text;
+	} else {
+		basename++;
+		dirname_len = basename - text;
+	}
+
+	sqlite3_bind_int64 (stmt, 1, filelists_xml->priv->pkgkey_temp);
+	sqlite3_bind_text (stmt, 2, text, dirname_len, SQLITE_TRANSIENT);
+	sqlite3_bind_text (stmt, 3, basename, text_len - dirname_len, SQLITE_TRANSIENT);
+	rc = sqlite3_step (stmt);
+	sqlite3_reset (stmt);
+	sqlite3_clear_bindings (stmt);
+	if (rc != SQLITE_DONE)
+		zif_md_filelists_xml_set_sql_error (filelists_xml, "add file", error);
+}
+
 /**
  * zif_md_filelists_xml_parser_text:
  **/
@@ -266,7 +327,7 @@ zif_md_filelists_xml_parser_text (GMarkupParseContext *context, const gchar *tex
 		}
 		if (filelists_xml->priv->section_list == ZIF_MD_FILELISTS_XML_SECTION_LIST_PACKAGE) {
 			if (filelists_xml->priv->section_list_package == ZIF_MD_FILELISTS_XML_SECTION_LIST_PACKAGE_FILE) {
-				g_ptr_array_add (filelists_xml->priv->array_temp, g_strdup (text));
+				zif_md_filelists_xml_add_file (filelists_xml, text, text_len, error);
 				goto out;
 			};
 			g_warning ("not saving: %s", text);
@@ -280,16 +341,26 @@ out:
 }
 
 /**
- * zif_md_filelists_xml_load:
+ * zif_md_filelists_xml_index_build:
+ *
+ * Streams the XML file into a new index. The index is written to a
+ * temporary file and only moved into place when complete, so other
+ * processes never see a partial index.
  **/
 static gboolean
-zif_md_filelists_xml_load (ZifMd *md, ZifState *state, GError **error)
+zif_md_filelists_xml_index_build (ZifMdFilelistsXml *filelists_xml,
+				  const gchar *filename,
+				  const gchar *filename_index,
+				  const gchar *checksum,
+				  GError **error)
 {
-	const gchar *filename;
-	gboolean ret;
-	gchar *contents = NULL;
-	gsize size;
-	ZifMdFilelistsXml *filelists_xml = ZIF_MD_FILELISTS_XML (md);
+	gboolean ret = FALSE;
+	gchar *buffer = NULL;
+	gchar *filename_tmp = NULL;
+	gint rc;
+	gssize len;
+	GFile *file;
+	GFileInputStream *stream = NULL;
 	GMarkupParseContext *context = NULL;
 	const GMarkupParser gpk_md_filelists_xml_markup_parser = {
 		zif_md_filelists_xml_parser_start_element,
@@ -299,6 +370,108 @@ zif_md_filelists_xml_load (ZifMd *md, ZifState *state, GError **error)
 		NULL /* error */
 	};
 
+	/* create the new database */
+	g_debug ("building index %s from %s", filename_index, filename);
+	filelists_xml->priv->db_build =
+		zif_md_index_build_begin (filename_index,
+					  "CREATE TABLE packages (pkgKey INTEGER PRIMARY KEY, pkgId TEXT);"
+					  "CREATE TABLE filelist (pkgKey INTEGER, dirname TEXT, basename TEXT);",
+					  &filename_tmp,
+					  error);
+	if (filelists_xml->priv->db_build == NULL)
+		goto out;
+	rc = sqlite3_prepare_v2 (filelists_xml->priv->db_build,
+				 "INSERT INTO packages (pkgId) VALUES (?)",
+				 -1, &filelists_xml->priv->stmt_package, NULL);
+	if (rc != SQLITE_OK) {
+		zif_md_filelists_xml_set_sql_error (filelists_xml, "prepare package", error);
+		goto out;
+	}
+	rc = sqlite3_prepare_v2 (filelists_xml->priv->db_build,
+				 "INSERT INTO filelist (pkgKey, dirname, basename) VALUES (?, ?, ?)",
+				 -1, &filelists_xml->priv->stmt_file, NULL);
+	if (rc != SQLITE_OK) {
+		zif_md_filelists_xml_set_sql_error (filelists_xml, "prepare file", error);
+		goto out;
+	}
+
+	/* open the XML file */
+	file = g_file_new_for_path (filename);
+	stream = g_file_read (file, NULL, error);
+	g_object_unref (file);
+	if (stream == NULL)
+		goto out;
+
+	/* parse a chunk at a time so the file is never fully resident */
+	context = g_markup_parse_context_new (&gpk_md_filelists_xml_markup_parser, G_MARKUP_PREFIX_ERROR_POSITION, filelists_xml, NULL);
+	buffer = g_new (gchar, ZIF_MD_FILELISTS_XML_CHUNK_SIZE);
+	do {
+		len = g_input_stream_read (G_INPUT_STREAM (stream),
+					   buffer,
+					   ZIF_MD_FILELISTS_XML_CHUNK_SIZE,
+					   NULL,
+					   error);
+		if (len < 0)
+			goto out;
+		if (len > 0 && !g_markup_parse_context_parse (context, buffer, len, error))
+			goto out;
+	} while (len > 0);
+	if (!g_markup_parse_context_end_parse (context, error))
+		goto out;
+
+	/* create the indexes and move into place */
+	sqlite3_finalize (filelists_xml->priv->stmt_package);
+	sqlite3_finalize (filelists_xml->priv->stmt_file);
+	filelists_xml->priv->stmt_package = NULL;
+	filelists_xml->priv->stmt_file = NULL;
+	ret = zif_md_index_build_finish (filelists_xml->priv->db_build,
+					 filename_tmp,
+					 filename_index,
+					 "CREATE INDEX filelist_path ON filelist (dirname, basename);"
+					 "CREATE INDEX packages_pkgid ON packages (pkgId);"
+					 "CREATE INDEX filelist_pkgkey ON filelist (pkgKey);",
+					 ZIF_MD_FILELISTS_XML_INDEX_VERSION,
+					 checksum,
+					 error);
+	filelists_xml->priv->db_build = NULL;
+out:
+	if (filelists_xml->priv->stmt_package != NULL) {
+		sqlite3_finalize (filelists_xml->priv->stmt_package);
+		filelists_xml->priv->stmt_package = NULL;
+	}
+	if (filelists_xml->priv->stmt_file != NULL) {
+		sqlite3_finalize (filelists_xml->priv->stmt_file);
+		filelists_xml->priv->stmt_file = NULL;
+	}
+	if (filelists_xml->priv->db_build != NULL) {
+		zif_md_index_build_abort (filelists_xml->priv->db_build, filename_tmp);
+		filelists_xml->priv->db_build = NULL;
+	}
+	if (context != NULL)
+		g_markup_parse_context_free (context);
+	if (stream != NULL)
+		g_object_unref (stream);
+	filelists_xml->priv->section = ZIF_MD_FILELISTS_XML_SECTION_UNKNOWN;
+	filelists_xml->priv->section_list = ZIF_MD_FILELISTS_XML_SECTION_LIST_UNKNOWN;
+	filelists_xml->priv->section_list_package = ZIF_MD_FILELISTS_XML_SECTION_LIST_PACKAGE_UNKNOWN;
+	g_free (filename_tmp);
+	g_free (buffer);
+	return ret;
+}
+
+/**
+ * zif_md_filelists_xml_load:
+ **/
+static gboolean
+zif_md_filelists_xml_load (ZifMd *md, ZifState *state, GError **error)
+{
+	const gchar *checksum;
+	const gchar *filename;
+	const gchar *filename_index;
+	gboolean ret;
+	gint rc;
+	ZifMdFilelistsXml *filelists_xml = ZIF_MD_FILELISTS_XML (md);
+
 	g_return_val_if_fail (ZIF_IS_MD_FILELISTS_XML (md), FALSE);
 	g_return_val_if_fail (zif_state_valid (state), FALSE);
 
@@ -306,14 +479,6 @@ zif_md_filelists_xml_load (ZifMd *md, ZifState *state, GError **error)
 	if (filelists_xml->priv->loaded)
 		goto out;
 
-	/* get the compare mode */
-	filelists_xml->priv->compare_mode = zif_config_get_enum (filelists_xml->priv->config,
-								 "pkg_compare_mode",
-								 zif_package_compare_mode_from_string,
-								 error);
-	if (filelists_xml->priv->compare_mode == G_MAXUINT)
-		goto out;
-
 	/* get filename */
 	filename = zif_md_get_filename_uncompressed (md);
 	if (filename == NULL) {
@@ -322,28 +487,39 @@ zif_md_filelists_xml_load (ZifMd *md, ZifState *state, GError **error)
 		goto out;
 	}
 
-	/* open database */
-	g_debug ("filename = %s", filename);
+	/* parse the XML into a new index if the old one is out of date */
 	zif_state_set_allow_cancel (state, FALSE);
-	ret = g_file_get_contents (filename, &contents, &size, error);
-	if (!ret)
-		goto out;
-
-	/* create parser */
-	context = g_markup_parse_context_new (&gpk_md_filelists_xml_markup_parser, G_MARKUP_PREFIX_ERROR_POSITION, filelists_xml, NULL);
+	filename_index = zif_md_get_filename_index (md);
+	checksum = zif_md_get_checksum_uncompressed (md);
+	if (zif_md_index_is_valid (filename_index,
+				   ZIF_MD_FILELISTS_XML_INDEX_VERSION,
+				   checksum)) {
+		g_debug ("reusing index %s", filename_index);
+	} else {
+		ret = zif_md_filelists_xml_index_build (filelists_xml,
+							filename,
+							filename_index,
+							checksum,
+							error);
+		if (!ret)
+			goto out;
+	}
 
-	/* parse data */
-	zif_state_set_allow_cancel (state, FALSE);
-	ret = g_markup_parse_context_parse (context, contents, (gssize) size, error);
-	if (!ret)
+	/* open the index */
+	rc = sqlite3_open_v2 (filename_index,
+			      &filelists_xml->priv->db,
+			      SQLITE_OPEN_READONLY,
+			      NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "can't open database: %s", sqlite3_errmsg (filelists_xml->priv->db));
+		sqlite3_close (filelists_xml->priv->db);
+		filelists_xml->priv->db = NULL;
 		goto out;
-
-	/* we don't need to keep syncing */
+	}
+	zif_sql_stats_attach (filelists_xml->priv->db, "filelists_xml_index", filename_index);
 	filelists_xml->priv->loaded = TRUE;
 out:
-	if (context != NULL)
-		g_markup_parse_context_free (context);
-	g_free (contents);
 	return filelists_xml->priv->loaded;
 }
 
@@ -355,15 +531,13 @@ zif_md_filelists_xml_get_files (ZifMd *md, ZifPackage *package,
 				ZifState *state, GError **error)
 {
 	GPtrArray *array = NULL;
-	GPtrArray *packages;
-	ZifPackage *package_tmp;
-	ZifPackage *package_found = NULL;
-	guint i;
+	GPtrArray *files = NULL;
+	gint rc;
 	gboolean ret;
 	const gchar *pkgid;
-	const gchar *pkgid_tmp;
 	GError *error_local = NULL;
 	ZifState *state_local;
+	sqlite3_stmt *stmt = NULL;
 	ZifMdFilelistsXml *md_filelists = ZIF_MD_FILELISTS_XML (md);
 
 	g_return_val_if_fail (ZIF_IS_MD_FILELISTS_XML (md), NULL);
@@ -403,20 +577,41 @@ zif_md_filelists_xml_get_files (ZifMd *md, ZifPackage *package,
 			goto out;
 	}
 
-	/* search array */
+	/* find the package */
 	pkgid = zif_package_get_pkgid (package);
-	packages = md_filelists->priv->array;
-	for (i = 0; i < packages->len; i++) {
-		package_tmp = g_ptr_array_index (packages, i);
-		pkgid_tmp = zif_package_get_pkgid (package_tmp);
-		if (g_strcmp0 (pkgid, pkgid_tmp) == 0) {
-			package_found = package_tmp;
-			break;
-		}
+	rc = sqlite3_prepare_v2 (md_filelists->priv->db,
+				 "SELECT p.pkgKey, f.dirname, f.basename FROM packages p "
+				 "LEFT JOIN filelist f ON p.pkgKey = f.pkgKey "
+				 "WHERE p.pkgId = ?",
+				 -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "SQL error (failed to get files): %s",
+			     sqlite3_errmsg (md_filelists->priv->db));
+		goto out;
+	}
+	sqlite3_bind_text (stmt, 1, pkgid, -1, SQLITE_STATIC);
+
+	/* packages with no files still return a row */
+	while ((rc = sqlite3_step (stmt)) == SQLITE_ROW) {
+		if (files == NULL)
+			files = g_ptr_array_new_with_free_func (g_free);
+		if (sqlite3_column_type (stmt, 2) == SQLITE_NULL)
+			continue;
+		g_ptr_array_add (files,
+				 g_strconcat ((const gchar *) sqlite3_column_text (stmt, 1),
+					      (const gchar *) sqlite3_column_text (stmt, 2),
+					      NULL));
+	}
+	if (rc != SQLITE_DONE) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "SQL error (failed to get files): %s",
+			     sqlite3_errmsg (md_filelists->priv->db));
+		goto out;
 	}
 
 	/* nothing found */
-	if (package_found == NULL) {
+	if (files == NULL) {
 		g_set_error (error,
 			     ZIF_MD_ERROR,
 			     ZIF_MD_ERROR_FAILED,
@@ -425,20 +620,18 @@ zif_md_filelists_xml_get_files (ZifMd *md, ZifPackage *package,
 		goto out;
 	}
 
-	/* get files */
-	state_local = zif_state_get_child (state);
-	array = zif_package_get_files (package_found,
-				       state_local,
-				       error);
-	if (array == NULL)
-		goto out;
-
 	/* this section done */
 	ret = zif_state_done (state, error);
 	if (!ret)
 		goto out;
 
+	/* success */
+	array = g_ptr_array_ref (files);
 out:
+	if (stmt != NULL)
+		sqlite3_finalize (stmt);
+	if (files != NULL)
+		g_ptr_array_unref (files);
 	return array;
 }
 
@@ -450,16 +643,15 @@ zif_md_filelists_xml_search_file (ZifMd *md, gchar **search,
 				  ZifState *state, GError **error)
 {
 	GPtrArray *array = NULL;
-	GPtrArray *packages;
-	ZifPackage *package;
-	GPtrArray *files = NULL;
-	const gchar *filename;
-	guint i, j, k;
+	GPtrArray *results = NULL;
+	const gchar *basename;
+	gchar *dirname;
+	guint j;
+	gint rc;
 	gboolean ret;
-	const gchar *pkgid;
 	GError *error_local = NULL;
 	ZifState *state_local;
-	ZifState *state_loop;
+	sqlite3_stmt *stmt = NULL;
 	ZifMdFilelistsXml *md_filelists = ZIF_MD_FILELISTS_XML (md);
 
 	g_return_val_if_fail (ZIF_IS_MD_FILELISTS_XML (md), NULL);
@@ -496,54 +688,89 @@ zif_md_filelists_xml_search_file (ZifMd *md, gchar **search,
 			goto out;
 	}
 
-	/* create results array */
-	array = g_ptr_array_new_with_free_func (g_free);
-
-	/* no entries, so shortcut */
-	if (md_filelists->priv->array->len == 0) {
-		ret = zif_state_done (state, error);
-		if (!ret)
-			goto out;
+	/* each lookup uses the path index */
+	rc = sqlite3_prepare_v2 (md_filelists->priv->db,
+				 "SELECT p.pkgId FROM filelist f, packages p "
+				 "WHERE f.dirname = ? AND f.basename = ? "
+				 "AND f.pkgKey = p.pkgKey",
+				 -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "SQL error (failed to search files): %s",
+			     sqlite3_errmsg (md_filelists->priv->db));
 		goto out;
 	}
 
-	/* setup steps */
-	state_local = zif_state_get_child (state);
-	zif_state_set_number_steps (state_local, md_filelists->priv->array->len);
-
-	/* search array */
-	packages = md_filelists->priv->array;
-	for (i = 0; i < packages->len; i++) {
-		package = g_ptr_array_index (packages, i);
-		pkgid = zif_package_get_pkgid (package);
-		state_loop = zif_state_get_child (state_local);
-		files = zif_package_get_files (package, state_loop, NULL);
-		for (k=0; k<files->len; k++) {
-			filename = g_ptr_array_index (files, k);
-			for (j = 0; search[j] != NULL; j++) {
-				if (g_strcmp0 (filename, search[j]) == 0) {
-					g_ptr_array_add (array, g_strdup (pkgid));
-					break;
-				}
-			}
+	/* search each part of the array */
+	results = g_ptr_array_new_with_free_func (g_free);
+	for (j = 0; search[j] != NULL; j++) {
+
+		/* split the same way as when building the index */
+		basename = strrchr (search[j], '/');
+		if (basename == NULL) {
+			dirname = g_strdup ("");
+			basename = search[j];
+		} else {
+			basename++;
+			dirname = g_strndup (search[j], basename - search[j]);
 		}
 
-		/* this section done */
-		ret = zif_state_done (state_local, error);
-		if (!ret)
+		sqlite3_bind_text (stmt, 1, dirname, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text (stmt, 2, basename, -1, SQLITE_STATIC);
+		g_free (dirname);
+		while ((rc = sqlite3_step (stmt)) == SQLITE_ROW) {
+			g_ptr_array_add (results,
+					 g_strdup ((const gchar *) sqlite3_column_text (stmt, 0)));
+		}
+		sqlite3_reset (stmt);
+		sqlite3_clear_bindings (stmt);
+		if (rc != SQLITE_DONE) {
+			g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+				     "SQL error (failed to get keys for %s): %s",
+				     search[j], sqlite3_errmsg (md_filelists->priv->db));
 			goto out;
+		}
 	}
 
 	/* this section done */
 	ret = zif_state_done (state, error);
 	if (!ret)
 		goto out;
+
+	/* success */
+	array = g_ptr_array_ref (results);
 out:
-	if (files != NULL)
-		g_ptr_array_unref (files);
+	if (stmt != NULL)
+		sqlite3_finalize (stmt);
+	if (results != NULL)
+		g_ptr_array_unref (results);
 	return array;
 }
 
+/**
+ * zif_md_filelists_xml_get_memory_usage:
+ **/
+static void
+zif_md_filelists_xml_get_memory_usage (ZifMd *md, ZifMemory *memory)
+{
+	gint highwater = 0;
+	gint used = 0;
+	ZifMdFilelistsXml *md_filelists = ZIF_MD_FILELISTS_XML (md);
+
+	if (md_filelists->priv->db == NULL)
+		return;
+
+	/* only the page cache of the index is resident */
+	sqlite3_db_status (md_filelists->priv->db,
+			   SQLITE_DBSTATUS_CACHE_USED,
+			   &used, &highwater, FALSE);
+	zif_memory_add (memory, ZIF_MEMORY_KIND_MD, used);
+	sqlite3_db_status (md_filelists->priv->db,
+			   SQLITE_DBSTATUS_STMT_USED,
+			   &used, &highwater, FALSE);
+	zif_memory_add (memory, ZIF_MEMORY_KIND_MD, used);
+}
+
 /**
  * zif_md_filelists_xml_finalize:
  **/
@@ -556,8 +783,8 @@ zif_md_filelists_xml_finalize (GObject *object)
 	g_return_if_fail (ZIF_IS_MD_FILELISTS_XML (object));
 	md = ZIF_MD_FILELISTS_XML (object);
 
-	g_ptr_array_unref (md->priv->array);
-	g_object_unref (md->priv->config);
+	if (md->priv->db != NULL)
+		sqlite3_close (md->priv->db);
 
 	G_OBJECT_CLASS (zif_md_filelists_xml_parent_class)->finalize (object);
 }
@@ -575,6 +802,7 @@ zif_md_filelists_xml_class_init (ZifMdFilelistsXmlClass *klass)
 	/* map */
 	md_class->load = zif_md_filelists_xml_load;
 	md_class->unload = zif_md_filelists_xml_unload;
+	md_class->get_memory_usage = zif_md_filelists_xml_get_memory_usage;
 	md_class->search_file = zif_md_filelists_xml_search_file;
 	md_class->get_files = zif_md_filelists_xml_get_files;
 
@@ -588,14 +816,15 @@ static void
 zif_md_filelists_xml_init (ZifMdFilelistsXml *md)
 {
 	md->priv = ZIF_MD_FILELISTS_XML_GET_PRIVATE (md);
-	md->priv->array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	md->priv->loaded = FALSE;
 	md->priv->section = ZIF_MD_FILELISTS_XML_SECTION_UNKNOWN;
 	md->priv->section_list = ZIF_MD_FILELISTS_XML_SECTION_LIST_UNKNOWN;
 	md->priv->section_list_package = ZIF_MD_FILELISTS_XML_SECTION_LIST_PACKAGE_UNKNOWN;
-	md->priv->package_temp = NULL;
-	md->priv->array_temp = NULL;
-	md->priv->config = zif_config_new ();
+	md->priv->db = NULL;
+	md->priv->db_build = NULL;
+	md->priv->stmt_package = NULL;
+	md->priv->stmt_file = NULL;
+	md->priv->pkgkey_temp = 0;
 }
 
 /**
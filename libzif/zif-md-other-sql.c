@@ -41,10 +41,15 @@
 #include "zif-md.h"
 #include "zif-md-other-sql.h"
 #include "zif-package-remote.h"
+#include "zif-sql-stats-private.h"
 #include "zif-state-private.h"
+#include "zif-utils.h"
 
 #define ZIF_MD_OTHER_SQL_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_MD_OTHER_SQL, ZifMdOtherSqlPrivate))
 
+/* how far before the build time to look for changelog entries, in seconds */
+#define ZIF_MD_OTHER_SQL_CHANGELOG_SLACK	(2 * 24 * 60 * 60)
+
 /**
  * ZifMdOtherSqlPrivate:
  *
@@ -54,6 +59,7 @@ struct _ZifMdOtherSqlPrivate
 {
 	gboolean		 loaded;
 	sqlite3			*db;
+	sqlite3_stmt		*stmt_changelog;
 };
 
 G_DEFINE_TYPE (ZifMdOtherSql, zif_md_other_sql, ZIF_TYPE_MD)
@@ -106,162 +112,152 @@ zif_md_other_sql_load (ZifMd *md, ZifState *state, GError **error)
 
 	/* we don't need to keep syncing */
 	sqlite3_exec (other_sql->priv->db, "PRAGMA synchronous=OFF", NULL, NULL, NULL);
+	zif_sql_stats_attach (other_sql->priv->db, "other_db", filename);
 	other_sql->priv->loaded = TRUE;
 out:
 	return other_sql->priv->loaded;
 }
 
 /**
- * zif_md_other_sql_sqlite_create_changelog_cb:
+ * zif_md_other_sql_prepare_changelog:
+ *
+ * The statement is prepared once and then re-used for every pkgId, so
+ * sqlite does not have to parse and plan the join for each package.
  **/
-static gint
-zif_md_other_sql_sqlite_create_changelog_cb (void *data, gint argc, gchar **argv, gchar **col_name)
+static gboolean
+zif_md_other_sql_prepare_changelog (ZifMdOtherSql *md, GError **error)
 {
-	GPtrArray *array = (GPtrArray *) data;
-	ZifChangeset *changeset;
-	gint i;
-	guint64 date = 0;
-	const gchar *author = NULL;
-	const gchar *changelog = NULL;
-	gboolean ret;
-	GError *error = NULL;
-	gchar *endptr = NULL;
-
-	/* get the ID */
-	for (i = 0; i < argc; i++) {
-		if (g_strcmp0 (col_name[i], "date") == 0) {
-			date = g_ascii_strtoull (argv[i], &endptr, 10);
-			if (argv[i] == endptr)
-				g_warning ("failed to parse date %s", argv[i]);
-		} else if (g_strcmp0 (col_name[i], "author") == 0) {
-			author = argv[i];
-		} else if (g_strcmp0 (col_name[i], "changelog") == 0) {
-			changelog = argv[i];
-		} else {
-			g_warning ("unrecognized: %s=%s", col_name[i], argv[i]);
-		}
-	}
+	gint rc;
 
-	/* create new object */
-	changeset = zif_changeset_new ();
-	zif_changeset_set_date (changeset, date);
-	zif_changeset_set_description (changeset, changelog);
-	ret = zif_changeset_parse_header (changeset, author, &error);
-	if (!ret) {
-		g_warning ("failed to parse header: %s", error->message);
-		g_error_free (error);
-		goto out;
+	/* already prepared */
+	if (md->priv->stmt_changelog != NULL)
+		return TRUE;
+
+	rc = sqlite3_prepare_v2 (md->priv->db,
+				 "SELECT changelog.author, "
+				 "changelog.date, "
+				 "changelog.changelog "
+				 "FROM packages "
+				 "JOIN changelog ON changelog.pkgKey = packages.pkgKey "
+				 "WHERE packages.pkgId = ? "
+				 "AND changelog.date >= ? "
+				 "ORDER BY changelog.date DESC "
+				 "LIMIT ?",
+				 -1, &md->priv->stmt_changelog, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "failed to prepare statement: %s",
+			     sqlite3_errmsg (md->priv->db));
+		return FALSE;
 	}
-
-	/* add to the array */
-	g_ptr_array_add (array, g_object_ref (changeset));
-out:
-	g_object_unref (changeset);
-	return 0;
+	return TRUE;
 }
 
 /**
- * zif_md_other_sql_search_pkgkey:
+ * zif_md_other_sql_search_pkgid:
  **/
 static GPtrArray *
-zif_md_other_sql_search_pkgkey (ZifMdOtherSql *md, guint pkgkey,
-			        ZifState *state, GError **error)
+zif_md_other_sql_search_pkgid (ZifMdOtherSql *md,
+			       const gchar *pkgid,
+			       guint64 since,
+			       guint limit,
+			       GError **error)
 {
-	gchar *statement = NULL;
-	gchar *error_msg = NULL;
+	const gchar *author;
+	gboolean ret;
 	gint rc;
-	GPtrArray *array = NULL;
+	GError *error_local = NULL;
+	GPtrArray *array;
+	sqlite3_stmt *statement = md->priv->stmt_changelog;
+	ZifChangeset *changeset;
 
-	g_return_val_if_fail (zif_state_valid (state), NULL);
+	/* bind data, where a negative limit is unlimited */
+	sqlite3_reset (statement);
+	sqlite3_bind_text (statement, 1, pkgid, -1, SQLITE_STATIC);
+	sqlite3_bind_int64 (statement, 2, since);
+	sqlite3_bind_int (statement, 3, limit > 0 ? (gint) limit : -1);
 
 	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	statement = g_strdup_printf ("SELECT author, date, changelog FROM changelog WHERE pkgKey = '%i' ORDER BY date DESC", pkgkey);
-	rc = sqlite3_exec (md->priv->db, statement, zif_md_other_sql_sqlite_create_changelog_cb, array, &error_msg);
-	if (rc != SQLITE_OK) {
+	while ((rc = sqlite3_step (statement)) == SQLITE_ROW) {
+		changeset = zif_changeset_new ();
+		zif_changeset_set_date (changeset, sqlite3_column_int64 (statement, 1));
+		zif_changeset_set_description (changeset,
+					       (const gchar *) sqlite3_column_text (statement, 2));
+		author = (const gchar *) sqlite3_column_text (statement, 0);
+		ret = zif_changeset_parse_header (changeset, author, &error_local);
+		if (!ret) {
+			g_warning ("failed to parse header: %s", error_local->message);
+			g_clear_error (&error_local);
+			g_object_unref (changeset);
+			continue;
+		}
+		g_ptr_array_add (array, changeset);
+	}
+	if (rc != SQLITE_DONE) {
 		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
-			     "SQL error: %s\n", error_msg);
-		sqlite3_free (error_msg);
+			     "SQL error: %s", sqlite3_errmsg (md->priv->db));
 		g_ptr_array_unref (array);
 		array = NULL;
-		goto out;
 	}
-out:
-	g_free (statement);
+	sqlite3_reset (statement);
 	return array;
 }
 
 /**
- * zif_md_other_sql_sqlite_pkgkey_cb:
- **/
-static gint
-zif_md_other_sql_sqlite_pkgkey_cb (void *data, gint argc, gchar **argv, gchar **col_name)
-{
-	gint i;
-	guint pkgkey;
-	gchar *endptr = NULL;
-	GPtrArray *array = (GPtrArray *) data;
-
-	/* get the ID */
-	for (i = 0; i < argc; i++) {
-		if (g_strcmp0 (col_name[i], "pkgKey") == 0) {
-			pkgkey = g_ascii_strtoull (argv[i], &endptr, 10);
-			if (argv[i] == endptr)
-				g_warning ("could not parse pkgKey '%s'", argv[i]);
-			else
-				g_ptr_array_add (array, GUINT_TO_POINTER (pkgkey));
-		} else {
-			g_warning ("unrecognized: %s=%s", col_name[i], argv[i]);
-		}
-	}
-	return 0;
-}
-
-/**
- * zif_md_other_sql_get_changelog:
+ * zif_md_other_sql_get_changelogs:
+ * @md: A #ZifMdOtherSql
+ * @pkgids: (array zero-terminated=1): the package pkgIds
+ * @limit: the maximum number of entries per package, or 0 for all
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Gets the changelogs for many packages at once. This is much faster
+ * than calling zif_md_get_changelog() for each package as the query is
+ * only prepared once.
+ *
+ * Return value: (transfer container): a hash table of pkgId to a
+ * #GPtrArray of #ZifChangeset's, newest first, or %NULL for error.
+ * Every requested pkgId is included, even if it has no entries.
+ *
+ * Since: 0.3.7
  **/
-static GPtrArray *
-zif_md_other_sql_get_changelog (ZifMd *md, const gchar *pkgid,
-			        ZifState *state, GError **error)
+GHashTable *
+zif_md_other_sql_get_changelogs (ZifMdOtherSql *md,
+				 gchar **pkgids,
+				 guint limit,
+				 ZifState *state,
+				 GError **error)
 {
-	gchar *statement = NULL;
-	gchar *error_msg = NULL;
-	gint rc;
 	gboolean ret;
 	GError *error_local = NULL;
-	GPtrArray *array = NULL;
-	GPtrArray *array_tmp = NULL;
-	GPtrArray *pkgkey_array = NULL;
-	guint i, j;
-	guint pkgkey;
+	GHashTable *hash = NULL;
+	GPtrArray *array;
+	guint i;
+	guint len;
 	ZifState *state_local;
-	ZifState *state_loop;
-	ZifChangeset *changeset;
-	ZifMdOtherSql *md_other_sql = ZIF_MD_OTHER_SQL (md);
 
+	g_return_val_if_fail (ZIF_IS_MD_OTHER_SQL (md), NULL);
+	g_return_val_if_fail (pkgids != NULL, NULL);
 	g_return_val_if_fail (zif_state_valid (state), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
 	/* setup steps */
-	if (md_other_sql->priv->loaded) {
-		ret = zif_state_set_steps (state,
-					   error,
-					   80, /* sql query */
-					   20, /* search */
-					   -1);
+	if (md->priv->loaded) {
+		zif_state_set_number_steps (state, 1);
 	} else {
 		ret = zif_state_set_steps (state,
 					   error,
 					   60, /* load */
-					   20, /* sql query */
-					   20, /* search */
+					   40, /* sql query */
 					   -1);
+		if (!ret)
+			goto out;
 	}
-	if (!ret)
-		goto out;
 
 	/* if not already loaded, load */
-	if (!md_other_sql->priv->loaded) {
+	if (!md->priv->loaded) {
 		state_local = zif_state_get_child (state);
-		ret = zif_md_load (md, state_local, &error_local);
+		ret = zif_md_load (ZIF_MD (md), state_local, &error_local);
 		if (!ret) {
 			g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED_TO_LOAD,
 				     "failed to load md_other_sql file: %s", error_local->message);
@@ -275,70 +271,175 @@ zif_md_other_sql_get_changelog (ZifMd *md, const gchar *pkgid,
 			goto out;
 	}
 
-	/* create data struct we can pass to the callback */
-	zif_state_set_allow_cancel (state, FALSE);
-	pkgkey_array = g_ptr_array_new ();
-	statement = g_strdup_printf ("SELECT pkgKey FROM packages WHERE pkgId = '%s'", pkgid);
-	rc = sqlite3_exec (md_other_sql->priv->db, statement, zif_md_other_sql_sqlite_pkgkey_cb, pkgkey_array, &error_msg);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
-			     "SQL error: %s\n", error_msg);
-		sqlite3_free (error_msg);
-		goto out;
-	}
-
-	/* this section done */
-	ret = zif_state_done (state, error);
+	/* prepare the joined query */
+	ret = zif_md_other_sql_prepare_changelog (md, error);
 	if (!ret)
 		goto out;
 
-	/* output array */
-	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-
-	/* resolve each pkgkey to a package */
+	/* run it for each pkgId */
+	zif_state_set_allow_cancel (state, FALSE);
 	state_local = zif_state_get_child (state);
-	if (pkgkey_array->len > 0)
-		zif_state_set_number_steps (state_local, pkgkey_array->len);
-	for (i = 0; i < pkgkey_array->len; i++) {
-		pkgkey = GPOINTER_TO_UINT (g_ptr_array_index (pkgkey_array, i));
-
-		/* get changeset for pkgKey */
-		state_loop = zif_state_get_child (state_local);
-		array_tmp = zif_md_other_sql_search_pkgkey (md_other_sql, pkgkey, state_loop, error);
-		if (array_tmp == NULL) {
-			g_ptr_array_unref (array);
-			array = NULL;
+	len = g_strv_length (pkgids);
+	if (len > 0)
+		zif_state_set_number_steps (state_local, len);
+	hash = g_hash_table_new_full (g_str_hash, g_str_equal,
+				      g_free, (GDestroyNotify) g_ptr_array_unref);
+	for (i = 0; i < len; i++) {
+		array = zif_md_other_sql_search_pkgid (md, pkgids[i], 0, limit, error);
+		if (array == NULL) {
+			g_hash_table_unref (hash);
+			hash = NULL;
 			goto out;
 		}
-
-		/* no results */
-		if (array_tmp->len == 0)
-			g_warning ("no changelog for pkgKey %i", pkgkey);
-		for (j = 0; j < array_tmp->len; j++) {
-			changeset = g_ptr_array_index (array_tmp, j);
-			g_ptr_array_add (array, g_object_ref (changeset));
-		}
-
-		/* clear array */
-		g_ptr_array_unref (array_tmp);
+		g_hash_table_insert (hash, g_strdup (pkgids[i]), array);
 
 		/* this section done */
 		ret = zif_state_done (state_local, error);
-		if (!ret)
+		if (!ret) {
+			g_hash_table_unref (hash);
+			hash = NULL;
 			goto out;
+		}
 	}
 
 	/* this section done */
 	ret = zif_state_done (state, error);
+	if (!ret) {
+		g_hash_table_unref (hash);
+		hash = NULL;
+		goto out;
+	}
+out:
+	return hash;
+}
+
+/**
+ * zif_md_other_sql_get_changelog_since:
+ * @md: A #ZifMdOtherSql
+ * @pkgid: the package pkgId
+ * @evr: the installed version, e.g. "1:1.2.3-4", or %NULL
+ * @since: the unix time of the installed build, or 0
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Gets the changelog entries that are newer than an installed package.
+ * Only the entries dated no more than two days before @since are read
+ * from the database, and the entries are then returned up to and
+ * including the first entry no newer than @evr.
+ *
+ * Return value: (element-type ZifChangeset) (transfer container): the
+ * changesets, newest first, or %NULL for error.
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_md_other_sql_get_changelog_since (ZifMdOtherSql *md,
+				      const gchar *pkgid,
+				      const gchar *evr,
+				      guint64 since,
+				      ZifState *state,
+				      GError **error)
+{
+	const gchar *version;
+	gboolean ret;
+	GError *error_local = NULL;
+	GPtrArray *array = NULL;
+	guint i;
+	ZifChangeset *changeset;
+
+	g_return_val_if_fail (ZIF_IS_MD_OTHER_SQL (md), NULL);
+	g_return_val_if_fail (pkgid != NULL, NULL);
+	g_return_val_if_fail (zif_state_valid (state), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* if not already loaded, load */
+	if (!md->priv->loaded) {
+		ret = zif_md_load (ZIF_MD (md), state, &error_local);
+		if (!ret) {
+			g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED_TO_LOAD,
+				     "failed to load md_other_sql file: %s", error_local->message);
+			g_error_free (error_local);
+			goto out;
+		}
+	}
+
+	/* prepare the joined query */
+	ret = zif_md_other_sql_prepare_changelog (md, error);
 	if (!ret)
 		goto out;
+
+	/* changelog entries only have the granularity of a day, and
+	 * may be dated before the package was built */
+	if (since > ZIF_MD_OTHER_SQL_CHANGELOG_SLACK)
+		since -= ZIF_MD_OTHER_SQL_CHANGELOG_SLACK;
+	else
+		since = 0;
+	array = zif_md_other_sql_search_pkgid (md, pkgid, since, 0, error);
+	if (array == NULL)
+		goto out;
+
+	/* drop anything older than the installed version */
+	for (i = 0; evr != NULL && i < array->len; i++) {
+		changeset = g_ptr_array_index (array, i);
+		version = zif_changeset_get_version (changeset);
+		if (version != NULL && zif_compare_evr (evr, version) >= 0) {
+			g_ptr_array_set_size (array, i + 1);
+			break;
+		}
+	}
 out:
-	g_free (statement);
-	if (pkgkey_array != NULL)
-		g_ptr_array_unref (pkgkey_array);
 	return array;
 }
 
+/**
+ * zif_md_other_sql_get_changelog:
+ **/
+static GPtrArray *
+zif_md_other_sql_get_changelog (ZifMd *md, const gchar *pkgid,
+			        ZifState *state, GError **error)
+{
+	gchar *pkgids[] = { NULL, NULL };
+	GHashTable *hash;
+	GPtrArray *array = NULL;
+
+	g_return_val_if_fail (zif_state_valid (state), NULL);
+
+	/* just a batch of one */
+	pkgids[0] = (gchar *) pkgid;
+	hash = zif_md_other_sql_get_changelogs (ZIF_MD_OTHER_SQL (md),
+						pkgids, 0, state, error);
+	if (hash == NULL)
+		goto out;
+	array = g_ptr_array_ref (g_hash_table_lookup (hash, pkgid));
+	g_hash_table_unref (hash);
+out:
+	return array;
+}
+
+/**
+ * zif_md_other_sql_get_memory_usage:
+ **/
+static void
+zif_md_other_sql_get_memory_usage (ZifMd *md, ZifMemory *memory)
+{
+	gint highwater = 0;
+	gint used = 0;
+	ZifMdOtherSql *md_other_sql = ZIF_MD_OTHER_SQL (md);
+
+	if (md_other_sql->priv->db == NULL)
+		return;
+
+	/* page cache and prepared statements */
+	sqlite3_db_status (md_other_sql->priv->db,
+			   SQLITE_DBSTATUS_CACHE_USED,
+			   &used, &highwater, FALSE);
+	zif_memory_add (memory, ZIF_MEMORY_KIND_MD, used);
+	sqlite3_db_status (md_other_sql->priv->db,
+			   SQLITE_DBSTATUS_STMT_USED,
+			   &used, &highwater, FALSE);
+	zif_memory_add (memory, ZIF_MEMORY_KIND_MD, used);
+}
+
 /**
  * zif_md_other_sql_finalize:
  **/
@@ -351,6 +452,8 @@ zif_md_other_sql_finalize (GObject *object)
 	g_return_if_fail (ZIF_IS_MD_OTHER_SQL (object));
 	md = ZIF_MD_OTHER_SQL (object);
 
+	if (md->priv->stmt_changelog != NULL)
+		sqlite3_finalize (md->priv->stmt_changelog);
 	sqlite3_close (md->priv->db);
 
 	G_OBJECT_CLASS (zif_md_other_sql_parent_class)->finalize (object);
@@ -369,6 +472,7 @@ zif_md_other_sql_class_init (ZifMdOtherSqlClass *klass)
 	/* map */
 	md_class->load = zif_md_other_sql_load;
 	md_class->unload = zif_md_other_sql_unload;
+	md_class->get_memory_usage = zif_md_other_sql_get_memory_usage;
 	md_class->get_changelog = zif_md_other_sql_get_changelog;
 	g_type_class_add_private (klass, sizeof (ZifMdOtherSqlPrivate));
 }
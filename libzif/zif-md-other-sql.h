@@ -61,6 +61,17 @@ struct _ZifMdOtherSqlClass
 
 GType		 zif_md_other_sql_get_type		(void);
 ZifMd		*zif_md_other_sql_new			(void);
+GHashTable	*zif_md_other_sql_get_changelogs	(ZifMdOtherSql		*md,
+							 gchar			**pkgids,
+							 guint			 limit,
+							 ZifState		*state,
+							 GError			**error);
+GPtrArray	*zif_md_other_sql_get_changelog_since	(ZifMdOtherSql		*md,
+							 const gchar		*pkgid,
+							 const gchar		*evr,
+							 guint64		 since,
+							 ZifState		*state,
+							 GError			**error);
 
 G_END_DECLS
 
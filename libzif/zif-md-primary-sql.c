@@ -41,8 +41,10 @@
 #include "zif-depend-private.h"
 #include "zif-md.h"
 #include "zif-md-primary-sql.h"
+#include "zif-md-primary-sql-private.h"
 #include "zif-package-array-private.h"
 #include "zif-package-remote.h"
+#include "zif-sql-stats-private.h"
 #include "zif-state-private.h"
 #include "zif-utils-private.h"
 
@@ -101,51 +103,51 @@ zif_md_primary_sql_sqlite_name_depends_cb (void *data,
 }
 
 /**
- * zif_md_primary_sql_load:
+ * zif_md_primary_sql_load_from_file:
+ * @md: A #ZifMdPrimarySql
+ * @filename: A primary database, e.g. "/var/cache/zif/fedora/primary.sqlite"
+ * @error: A #GError, or %NULL
+ *
+ * Opens a database with the primary schema without checking it against
+ * the repomd. This is used to query an index built from primary.xml.
+ *
+ * Return value: %TRUE for success, %FALSE otherwise
  **/
-static gboolean
-zif_md_primary_sql_load (ZifMd *md, ZifState *state, GError **error)
+gboolean
+zif_md_primary_sql_load_from_file (ZifMdPrimarySql *md,
+				   const gchar *filename,
+				   GError **error)
 {
-	const gchar *filename;
 	const gchar *statement;
 	gchar *error_msg = NULL;
 	gint rc;
-	ZifMdPrimarySql *primary_sql = ZIF_MD_PRIMARY_SQL (md);
 
 	g_return_val_if_fail (ZIF_IS_MD_PRIMARY_SQL (md), FALSE);
-	g_return_val_if_fail (zif_state_valid (state), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
 
 	/* already loaded */
-	if (primary_sql->priv->loaded)
+	if (md->priv->loaded)
 		goto out;
 
-	/* get filename */
-	filename = zif_md_get_filename_uncompressed (md);
-	if (filename == NULL) {
-		g_set_error_literal (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED,
-				     "failed to get filename for primary_sql");
-		goto out;
-	}
-
 	/* open database */
-	zif_state_set_allow_cancel (state, FALSE);
 	g_debug ("filename = %s", filename);
-	rc = sqlite3_open (filename, &primary_sql->priv->db);
+	rc = sqlite3_open (filename, &md->priv->db);
 	if (rc != 0) {
-		g_warning ("Can't open database: %s\n", sqlite3_errmsg (primary_sql->priv->db));
+		g_warning ("Can't open database: %s\n", sqlite3_errmsg (md->priv->db));
 		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
-			     "can't open database: %s", sqlite3_errmsg (primary_sql->priv->db));
+			     "can't open database: %s", sqlite3_errmsg (md->priv->db));
 		goto out;
 	}
 
 	/* we don't need to keep syncing */
-	sqlite3_exec (primary_sql->priv->db, "PRAGMA synchronous=OFF;", NULL, NULL, NULL);
+	sqlite3_exec (md->priv->db, "PRAGMA synchronous=OFF;", NULL, NULL, NULL);
+	zif_sql_stats_attach (md->priv->db, "primary_db", filename);
 
 	/* populate the obsoletes name cache */
 	statement = "SELECT name FROM obsoletes;";
-	rc = sqlite3_exec (primary_sql->priv->db, statement,
+	rc = sqlite3_exec (md->priv->db, statement,
 			   zif_md_primary_sql_sqlite_name_depends_cb,
-			   primary_sql->priv->obsoletes_name,
+			   md->priv->obsoletes_name,
 			   &error_msg);
 	if (rc != SQLITE_OK) {
 		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
@@ -156,9 +158,9 @@ zif_md_primary_sql_load (ZifMd *md, ZifState *state, GError **error)
 
 	/* populate the conflicts name cache */
 	statement = "SELECT name FROM conflicts;";
-	rc = sqlite3_exec (primary_sql->priv->db, statement,
+	rc = sqlite3_exec (md->priv->db, statement,
 			   zif_md_primary_sql_sqlite_name_depends_cb,
-			   primary_sql->priv->conflicts_name,
+			   md->priv->conflicts_name,
 			   &error_msg);
 	if (rc != SQLITE_OK) {
 		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
@@ -167,9 +169,35 @@ zif_md_primary_sql_load (ZifMd *md, ZifState *state, GError **error)
 		goto out;
 	}
 
-	primary_sql->priv->loaded = TRUE;
+	md->priv->loaded = TRUE;
 out:
-	return primary_sql->priv->loaded;
+	return md->priv->loaded;
+}
+
+/**
+ * zif_md_primary_sql_load:
+ **/
+static gboolean
+zif_md_primary_sql_load (ZifMd *md, ZifState *state, GError **error)
+{
+	const gchar *filename;
+
+	g_return_val_if_fail (ZIF_IS_MD_PRIMARY_SQL (md), FALSE);
+	g_return_val_if_fail (zif_state_valid (state), FALSE);
+
+	/* get filename */
+	filename = zif_md_get_filename_uncompressed (md);
+	if (filename == NULL) {
+		g_set_error_literal (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED,
+				     "failed to get filename for primary_sql");
+		return FALSE;
+	}
+
+	/* open database */
+	zif_state_set_allow_cancel (state, FALSE);
+	return zif_md_primary_sql_load_from_file (ZIF_MD_PRIMARY_SQL (md),
+						  filename,
+						  error);
 }
 
 /**
@@ -1049,6 +1077,34 @@ zif_md_primary_sql_get_packages (ZifMd *md, ZifState *state, GError **error)
 	return array;
 }
 
+/**
+ * zif_md_primary_sql_get_memory_usage:
+ **/
+static void
+zif_md_primary_sql_get_memory_usage (ZifMd *md, ZifMemory *memory)
+{
+	gint highwater = 0;
+	gint used = 0;
+	ZifMdPrimarySql *md_primary_sql = ZIF_MD_PRIMARY_SQL (md);
+
+	if (md_primary_sql->priv->db == NULL)
+		return;
+
+	/* page cache and prepared statements */
+	sqlite3_db_status (md_primary_sql->priv->db,
+			   SQLITE_DBSTATUS_CACHE_USED,
+			   &used, &highwater, FALSE);
+	zif_memory_add (memory, ZIF_MEMORY_KIND_MD, used);
+	sqlite3_db_status (md_primary_sql->priv->db,
+			   SQLITE_DBSTATUS_STMT_USED,
+			   &used, &highwater, FALSE);
+	zif_memory_add (memory, ZIF_MEMORY_KIND_MD, used);
+
+	/* depend name lookups */
+	zif_memory_add_hash_table (memory, md_primary_sql->priv->conflicts_name);
+	zif_memory_add_hash_table (memory, md_primary_sql->priv->obsoletes_name);
+}
+
 /**
  * zif_md_primary_sql_finalize:
  **/
@@ -1082,6 +1138,7 @@ zif_md_primary_sql_class_init (ZifMdPrimarySqlClass *klass)
 	/* map */
 	md_class->load = zif_md_primary_sql_load;
 	md_class->unload = zif_md_primary_sql_unload;
+	md_class->get_memory_usage = zif_md_primary_sql_get_memory_usage;
 	md_class->search_name = zif_md_primary_sql_search_name;
 	md_class->search_details = zif_md_primary_sql_search_details;
 	md_class->search_group = zif_md_primary_sql_search_group;
@@ -25,6 +25,10 @@
  *
  * Provide access to the primary_xml repo metadata.
  * This object is a subclass of #ZifMd
+ *
+ * The XML data is only parsed once, into an on-disk SQLite index with
+ * the same schema as the primary.sqlite metadata, and all the queries
+ * are then done using a #ZifMdPrimarySql on that index.
  */
 
 typedef enum {
@@ -52,6 +56,27 @@ typedef enum {
 	ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_UNKNOWN
 } ZifMdPrimaryXmlSectionPackage;
 
+/* parameters of the package insert statement */
+typedef enum {
+	ZIF_MD_PRIMARY_XML_COLUMN_PKGKEY = 1,
+	ZIF_MD_PRIMARY_XML_COLUMN_PKGID,
+	ZIF_MD_PRIMARY_XML_COLUMN_NAME,
+	ZIF_MD_PRIMARY_XML_COLUMN_ARCH,
+	ZIF_MD_PRIMARY_XML_COLUMN_VERSION,
+	ZIF_MD_PRIMARY_XML_COLUMN_EPOCH,
+	ZIF_MD_PRIMARY_XML_COLUMN_RELEASE,
+	ZIF_MD_PRIMARY_XML_COLUMN_SUMMARY,
+	ZIF_MD_PRIMARY_XML_COLUMN_DESCRIPTION,
+	ZIF_MD_PRIMARY_XML_COLUMN_URL,
+	ZIF_MD_PRIMARY_XML_COLUMN_TIME_FILE,
+	ZIF_MD_PRIMARY_XML_COLUMN_LICENSE,
+	ZIF_MD_PRIMARY_XML_COLUMN_GROUP,
+	ZIF_MD_PRIMARY_XML_COLUMN_SOURCERPM,
+	ZIF_MD_PRIMARY_XML_COLUMN_SIZE_PACKAGE,
+	ZIF_MD_PRIMARY_XML_COLUMN_LOCATION_HREF,
+	ZIF_MD_PRIMARY_XML_COLUMN_UNKNOWN
+} ZifMdPrimaryXmlColumn;
+
 #ifdef HAVE_CONFIG_H
 #  include <config.h>
 #endif
@@ -62,19 +87,21 @@ typedef enum {
 #include <sqlite3.h>
 #include <gio/gio.h>
 
-#include "zif-config.h"
-#include "zif-depend-private.h"
 #include "zif-md.h"
+#include "zif-md-private.h"
+#include "zif-md-primary-sql.h"
+#include "zif-md-primary-sql-private.h"
 #include "zif-md-primary-xml.h"
-#include "zif-object-array.h"
-#include "zif-package-private.h"
-#include "zif-package-remote.h"
 #include "zif-state-private.h"
-#include "zif-string.h"
-#include "zif-utils-private.h"
 
 #define ZIF_MD_PRIMARY_XML_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_MD_PRIMARY_XML, ZifMdPrimaryXmlPrivate))
 
+/* bump this if the index schema changes */
+#define ZIF_MD_PRIMARY_XML_INDEX_VERSION	1
+
+/* the size of each chunk passed to the XML parser */
+#define ZIF_MD_PRIMARY_XML_CHUNK_SIZE		(32 * 1024)
+
 /**
  * ZifMdPrimaryXmlPrivate:
  *
@@ -85,19 +112,14 @@ struct _ZifMdPrimaryXmlPrivate
 	gboolean			 loaded;
 	ZifMdPrimaryXmlSection		 section;
 	ZifMdPrimaryXmlSectionPackage	 section_package;
-	ZifPackage			*package_temp;
-	GPtrArray			*package_provides_temp;
-	GPtrArray			*package_requires_temp;
-	GPtrArray			*package_obsoletes_temp;
-	GPtrArray			*package_conflicts_temp;
-	GPtrArray			*array;
-	gchar				*package_name_temp;
-	gchar				*package_arch_temp;
-	gchar				*package_version_temp;
-	gchar				*package_release_temp;
-	guint				 package_epoch_temp;
-	ZifConfig			*config;
-	ZifPackageCompareMode		 compare_mode;
+	ZifMd				*md_sql;
+	sqlite3				*db_build;
+	sqlite3_stmt			*stmt_package;
+	sqlite3_stmt			*stmt_provides;
+	sqlite3_stmt			*stmt_requires;
+	sqlite3_stmt			*stmt_obsoletes;
+	sqlite3_stmt			*stmt_conflicts;
+	sqlite3_int64			 pkgkey_temp;
 };
 
 G_DEFINE_TYPE (ZifMdPrimaryXml, zif_md_primary_xml, ZIF_TYPE_MD)
@@ -112,6 +134,63 @@ zif_md_primary_xml_unload (ZifMd *md, ZifState *state, GError **error)
 	return ret;
 }
 
+/**
+ * zif_md_primary_xml_set_sql_error:
+ **/
+static void
+zif_md_primary_xml_set_sql_error (ZifMdPrimaryXml *primary_xml,
+				  const gchar *action,
+				  GError **error)
+{
+	g_set_error (error,
+		     ZIF_MD_ERROR,
+		     ZIF_MD_ERROR_BAD_SQL,
+		     "SQL error (failed to %s): %s",
+		     action,
+		     sqlite3_errmsg (primary_xml->priv->db_build));
+}
+
+/**
+ * zif_md_primary_xml_add_depend:
+ **/
+static void
+zif_md_primary_xml_add_depend (ZifMdPrimaryXml *primary_xml,
+			       sqlite3_stmt *stmt,
+			       const gchar **attribute_names,
+			       const gchar **attribute_values,
+			       gboolean skip_rpmlib,
+			       GError **error)
+{
+	gint rc;
+	guint i;
+
+	for (i = 0; attribute_names[i] != NULL; i++) {
+		if (g_strcmp0 (attribute_names[i], "name") == 0) {
+			/* some repos are broken */
+			if (skip_rpmlib &&
+			    g_str_has_prefix (attribute_values[i], "rpmlib(")) {
+				sqlite3_clear_bindings (stmt);
+				return;
+			}
+			sqlite3_bind_text (stmt, 1, attribute_values[i], -1, SQLITE_STATIC);
+		} else if (g_strcmp0 (attribute_names[i], "flags") == 0) {
+			sqlite3_bind_text (stmt, 2, attribute_values[i], -1, SQLITE_STATIC);
+		} else if (g_strcmp0 (attribute_names[i], "epoch") == 0) {
+			sqlite3_bind_text (stmt, 3, attribute_values[i], -1, SQLITE_STATIC);
+		} else if (g_strcmp0 (attribute_names[i], "ver") == 0) {
+			sqlite3_bind_text (stmt, 4, attribute_values[i], -1, SQLITE_STATIC);
+		} else if (g_strcmp0 (attribute_names[i], "rel") == 0) {
+			sqlite3_bind_text (stmt, 5, attribute_values[i], -1, SQLITE_STATIC);
+		}
+	}
+	sqlite3_bind_int64 (stmt, 6, primary_xml->priv->pkgkey_temp);
+	rc = sqlite3_step (stmt);
+	sqlite3_reset (stmt);
+	sqlite3_clear_bindings (stmt);
+	if (rc != SQLITE_DONE)
+		zif_md_primary_xml_set_sql_error (primary_xml, "add depend", error);
+}
+
 /**
  * zif_md_primary_xml_parser_start_element:
  **/
@@ -121,9 +200,8 @@ zif_md_primary_xml_parser_start_element (GMarkupParseContext *context, const gch
 					gpointer user_data, GError **error)
 {
 	guint i;
-	ZifDepend *depend = NULL;
-	ZifString *tmp;
 	ZifMdPrimaryXml *primary_xml = user_data;
+	sqlite3_stmt *stmt = primary_xml->priv->stmt_package;
 
 	g_return_if_fail (ZIF_IS_MD_PRIMARY_XML (primary_xml));
 
@@ -137,13 +215,14 @@ zif_md_primary_xml_parser_start_element (GMarkupParseContext *context, const gch
 		/* start of update */
 		if (g_strcmp0 (element_name, "package") == 0) {
 			primary_xml->priv->section = ZIF_MD_PRIMARY_XML_SECTION_PACKAGE;
-			primary_xml->priv->package_temp = ZIF_PACKAGE (zif_package_remote_new ());
-			primary_xml->priv->package_provides_temp = zif_object_array_new ();
-			primary_xml->priv->package_requires_temp = zif_object_array_new ();
-			primary_xml->priv->package_obsoletes_temp = zif_object_array_new ();
-			primary_xml->priv->package_conflicts_temp = zif_object_array_new ();
-			zif_package_set_compare_mode (primary_xml->priv->package_temp,
-						      primary_xml->priv->compare_mode);
+			primary_xml->priv->pkgkey_temp++;
+
+			/* not every package sets every value */
+			for (i = ZIF_MD_PRIMARY_XML_COLUMN_PKGID; i < ZIF_MD_PRIMARY_XML_COLUMN_UNKNOWN; i++)
+				sqlite3_bind_text (stmt, i, "", 0, SQLITE_STATIC);
+			sqlite3_bind_text (stmt, ZIF_MD_PRIMARY_XML_COLUMN_EPOCH, "0", 1, SQLITE_STATIC);
+			sqlite3_bind_int64 (stmt, ZIF_MD_PRIMARY_XML_COLUMN_TIME_FILE, 0);
+			sqlite3_bind_int64 (stmt, ZIF_MD_PRIMARY_XML_COLUMN_SIZE_PACKAGE, 0);
 			goto out;
 		}
 
@@ -197,11 +276,14 @@ zif_md_primary_xml_parser_start_element (GMarkupParseContext *context, const gch
 				primary_xml->priv->section_package = ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_VERSION;
 				for (i = 0; attribute_names[i] != NULL; i++) {
 					if (g_strcmp0 (attribute_names[i], "rel") == 0) {
-						primary_xml->priv->package_release_temp = g_strdup (attribute_values[i]);
+						sqlite3_bind_text (stmt, ZIF_MD_PRIMARY_XML_COLUMN_RELEASE,
+								   attribute_values[i], -1, SQLITE_TRANSIENT);
 					} else if (g_strcmp0 (attribute_names[i], "epoch") == 0) {
-						primary_xml->priv->package_epoch_temp = atoi (attribute_values[i]);
+						sqlite3_bind_text (stmt, ZIF_MD_PRIMARY_XML_COLUMN_EPOCH,
+								   attribute_values[i], -1, SQLITE_TRANSIENT);
 					} else if (g_strcmp0 (attribute_names[i], "ver") == 0) {
-						primary_xml->priv->package_version_temp = g_strdup (attribute_values[i]);
+						sqlite3_bind_text (stmt, ZIF_MD_PRIMARY_XML_COLUMN_VERSION,
+								   attribute_values[i], -1, SQLITE_TRANSIENT);
 					}
 				}
 				goto out;
@@ -210,7 +292,8 @@ zif_md_primary_xml_parser_start_element (GMarkupParseContext *context, const gch
 				primary_xml->priv->section_package = ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_SIZE;
 				for (i = 0; attribute_names[i] != NULL; i++) {
 					if (g_strcmp0 (attribute_names[i], "package") == 0) {
-						zif_package_set_size (primary_xml->priv->package_temp, atoi (attribute_values[i]));
+						sqlite3_bind_int64 (stmt, ZIF_MD_PRIMARY_XML_COLUMN_SIZE_PACKAGE,
+								    g_ascii_strtoull (attribute_values[i], NULL, 10));
 					}
 				}
 				goto out;
@@ -219,7 +302,8 @@ zif_md_primary_xml_parser_start_element (GMarkupParseContext *context, const gch
 				primary_xml->priv->section_package = ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_VERSION;
 				for (i = 0; attribute_names[i] != NULL; i++) {
 					if (g_strcmp0 (attribute_names[i], "file") == 0) {
-						zif_package_set_time_file (primary_xml->priv->package_temp, atoi (attribute_values[i]));
+						sqlite3_bind_int64 (stmt, ZIF_MD_PRIMARY_XML_COLUMN_TIME_FILE,
+								    g_ascii_strtoull (attribute_values[i], NULL, 10));
 					}
 				}
 				goto out;
@@ -228,10 +312,8 @@ zif_md_primary_xml_parser_start_element (GMarkupParseContext *context, const gch
 				primary_xml->priv->section_package = ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_LOCATION;
 				for (i = 0; attribute_names[i] != NULL; i++) {
 					if (g_strcmp0 (attribute_names[i], "href") == 0) {
-						tmp = zif_string_new (attribute_values[i]);
-						zif_package_set_location_href (primary_xml->priv->package_temp,
-									       tmp);
-						zif_string_unref (tmp);
+						sqlite3_bind_text (stmt, ZIF_MD_PRIMARY_XML_COLUMN_LOCATION_HREF,
+								   attribute_values[i], -1, SQLITE_TRANSIENT);
 					}
 				}
 				goto out;
@@ -265,40 +347,42 @@ zif_md_primary_xml_parser_start_element (GMarkupParseContext *context, const gch
 
 		} else if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_REQUIRES) {
 			if (g_strcmp0 (element_name, "rpm:entry") == 0) {
-				depend = zif_depend_new_from_data (attribute_names,
-								   attribute_values);
-				/* some repos are broken */
-				if (!g_str_has_prefix (zif_depend_get_name (depend), "rpmlib(")) {
-					g_ptr_array_add (primary_xml->priv->package_requires_temp,
-							 g_object_ref (depend));
-				}
+				zif_md_primary_xml_add_depend (primary_xml,
+							       primary_xml->priv->stmt_requires,
+							       attribute_names,
+							       attribute_values,
+							       TRUE,
+							       error);
 				goto out;
 			}
 		} else if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_OBSOLETES) {
 			if (g_strcmp0 (element_name, "rpm:entry") == 0) {
-				depend = zif_depend_new_from_data (attribute_names,
-								   attribute_values);
-				g_ptr_array_add (primary_xml->priv->package_obsoletes_temp,
-						 g_object_ref (depend));
+				zif_md_primary_xml_add_depend (primary_xml,
+							       primary_xml->priv->stmt_obsoletes,
+							       attribute_names,
+							       attribute_values,
+							       FALSE,
+							       error);
 				goto out;
 			}
 		} else if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_CONFLICTS) {
 			if (g_strcmp0 (element_name, "rpm:entry") == 0) {
-				depend = zif_depend_new_from_data (attribute_names,
-								   attribute_values);
-				g_ptr_array_add (primary_xml->priv->package_conflicts_temp,
-						 g_object_ref (depend));
+				zif_md_primary_xml_add_depend (primary_xml,
+							       primary_xml->priv->stmt_conflicts,
+							       attribute_names,
+							       attribute_values,
+							       FALSE,
+							       error);
 				goto out;
 			}
 		} else if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_PROVIDES) {
 			if (g_strcmp0 (element_name, "rpm:entry") == 0) {
-				depend = zif_depend_new_from_data (attribute_names,
-								   attribute_values);
-				/* some repos are broken */
-				if (!g_str_has_prefix (zif_depend_get_name (depend), "rpmlib(")) {
-					g_ptr_array_add (primary_xml->priv->package_provides_temp,
-							 g_object_ref (depend));
-				}
+				zif_md_primary_xml_add_depend (primary_xml,
+							       primary_xml->priv->stmt_provides,
+							       attribute_names,
+							       attribute_values,
+							       TRUE,
+							       error);
 				goto out;
 			}
 			goto out;
@@ -308,8 +392,6 @@ zif_md_primary_xml_parser_start_element (GMarkupParseContext *context, const gch
 
 	g_warning ("unhandled base tag: %s", element_name);
 out:
-	if (depend != NULL)
-		g_object_unref (depend);
 	return;
 }
 
@@ -320,11 +402,9 @@ static void
 zif_md_primary_xml_parser_end_element (GMarkupParseContext *context, const gchar *element_name,
 				      gpointer user_data, GError **error)
 {
+	gint rc;
 	ZifMdPrimaryXml *primary_xml = user_data;
-	gchar *package_id = NULL;
-	GError *error_local = NULL;
-	gboolean ret;
-	ZifStore *store;
+	sqlite3_stmt *stmt = primary_xml->priv->stmt_package;
 
 	/* no element */
 	if (primary_xml->priv->section == ZIF_MD_PRIMARY_XML_SECTION_UNKNOWN) {
@@ -341,48 +421,14 @@ zif_md_primary_xml_parser_end_element (GMarkupParseContext *context, const gchar
 		if (g_strcmp0 (element_name, "package") == 0) {
 			primary_xml->priv->section = ZIF_MD_PRIMARY_XML_SECTION_UNKNOWN;
 
-			/* add to array */
-			package_id = zif_package_id_from_nevra (primary_xml->priv->package_name_temp,
-								primary_xml->priv->package_epoch_temp,
-								primary_xml->priv->package_version_temp,
-								primary_xml->priv->package_release_temp,
-								primary_xml->priv->package_arch_temp,
-								zif_md_get_id (ZIF_MD (primary_xml)));
-			ret = zif_package_set_id (primary_xml->priv->package_temp, package_id, &error_local);
-			if (ret) {
-				g_ptr_array_add (primary_xml->priv->array,
-						 primary_xml->priv->package_temp);
-				zif_package_set_provides (primary_xml->priv->package_temp,
-							  primary_xml->priv->package_provides_temp);
-				zif_package_set_requires (primary_xml->priv->package_temp,
-							  primary_xml->priv->package_requires_temp);
-				zif_package_set_obsoletes (primary_xml->priv->package_temp,
-							   primary_xml->priv->package_obsoletes_temp);
-				zif_package_set_conflicts (primary_xml->priv->package_temp,
-							   primary_xml->priv->package_conflicts_temp);
-			} else {
-				g_warning ("failed to set %s: %s", package_id, error_local->message);
-				g_object_unref (primary_xml->priv->package_temp);
-				g_error_free (error_local);
-				goto out;
-			}
-
-			/* set the store the package came from */
-			store = zif_md_get_store (ZIF_MD (primary_xml));
-			if (store != NULL) {
-				zif_package_remote_set_store_remote (ZIF_PACKAGE_REMOTE (primary_xml->priv->package_temp),
-								     ZIF_STORE_REMOTE (store));
-			}
-
-			primary_xml->priv->package_temp = NULL;
-			g_free (primary_xml->priv->package_name_temp);
-			g_free (primary_xml->priv->package_version_temp);
-			g_free (primary_xml->priv->package_release_temp);
-			g_free (primary_xml->priv->package_arch_temp);
-			g_ptr_array_unref (primary_xml->priv->package_provides_temp);
-			g_ptr_array_unref (primary_xml->priv->package_requires_temp);
-			g_ptr_array_unref (primary_xml->priv->package_obsoletes_temp);
-			g_ptr_array_unref (primary_xml->priv->package_conflicts_temp);
+			/* add to index */
+			sqlite3_bind_int64 (stmt, ZIF_MD_PRIMARY_XML_COLUMN_PKGKEY,
+					    primary_xml->priv->pkgkey_temp);
+			rc = sqlite3_step (stmt);
+			sqlite3_reset (stmt);
+			sqlite3_clear_bindings (stmt);
+			if (rc != SQLITE_DONE)
+				zif_md_primary_xml_set_sql_error (primary_xml, "add package", error);
 			goto out;
 		}
 
@@ -424,10 +470,36 @@ zif_md_primary_xml_parser_end_element (GMarkupParseContext *context, const gchar
 
 	g_warning ("unhandled end tag: %s", element_name);
 out:
-	g_free (package_id);
 	return;
 }
 
+/**
+ * zif_md_primary_xml_section_to_column:
+ **/
+static ZifMdPrimaryXmlColumn
+zif_md_primary_xml_section_to_column (ZifMdPrimaryXmlSectionPackage section)
+{
+	if (section == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_NAME)
+		return ZIF_MD_PRIMARY_XML_COLUMN_NAME;
+	if (section == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_ARCH)
+		return ZIF_MD_PRIMARY_XML_COLUMN_ARCH;
+	if (section == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_SUMMARY)
+		return ZIF_MD_PRIMARY_XML_COLUMN_SUMMARY;
+	if (section == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_DESCRIPTION)
+		return ZIF_MD_PRIMARY_XML_COLUMN_DESCRIPTION;
+	if (section == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_URL)
+		return ZIF_MD_PRIMARY_XML_COLUMN_URL;
+	if (section == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_GROUP)
+		return ZIF_MD_PRIMARY_XML_COLUMN_GROUP;
+	if (section == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_SOURCERPM)
+		return ZIF_MD_PRIMARY_XML_COLUMN_SOURCERPM;
+	if (section == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_LICENCE)
+		return ZIF_MD_PRIMARY_XML_COLUMN_LICENSE;
+	if (section == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_CHECKSUM)
+		return ZIF_MD_PRIMARY_XML_COLUMN_PKGID;
+	return ZIF_MD_PRIMARY_XML_COLUMN_UNKNOWN;
+}
+
 /**
  * zif_md_primary_xml_parser_text:
  **/
@@ -437,7 +509,7 @@ zif_md_primary_xml_parser_text (GMarkupParseContext *context, const gchar *text,
 
 {
 	ZifMdPrimaryXml *primary_xml = user_data;
-	ZifString *string = NULL;
+	ZifMdPrimaryXmlColumn column;
 
 	/* skip whitespace */
 	if (text_len < 1 || text[0] == ' ' || text[0] == '\t' || text[0] == '\n')
@@ -447,69 +519,64 @@ zif_md_primary_xml_parser_text (GMarkupParseContext *context, const gchar *text,
 	if (primary_xml->priv->section == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE) {
 		if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_UNKNOWN)
 			goto out;
-		if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_NAME) {
-			primary_xml->priv->package_name_temp = g_strdup (text);
-			goto out;
-		}
-		if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_ARCH) {
-			primary_xml->priv->package_arch_temp = g_strdup (text);
-			goto out;
-		}
-		if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_SUMMARY) {
-			string = zif_string_new (text);
-			zif_package_set_summary (primary_xml->priv->package_temp, string);
-			goto out;
-		}
-		if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_DESCRIPTION) {
-			string = zif_string_new (text);
-			zif_package_set_description (primary_xml->priv->package_temp, string);
-			goto out;
-		}
-		if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_URL) {
-			string = zif_string_new (text);
-			zif_package_set_url (primary_xml->priv->package_temp, string);
-			goto out;
-		}
-		if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_GROUP) {
-			string = zif_string_new (text);
-			zif_package_set_category (primary_xml->priv->package_temp, string);
-			goto out;
-		}
-		if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_SOURCERPM) {
-			string = zif_string_new (text);
-			zif_package_set_source_filename (primary_xml->priv->package_temp, string);
-			goto out;
-		}
-		if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_LICENCE) {
-			string = zif_string_new (text);
-			zif_package_set_license (primary_xml->priv->package_temp, string);
-			goto out;
-		}
-		if (primary_xml->priv->section_package == ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_CHECKSUM) {
-			string = zif_string_new (text);
-			zif_package_set_pkgid (primary_xml->priv->package_temp, string);
+		column = zif_md_primary_xml_section_to_column (primary_xml->priv->section_package);
+		if (column != ZIF_MD_PRIMARY_XML_COLUMN_UNKNOWN) {
+			sqlite3_bind_text (primary_xml->priv->stmt_package,
+					   column, text, text_len, SQLITE_TRANSIENT);
 			goto out;
 		}
 		g_warning ("not saving: %s", text);
 		goto out;
 	}
 out:
-	if (string != NULL)
-		zif_string_unref (string);
 	return;
 }
 
 /**
- * zif_md_primary_xml_load:
+ * zif_md_primary_xml_prepare_depend:
  **/
 static gboolean
-zif_md_primary_xml_load (ZifMd *md, ZifState *state, GError **error)
+zif_md_primary_xml_prepare_depend (ZifMdPrimaryXml *primary_xml,
+				   const gchar *table_name,
+				   sqlite3_stmt **stmt,
+				   GError **error)
 {
-	const gchar *filename;
-	gboolean ret;
-	gchar *contents = NULL;
-	gsize size;
-	ZifMdPrimaryXml *primary_xml = ZIF_MD_PRIMARY_XML (md);
+	gchar *statement;
+	gint rc;
+
+	statement = g_strdup_printf ("INSERT INTO %s (name, flags, epoch, version, release, pkgKey) "
+				     "VALUES (?, ?, ?, ?, ?, ?)", table_name);
+	rc = sqlite3_prepare_v2 (primary_xml->priv->db_build, statement, -1, stmt, NULL);
+	g_free (statement);
+	if (rc != SQLITE_OK) {
+		zif_md_primary_xml_set_sql_error (primary_xml, "prepare depend", error);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * zif_md_primary_xml_index_build:
+ *
+ * Streams the XML file into a new index with the same schema as the
+ * primary.sqlite metadata. The index is written to a temporary file and
+ * only moved into place when complete, so other processes never see a
+ * partial index.
+ **/
+static gboolean
+zif_md_primary_xml_index_build (ZifMdPrimaryXml *primary_xml,
+				const gchar *filename,
+				const gchar *filename_index,
+				const gchar *checksum,
+				GError **error)
+{
+	gboolean ret = FALSE;
+	gchar *buffer = NULL;
+	gchar *filename_tmp = NULL;
+	gint rc;
+	gssize len;
+	GFile *file;
+	GFileInputStream *stream = NULL;
 	GMarkupParseContext *context = NULL;
 	const GMarkupParser gpk_md_primary_xml_markup_parser = {
 		zif_md_primary_xml_parser_start_element,
@@ -519,6 +586,143 @@ zif_md_primary_xml_load (ZifMd *md, ZifState *state, GError **error)
 		NULL /* error */
 	};
 
+	/* create the new database */
+	g_debug ("building index %s from %s", filename_index, filename);
+	primary_xml->priv->db_build =
+		zif_md_index_build_begin (filename_index,
+					  "CREATE TABLE packages (pkgKey INTEGER PRIMARY KEY, pkgId TEXT, "
+					  "name TEXT, arch TEXT, version TEXT, epoch TEXT, release TEXT, "
+					  "summary TEXT, description TEXT, url TEXT, time_file INTEGER, "
+					  "rpm_license TEXT, rpm_group TEXT, rpm_sourcerpm TEXT, "
+					  "size_package INTEGER, location_href TEXT);"
+					  "CREATE TABLE provides (name TEXT, flags TEXT, epoch TEXT, "
+					  "version TEXT, release TEXT, pkgKey INTEGER);"
+					  "CREATE TABLE requires (name TEXT, flags TEXT, epoch TEXT, "
+					  "version TEXT, release TEXT, pkgKey INTEGER);"
+					  "CREATE TABLE obsoletes (name TEXT, flags TEXT, epoch TEXT, "
+					  "version TEXT, release TEXT, pkgKey INTEGER);"
+					  "CREATE TABLE conflicts (name TEXT, flags TEXT, epoch TEXT, "
+					  "version TEXT, release TEXT, pkgKey INTEGER);",
+					  &filename_tmp,
+					  error);
+	if (primary_xml->priv->db_build == NULL)
+		goto out;
+	rc = sqlite3_prepare_v2 (primary_xml->priv->db_build,
+				 "INSERT INTO packages (pkgKey, pkgId, name, arch, version, "
+				 "epoch, release, summary, description, url, time_file, "
+				 "rpm_license, rpm_group, rpm_sourcerpm, size_package, "
+				 "location_href) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, "
+				 "?, ?, ?, ?, ?)",
+				 -1, &primary_xml->priv->stmt_package, NULL);
+	if (rc != SQLITE_OK) {
+		zif_md_primary_xml_set_sql_error (primary_xml, "prepare package", error);
+		goto out;
+	}
+	if (!zif_md_primary_xml_prepare_depend (primary_xml, "provides",
+						&primary_xml->priv->stmt_provides, error))
+		goto out;
+	if (!zif_md_primary_xml_prepare_depend (primary_xml, "requires",
+						&primary_xml->priv->stmt_requires, error))
+		goto out;
+	if (!zif_md_primary_xml_prepare_depend (primary_xml, "obsoletes",
+						&primary_xml->priv->stmt_obsoletes, error))
+		goto out;
+	if (!zif_md_primary_xml_prepare_depend (primary_xml, "conflicts",
+						&primary_xml->priv->stmt_conflicts, error))
+		goto out;
+
+	/* open the XML file */
+	file = g_file_new_for_path (filename);
+	stream = g_file_read (file, NULL, error);
+	g_object_unref (file);
+	if (stream == NULL)
+		goto out;
+
+	/* parse a chunk at a time so the file is never fully resident */
+	primary_xml->priv->pkgkey_temp = 0;
+	context = g_markup_parse_context_new (&gpk_md_primary_xml_markup_parser, G_MARKUP_PREFIX_ERROR_POSITION, primary_xml, NULL);
+	buffer = g_new (gchar, ZIF_MD_PRIMARY_XML_CHUNK_SIZE);
+	do {
+		len = g_input_stream_read (G_INPUT_STREAM (stream),
+					   buffer,
+					   ZIF_MD_PRIMARY_XML_CHUNK_SIZE,
+					   NULL,
+					   error);
+		if (len < 0)
+			goto out;
+		if (len > 0 && !g_markup_parse_context_parse (context, buffer, len, error))
+			goto out;
+	} while (len > 0);
+	if (!g_markup_parse_context_end_parse (context, error))
+		goto out;
+
+	/* create the indexes and move into place */
+	sqlite3_finalize (primary_xml->priv->stmt_package);
+	sqlite3_finalize (primary_xml->priv->stmt_provides);
+	sqlite3_finalize (primary_xml->priv->stmt_requires);
+	sqlite3_finalize (primary_xml->priv->stmt_obsoletes);
+	sqlite3_finalize (primary_xml->priv->stmt_conflicts);
+	primary_xml->priv->stmt_package = NULL;
+	primary_xml->priv->stmt_provides = NULL;
+	primary_xml->priv->stmt_requires = NULL;
+	primary_xml->priv->stmt_obsoletes = NULL;
+	primary_xml->priv->stmt_conflicts = NULL;
+	ret = zif_md_index_build_finish (primary_xml->priv->db_build,
+					 filename_tmp,
+					 filename_index,
+					 "CREATE INDEX packagename ON packages (name);"
+					 "CREATE INDEX packageId ON packages (pkgId);"
+					 "CREATE INDEX providesname ON provides (name);"
+					 "CREATE INDEX pkgprovides ON provides (pkgKey);"
+					 "CREATE INDEX requiresname ON requires (name);"
+					 "CREATE INDEX pkgrequires ON requires (pkgKey);"
+					 "CREATE INDEX obsoletesname ON obsoletes (name);"
+					 "CREATE INDEX pkgobsoletes ON obsoletes (pkgKey);"
+					 "CREATE INDEX conflictsname ON conflicts (name);"
+					 "CREATE INDEX pkgconflicts ON conflicts (pkgKey);",
+					 ZIF_MD_PRIMARY_XML_INDEX_VERSION,
+					 checksum,
+					 error);
+	primary_xml->priv->db_build = NULL;
+out:
+	/* sqlite3_finalize() is a no-op for NULL */
+	sqlite3_finalize (primary_xml->priv->stmt_package);
+	sqlite3_finalize (primary_xml->priv->stmt_provides);
+	sqlite3_finalize (primary_xml->priv->stmt_requires);
+	sqlite3_finalize (primary_xml->priv->stmt_obsoletes);
+	sqlite3_finalize (primary_xml->priv->stmt_conflicts);
+	primary_xml->priv->stmt_package = NULL;
+	primary_xml->priv->stmt_provides = NULL;
+	primary_xml->priv->stmt_requires = NULL;
+	primary_xml->priv->stmt_obsoletes = NULL;
+	primary_xml->priv->stmt_conflicts = NULL;
+	if (primary_xml->priv->db_build != NULL) {
+		zif_md_index_build_abort (primary_xml->priv->db_build, filename_tmp);
+		primary_xml->priv->db_build = NULL;
+	}
+	if (context != NULL)
+		g_markup_parse_context_free (context);
+	if (stream != NULL)
+		g_object_unref (stream);
+	primary_xml->priv->section = ZIF_MD_PRIMARY_XML_SECTION_UNKNOWN;
+	primary_xml->priv->section_package = ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_UNKNOWN;
+	g_free (filename_tmp);
+	g_free (buffer);
+	return ret;
+}
+
+/**
+ * zif_md_primary_xml_load:
+ **/
+static gboolean
+zif_md_primary_xml_load (ZifMd *md, ZifState *state, GError **error)
+{
+	const gchar *checksum;
+	const gchar *filename;
+	const gchar *filename_index;
+	gboolean ret;
+	ZifMdPrimaryXml *primary_xml = ZIF_MD_PRIMARY_XML (md);
+
 	g_return_val_if_fail (ZIF_IS_MD_PRIMARY_XML (md), FALSE);
 	g_return_val_if_fail (zif_state_valid (state), FALSE);
 
@@ -526,14 +730,6 @@ zif_md_primary_xml_load (ZifMd *md, ZifState *state, GError **error)
 	if (primary_xml->priv->loaded)
 		goto out;
 
-	/* get the compare mode */
-	primary_xml->priv->compare_mode = zif_config_get_enum (primary_xml->priv->config,
-							       "pkg_compare_mode",
-							       zif_package_compare_mode_from_string,
-							       error);
-	if (primary_xml->priv->compare_mode == G_MAXUINT)
-		goto out;
-
 	/* get filename */
 	filename = zif_md_get_filename_uncompressed (md);
 	if (filename == NULL) {
@@ -542,221 +738,99 @@ zif_md_primary_xml_load (ZifMd *md, ZifState *state, GError **error)
 		goto out;
 	}
 
-	/* open database */
-	g_debug ("filename = %s", filename);
+	/* parse the XML into a new index if the old one is out of date */
 	zif_state_set_allow_cancel (state, FALSE);
-	ret = g_file_get_contents (filename, &contents, &size, error);
-	if (!ret)
-		goto out;
-
-	/* create parser */
-	context = g_markup_parse_context_new (&gpk_md_primary_xml_markup_parser, G_MARKUP_PREFIX_ERROR_POSITION, primary_xml, NULL);
+	filename_index = zif_md_get_filename_index (md);
+	checksum = zif_md_get_checksum_uncompressed (md);
+	if (zif_md_index_is_valid (filename_index,
+				   ZIF_MD_PRIMARY_XML_INDEX_VERSION,
+				   checksum)) {
+		g_debug ("reusing index %s", filename_index);
+	} else {
+		ret = zif_md_primary_xml_index_build (primary_xml,
+						      filename,
+						      filename_index,
+						      checksum,
+						      error);
+		if (!ret)
+			goto out;
+	}
 
-	/* parse data */
-	zif_state_set_allow_cancel (state, FALSE);
-	ret = g_markup_parse_context_parse (context, contents, (gssize) size, error);
+	/* the index has the primary.sqlite schema, so query it the same way */
+	if (zif_md_get_id (md) != NULL)
+		zif_md_set_id (primary_xml->priv->md_sql, zif_md_get_id (md));
+	zif_md_set_filename (primary_xml->priv->md_sql, filename_index);
+	if (zif_md_get_store (md) != NULL)
+		zif_md_set_store (primary_xml->priv->md_sql, zif_md_get_store (md));
+	ret = zif_md_primary_sql_load_from_file (ZIF_MD_PRIMARY_SQL (primary_xml->priv->md_sql),
+						 filename_index,
+						 error);
 	if (!ret)
 		goto out;
-
-	/* we don't need to keep syncing */
 	primary_xml->priv->loaded = TRUE;
 out:
-	if (context != NULL)
-		g_markup_parse_context_free (context);
-	g_free (contents);
 	return primary_xml->priv->loaded;
 }
 
-typedef gboolean (*ZifPackageFilterFunc)		(ZifPackage		*package,
-							 gpointer		 user_data,
-							 ZifStrCompareFunc	 compare_func);
-
 /**
- * zif_md_primary_xml_filter:
+ * zif_md_primary_xml_load_for_query:
+ *
+ * Loads the index if required, and returns the child state to use for
+ * the query itself.
  **/
-static GPtrArray *
-zif_md_primary_xml_filter (ZifMd *md,
-			   ZifPackageFilterFunc filter_func,
-			   gpointer user_data,
-			   ZifStrCompareFunc compare_func,
-			   ZifState *state,
-			   GError **error)
+static ZifState *
+zif_md_primary_xml_load_for_query (ZifMd *md, ZifState *state, GError **error)
 {
-	GPtrArray *array = NULL;
-	GPtrArray *packages;
-	ZifPackage *package;
-	guint i;
 	gboolean ret;
 	GError *error_local = NULL;
 	ZifState *state_local;
 	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
 
-	g_return_val_if_fail (ZIF_IS_MD_PRIMARY_XML (md), NULL);
-	g_return_val_if_fail (zif_state_valid (state), NULL);
-	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
-
-	/* setup state */
+	/* already loaded */
 	if (md_primary->priv->loaded) {
 		zif_state_set_number_steps (state, 1);
-	} else {
-		ret = zif_state_set_steps (state,
-					   error,
-					   80, /* load */
-					   20, /* search */
-					   -1);
-		if (!ret)
-			goto out;
-	}
-
-	/* if not already loaded, load */
-	if (!md_primary->priv->loaded) {
-		state_local = zif_state_get_child (state);
-		ret = zif_md_load (ZIF_MD (md), state_local, &error_local);
-		if (!ret) {
-			g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED_TO_LOAD,
-				     "failed to load md_primary_xml file: %s", error_local->message);
-			g_error_free (error_local);
-			goto out;
-		}
-
-		/* this section done */
-		ret = zif_state_done (state, error);
-		if (!ret)
-			goto out;
+		return zif_state_get_child (state);
 	}
 
-	/* search array */
-	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	packages = md_primary->priv->array;
-	for (i = 0; i < packages->len; i++) {
-		package = g_ptr_array_index (packages, i);
-		if (filter_func (package, user_data, compare_func))
-			g_ptr_array_add (array, g_object_ref (package));
+	/* setup state */
+	ret = zif_state_set_steps (state,
+				   error,
+				   80, /* load */
+				   20, /* query */
+				   -1);
+	if (!ret)
+		return NULL;
+
+	/* load */
+	state_local = zif_state_get_child (state);
+	ret = zif_md_load (md, state_local, &error_local);
+	if (!ret) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED_TO_LOAD,
+			     "failed to load md_primary_xml file: %s", error_local->message);
+		g_error_free (error_local);
+		return NULL;
 	}
 
 	/* this section done */
 	ret = zif_state_done (state, error);
 	if (!ret)
-		goto out;
-out:
-	return array;
-}
-
-/**
- * zif_md_primary_xml_resolve_name_cb:
- **/
-static gboolean
-zif_md_primary_xml_resolve_name_cb (ZifPackage *package,
-				    gpointer user_data,
-				    ZifStrCompareFunc compare_func)
-{
-	guint i;
-	const gchar *value;
-	gchar **search = (gchar **) user_data;
-	value = zif_package_get_name (package);
-	for (i = 0; search[i] != NULL; i++) {
-		if (compare_func (value, search[i]))
-			return TRUE;
-	}
-	return FALSE;
+		return NULL;
+	return zif_state_get_child (state);
 }
 
 /**
- * zif_md_primary_xml_resolve_name_arch_kill_arch:
+ * zif_md_primary_xml_query_done:
  **/
-static gboolean
-zif_md_primary_xml_resolve_name_arch_kill_arch (ZifPackage *package,
-						gpointer user_data,
-						ZifStrCompareFunc compare_func)
-{
-	guint i;
-	gboolean ret = FALSE;
-	const gchar *value;
-	gchar *tmp;
-	gchar **search = g_strdupv (user_data);
-
-	/* we don't use this code path for non-noarch packages as it
-	 * means copying the search GStrv each time */
-	for (i = 0; search[i] != NULL; i++) {
-		tmp = strrchr (search[i], '.');
-		if (tmp != NULL)
-			*tmp = '\0';
-	}
-	value = zif_package_get_name (package);
-	for (i = 0; search[i] != NULL; i++) {
-		if (compare_func (value, search[i])) {
-			ret = TRUE;
-			break;
-		}
-	}
-	g_strfreev (search);
-	return ret;
-}
-
-/**
- * zif_md_primary_xml_resolve_name_arch_cb:
- **/
-static gboolean
-zif_md_primary_xml_resolve_name_arch_cb (ZifPackage *package,
-					 gpointer user_data,
-					 ZifStrCompareFunc compare_func)
-{
-	guint i;
-	const gchar *value;
-	gchar **search = (gchar **) user_data;
-
-	/* a noarch package has to be handled specially */
-	value = zif_package_get_arch (package);
-	if (g_strcmp0 (value, "noarch") == 0) {
-		return zif_md_primary_xml_resolve_name_arch_kill_arch (package,
-								       user_data,
-								       compare_func);
-	}
-
-	value = zif_package_get_name_arch (package);
-	for (i = 0; search[i] != NULL; i++) {
-		if (compare_func (value, search[i]))
-			return TRUE;
-	}
-	return FALSE;
-}
-
-/**
- * zif_md_primary_xml_resolve_name_version_cb:
- **/
-static gboolean
-zif_md_primary_xml_resolve_name_version_cb (ZifPackage *package,
-					    gpointer user_data,
-					    ZifStrCompareFunc compare_func)
-{
-	guint i;
-	const gchar *value;
-	gchar **search = (gchar **) user_data;
-	value = zif_package_get_name_version (package);
-	for (i = 0; search[i] != NULL; i++) {
-		if (compare_func (value, search[i]))
-			return TRUE;
-	}
-	return FALSE;
-}
-
-/**
- * zif_md_primary_xml_resolve_name_version_arch_cb:
- **/
-static gboolean
-zif_md_primary_xml_resolve_name_version_arch_cb (ZifPackage *package,
-						 gpointer user_data,
-						 ZifStrCompareFunc compare_func)
+static GPtrArray *
+zif_md_primary_xml_query_done (GPtrArray *array, ZifState *state, GError **error)
 {
-	guint i;
-	const gchar *value;
-	gchar **search = (gchar **) user_data;
-	value = zif_package_get_name_version_arch (package);
-	for (i = 0; search[i] != NULL; i++) {
-		if (compare_func (value, search[i]))
-			return TRUE;
+	if (array == NULL)
+		return NULL;
+	if (!zif_state_done (state, error)) {
+		g_ptr_array_unref (array);
+		return NULL;
 	}
-	return FALSE;
+	return array;
 }
 
 /**
@@ -769,143 +843,18 @@ zif_md_primary_xml_resolve (ZifMd *md,
 			    ZifState *state,
 			    GError **error)
 {
-	gboolean ret;
-	GPtrArray *array = NULL;
-	GPtrArray *array_tmp;
-	GPtrArray *tmp;
-	guint cnt = 0;
-	guint i;
+	GPtrArray *array;
 	ZifState *state_local;
-	ZifStrCompareFunc compare_func;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
 
 	g_return_val_if_fail (zif_state_valid (state), NULL);
 	g_return_val_if_fail (flags != 0, NULL);
 
-	/* find out how many steps we need to do */
-	cnt += ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME) > 0);
-	cnt += ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_ARCH) > 0);
-	cnt += ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_VERSION) > 0);
-	cnt += ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_VERSION_ARCH) > 0);
-	zif_state_set_number_steps (state, cnt);
-
-	/* allow globbing (slow) or a regular expressions (much slower) */
-	if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_REGEX) > 0)
-		compare_func = zif_str_compare_regex;
-	else if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_GLOB) > 0)
-		compare_func = zif_str_compare_glob;
-	else
-		compare_func = zif_str_compare_equal;
-
-	array_tmp = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-
-	/* name */
-	if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME) > 0) {
-		state_local = zif_state_get_child (state);
-		tmp = zif_md_primary_xml_filter (md,
-						 zif_md_primary_xml_resolve_name_cb,
-						 (gpointer) search,
-						 compare_func,
-						 state_local,
-						 error);
-		if (tmp == NULL)
-			goto out;
-		for (i = 0; i < tmp->len; i++)
-			g_ptr_array_add (array_tmp, g_object_ref (g_ptr_array_index (tmp, i)));
-		g_ptr_array_unref (tmp);
-
-		/* this section done */
-		ret = zif_state_done (state, error);
-		if (!ret)
-			goto out;
-	}
-
-	/* name.arch */
-	if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_ARCH) > 0) {
-		state_local = zif_state_get_child (state);
-		tmp = zif_md_primary_xml_filter (md,
-						 zif_md_primary_xml_resolve_name_arch_cb,
-						 (gpointer) search,
-						 compare_func,
-						 state_local,
-						 error);
-		if (tmp == NULL)
-			goto out;
-		for (i = 0; i < tmp->len; i++)
-			g_ptr_array_add (array_tmp, g_object_ref (g_ptr_array_index (tmp, i)));
-		g_ptr_array_unref (tmp);
-
-		/* this section done */
-		ret = zif_state_done (state, error);
-		if (!ret)
-			goto out;
-	}
-
-	/* name-version */
-	if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_VERSION) > 0) {
-		state_local = zif_state_get_child (state);
-		tmp = zif_md_primary_xml_filter (md,
-						 zif_md_primary_xml_resolve_name_version_cb,
-						 (gpointer) search,
-						 compare_func,
-						 state_local,
-						 error);
-		if (tmp == NULL)
-			goto out;
-		for (i = 0; i < tmp->len; i++)
-			g_ptr_array_add (array_tmp, g_object_ref (g_ptr_array_index (tmp, i)));
-		g_ptr_array_unref (tmp);
-
-		/* this section done */
-		ret = zif_state_done (state, error);
-		if (!ret)
-			goto out;
-	}
-
-	/* name-version.arch */
-	if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_VERSION_ARCH) > 0) {
-		state_local = zif_state_get_child (state);
-		tmp = zif_md_primary_xml_filter (md,
-						 zif_md_primary_xml_resolve_name_version_arch_cb,
-						 (gpointer) search,
-						 compare_func,
-						 state_local,
-						 error);
-		if (tmp == NULL)
-			goto out;
-		for (i = 0; i < tmp->len; i++)
-			g_ptr_array_add (array_tmp, g_object_ref (g_ptr_array_index (tmp, i)));
-		g_ptr_array_unref (tmp);
-
-		/* this section done */
-		ret = zif_state_done (state, error);
-		if (!ret)
-			goto out;
-	}
-
-	/* success */
-	array = g_ptr_array_ref (array_tmp);
-out:
-	g_ptr_array_unref (array_tmp);
-	return array;
-}
-
-/**
- * zif_md_primary_xml_search_name_cb:
- **/
-static gboolean
-zif_md_primary_xml_search_name_cb (ZifPackage *package,
-				   gpointer user_data,
-				   ZifStrCompareFunc compare_func)
-{
-	guint i;
-	const gchar *value;
-	gchar **search = (gchar **) user_data;
-	value = zif_package_get_name (package);
-	for (i = 0; search[i] != NULL; i++) {
-		if (g_strstr_len (value, -1, search[i]) != NULL)
-			return TRUE;
-	}
-	return FALSE;
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_resolve_full (md_primary->priv->md_sql, search, flags, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -914,62 +863,17 @@ zif_md_primary_xml_search_name_cb (ZifPackage *package,
 static GPtrArray *
 zif_md_primary_xml_search_name (ZifMd *md, gchar **search, ZifState *state, GError **error)
 {
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
 	g_return_val_if_fail (zif_state_valid (state), NULL);
-	return zif_md_primary_xml_filter (md,
-					  zif_md_primary_xml_search_name_cb,
-					  (gpointer) search,
-					  NULL,
-					  state, error);
-}
 
-/**
- * zif_md_primary_xml_search_details_cb:
- **/
-static gboolean
-zif_md_primary_xml_search_details_cb (ZifPackage *package,
-				      gpointer user_data,
-				      ZifStrCompareFunc compare_func)
-{
-	guint i;
-	gboolean ret = FALSE;
-	const gchar *name;
-	const gchar *summary;
-	const gchar *description;
-	ZifState *state_tmp;
-	GError *error = NULL;
-	gchar **search = (gchar **) user_data;
-
-	state_tmp = zif_state_new ();
-	name = zif_package_get_name (package);
-	summary = zif_package_get_summary (package, state_tmp, &error);
-	if (summary == NULL) {
-		g_warning ("failed to get summary: %s", error->message);
-		g_error_free (error);
-		goto out;
-	}
-	description = zif_package_get_description (package, state_tmp, &error);
-	if (description == NULL) {
-		g_warning ("failed to get description: %s", error->message);
-		g_error_free (error);
-		goto out;
-	}
-	for (i = 0; search[i] != NULL; i++) {
-		if (g_strstr_len (name, -1, search[i]) != NULL) {
-			ret = TRUE;
-			break;
-		}
-		if (g_strstr_len (summary, -1, search[i]) != NULL) {
-			ret = TRUE;
-			break;
-		}
-		if (g_strstr_len (description, -1, search[i]) != NULL) {
-			ret = TRUE;
-			break;
-		}
-	}
-out:
-	g_object_unref (state_tmp);
-	return ret;
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_search_name (md_primary->priv->md_sql, search, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -978,46 +882,17 @@ out:
 static GPtrArray *
 zif_md_primary_xml_search_details (ZifMd *md, gchar **search, ZifState *state, GError **error)
 {
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
 	g_return_val_if_fail (zif_state_valid (state), NULL);
-	return zif_md_primary_xml_filter (md,
-					  zif_md_primary_xml_search_details_cb,
-					  (gpointer) search,
-					  NULL,
-					  state,
-					  error);
-}
 
-/**
- * zif_md_primary_xml_search_group_cb:
- **/
-static gboolean
-zif_md_primary_xml_search_group_cb (ZifPackage *package,
-				    gpointer user_data,
-				    ZifStrCompareFunc compare_func)
-{
-	guint i;
-	gboolean ret = FALSE;
-	const gchar *value;
-	ZifState *state_tmp;
-	GError *error = NULL;
-	gchar **search = (gchar **) user_data;
-
-	state_tmp = zif_state_new ();
-	value = zif_package_get_category (package, state_tmp, &error);
-	if (value == NULL) {
-		g_warning ("failed to get category: %s", error->message);
-		g_error_free (error);
-		goto out;
-	}
-	for (i = 0; search[i] != NULL; i++) {
-		if (g_strstr_len (value, -1, search[i]) != NULL) {
-			ret = TRUE;
-			goto out;
-		}
-	}
-out:
-	g_object_unref (state_tmp);
-	return ret;
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_search_details (md_primary->priv->md_sql, search, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1026,32 +901,17 @@ out:
 static GPtrArray *
 zif_md_primary_xml_search_group (ZifMd *md, gchar **search, ZifState *state, GError **error)
 {
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
 	g_return_val_if_fail (zif_state_valid (state), NULL);
-	return zif_md_primary_xml_filter (md,
-					  zif_md_primary_xml_search_group_cb,
-					  (gpointer) search,
-					  NULL,
-					  state,
-					  error);
-}
 
-/**
- * zif_md_primary_xml_search_pkgid_cb:
- **/
-static gboolean
-zif_md_primary_xml_search_pkgid_cb (ZifPackage *package,
-				    gpointer user_data,
-				    ZifStrCompareFunc compare_func)
-{
-	guint i;
-	const gchar *pkgid;
-	gchar **search = (gchar **) user_data;
-	pkgid = zif_package_get_pkgid (package);
-	for (i = 0; search[i] != NULL; i++) {
-		if (g_strcmp0 (pkgid, search[i]) == 0)
-			return TRUE;
-	}
-	return FALSE;
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_search_group (md_primary->priv->md_sql, search, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1060,185 +920,17 @@ zif_md_primary_xml_search_pkgid_cb (ZifPackage *package,
 static GPtrArray *
 zif_md_primary_xml_search_pkgid (ZifMd *md, gchar **search, ZifState *state, GError **error)
 {
-	g_return_val_if_fail (zif_state_valid (state), NULL);
-	return zif_md_primary_xml_filter (md,
-					  zif_md_primary_xml_search_pkgid_cb,
-					  (gpointer) search,
-					  NULL,
-					  state,
-					  error);
-}
-
-/**
- * zif_md_primary_xml_what_provides_cb:
- **/
-static gboolean
-zif_md_primary_xml_what_provides_cb (ZifPackage *package,
-				     gpointer user_data,
-				     ZifStrCompareFunc compare_func)
-{
-	guint i, j;
-	gboolean ret = FALSE;
-	GPtrArray *array = NULL;
-	ZifState *state_tmp;
-	ZifDepend *depend_tmp;
-	ZifDepend *depend;
-	GError *error = NULL;
-	GPtrArray *depends = (GPtrArray *) user_data;
-
-	state_tmp = zif_state_new ();
-	array = zif_package_get_provides (package, state_tmp, &error);
-	if (array == NULL) {
-		g_warning ("failed to get provides: %s", error->message);
-		g_error_free (error);
-		goto out;
-	}
-
-	/* find a depends string */
-	for (i = 0; i < array->len; i++) {
-		depend_tmp = g_ptr_array_index (array, i);
-		for (j = 0; j < depends->len; j++) {
-			depend = g_ptr_array_index (depends, j);
-			if (zif_depend_satisfies (depend_tmp, depend)) {
-				ret = TRUE;
-				goto out;
-			}
-		}
-	}
-out:
-	g_object_unref (state_tmp);
-	if (array != NULL)
-		g_ptr_array_unref (array);
-	return ret;
-}
-
-/**
- * zif_md_primary_xml_what_requires_cb:
- **/
-static gboolean
-zif_md_primary_xml_what_requires_cb (ZifPackage *package,
-				     gpointer user_data,
-				     ZifStrCompareFunc compare_func)
-{
-	guint i, j;
-	gboolean ret = FALSE;
-	GPtrArray *array = NULL;
-	ZifState *state_tmp;
-	ZifDepend *depend_tmp;
-	ZifDepend *depend;
-	GError *error = NULL;
-	GPtrArray *depends = (GPtrArray *) user_data;
-
-	state_tmp = zif_state_new ();
-	array = zif_package_get_requires (package, state_tmp, &error);
-	if (array == NULL) {
-		g_warning ("failed to get requires: %s", error->message);
-		g_error_free (error);
-		goto out;
-	}
-
-	/* find a depends string */
-	for (i = 0; i < array->len; i++) {
-		depend_tmp = g_ptr_array_index (array, i);
-		for (j = 0; j < depends->len; j++) {
-			depend = g_ptr_array_index (depends, j);
-			if (zif_depend_satisfies (depend_tmp, depend)) {
-				ret = TRUE;
-				goto out;
-			}
-		}
-	}
-out:
-	g_object_unref (state_tmp);
-	if (array != NULL)
-		g_ptr_array_unref (array);
-	return ret;
-}
-
-/**
- * zif_md_primary_xml_what_obsoletes_cb:
- **/
-static gboolean
-zif_md_primary_xml_what_obsoletes_cb (ZifPackage *package,
-				      gpointer user_data,
-				      ZifStrCompareFunc compare_func)
-{
-	guint i, j;
-	gboolean ret = FALSE;
-	GPtrArray *array = NULL;
-	ZifState *state_tmp;
-	ZifDepend *depend_tmp;
-	ZifDepend *depend;
-	GError *error = NULL;
-	GPtrArray *depends = (GPtrArray *) user_data;
-
-	state_tmp = zif_state_new ();
-	array = zif_package_get_obsoletes (package, state_tmp, &error);
-	if (array == NULL) {
-		g_warning ("failed to get obsoletes: %s", error->message);
-		g_error_free (error);
-		goto out;
-	}
-
-	/* find a depends string */
-	for (i = 0; i < array->len; i++) {
-		depend_tmp = g_ptr_array_index (array, i);
-		for (j = 0; j < depends->len; j++) {
-			depend = g_ptr_array_index (depends, j);
-			if (zif_depend_satisfies (depend_tmp, depend)) {
-				ret = TRUE;
-				goto out;
-			}
-		}
-	}
-out:
-	g_object_unref (state_tmp);
-	if (array != NULL)
-		g_ptr_array_unref (array);
-	return ret;
-}
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
 
-/**
- * zif_md_primary_xml_what_conflicts_cb:
- **/
-static gboolean
-zif_md_primary_xml_what_conflicts_cb (ZifPackage *package,
-				      gpointer user_data,
-				      ZifStrCompareFunc compare_func)
-{
-	guint i, j;
-	gboolean ret = FALSE;
-	GPtrArray *array = NULL;
-	ZifState *state_tmp;
-	ZifDepend *depend_tmp;
-	ZifDepend *depend;
-	GError *error = NULL;
-	GPtrArray *depends = (GPtrArray *) user_data;
-
-	state_tmp = zif_state_new ();
-	array = zif_package_get_conflicts (package, state_tmp, &error);
-	if (array == NULL) {
-		g_warning ("failed to get conflicts: %s", error->message);
-		g_error_free (error);
-		goto out;
-	}
+	g_return_val_if_fail (zif_state_valid (state), NULL);
 
-	/* find a depends string */
-	for (i = 0; i < array->len; i++) {
-		depend_tmp = g_ptr_array_index (array, i);
-		for (j = 0; j < depends->len; j++) {
-			depend = g_ptr_array_index (depends, j);
-			if (zif_depend_satisfies (depend_tmp, depend)) {
-				ret = TRUE;
-				goto out;
-			}
-		}
-	}
-out:
-	g_object_unref (state_tmp);
-	if (array != NULL)
-		g_ptr_array_unref (array);
-	return ret;
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_search_pkgid (md_primary->priv->md_sql, search, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1248,13 +940,17 @@ static GPtrArray *
 zif_md_primary_xml_what_provides (ZifMd *md, GPtrArray *depends,
 				  ZifState *state, GError **error)
 {
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
 	g_return_val_if_fail (zif_state_valid (state), NULL);
-	return zif_md_primary_xml_filter (md,
-					  zif_md_primary_xml_what_provides_cb,
-					  (gpointer) depends,
-					  NULL,
-					  state,
-					  error);
+
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_what_provides (md_primary->priv->md_sql, depends, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1264,13 +960,17 @@ static GPtrArray *
 zif_md_primary_xml_what_requires (ZifMd *md, GPtrArray *depends,
 				  ZifState *state, GError **error)
 {
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
 	g_return_val_if_fail (zif_state_valid (state), NULL);
-	return zif_md_primary_xml_filter (md,
-					  zif_md_primary_xml_what_requires_cb,
-					  (gpointer) depends,
-					  NULL,
-					  state,
-					  error);
+
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_what_requires (md_primary->priv->md_sql, depends, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1280,13 +980,17 @@ static GPtrArray *
 zif_md_primary_xml_what_obsoletes (ZifMd *md, GPtrArray *depends,
 				   ZifState *state, GError **error)
 {
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
 	g_return_val_if_fail (zif_state_valid (state), NULL);
-	return zif_md_primary_xml_filter (md,
-					  zif_md_primary_xml_what_obsoletes_cb,
-					  (gpointer) depends,
-					  NULL,
-					  state,
-					  error);
+
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_what_obsoletes (md_primary->priv->md_sql, depends, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1296,27 +1000,17 @@ static GPtrArray *
 zif_md_primary_xml_what_conflicts (ZifMd *md, GPtrArray *depends,
 				   ZifState *state, GError **error)
 {
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
 	g_return_val_if_fail (zif_state_valid (state), NULL);
-	return zif_md_primary_xml_filter (md,
-					  zif_md_primary_xml_what_conflicts_cb,
-					  (gpointer) depends,
-					  NULL,
-					  state,
-					  error);
-}
 
-/**
- * zif_md_primary_xml_find_package_cb:
- **/
-static gboolean
-zif_md_primary_xml_find_package_cb (ZifPackage *package,
-				    gpointer user_data,
-				    ZifStrCompareFunc compare_func)
-{
-	const gchar *value;
-	const gchar *search = (const gchar *) user_data;
-	value = zif_package_get_id (package);
-	return (g_strcmp0 (value, search) == 0);
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_what_conflicts (md_primary->priv->md_sql, depends, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1328,13 +1022,17 @@ zif_md_primary_xml_find_package (ZifMd *md,
 				 ZifState *state,
 				 GError **error)
 {
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
 	g_return_val_if_fail (zif_state_valid (state), NULL);
-	return zif_md_primary_xml_filter (md,
-					  zif_md_primary_xml_find_package_cb,
-					  (gpointer) package_id,
-					  NULL,
-					  state,
-					  error);
+
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_find_package (md_primary->priv->md_sql, package_id, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1343,75 +1041,17 @@ zif_md_primary_xml_find_package (ZifMd *md,
 static GPtrArray *
 zif_md_primary_xml_get_packages (ZifMd *md, ZifState *state, GError **error)
 {
-	gboolean ret;
-	GPtrArray *array = NULL;
-	ZifMdPrimaryXml *primary_xml = ZIF_MD_PRIMARY_XML (md);
-
-	/* if not already loaded, load */
-	if (!primary_xml->priv->loaded) {
-		ret = zif_md_load (ZIF_MD (md), state, error);
-		if (!ret)
-			goto out;
-	}
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
 
-	/* just return a ref to the ZifPackage array */
-	array = g_ptr_array_ref (primary_xml->priv->array);
-out:
-	return array;
-}
+	g_return_val_if_fail (zif_state_valid (state), NULL);
 
-/**
- * zif_md_primary_xml_get_depends:
- **/
-static GPtrArray *
-zif_md_primary_xml_get_depends (ZifMd *md,
-				const gchar *type,
-				ZifPackage *package,
-				ZifState *state,
-				GError **error)
-{
-	guint i;
-	ZifMdPrimaryXml *primary_xml = ZIF_MD_PRIMARY_XML (md);
-	GPtrArray *array;
-	GPtrArray *depends = NULL;
-	ZifPackage *pkg_tmp;
-
-	array = primary_xml->priv->array;
-	for (i = 0; i < array->len; i++) {
-		pkg_tmp = g_ptr_array_index (array, i);
-		if (zif_package_compare (pkg_tmp, package) == 0) {
-			if (g_strcmp0 (type, "provides") == 0) {
-				depends = zif_package_get_provides (pkg_tmp,
-								    state,
-								    error);
-			} else if (g_strcmp0 (type, "requires") == 0) {
-				depends = zif_package_get_requires (pkg_tmp,
-								    state,
-								    error);
-			} else if (g_strcmp0 (type, "obsoletes") == 0) {
-				depends = zif_package_get_obsoletes (pkg_tmp,
-								     state,
-								     error);
-			} else if (g_strcmp0 (type, "conflicts") == 0) {
-				depends = zif_package_get_conflicts (pkg_tmp,
-								     state,
-								     error);
-			} else {
-				g_assert_not_reached ();
-			}
-			goto out;
-		}
-	}
-	if (depends == NULL) {
-		g_set_error (error,
-			     ZIF_MD_ERROR,
-			     ZIF_MD_ERROR_FAILED,
-			     "Failed to find package %s in %s",
-			     zif_package_get_printable (package),
-			     zif_md_get_id (md));
-	}
-out:
-	return depends;
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_get_packages (md_primary->priv->md_sql, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1421,7 +1061,15 @@ static GPtrArray *
 zif_md_primary_xml_get_provides (ZifMd *md, ZifPackage *package,
 				 ZifState *state, GError **error)
 {
-	return zif_md_primary_xml_get_depends (md, "provides", package, state, error);
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_get_provides (md_primary->priv->md_sql, package, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1431,7 +1079,15 @@ static GPtrArray *
 zif_md_primary_xml_get_requires (ZifMd *md, ZifPackage *package,
 				 ZifState *state, GError **error)
 {
-	return zif_md_primary_xml_get_depends (md, "requires", package, state, error);
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_get_requires (md_primary->priv->md_sql, package, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1441,7 +1097,15 @@ static GPtrArray *
 zif_md_primary_xml_get_obsoletes (ZifMd *md, ZifPackage *package,
 				  ZifState *state, GError **error)
 {
-	return zif_md_primary_xml_get_depends (md, "obsoletes", package, state, error);
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_get_obsoletes (md_primary->priv->md_sql, package, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
 }
 
 /**
@@ -1451,7 +1115,29 @@ static GPtrArray *
 zif_md_primary_xml_get_conflicts (ZifMd *md, ZifPackage *package,
 				  ZifState *state, GError **error)
 {
-	return zif_md_primary_xml_get_depends (md, "conflicts", package, state, error);
+	GPtrArray *array;
+	ZifState *state_local;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
+	state_local = zif_md_primary_xml_load_for_query (md, state, error);
+	if (state_local == NULL)
+		return NULL;
+	array = zif_md_get_conflicts (md_primary->priv->md_sql, package, state_local, error);
+	return zif_md_primary_xml_query_done (array, state, error);
+}
+
+/**
+ * zif_md_primary_xml_get_memory_usage:
+ **/
+static void
+zif_md_primary_xml_get_memory_usage (ZifMd *md, ZifMemory *memory)
+{
+	ZifMdClass *klass;
+	ZifMdPrimaryXml *md_primary = ZIF_MD_PRIMARY_XML (md);
+
+	/* only the page cache of the index is resident */
+	klass = ZIF_MD_GET_CLASS (md_primary->priv->md_sql);
+	klass->get_memory_usage (md_primary->priv->md_sql, memory);
 }
 
 /**
@@ -1466,8 +1152,7 @@ zif_md_primary_xml_finalize (GObject *object)
 	g_return_if_fail (ZIF_IS_MD_PRIMARY_XML (object));
 	md = ZIF_MD_PRIMARY_XML (object);
 
-	g_ptr_array_unref (md->priv->array);
-	g_object_unref (md->priv->config);
+	g_object_unref (md->priv->md_sql);
 
 	G_OBJECT_CLASS (zif_md_primary_xml_parent_class)->finalize (object);
 }
@@ -1485,6 +1170,7 @@ zif_md_primary_xml_class_init (ZifMdPrimaryXmlClass *klass)
 	/* map */
 	md_class->load = zif_md_primary_xml_load;
 	md_class->unload = zif_md_primary_xml_unload;
+	md_class->get_memory_usage = zif_md_primary_xml_get_memory_usage;
 	md_class->search_name = zif_md_primary_xml_search_name;
 	md_class->search_details = zif_md_primary_xml_search_details;
 	md_class->search_group = zif_md_primary_xml_search_group;
@@ -1511,12 +1197,17 @@ static void
 zif_md_primary_xml_init (ZifMdPrimaryXml *md)
 {
 	md->priv = ZIF_MD_PRIMARY_XML_GET_PRIVATE (md);
-	md->priv->array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	md->priv->loaded = FALSE;
 	md->priv->section = ZIF_MD_PRIMARY_XML_SECTION_UNKNOWN;
 	md->priv->section_package = ZIF_MD_PRIMARY_XML_SECTION_PACKAGE_UNKNOWN;
-	md->priv->package_temp = NULL;
-	md->priv->config = zif_config_new ();
+	md->priv->md_sql = zif_md_primary_sql_new ();
+	md->priv->db_build = NULL;
+	md->priv->stmt_package = NULL;
+	md->priv->stmt_provides = NULL;
+	md->priv->stmt_requires = NULL;
+	md->priv->stmt_obsoletes = NULL;
+	md->priv->stmt_conflicts = NULL;
+	md->priv->pkgkey_temp = 0;
 }
 
 /**
@@ -1535,4 +1226,3 @@ zif_md_primary_xml_new (void)
 			   NULL);
 	return ZIF_MD (md);
 }
-
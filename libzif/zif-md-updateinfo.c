@@ -78,6 +78,8 @@ struct _ZifMdUpdateinfoPrivate
 	gboolean			 loaded;
 	ZifConfig			*config;
 	GPtrArray			*array_updates;		/* stored as ZifUpdate */
+	GHashTable			*hash_package_id;	/* package_id:GPtrArray of ZifUpdate */
+	GHashTable			*hash_update_id;	/* update_id:ZifUpdate */
 	/* for parser */
 	ZifMdUpdateinfoSection		 section;
 	ZifMdUpdateinfoSectionGroup	 section_group;
@@ -366,6 +368,52 @@ out:
 	g_free (url);
 }
 
+/**
+ * zif_md_updateinfo_add_to_index:
+ **/
+static void
+zif_md_updateinfo_add_to_index (ZifMdUpdateinfo *md, ZifUpdate *update)
+{
+	const gchar *package_id;
+	const gchar *update_id;
+	GPtrArray *array_tmp;
+	GPtrArray *packages;
+	guint i;
+	ZifPackage *package;
+
+	/* the first update with a given ID wins, like the old linear search */
+	update_id = zif_update_get_id (update);
+	if (update_id != NULL &&
+	    g_hash_table_lookup (md->priv->hash_update_id, update_id) == NULL) {
+		g_hash_table_insert (md->priv->hash_update_id,
+				     g_strdup (update_id),
+				     update);
+	}
+
+	/* add a back-reference for each package updated */
+	packages = zif_update_get_packages (update);
+	for (i = 0; i < packages->len; i++) {
+		package = g_ptr_array_index (packages, i);
+		package_id = zif_package_get_id (package);
+		if (package_id == NULL)
+			continue;
+		array_tmp = g_hash_table_lookup (md->priv->hash_package_id, package_id);
+		if (array_tmp == NULL) {
+			array_tmp = g_ptr_array_new ();
+			g_hash_table_insert (md->priv->hash_package_id,
+					     g_strdup (package_id),
+					     array_tmp);
+		}
+
+		/* an update can list the same package more than once */
+		if (array_tmp->len > 0 &&
+		    g_ptr_array_index (array_tmp, array_tmp->len - 1) == update)
+			continue;
+		g_ptr_array_add (array_tmp, update);
+	}
+	g_ptr_array_unref (packages);
+}
+
 /**
  * zif_md_updateinfo_parser_end_element:
  **/
@@ -396,8 +444,9 @@ zif_md_updateinfo_parser_end_element (GMarkupParseContext *context, const gchar
 			zif_md_updateinfo_add_vendor_info (updateinfo,
 							   updateinfo->priv->update_temp);
 
-			/* add to array */
+			/* add to array and indexes */
 			g_ptr_array_add (updateinfo->priv->array_updates, updateinfo->priv->update_temp);
+			zif_md_updateinfo_add_to_index (updateinfo, updateinfo->priv->update_temp);
 			updateinfo->priv->update_temp = NULL;
 			goto out;
 		}
@@ -645,12 +694,9 @@ zif_md_updateinfo_get_detail_for_package (ZifMdUpdateinfo *md, const gchar *pack
 	GPtrArray *array = NULL;
 	GPtrArray *array_tmp;
 	guint i;
-	guint j;
-	guint len;
 	gboolean ret;
 	GError *error_local = NULL;
 	ZifUpdate *update;
-	ZifPackage *package;
 
 	g_return_val_if_fail (ZIF_IS_MD_UPDATEINFO (md), NULL);
 	g_return_val_if_fail (package_id != NULL, NULL);
@@ -668,40 +714,74 @@ zif_md_updateinfo_get_detail_for_package (ZifMdUpdateinfo *md, const gchar *pack
 		}
 	}
 
-	/* get packages in this group */
-	len = md->priv->array_updates->len;
-	for (i = 0; i < len; i++) {
-		update = g_ptr_array_index (md->priv->array_updates, i);
-
-		/* have we matched on any entries */
-		ret = FALSE;
-
-		/* get the list of packages updated by this update */
-		array_tmp = zif_update_get_packages (update);
-		for (j = 0; j < array_tmp->len; j++) {
-			package = g_ptr_array_index (array_tmp, j);
-			if (g_strcmp0 (zif_package_get_id (package), package_id) == 0) {
-				ret = TRUE;
-				break;
-			}
-		}
+	/* get the updates that reference this package */
+	array_tmp = g_hash_table_lookup (md->priv->hash_package_id, package_id);
+	if (array_tmp == NULL) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED,
+			     "could not find package (%i in sack): %s",
+			     md->priv->array_updates->len, package_id);
+		goto out;
+	}
+
+	/* copy so the caller can modify the result */
+	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; i < array_tmp->len; i++) {
+		update = g_ptr_array_index (array_tmp, i);
+		g_ptr_array_add (array, g_object_ref (update));
+	}
+out:
+	return array;
+}
 
-		/* we found a package match */
-		if (ret) {
-			if (array == NULL)
-				array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-			g_ptr_array_add (array, g_object_ref (update));
+/**
+ * zif_md_updateinfo_get_detail_for_id:
+ * @md: A #ZifMdUpdateinfo
+ * @update_id: The update ID to use, e.g. "FEDORA-2008-9969"
+ * @state: A %ZifState
+ * @error: A #GError, or %NULL
+ *
+ * Gets the update detail for a specific update ID.
+ *
+ * Return value: (transfer full): A #ZifUpdate, or %NULL for error
+ *
+ * Since: 0.3.7
+ **/
+ZifUpdate *
+zif_md_updateinfo_get_detail_for_id (ZifMdUpdateinfo *md, const gchar *update_id,
+				     ZifState *state, GError **error)
+{
+	ZifUpdate *update = NULL;
+	ZifUpdate *update_tmp;
+	gboolean ret;
+	GError *error_local = NULL;
+
+	g_return_val_if_fail (ZIF_IS_MD_UPDATEINFO (md), NULL);
+	g_return_val_if_fail (update_id != NULL, NULL);
+	g_return_val_if_fail (zif_state_valid (state), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* if not already loaded, load */
+	if (!md->priv->loaded) {
+		ret = zif_md_load (ZIF_MD (md), state, &error_local);
+		if (!ret) {
+			g_propagate_prefixed_error (error,
+						    error_local,
+						    "failed to get load updateinfo: ");
+			goto out;
 		}
-		g_ptr_array_unref (array_tmp);
 	}
 
-	/* nothing found */
-	if (array == NULL) {
+	/* find the update */
+	update_tmp = g_hash_table_lookup (md->priv->hash_update_id, update_id);
+	if (update_tmp == NULL) {
 		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED,
-			     "could not find package (%i in sack): %s", len, package_id);
+			     "could not find update (%i in sack): %s",
+			     md->priv->array_updates->len, update_id);
+		goto out;
 	}
+	update = g_object_ref (update_tmp);
 out:
-	return array;
+	return update;
 }
 
 /**
@@ -718,6 +798,8 @@ zif_md_updateinfo_finalize (GObject *object)
 
 	g_object_unref (md->priv->config);
 	g_ptr_array_unref (md->priv->array_updates);
+	g_hash_table_unref (md->priv->hash_package_id);
+	g_hash_table_unref (md->priv->hash_update_id);
 
 	G_OBJECT_CLASS (zif_md_updateinfo_parent_class)->finalize (object);
 }
@@ -754,6 +836,10 @@ zif_md_updateinfo_init (ZifMdUpdateinfo *md)
 	md->priv->update_info_temp = NULL;
 	md->priv->package_temp = NULL;
 	md->priv->array_updates = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	md->priv->hash_package_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+							   g_free, (GDestroyNotify) g_ptr_array_unref);
+	md->priv->hash_update_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+							  g_free, NULL);
 }
 
 /**
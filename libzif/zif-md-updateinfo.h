@@ -29,6 +29,7 @@
 #include <glib-object.h>
 
 #include "zif-md.h"
+#include "zif-update.h"
 
 G_BEGIN_DECLS
 
@@ -69,6 +70,10 @@ GPtrArray	*zif_md_updateinfo_get_detail_for_package (ZifMdUpdateinfo	*md,
 							 const gchar		*package_id,
 							 ZifState		*state,
 							 GError			**error);
+ZifUpdate	*zif_md_updateinfo_get_detail_for_id	(ZifMdUpdateinfo	*md,
+							 const gchar		*update_id,
+							 ZifState		*state,
+							 GError			**error);
 
 G_END_DECLS
 
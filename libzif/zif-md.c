@@ -37,10 +37,13 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/types.h>
+#include <unistd.h>
+#include <sqlite3.h>
 #include <attr/xattr.h>
 
 #include "zif-config.h"
 #include "zif-md.h"
+#include "zif-md-private.h"
 #include "zif-state-private.h"
 #include "zif-store-remote-private.h"
 #include "zif-utils.h"
@@ -58,6 +61,7 @@ struct _ZifMdPrivate
 	gchar			*id;			/* fedora */
 	gchar			*filename;		/* /var/cache/yum/fedora/repo.sqlite.bz2 */
 	gchar			*filename_uncompressed;	/* /var/cache/yum/fedora/repo.sqlite */
+	gchar			*filename_index;	/* /var/cache/yum/fedora/repo.sqlite.index */
 	guint			 timestamp;
 	gchar			*location;		/* repodata/35d817e-primary.sqlite.bz2 */
 	gchar			*checksum;		/* of compressed file */
@@ -197,6 +201,272 @@ zif_md_get_filename_uncompressed (ZifMd *md)
 	return md->priv->filename_uncompressed;
 }
 
+/**
+ * zif_md_get_checksum_uncompressed:
+ * @md: A #ZifMd
+ *
+ * Gets the expected checksum of the uncompressed file, falling back to
+ * the checksum of the compressed file if the repomd did not specify one.
+ *
+ * Return value: The checksum, or %NULL if not set
+ *
+ * Since: 0.3.7
+ **/
+const gchar *
+zif_md_get_checksum_uncompressed (ZifMd *md)
+{
+	g_return_val_if_fail (ZIF_IS_MD (md), NULL);
+	if (md->priv->checksum_uncompressed != NULL)
+		return md->priv->checksum_uncompressed;
+	return md->priv->checksum;
+}
+
+/**
+ * zif_md_get_filename_index:
+ * @md: A #ZifMd
+ *
+ * Gets the filename of the index that subclasses may build from the
+ * uncompressed file to avoid parsing it again.
+ *
+ * Return value: The index filename, e.g. "/var/cache/dave.xml.index"
+ *
+ * Since: 0.3.7
+ **/
+const gchar *
+zif_md_get_filename_index (ZifMd *md)
+{
+	g_return_val_if_fail (ZIF_IS_MD (md), NULL);
+	return md->priv->filename_index;
+}
+
+/**
+ * zif_md_index_is_valid: (skip)
+ * @filename_index: The index filename, e.g. "/var/cache/dave.xml.index"
+ * @version: The schema version the caller expects
+ * @checksum: The checksum of the data the index should be built from
+ *
+ * Checks an existing index was built from the same data by this
+ * version of the schema, and so can be reused.
+ *
+ * Return value: %TRUE if the index can be reused
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_md_index_is_valid (const gchar *filename_index,
+		       guint version,
+		       const gchar *checksum)
+{
+	gboolean ret = FALSE;
+	gint rc;
+	sqlite3 *db = NULL;
+	sqlite3_stmt *stmt = NULL;
+
+	/* no checksum to compare */
+	if (checksum == NULL)
+		goto out;
+	if (!g_file_test (filename_index, G_FILE_TEST_EXISTS))
+		goto out;
+
+	rc = sqlite3_open_v2 (filename_index, &db, SQLITE_OPEN_READONLY, NULL);
+	if (rc != SQLITE_OK)
+		goto out;
+	rc = sqlite3_prepare_v2 (db,
+				 "SELECT version, checksum FROM info",
+				 -1, &stmt, NULL);
+	if (rc != SQLITE_OK)
+		goto out;
+	rc = sqlite3_step (stmt);
+	if (rc != SQLITE_ROW)
+		goto out;
+	if (sqlite3_column_int (stmt, 0) != (gint) version)
+		goto out;
+	ret = (g_strcmp0 ((const gchar *) sqlite3_column_text (stmt, 1), checksum) == 0);
+out:
+	if (stmt != NULL)
+		sqlite3_finalize (stmt);
+	if (db != NULL)
+		sqlite3_close (db);
+	return ret;
+}
+
+/**
+ * zif_md_index_build_begin: (skip)
+ * @filename_index: The index filename, e.g. "/var/cache/dave.xml.index"
+ * @schema: The SQL to create the tables, e.g. "CREATE TABLE packages (pkgId TEXT);"
+ * @filename_tmp: (out): The temporary filename, free with g_free()
+ * @error: A #GError, or %NULL
+ *
+ * Creates a new index in a temporary file and starts a transaction.
+ * The index is only moved into place by zif_md_index_build_finish(),
+ * so other processes never see a partial index.
+ *
+ * Return value: The open database, or %NULL for failure
+ *
+ * Since: 0.3.7
+ **/
+sqlite3 *
+zif_md_index_build_begin (const gchar *filename_index,
+			  const gchar *schema,
+			  gchar **filename_tmp,
+			  GError **error)
+{
+	gchar *error_msg = NULL;
+	gchar *statement;
+	gint rc;
+	sqlite3 *db = NULL;
+
+	g_return_val_if_fail (filename_index != NULL, NULL);
+	g_return_val_if_fail (schema != NULL, NULL);
+	g_return_val_if_fail (filename_tmp != NULL, NULL);
+
+	/* create the new database */
+	*filename_tmp = g_strdup_printf ("%s.%i.tmp", filename_index, getpid ());
+	g_unlink (*filename_tmp);
+	rc = sqlite3_open (*filename_tmp, &db);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "SQL error (failed to create index): %s",
+			     sqlite3_errmsg (db));
+		goto out;
+	}
+
+	/* nothing else can see this file, so don't bother journaling */
+	statement = g_strconcat ("PRAGMA synchronous=OFF;"
+				 "PRAGMA journal_mode=OFF;"
+				 "CREATE TABLE info (version INTEGER, checksum TEXT);",
+				 schema,
+				 "BEGIN TRANSACTION;",
+				 NULL);
+	rc = sqlite3_exec (db, statement, NULL, NULL, &error_msg);
+	g_free (statement);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "SQL error (failed to create tables): %s", error_msg);
+		sqlite3_free (error_msg);
+		goto out;
+	}
+	return db;
+out:
+	zif_md_index_build_abort (db, *filename_tmp);
+	g_free (*filename_tmp);
+	*filename_tmp = NULL;
+	return NULL;
+}
+
+/**
+ * zif_md_index_build_finish: (skip)
+ * @db: The database returned by zif_md_index_build_begin()
+ * @filename_tmp: The temporary filename
+ * @filename_index: The index filename, e.g. "/var/cache/dave.xml.index"
+ * @indexes: The SQL to create the indexes, e.g. "CREATE INDEX pkgid ON packages (pkgId);"
+ * @version: The schema version to record
+ * @checksum: The checksum of the data the index was built from, or %NULL
+ * @error: A #GError, or %NULL
+ *
+ * Creates the indexes once all the data has been added, records the
+ * checksum and moves the index into place. The database is always
+ * closed, and the temporary file is removed on failure. Any prepared
+ * statements must be finalized before calling this.
+ *
+ * Return value: %TRUE for success
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_md_index_build_finish (sqlite3 *db,
+			   const gchar *filename_tmp,
+			   const gchar *filename_index,
+			   const gchar *indexes,
+			   guint version,
+			   const gchar *checksum,
+			   GError **error)
+{
+	gboolean ret = FALSE;
+	gchar *error_msg = NULL;
+	gint rc;
+	sqlite3_stmt *stmt = NULL;
+
+	g_return_val_if_fail (db != NULL, FALSE);
+	g_return_val_if_fail (filename_tmp != NULL, FALSE);
+	g_return_val_if_fail (filename_index != NULL, FALSE);
+
+	/* create the indexes after the data has been added */
+	rc = sqlite3_exec (db, indexes, NULL, NULL, &error_msg);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "SQL error (failed to create index): %s", error_msg);
+		sqlite3_free (error_msg);
+		goto out;
+	}
+
+	/* only record the checksum when everything else has succeeded */
+	rc = sqlite3_prepare_v2 (db,
+				 "INSERT INTO info (version, checksum) VALUES (?, ?)",
+				 -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "SQL error (failed to prepare info): %s",
+			     sqlite3_errmsg (db));
+		goto out;
+	}
+	sqlite3_bind_int (stmt, 1, version);
+	sqlite3_bind_text (stmt, 2, checksum != NULL ? checksum : "", -1, SQLITE_STATIC);
+	rc = sqlite3_step (stmt);
+	if (rc != SQLITE_DONE) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "SQL error (failed to add info): %s",
+			     sqlite3_errmsg (db));
+		goto out;
+	}
+	rc = sqlite3_exec (db, "COMMIT;", NULL, NULL, &error_msg);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_BAD_SQL,
+			     "SQL error (failed to commit): %s", error_msg);
+		sqlite3_free (error_msg);
+		goto out;
+	}
+
+	/* move into place */
+	sqlite3_finalize (stmt);
+	stmt = NULL;
+	sqlite3_close (db);
+	db = NULL;
+	if (g_rename (filename_tmp, filename_index) != 0) {
+		g_set_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED,
+			     "failed to rename %s to %s",
+			     filename_tmp, filename_index);
+		goto out;
+	}
+
+	/* success */
+	ret = TRUE;
+out:
+	if (stmt != NULL)
+		sqlite3_finalize (stmt);
+	if (!ret)
+		zif_md_index_build_abort (db, filename_tmp);
+	return ret;
+}
+
+/**
+ * zif_md_index_build_abort: (skip)
+ * @db: The database returned by zif_md_index_build_begin(), or %NULL
+ * @filename_tmp: The temporary filename
+ *
+ * Closes the database and removes the partial index.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_md_index_build_abort (sqlite3 *db, const gchar *filename_tmp)
+{
+	if (db != NULL)
+		sqlite3_close (db);
+	if (filename_tmp != NULL)
+		g_unlink (filename_tmp);
+}
+
 /**
  * zif_md_set_filename:
  * @md: A #ZifMd
@@ -223,6 +493,10 @@ zif_md_set_filename (ZifMd *md, const gchar *filename)
 	/* this is the uncompressed name */
 	g_free (md->priv->filename_uncompressed);
 	md->priv->filename_uncompressed = zif_file_get_uncompressed_name (filename);
+
+	/* this is the index built from the uncompressed file */
+	g_free (md->priv->filename_index);
+	md->priv->filename_index = g_strdup_printf ("%s.index", md->priv->filename_uncompressed);
 }
 
 /**
@@ -1639,12 +1913,44 @@ zif_md_clean (ZifMd *md, GError **error)
 		}
 	}
 
+	/* any index built from the uncompressed file is now stale */
+	zif_md_delete_file (md->priv->filename_index);
+
 	/* okay */
 	ret = TRUE;
 out:
 	return ret;
 }
 
+/**
+ * zif_md_get_memory_usage:
+ * @md: A #ZifMd
+ * @memory: A #ZifMemory to add the sizes to
+ *
+ * Adds the memory used by any data the metadata object keeps loaded,
+ * for instance parsed packages or the database page cache, to @memory.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_md_get_memory_usage (ZifMd *md, ZifMemory *memory)
+{
+	ZifMdClass *klass = ZIF_MD_GET_CLASS (md);
+
+	g_return_if_fail (ZIF_IS_MD (md));
+	g_return_if_fail (ZIF_IS_MEMORY (memory));
+
+	/* nothing loaded */
+	if (!md->priv->loaded)
+		return;
+	if (!zif_memory_visit (memory, md))
+		return;
+
+	/* superclass */
+	if (klass->get_memory_usage != NULL)
+		klass->get_memory_usage (md, memory);
+}
+
 /**
  * zif_md_kind_to_text:
  *
@@ -2313,6 +2619,7 @@ zif_md_finalize (GObject *object)
 	g_free (md->priv->id);
 	g_free (md->priv->filename);
 	g_free (md->priv->filename_uncompressed);
+	g_free (md->priv->filename_index);
 	g_free (md->priv->location);
 	g_free (md->priv->checksum);
 	g_free (md->priv->checksum_uncompressed);
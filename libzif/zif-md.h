@@ -31,6 +31,7 @@
 
 #include "zif-depend.h"
 #include "zif-md.h"
+#include "zif-memory.h"
 #include "zif-state.h"
 #include "zif-store.h"
 
@@ -136,8 +137,9 @@ struct _ZifMdClass
 						 ZifPackage		*package,
 						 ZifState		*state,
 						 GError			**error);
+	void		 (*get_memory_usage)	(ZifMd			*md,
+						 ZifMemory		*memory);
 	/* Padding for future expansion */
-	void (*_zif_reserved1) (void);
 	void (*_zif_reserved2) (void);
 	void (*_zif_reserved3) (void);
 	void (*_zif_reserved4) (void);
@@ -208,6 +210,8 @@ const gchar	*zif_md_get_id				(ZifMd		*md);
 ZifMdKind	 zif_md_get_kind			(ZifMd		*md);
 const gchar	*zif_md_get_filename			(ZifMd		*md);
 const gchar	*zif_md_get_filename_uncompressed	(ZifMd		*md);
+const gchar	*zif_md_get_filename_index		(ZifMd		*md);
+const gchar	*zif_md_get_checksum_uncompressed	(ZifMd		*md);
 const gchar	*zif_md_get_location			(ZifMd		*md);
 
 /* actions */
@@ -219,6 +223,8 @@ gboolean	 zif_md_unload				(ZifMd		*md,
 							 GError		**error);
 gboolean	 zif_md_clean				(ZifMd		*md,
 							 GError		**error);
+void		 zif_md_get_memory_usage		(ZifMd		*md,
+							 ZifMemory	*memory);
 gboolean	 zif_md_file_check			(ZifMd		*md,
 							 gboolean	 use_uncompressed,
 							 gboolean	*valid,
@@ -0,0 +1,369 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2011 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * SECTION:zif-memory
+ * @short_description: Memory accounting for stores and packages
+ *
+ * A #ZifMemory object is passed to zif_store_get_memory_usage() or
+ * zif_package_get_memory_usage() and collects the number of bytes used
+ * by each category of object.
+ *
+ * Objects that are shared between packages, for instance the #ZifString
+ * used for a common license, are only counted once. The sizes of the
+ * GLib containers are estimated from the number of items they hold, so
+ * the totals should be used for comparison rather than as exact values.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+#include <string.h>
+
+#include "zif-memory.h"
+
+#define ZIF_MEMORY_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_MEMORY, ZifMemoryPrivate))
+
+struct _ZifMemoryPrivate
+{
+	guint64			 size[ZIF_MEMORY_KIND_LAST];
+	GHashTable		*visited;
+};
+
+G_DEFINE_TYPE (ZifMemory, zif_memory, G_TYPE_OBJECT)
+
+/**
+ * zif_memory_kind_to_string:
+ * @kind: A #ZifMemoryKind
+ *
+ * Converts the kind to a string.
+ *
+ * Return value: A static string, e.g. "packages"
+ *
+ * Since: 0.3.7
+ **/
+const gchar *
+zif_memory_kind_to_string (ZifMemoryKind kind)
+{
+	if (kind == ZIF_MEMORY_KIND_PACKAGES)
+		return "packages";
+	if (kind == ZIF_MEMORY_KIND_STRINGS)
+		return "strings";
+	if (kind == ZIF_MEMORY_KIND_DEPENDS)
+		return "depends";
+	if (kind == ZIF_MEMORY_KIND_HASHES)
+		return "hashes";
+	if (kind == ZIF_MEMORY_KIND_FILES)
+		return "files";
+	if (kind == ZIF_MEMORY_KIND_MD)
+		return "md";
+	return "unknown";
+}
+
+/**
+ * zif_memory_visit:
+ * @memory: A #ZifMemory
+ * @object: An object or structure that may be shared
+ *
+ * Records that @object has been accounted for.
+ *
+ * Return value: %TRUE if the object has not been visited before
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_memory_visit (ZifMemory *memory, gconstpointer object)
+{
+	g_return_val_if_fail (ZIF_IS_MEMORY (memory), FALSE);
+	g_return_val_if_fail (object != NULL, FALSE);
+
+	if (g_hash_table_lookup (memory->priv->visited, object) != NULL)
+		return FALSE;
+	g_hash_table_insert (memory->priv->visited,
+			     (gpointer) object,
+			     GINT_TO_POINTER (1));
+	return TRUE;
+}
+
+/**
+ * zif_memory_add:
+ * @memory: A #ZifMemory
+ * @kind: A #ZifMemoryKind
+ * @bytes: The number of bytes to add
+ *
+ * Adds a number of bytes to a category.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_memory_add (ZifMemory *memory, ZifMemoryKind kind, gsize bytes)
+{
+	g_return_if_fail (ZIF_IS_MEMORY (memory));
+	g_return_if_fail (kind < ZIF_MEMORY_KIND_LAST);
+	memory->priv->size[kind] += bytes;
+}
+
+/**
+ * zif_memory_add_string:
+ * @memory: A #ZifMemory
+ * @kind: A #ZifMemoryKind
+ * @value: A string, or %NULL
+ *
+ * Adds the size of a string to a category.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_memory_add_string (ZifMemory *memory, ZifMemoryKind kind, const gchar *value)
+{
+	if (value == NULL)
+		return;
+	zif_memory_add (memory, kind, strlen (value) + 1);
+}
+
+/**
+ * zif_memory_add_zif_string:
+ * @memory: A #ZifMemory
+ * @string: A #ZifString, or %NULL
+ *
+ * Adds the size of a reference counted string, unless it has already
+ * been counted.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_memory_add_zif_string (ZifMemory *memory, ZifString *string)
+{
+	if (string == NULL)
+		return;
+	if (!zif_memory_visit (memory, string))
+		return;
+	zif_memory_add (memory,
+			ZIF_MEMORY_KIND_STRINGS,
+			zif_string_get_size (string));
+}
+
+/**
+ * zif_memory_get_allocated:
+ *
+ * GLib grows arrays and hash tables in powers of two.
+ **/
+static gsize
+zif_memory_get_allocated (gsize items, gsize minimum)
+{
+	gsize allocated = minimum;
+	while (allocated < items)
+		allocated <<= 1;
+	return allocated;
+}
+
+/**
+ * zif_memory_add_ptr_array:
+ * @memory: A #ZifMemory
+ * @kind: A #ZifMemoryKind
+ * @array: A #GPtrArray, or %NULL
+ *
+ * Adds the estimated size of the array, but not the size of the items
+ * it contains. Arrays that have already been counted are ignored.
+ *
+ * Return value: %TRUE if the array has not been counted before
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_memory_add_ptr_array (ZifMemory *memory, ZifMemoryKind kind, GPtrArray *array)
+{
+	gsize size;
+
+	if (array == NULL)
+		return FALSE;
+	if (!zif_memory_visit (memory, array))
+		return FALSE;
+
+	/* pdata, len, alloc, ref_count and element_free_func */
+	size = 5 * sizeof (gpointer);
+	if (array->len > 0)
+		size += zif_memory_get_allocated (array->len, 16) * sizeof (gpointer);
+	zif_memory_add (memory, kind, size);
+	return TRUE;
+}
+
+/**
+ * zif_memory_add_hash_table:
+ * @memory: A #ZifMemory
+ * @hash: A #GHashTable, or %NULL
+ *
+ * Adds the estimated size of the hash table, but not the size of the
+ * keys and values it contains. Hash tables that have already been
+ * counted are ignored.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_memory_add_hash_table (ZifMemory *memory, GHashTable *hash)
+{
+	gsize buckets;
+	gsize size;
+
+	if (hash == NULL)
+		return;
+	if (!zif_memory_visit (memory, hash))
+		return;
+
+	/* each bucket has a key, a value and a hash, and the table is
+	 * resized when it is more than three quarters full */
+	buckets = zif_memory_get_allocated (g_hash_table_size (hash) * 4 / 3 + 1, 8);
+	size = 12 * sizeof (gpointer);
+	size += buckets * (2 * sizeof (gpointer) + sizeof (guint));
+	zif_memory_add (memory, ZIF_MEMORY_KIND_HASHES, size);
+}
+
+/**
+ * zif_memory_get_size:
+ * @memory: A #ZifMemory
+ * @kind: A #ZifMemoryKind
+ *
+ * Gets the number of bytes used by a category.
+ *
+ * Return value: the size in bytes
+ *
+ * Since: 0.3.7
+ **/
+guint64
+zif_memory_get_size (ZifMemory *memory, ZifMemoryKind kind)
+{
+	g_return_val_if_fail (ZIF_IS_MEMORY (memory), 0);
+	g_return_val_if_fail (kind < ZIF_MEMORY_KIND_LAST, 0);
+	return memory->priv->size[kind];
+}
+
+/**
+ * zif_memory_get_total:
+ * @memory: A #ZifMemory
+ *
+ * Gets the number of bytes used by all the categories.
+ *
+ * Return value: the size in bytes
+ *
+ * Since: 0.3.7
+ **/
+guint64
+zif_memory_get_total (ZifMemory *memory)
+{
+	guint i;
+	guint64 total = 0;
+
+	g_return_val_if_fail (ZIF_IS_MEMORY (memory), 0);
+
+	for (i = 0; i < ZIF_MEMORY_KIND_LAST; i++)
+		total += memory->priv->size[i];
+	return total;
+}
+
+/**
+ * zif_memory_to_string:
+ * @memory: A #ZifMemory
+ *
+ * Gets a human readable report of the memory used by each category.
+ *
+ * Return value: A string, free with g_free()
+ *
+ * Since: 0.3.7
+ **/
+gchar *
+zif_memory_to_string (ZifMemory *memory)
+{
+	gchar *tmp;
+	GString *string;
+	guint i;
+
+	g_return_val_if_fail (ZIF_IS_MEMORY (memory), NULL);
+
+	string = g_string_new ("");
+	for (i = 0; i < ZIF_MEMORY_KIND_LAST; i++) {
+		tmp = g_format_size (memory->priv->size[i]);
+		g_string_append_printf (string, "%-10s\t%" G_GUINT64_FORMAT "\t%s\n",
+					zif_memory_kind_to_string (i),
+					memory->priv->size[i],
+					tmp);
+		g_free (tmp);
+	}
+	tmp = g_format_size (zif_memory_get_total (memory));
+	g_string_append_printf (string, "%-10s\t%" G_GUINT64_FORMAT "\t%s\n",
+				"total",
+				zif_memory_get_total (memory),
+				tmp);
+	g_free (tmp);
+	return g_string_free (string, FALSE);
+}
+
+/**
+ * zif_memory_finalize:
+ **/
+static void
+zif_memory_finalize (GObject *object)
+{
+	ZifMemory *memory;
+	g_return_if_fail (ZIF_IS_MEMORY (object));
+	memory = ZIF_MEMORY (object);
+
+	g_hash_table_unref (memory->priv->visited);
+
+	G_OBJECT_CLASS (zif_memory_parent_class)->finalize (object);
+}
+
+/**
+ * zif_memory_class_init:
+ **/
+static void
+zif_memory_class_init (ZifMemoryClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = zif_memory_finalize;
+	g_type_class_add_private (klass, sizeof (ZifMemoryPrivate));
+}
+
+/**
+ * zif_memory_init:
+ **/
+static void
+zif_memory_init (ZifMemory *memory)
+{
+	memory->priv = ZIF_MEMORY_GET_PRIVATE (memory);
+	memory->priv->visited = g_hash_table_new (g_direct_hash, g_direct_equal);
+}
+
+/**
+ * zif_memory_new:
+ *
+ * Return value: A new #ZifMemory instance.
+ *
+ * Since: 0.3.7
+ **/
+ZifMemory *
+zif_memory_new (void)
+{
+	ZifMemory *memory;
+	memory = g_object_new (ZIF_TYPE_MEMORY, NULL);
+	return ZIF_MEMORY (memory);
+}
@@ -0,0 +1,98 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2011 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#if !defined (__ZIF_H_INSIDE__) && !defined (ZIF_COMPILATION)
+#error "Only <zif.h> can be included directly."
+#endif
+
+#ifndef __ZIF_MEMORY_H
+#define __ZIF_MEMORY_H
+
+#include <glib-object.h>
+
+#include "zif-string.h"
+
+G_BEGIN_DECLS
+
+#define ZIF_TYPE_MEMORY		(zif_memory_get_type ())
+#define ZIF_MEMORY(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), ZIF_TYPE_MEMORY, ZifMemory))
+#define ZIF_MEMORY_CLASS(k)	(G_TYPE_CHECK_CLASS_CAST((k), ZIF_TYPE_MEMORY, ZifMemoryClass))
+#define ZIF_IS_MEMORY(o)	(G_TYPE_CHECK_INSTANCE_TYPE ((o), ZIF_TYPE_MEMORY))
+#define ZIF_IS_MEMORY_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), ZIF_TYPE_MEMORY))
+#define ZIF_MEMORY_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), ZIF_TYPE_MEMORY, ZifMemoryClass))
+
+typedef struct _ZifMemoryPrivate	ZifMemoryPrivate;
+typedef struct _ZifMemory		ZifMemory;
+typedef struct _ZifMemoryClass		ZifMemoryClass;
+
+struct _ZifMemory
+{
+	 GObject		 parent;
+	 ZifMemoryPrivate	*priv;
+};
+
+struct _ZifMemoryClass
+{
+	GObjectClass		parent_class;
+	/* Padding for future expansion */
+	void (*_zif_reserved1) (void);
+	void (*_zif_reserved2) (void);
+	void (*_zif_reserved3) (void);
+	void (*_zif_reserved4) (void);
+};
+
+typedef enum {
+	ZIF_MEMORY_KIND_PACKAGES,
+	ZIF_MEMORY_KIND_STRINGS,
+	ZIF_MEMORY_KIND_DEPENDS,
+	ZIF_MEMORY_KIND_HASHES,
+	ZIF_MEMORY_KIND_FILES,
+	ZIF_MEMORY_KIND_MD,
+	ZIF_MEMORY_KIND_LAST
+} ZifMemoryKind;
+
+GType		 zif_memory_get_type			(void);
+ZifMemory	*zif_memory_new				(void);
+
+const gchar	*zif_memory_kind_to_string		(ZifMemoryKind	 kind);
+gboolean	 zif_memory_visit			(ZifMemory	*memory,
+							 gconstpointer	 object);
+void		 zif_memory_add				(ZifMemory	*memory,
+							 ZifMemoryKind	 kind,
+							 gsize		 bytes);
+void		 zif_memory_add_string			(ZifMemory	*memory,
+							 ZifMemoryKind	 kind,
+							 const gchar	*value);
+void		 zif_memory_add_zif_string		(ZifMemory	*memory,
+							 ZifString	*string);
+gboolean	 zif_memory_add_ptr_array		(ZifMemory	*memory,
+							 ZifMemoryKind	 kind,
+							 GPtrArray	*array);
+void		 zif_memory_add_hash_table		(ZifMemory	*memory,
+							 GHashTable	*hash);
+guint64		 zif_memory_get_size			(ZifMemory	*memory,
+							 ZifMemoryKind	 kind);
+guint64		 zif_memory_get_total			(ZifMemory	*memory);
+gchar		*zif_memory_to_string			(ZifMemory	*memory);
+
+G_END_DECLS
+
+#endif /* __ZIF_MEMORY_H */
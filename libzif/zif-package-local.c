@@ -252,12 +252,11 @@ zif_package_local_ensure_data (ZifPackage *pkg,
 			       ZifState *state,
 			       GError **error)
 {
-	GPtrArray *files;
+	ZifFileList *files;
 	GPtrArray *dirnames;
 	GPtrArray *basenames;
 	GPtrArray *fileindex;
 	guint i;
-	gchar *filename;
 	guint size;
 	ZifString *tmp;
 	const gchar *text;
@@ -283,9 +282,10 @@ zif_package_local_ensure_data (ZifPackage *pkg,
 
 	if (type == ZIF_PACKAGE_ENSURE_TYPE_FILES) {
 		/* files */
+		files = zif_file_list_new ();
 		basenames = zif_get_header_string_array (header, RPMTAG_BASENAMES);
 
-		/* create the files */
+		/* add the files without building the full paths */
 		if (basenames != NULL) {
 
 			/* get the mapping */
@@ -295,37 +295,40 @@ zif_package_local_ensure_data (ZifPackage *pkg,
 				g_set_error_literal (error, ZIF_PACKAGE_ERROR, ZIF_PACKAGE_ERROR_FAILED,
 						     "internal error, basenames length is not the same as index length, "
 						     "possibly corrupt db?");
+				zif_file_list_unref (files);
 				goto out;
 			}
 
-			files = g_ptr_array_new_with_free_func (g_free);
 			for (i = 0; i < basenames->len; i++) {
 				guint idx;
 				idx = GPOINTER_TO_UINT (g_ptr_array_index (fileindex, i));
-				if (idx > dirnames->len) {
+				if (idx >= dirnames->len) {
 					g_warning ("index bigger than dirnames (%i > %i) for package %s [%s], i=%i, dn=%i, bn=%i, fi=%i",
 						     idx, dirnames->len, zif_package_get_id (pkg),
 						     (const gchar *) g_ptr_array_index (basenames, i),
 						     i, dirnames->len, basenames->len, fileindex->len);
 					continue;
 				}
-				filename = g_strconcat (g_ptr_array_index (dirnames, idx), g_ptr_array_index (basenames, i), NULL);
-				g_ptr_array_add (files, filename);
+				zif_file_list_add (files,
+						   g_ptr_array_index (dirnames, idx),
+						   g_ptr_array_index (basenames, i));
 			}
-			zif_package_set_files (pkg, files);
-			zif_package_set_provides_files (pkg, files);
-			g_ptr_array_unref (files);
 
 			/* free, as we have files */
 			g_ptr_array_unref (dirnames);
 			g_ptr_array_unref (basenames);
 			g_ptr_array_unref (fileindex);
-		} else {
-			files = g_ptr_array_new_with_free_func (g_free);
-			zif_package_set_files (pkg, files);
-			zif_package_set_provides_files (pkg, files);
-			g_ptr_array_unref (files);
 		}
+		zif_package_set_file_list (pkg, files);
+		zif_file_list_unref (files);
+
+	} else if (type == ZIF_PACKAGE_ENSURE_TYPE_FILE_DIRS) {
+		/* just the directories, which is a much smaller list */
+		dirnames = zif_get_header_string_array (header, RPMTAG_DIRNAMES);
+		if (dirnames == NULL)
+			dirnames = g_ptr_array_new_with_free_func (g_free);
+		zif_package_set_file_dirs (pkg, dirnames);
+		g_ptr_array_unref (dirnames);
 
 	} else if (type == ZIF_PACKAGE_ENSURE_TYPE_SUMMARY) {
 		/* summary */
@@ -559,6 +562,10 @@ zif_package_local_set_from_header (ZifPackageLocal *pkg,
 	}
 	zif_package_set_pkgid (ZIF_PACKAGE (pkg), pkgid);
 
+	/* the build time is used to bound the update changelog */
+	zif_package_set_time_file (ZIF_PACKAGE (pkg),
+				   headerGetNumber (header, RPMTAG_BUILDTIME));
+
 	/* non-installed ZifPackageLocal objects are local files */
 	installed = zif_package_is_installed (ZIF_PACKAGE (pkg));
 
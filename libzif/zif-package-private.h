@@ -67,8 +67,13 @@ void			 zif_package_add_file		(ZifPackage	*package,
 							 const gchar	*filename);
 void			 zif_package_set_files		(ZifPackage	*package,
 							 GPtrArray	*files);
-void			 zif_package_set_provides_files	(ZifPackage	*package,
-							 GPtrArray	*files);
+void			 zif_package_set_file_list	(ZifPackage	*package,
+							 ZifFileList	*files);
+void			 zif_package_set_file_dirs	(ZifPackage	*package,
+							 GPtrArray	*dirs);
+GPtrArray		*zif_package_get_provides_no_files (ZifPackage	*package,
+							 ZifState	*state,
+							 GError		**error);
 void			 zif_package_add_require	(ZifPackage	*package,
 							 ZifDepend	*depend);
 void			 zif_package_add_provide	(ZifPackage	*package,
@@ -31,11 +31,13 @@
 #endif
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <libsoup/soup.h>
 #include <stdlib.h>
 
 #include "zif-package-private.h"
 #include "zif-package-rhn.h"
+#include "zif-package-rhn-private.h"
 
 #define ZIF_PACKAGE_RHN_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_PACKAGE_RHN, ZifPackageRhnPrivate))
 
@@ -48,6 +50,7 @@ struct _ZifPackageRhnPrivate
 {
 	gchar			*server;
 	gchar			*session_key;
+	gchar			*cache_dir;
 	guint			 id;
 	SoupSession		*session;
 };
@@ -55,58 +58,17 @@ struct _ZifPackageRhnPrivate
 G_DEFINE_TYPE (ZifPackageRhn, zif_package_rhn, ZIF_TYPE_PACKAGE)
 
 /*
- * zif_package_rhn_get_details:
+ * zif_package_rhn_set_details:
  */
 static gboolean
-zif_package_rhn_get_details (ZifPackageRhn *rhn,
-			     ZifState *state,
+zif_package_rhn_set_details (ZifPackageRhn *rhn,
+			     GHashTable *hash,
 			     GError **error)
 {
-	gboolean ret;
-	GError *error_local = NULL;
-	GHashTable *hash = NULL;
 	GValue *value;
-	SoupMessage *msg;
 	ZifPackage *pkg = ZIF_PACKAGE (rhn);
 	ZifString *tmp;
 
-	/* create request */
-	msg = soup_xmlrpc_request_new (rhn->priv->server,
-				       "packages.getDetails",
-				       G_TYPE_STRING, rhn->priv->session_key,
-				       G_TYPE_INT, rhn->priv->id,
-				       G_TYPE_INVALID);
-
-	/* send message */
-	soup_session_send_message (rhn->priv->session, msg);
-	ret = SOUP_STATUS_IS_SUCCESSFUL (msg->status_code);
-	if (!ret) {
-		g_set_error (error,
-			     ZIF_PACKAGE_ERROR,
-			     ZIF_PACKAGE_ERROR_FAILED,
-			     "%s (error #%d)",
-			     msg->reason_phrase,
-			     msg->status_code);
-		goto out;
-	}
-
-	/* get response */
-	ret = soup_xmlrpc_extract_method_response (msg->response_body->data,
-						   msg->response_body->length,
-						   &error_local,
-						   G_TYPE_HASH_TABLE, &hash);
-	if (!ret) {
-		g_set_error (error,
-			     ZIF_PACKAGE_ERROR,
-			     ZIF_PACKAGE_ERROR_FAILED,
-			     "Could not parse XML-RPC response for %s (%i): %s",
-			     msg->response_body->data,
-			     (guint) msg->response_body->length,
-			     error_local->message);
-		g_error_free (error_local);
-		goto out;
-	}
-
 	/* set summary */
 	value = g_hash_table_lookup (hash, "package_summary");
 	tmp = zif_string_new (g_value_get_string (value));
@@ -154,73 +116,26 @@ zif_package_rhn_get_details (ZifPackageRhn *rhn,
 	tmp = zif_string_new ("https://rhn.redhat.com/");
 	zif_package_set_url (pkg, tmp);
 	zif_string_unref (tmp);
-
-out:
-	if (hash != NULL)
-		g_hash_table_destroy (hash);
-	g_object_unref (msg);
-	return ret;
+	return TRUE;
 }
 
 /*
- * zif_package_rhn_list_files:
+ * zif_package_rhn_set_file_list:
  */
 static gboolean
-zif_package_rhn_list_files (ZifPackageRhn *rhn,
-			    ZifState *state,
-			    GError **error)
+zif_package_rhn_set_file_list (ZifPackageRhn *rhn,
+			       GValueArray *array,
+			       GError **error)
 {
-	gboolean ret;
-	GError *error_local = NULL;
 	GHashTable *hash;
-	GPtrArray *files = NULL;
+	GPtrArray *files;
 	guint i;
-	GArray *array = NULL;
 	GValue *value;
-	SoupMessage *msg;
-	ZifPackage *pkg = ZIF_PACKAGE (rhn);
-
-	/* create request */
-	msg = soup_xmlrpc_request_new (rhn->priv->server,
-				       "packages.listFiles",
-				       G_TYPE_STRING, rhn->priv->session_key,
-				       G_TYPE_INT, rhn->priv->id,
-				       G_TYPE_INVALID);
-
-	/* send message */
-	soup_session_send_message (rhn->priv->session, msg);
-	ret = SOUP_STATUS_IS_SUCCESSFUL (msg->status_code);
-	if (!ret) {
-		g_set_error (error,
-			     ZIF_PACKAGE_ERROR,
-			     ZIF_PACKAGE_ERROR_FAILED,
-			     "%s (error #%d)",
-			     msg->reason_phrase,
-			     msg->status_code);
-		goto out;
-	}
-
-	/* get response */
-	ret = soup_xmlrpc_extract_method_response (msg->response_body->data,
-						   msg->response_body->length,
-						   &error_local,
-						   G_TYPE_ARRAY, &array);
-	if (!ret) {
-		g_set_error (error,
-			     ZIF_PACKAGE_ERROR,
-			     ZIF_PACKAGE_ERROR_FAILED,
-			     "Could not parse XML-RPC response for %s (%i): %s",
-			     msg->response_body->data,
-			     (guint) msg->response_body->length,
-			     error_local->message);
-		g_error_free (error_local);
-		goto out;
-	}
 
 	/* get packages */
 	files = g_ptr_array_new_with_free_func (g_free);
-	for (i = 0; i < array->len; i++) {
-		hash = g_array_index (array, GHashTable *, i);
+	for (i = 0; i < array->n_values; i++) {
+		hash = g_value_get_boxed (g_value_array_get_nth (array, i));
 
 		/* FIXME: do we care that we're adding directories? */
 		value = g_hash_table_lookup (hash, "file_path");
@@ -228,14 +143,9 @@ zif_package_rhn_list_files (ZifPackageRhn *rhn,
 	}
 
 	/* set files */
-	zif_package_set_files (pkg, files);
-out:
-	if (array != NULL)
-		g_array_free (array, TRUE);
-	if (files != NULL)
-		g_ptr_array_unref (files);
-	g_object_unref (msg);
-	return ret;
+	zif_package_set_files (ZIF_PACKAGE (rhn), files);
+	g_ptr_array_unref (files);
+	return TRUE;
 }
 
 /*
@@ -265,74 +175,34 @@ zif_package_rhn_depend_parse (ZifDepend *depend,
 }
 
 /*
- * zif_package_rhn_list_deps:
+ * zif_package_rhn_set_depend_list:
  */
 static gboolean
-zif_package_rhn_list_deps (ZifPackageRhn *rhn,
-			   ZifState *state,
-			   GError **error)
+zif_package_rhn_set_depend_list (ZifPackageRhn *rhn,
+				 GValueArray *array,
+				 GError **error)
 {
 	const gchar *type;
-	gboolean ret;
-	GError *error_local = NULL;
+	gboolean ret = TRUE;
 	GHashTable *hash;
 	GPtrArray *conflicts = NULL;
 	GPtrArray *obsoletes = NULL;
 	GPtrArray *provides = NULL;
 	GPtrArray *requires = NULL;
 	guint i;
-	GArray *array = NULL;
 	GValue *modifier;
 	GValue *name;
 	GValue *value;
-	SoupMessage *msg;
 	ZifDepend *depend;
 	ZifPackage *pkg = ZIF_PACKAGE (rhn);
 
-	/* create request */
-	msg = soup_xmlrpc_request_new (rhn->priv->server,
-				       "packages.listDependencies",
-				       G_TYPE_STRING, rhn->priv->session_key,
-				       G_TYPE_INT, rhn->priv->id,
-				       G_TYPE_INVALID);
-
-	/* send message */
-	soup_session_send_message (rhn->priv->session, msg);
-	ret = SOUP_STATUS_IS_SUCCESSFUL (msg->status_code);
-	if (!ret) {
-		g_set_error (error,
-			     ZIF_PACKAGE_ERROR,
-			     ZIF_PACKAGE_ERROR_FAILED,
-			     "%s (error #%d)",
-			     msg->reason_phrase,
-			     msg->status_code);
-		goto out;
-	}
-
-	/* get response */
-	ret = soup_xmlrpc_extract_method_response (msg->response_body->data,
-						   msg->response_body->length,
-						   &error_local,
-						   G_TYPE_ARRAY, &array);
-	if (!ret) {
-		g_set_error (error,
-			     ZIF_PACKAGE_ERROR,
-			     ZIF_PACKAGE_ERROR_FAILED,
-			     "Could not parse XML-RPC response for %s (%i): %s",
-			     msg->response_body->data,
-			     (guint) msg->response_body->length,
-			     error_local->message);
-		g_error_free (error_local);
-		goto out;
-	}
-
 	/* get packages */
 	provides = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	requires = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	obsoletes = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	conflicts = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	for (i = 0; i < array->len; i++) {
-		hash = g_array_index (array, GHashTable *, i);
+	for (i = 0; i < array->n_values; i++) {
+		hash = g_value_get_boxed (g_value_array_get_nth (array, i));
 
 		value = g_hash_table_lookup (hash, "dependency_type");
 		type = g_value_get_string (value);
@@ -345,8 +215,6 @@ zif_package_rhn_list_deps (ZifPackageRhn *rhn,
 						    g_value_get_string (name),
 						    g_value_get_string (modifier),
 						    error);
-		g_assert_no_error (*error);
-		g_assert (ret);
 		if (!ret) {
 			g_object_unref (depend);
 			goto out;
@@ -371,17 +239,301 @@ zif_package_rhn_list_deps (ZifPackageRhn *rhn,
 	zif_package_set_obsoletes (pkg, obsoletes);
 	zif_package_set_conflicts (pkg, conflicts);
 out:
-	if (array != NULL)
-		g_array_free (array, TRUE);
-	if (provides != NULL)
-		g_ptr_array_unref (provides);
-	if (requires != NULL)
-		g_ptr_array_unref (requires);
-	if (obsoletes != NULL)
-		g_ptr_array_unref (obsoletes);
-	if (conflicts != NULL)
-		g_ptr_array_unref (conflicts);
-	g_object_unref (msg);
+	g_ptr_array_unref (provides);
+	g_ptr_array_unref (requires);
+	g_ptr_array_unref (obsoletes);
+	g_ptr_array_unref (conflicts);
+	return ret;
+}
+
+/**
+ * zif_package_rhn_precache_to_method:
+ * @precache: A single #ZifPackageRhnPrecache value
+ *
+ * Gets the XML-RPC method used to get the data for the package.
+ *
+ * Return value: the method name, e.g. "packages.getDetails"
+ *
+ * Since: 0.3.7
+ **/
+const gchar *
+zif_package_rhn_precache_to_method (ZifPackageRhnPrecache precache)
+{
+	if (precache == ZIF_PACKAGE_RHN_PRECACHE_GET_DETAILS)
+		return "packages.getDetails";
+	if (precache == ZIF_PACKAGE_RHN_PRECACHE_LIST_FILES)
+		return "packages.listFiles";
+	if (precache == ZIF_PACKAGE_RHN_PRECACHE_LIST_DEPS)
+		return "packages.listDependencies";
+	return NULL;
+}
+
+/*
+ * zif_package_rhn_get_cache_filename:
+ */
+static gchar *
+zif_package_rhn_get_cache_filename (ZifPackageRhn *rhn,
+				    ZifPackageRhnPrecache precache)
+{
+	gchar *basename;
+	gchar *filename;
+
+	if (rhn->priv->cache_dir == NULL)
+		return NULL;
+
+	/* the data for a package ID never changes on the server */
+	basename = g_strdup_printf ("%i-%s.xml",
+				    rhn->priv->id,
+				    zif_package_rhn_precache_to_method (precache));
+	filename = g_build_filename (rhn->priv->cache_dir, basename, NULL);
+	g_free (basename);
+	return filename;
+}
+
+/**
+ * zif_package_rhn_is_cached:
+ * @pkg: A #ZifPackageRhn
+ * @precache: A single #ZifPackageRhnPrecache value
+ *
+ * Finds out if the data has already been saved to the cache directory.
+ *
+ * Return value: %TRUE if the server does not need to be asked
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_package_rhn_is_cached (ZifPackageRhn *pkg,
+			   ZifPackageRhnPrecache precache)
+{
+	gboolean ret;
+	gchar *filename;
+
+	g_return_val_if_fail (ZIF_IS_PACKAGE_RHN (pkg), FALSE);
+
+	filename = zif_package_rhn_get_cache_filename (pkg, precache);
+	if (filename == NULL)
+		return FALSE;
+	ret = g_file_test (filename, G_FILE_TEST_EXISTS);
+	g_free (filename);
+	return ret;
+}
+
+/*
+ * zif_package_rhn_apply_value:
+ */
+static gboolean
+zif_package_rhn_apply_value (ZifPackageRhn *rhn,
+			     ZifPackageRhnPrecache precache,
+			     const GValue *value,
+			     GError **error)
+{
+	gboolean ret = FALSE;
+
+	switch (precache) {
+	case ZIF_PACKAGE_RHN_PRECACHE_GET_DETAILS:
+		if (!G_VALUE_HOLDS (value, G_TYPE_HASH_TABLE))
+			break;
+		ret = zif_package_rhn_set_details (rhn,
+						   g_value_get_boxed (value),
+						   error);
+		goto out;
+	case ZIF_PACKAGE_RHN_PRECACHE_LIST_FILES:
+		if (!G_VALUE_HOLDS (value, G_TYPE_VALUE_ARRAY))
+			break;
+		ret = zif_package_rhn_set_file_list (rhn,
+						     g_value_get_boxed (value),
+						     error);
+		goto out;
+	case ZIF_PACKAGE_RHN_PRECACHE_LIST_DEPS:
+		if (!G_VALUE_HOLDS (value, G_TYPE_VALUE_ARRAY))
+			break;
+		ret = zif_package_rhn_set_depend_list (rhn,
+						       g_value_get_boxed (value),
+						       error);
+		goto out;
+	default:
+		break;
+	}
+
+	/* not what we expected */
+	g_set_error (error,
+		     ZIF_PACKAGE_ERROR,
+		     ZIF_PACKAGE_ERROR_FAILED,
+		     "unexpected %s result of type %s",
+		     zif_package_rhn_precache_to_method (precache),
+		     G_VALUE_TYPE_NAME (value));
+out:
+	return ret;
+}
+
+/**
+ * zif_package_rhn_set_value:
+ * @pkg: A #ZifPackageRhn
+ * @precache: A single #ZifPackageRhnPrecache value
+ * @value: The result of the XML-RPC method
+ * @error: A #GError, or %NULL
+ *
+ * Sets the package data from the result of an XML-RPC call, which
+ * may have been part of a multicall request, and saves the result to
+ * the cache directory if one is set.
+ *
+ * Return value: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_package_rhn_set_value (ZifPackageRhn *pkg,
+			   ZifPackageRhnPrecache precache,
+			   const GValue *value,
+			   GError **error)
+{
+	gboolean ret;
+	gchar *data = NULL;
+	gchar *filename;
+	GError *error_local = NULL;
+
+	g_return_val_if_fail (ZIF_IS_PACKAGE_RHN (pkg), FALSE);
+	g_return_val_if_fail (value != NULL, FALSE);
+
+	ret = zif_package_rhn_apply_value (pkg, precache, value, error);
+	if (!ret)
+		goto out;
+
+	/* failing to save is not fatal */
+	filename = zif_package_rhn_get_cache_filename (pkg, precache);
+	if (filename == NULL)
+		goto out;
+	data = soup_xmlrpc_build_method_response (value);
+	if (!g_file_set_contents (filename, data, -1, &error_local)) {
+		g_warning ("failed to save %s: %s",
+			   filename, error_local->message);
+		g_error_free (error_local);
+	}
+	g_free (filename);
+out:
+	g_free (data);
+	return ret;
+}
+
+/**
+ * zif_package_rhn_load_cache:
+ * @rhn: A #ZifPackageRhn
+ * @precache: A single #ZifPackageRhnPrecache value
+ * @error: A #GError, or %NULL
+ *
+ * Loads data previously saved to the cache directory. If the saved
+ * file cannot be used then it is deleted, so the caller can get the
+ * data from the server instead.
+ *
+ * Return value: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_package_rhn_load_cache (ZifPackageRhn *rhn,
+			    ZifPackageRhnPrecache precache,
+			    GError **error)
+{
+	gboolean ret;
+	gchar *data = NULL;
+	gchar *filename;
+	gsize len;
+	GError *error_local = NULL;
+	GValue value = { 0, };
+
+	filename = zif_package_rhn_get_cache_filename (rhn, precache);
+	ret = g_file_get_contents (filename, &data, &len, error);
+	if (!ret)
+		goto out;
+	ret = soup_xmlrpc_parse_method_response (data, len, &value, &error_local);
+	if (!ret) {
+		g_set_error (error,
+			     ZIF_PACKAGE_ERROR,
+			     ZIF_PACKAGE_ERROR_FAILED,
+			     "failed to parse %s: %s",
+			     filename,
+			     error_local->message);
+		g_error_free (error_local);
+		goto out;
+	}
+	ret = zif_package_rhn_apply_value (rhn, precache, &value, error);
+	g_value_unset (&value);
+out:
+	/* never try to use this file again */
+	if (!ret && filename != NULL)
+		g_unlink (filename);
+	g_free (filename);
+	g_free (data);
+	return ret;
+}
+
+/*
+ * zif_package_rhn_fetch:
+ */
+static gboolean
+zif_package_rhn_fetch (ZifPackageRhn *rhn,
+		       ZifPackageRhnPrecache precache,
+		       GError **error)
+{
+	gboolean ret;
+	GError *error_local = NULL;
+	GValue value = { 0, };
+	SoupMessage *msg = NULL;
+
+	/* already downloaded */
+	if (zif_package_rhn_is_cached (rhn, precache)) {
+		ret = zif_package_rhn_load_cache (rhn, precache, &error_local);
+		if (ret)
+			goto out;
+		g_debug ("ignoring invalid cache: %s", error_local->message);
+		g_clear_error (&error_local);
+	}
+
+	/* packages created without a store */
+	if (rhn->priv->session == NULL)
+		rhn->priv->session = soup_session_sync_new ();
+
+	/* create request */
+	msg = soup_xmlrpc_request_new (rhn->priv->server,
+				       zif_package_rhn_precache_to_method (precache),
+				       G_TYPE_STRING, rhn->priv->session_key,
+				       G_TYPE_INT, rhn->priv->id,
+				       G_TYPE_INVALID);
+
+	/* send message */
+	soup_session_send_message (rhn->priv->session, msg);
+	ret = SOUP_STATUS_IS_SUCCESSFUL (msg->status_code);
+	if (!ret) {
+		g_set_error (error,
+			     ZIF_PACKAGE_ERROR,
+			     ZIF_PACKAGE_ERROR_FAILED,
+			     "%s (error #%d)",
+			     msg->reason_phrase,
+			     msg->status_code);
+		goto out;
+	}
+
+	/* get response */
+	ret = soup_xmlrpc_parse_method_response (msg->response_body->data,
+						 msg->response_body->length,
+						 &value,
+						 &error_local);
+	if (!ret) {
+		g_set_error (error,
+			     ZIF_PACKAGE_ERROR,
+			     ZIF_PACKAGE_ERROR_FAILED,
+			     "Could not parse XML-RPC response for %s (%i): %s",
+			     msg->response_body->data,
+			     (guint) msg->response_body->length,
+			     error_local->message);
+		g_error_free (error_local);
+		goto out;
+	}
+	ret = zif_package_rhn_set_value (rhn, precache, &value, error);
+	g_value_unset (&value);
+out:
+	if (msg != NULL)
+		g_object_unref (msg);
 	return ret;
 }
 
@@ -407,16 +559,16 @@ zif_package_rhn_ensure_data (ZifPackage *pkg,
 	case ZIF_PACKAGE_ENSURE_TYPE_CACHE_FILENAME:
 	case ZIF_PACKAGE_ENSURE_TYPE_CATEGORY:
 	case ZIF_PACKAGE_ENSURE_TYPE_URL:
-		ret = zif_package_rhn_get_details (ZIF_PACKAGE_RHN (pkg),
-						   state,
-						   error);
+		ret = zif_package_rhn_fetch (ZIF_PACKAGE_RHN (pkg),
+					     ZIF_PACKAGE_RHN_PRECACHE_GET_DETAILS,
+					     error);
 		if (!ret)
 			goto out;
 		break;
 	case ZIF_PACKAGE_ENSURE_TYPE_FILES:
-		ret = zif_package_rhn_list_files (ZIF_PACKAGE_RHN (pkg),
-						  state,
-						  error);
+		ret = zif_package_rhn_fetch (ZIF_PACKAGE_RHN (pkg),
+					     ZIF_PACKAGE_RHN_PRECACHE_LIST_FILES,
+					     error);
 		if (!ret)
 			goto out;
 		break;
@@ -424,9 +576,9 @@ zif_package_rhn_ensure_data (ZifPackage *pkg,
 	case ZIF_PACKAGE_ENSURE_TYPE_PROVIDES:
 	case ZIF_PACKAGE_ENSURE_TYPE_REQUIRES:
 	case ZIF_PACKAGE_ENSURE_TYPE_OBSOLETES:
-		ret = zif_package_rhn_list_deps (ZIF_PACKAGE_RHN (pkg),
-						 state,
-						 error);
+		ret = zif_package_rhn_fetch (ZIF_PACKAGE_RHN (pkg),
+					     ZIF_PACKAGE_RHN_PRECACHE_LIST_DEPS,
+					     error);
 		if (!ret)
 			goto out;
 		break;
@@ -454,21 +606,27 @@ zif_package_rhn_precache (ZifPackageRhn *rhn,
 
 	/* get details */
 	if ((precache & ZIF_PACKAGE_RHN_PRECACHE_GET_DETAILS) > 0) {
-		ret = zif_package_rhn_get_details (rhn, NULL, error);
+		ret = zif_package_rhn_fetch (rhn,
+					     ZIF_PACKAGE_RHN_PRECACHE_GET_DETAILS,
+					     error);
 		if (!ret)
 			goto out;
 	}
 
 	/* list files */
 	if ((precache & ZIF_PACKAGE_RHN_PRECACHE_LIST_FILES) > 0) {
-		ret = zif_package_rhn_list_files (rhn, NULL, error);
+		ret = zif_package_rhn_fetch (rhn,
+					     ZIF_PACKAGE_RHN_PRECACHE_LIST_FILES,
+					     error);
 		if (!ret)
 			goto out;
 	}
 
 	/* list deps */
 	if ((precache & ZIF_PACKAGE_RHN_PRECACHE_LIST_DEPS) > 0) {
-		ret = zif_package_rhn_list_deps (rhn, NULL, error);
+		ret = zif_package_rhn_fetch (rhn,
+					     ZIF_PACKAGE_RHN_PRECACHE_LIST_DEPS,
+					     error);
 		if (!ret)
 			goto out;
 	}
@@ -548,6 +706,46 @@ zif_package_rhn_set_server (ZifPackageRhn *pkg,
 	pkg->priv->server = g_strdup (server);
 }
 
+/**
+ * zif_package_rhn_set_session:
+ * @pkg: A #ZifPackageRhn
+ * @session: A #SoupSession
+ *
+ * Sets the session to use for requests, so that all the packages in a
+ * store can share the same connections.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_package_rhn_set_session (ZifPackageRhn *pkg,
+			     SoupSession *session)
+{
+	g_return_if_fail (ZIF_IS_PACKAGE_RHN (pkg));
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	if (pkg->priv->session != NULL)
+		g_object_unref (pkg->priv->session);
+	pkg->priv->session = g_object_ref (session);
+}
+
+/**
+ * zif_package_rhn_set_cache_dir:
+ * @pkg: A #ZifPackageRhn
+ * @cache_dir: A directory, which must exist
+ *
+ * Sets the directory used to save the results of requests, which
+ * should be unique for each RHN channel.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_package_rhn_set_cache_dir (ZifPackageRhn *pkg,
+			       const gchar *cache_dir)
+{
+	g_return_if_fail (ZIF_IS_PACKAGE_RHN (pkg));
+	g_free (pkg->priv->cache_dir);
+	pkg->priv->cache_dir = g_strdup (cache_dir);
+}
+
 /**
  * zif_package_rhn_finalize:
  **/
@@ -562,7 +760,9 @@ zif_package_rhn_finalize (GObject *object)
 
 	g_free (pkg->priv->session_key);
 	g_free (pkg->priv->server);
-	g_object_unref (pkg->priv->session);
+	g_free (pkg->priv->cache_dir);
+	if (pkg->priv->session != NULL)
+		g_object_unref (pkg->priv->session);
 
 	G_OBJECT_CLASS (zif_package_rhn_parent_class)->finalize (object);
 }
@@ -589,7 +789,6 @@ static void
 zif_package_rhn_init (ZifPackageRhn *pkg)
 {
 	pkg->priv = ZIF_PACKAGE_RHN_GET_PRIVATE (pkg);
-	pkg->priv->session = soup_session_sync_new ();
 }
 
 /**
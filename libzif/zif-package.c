@@ -68,10 +68,12 @@ struct _ZifPackagePrivate
 	ZifString		*pkgid;
 	guint64			 size;
 	guint64			 time_file;
-	GPtrArray		*files;
+	ZifFileList		*files;
+	GHashTable		*file_dirs;
 	GPtrArray		*requires;
 	GPtrArray		*provides;
 	gboolean		 provides_set;
+	gboolean		 provides_files_set;
 	GPtrArray		*obsoletes;
 	GPtrArray		*conflicts;
 	GHashTable		*requires_hash;
@@ -363,9 +365,11 @@ zif_package_print (ZifPackage *package)
 
 	if (package->priv->files != NULL) {
 		g_print ("files:\n");
-		array = package->priv->files;
-		for (i = 0; i < array->len; i++)
-			g_print ("\t%s\n", (const gchar *) g_ptr_array_index (array, i));
+		for (i = 0; i < zif_file_list_get_length (package->priv->files); i++) {
+			g_print ("\t%s%s\n",
+				 zif_file_list_get_dirname (package->priv->files, i),
+				 zif_file_list_get_basename (package->priv->files, i));
+		}
 	}
 	if (package->priv->requires != NULL) {
 		g_print ("requires:\n");
@@ -405,6 +409,111 @@ zif_package_print (ZifPackage *package)
 	}
 }
 
+/**
+ * zif_package_get_memory_usage_depends:
+ **/
+static void
+zif_package_get_memory_usage_depends (GPtrArray *array, ZifMemory *memory)
+{
+	guint i;
+
+	if (array == NULL)
+		return;
+	zif_memory_add_ptr_array (memory, ZIF_MEMORY_KIND_DEPENDS, array);
+	for (i = 0; i < array->len; i++)
+		zif_depend_get_memory_usage (g_ptr_array_index (array, i), memory);
+}
+
+/**
+ * zif_package_get_memory_usage:
+ * @package: A #ZifPackage
+ * @memory: A #ZifMemory to add the sizes to
+ *
+ * Adds the memory used by the package to @memory, including any file
+ * lists, depends and hash tables that have been loaded. Data that is
+ * shared with other packages is only counted once.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_package_get_memory_usage (ZifPackage *package, ZifMemory *memory)
+{
+	gpointer key;
+	guint i;
+	GHashTableIter iter;
+	GTypeQuery query;
+	ZifPackagePrivate *priv;
+
+	g_return_if_fail (ZIF_IS_PACKAGE (package));
+	g_return_if_fail (ZIF_IS_MEMORY (memory));
+
+	if (!zif_memory_visit (memory, package))
+		return;
+	priv = package->priv;
+
+	/* the object itself */
+	g_type_query (G_OBJECT_TYPE (package), &query);
+	zif_memory_add (memory,
+			ZIF_MEMORY_KIND_PACKAGES,
+			query.instance_size + sizeof (ZifPackagePrivate));
+
+	/* cached strings */
+	if (priv->package_id_split != NULL) {
+		zif_memory_add (memory,
+				ZIF_MEMORY_KIND_STRINGS,
+				(g_strv_length (priv->package_id_split) + 1) * sizeof (gchar *));
+		for (i = 0; priv->package_id_split[i] != NULL; i++) {
+			zif_memory_add_string (memory,
+					       ZIF_MEMORY_KIND_STRINGS,
+					       priv->package_id_split[i]);
+		}
+	}
+	zif_memory_add_string (memory, ZIF_MEMORY_KIND_STRINGS, priv->package_id);
+	zif_memory_add_string (memory, ZIF_MEMORY_KIND_STRINGS, priv->package_id_basic);
+	zif_memory_add_string (memory, ZIF_MEMORY_KIND_STRINGS, priv->printable);
+	zif_memory_add_string (memory, ZIF_MEMORY_KIND_STRINGS, priv->name_arch);
+	zif_memory_add_string (memory, ZIF_MEMORY_KIND_STRINGS, priv->name_version);
+	zif_memory_add_string (memory, ZIF_MEMORY_KIND_STRINGS, priv->name_version_arch);
+	zif_memory_add_string (memory, ZIF_MEMORY_KIND_STRINGS, priv->version_arch);
+	zif_memory_add_string (memory, ZIF_MEMORY_KIND_STRINGS, priv->cache_filename);
+	zif_memory_add_zif_string (memory, priv->summary);
+	zif_memory_add_zif_string (memory, priv->description);
+	zif_memory_add_zif_string (memory, priv->license);
+	zif_memory_add_zif_string (memory, priv->url);
+	zif_memory_add_zif_string (memory, priv->category);
+	zif_memory_add_zif_string (memory, priv->location_href);
+	zif_memory_add_zif_string (memory, priv->source_filename);
+	zif_memory_add_zif_string (memory, priv->group);
+	zif_memory_add_zif_string (memory, priv->pkgid);
+
+	/* file list, which may be shared using zif_package_set_file_list() */
+	if (priv->files != NULL && zif_memory_visit (memory, priv->files)) {
+		zif_memory_add (memory,
+				ZIF_MEMORY_KIND_FILES,
+				zif_file_list_get_size (priv->files));
+	}
+
+	/* depends */
+	zif_package_get_memory_usage_depends (priv->requires, memory);
+	zif_package_get_memory_usage_depends (priv->provides, memory);
+	zif_package_get_memory_usage_depends (priv->obsoletes, memory);
+	zif_package_get_memory_usage_depends (priv->conflicts, memory);
+
+	/* lookup tables */
+	zif_memory_add_hash_table (memory, priv->requires_hash);
+	zif_memory_add_hash_table (memory, priv->provides_hash);
+	zif_memory_add_hash_table (memory, priv->obsoletes_hash);
+	zif_memory_add_hash_table (memory, priv->conflicts_hash);
+
+	/* directory summary */
+	if (priv->file_dirs != NULL) {
+		zif_memory_add_hash_table (memory, priv->file_dirs);
+		g_hash_table_iter_init (&iter, priv->file_dirs);
+		while (g_hash_table_iter_next (&iter, &key, NULL))
+			zif_memory_add_string (memory, ZIF_MEMORY_KIND_HASHES, key);
+	}
+}
+
 /**
  * zif_package_is_devel:
  * @package: A #ZifPackage
@@ -585,6 +694,166 @@ out:
 	return is_free;
 }
 
+/**
+ * zif_package_str_has_prefix:
+ **/
+static gboolean
+zif_package_str_has_prefix (const gchar *filename, gchar **strv)
+{
+	guint i;
+	if (strv == NULL)
+		return FALSE;
+	for (i = 0; strv[i] != NULL; i++) {
+		if (g_str_has_prefix (filename, strv[i]))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * zif_package_get_file_provide_internal:
+ **/
+static ZifDepend *
+zif_package_get_file_provide_internal (ZifPackage *package,
+				       const gchar *filename)
+{
+	ZifDepend *depend_tmp;
+
+	/* already created, or explicitly provided */
+	depend_tmp = g_hash_table_lookup (package->priv->provides_hash, filename);
+	if (depend_tmp != NULL)
+		return depend_tmp;
+
+	/* create the depend, which owns the key */
+	depend_tmp = zif_depend_new ();
+	zif_depend_set_flag (depend_tmp, ZIF_DEPEND_FLAG_ANY);
+	zif_depend_set_name (depend_tmp, filename);
+	g_hash_table_insert (package->priv->provides_hash,
+			     (gpointer) zif_depend_get_name (depend_tmp),
+			     depend_tmp);
+	return depend_tmp;
+}
+
+/**
+ * zif_package_get_file_provide:
+ *
+ * Gets the file provide for a file in the package file list, creating
+ * it if required. The file provides are only created when they are
+ * needed, as most of them are never used.
+ **/
+static ZifDepend *
+zif_package_get_file_provide (ZifPackage *package, const gchar *filename)
+{
+	gchar **file_prefixes;
+	ZifConfig *config;
+
+	if (package->priv->files == NULL)
+		return NULL;
+
+	/* ignore any files with blacklisted prefixes */
+	config = zif_config_new ();
+	file_prefixes = zif_config_get_strv_cached (config,
+						    "ignore_file_dep_prefixes",
+						    NULL);
+	g_object_unref (config);
+	if (zif_package_str_has_prefix (filename, file_prefixes))
+		return NULL;
+	if (!zif_file_list_contains (package->priv->files, filename))
+		return NULL;
+
+	return zif_package_get_file_provide_internal (package, filename);
+}
+
+/**
+ * zif_package_add_file_provides:
+ **/
+static void
+zif_package_add_file_provides (ZifPackage *package)
+{
+	gchar **file_prefixes;
+	gchar *filename;
+	guint i;
+	ZifConfig *config;
+	ZifDepend *depend_tmp;
+
+	/* get the list of file prefixes to ignore */
+	config = zif_config_new ();
+	file_prefixes = zif_config_get_strv_cached (config,
+						    "ignore_file_dep_prefixes",
+						    NULL);
+
+	/* add files as provides, reusing any already created */
+	for (i = 0; i < zif_file_list_get_length (package->priv->files); i++) {
+		filename = zif_file_list_get_filename (package->priv->files, i);
+		if (!zif_package_str_has_prefix (filename, file_prefixes)) {
+			depend_tmp = zif_package_get_file_provide_internal (package,
+									    filename);
+			g_ptr_array_add (package->priv->provides,
+					 g_object_ref (depend_tmp));
+		}
+		g_free (filename);
+	}
+	package->priv->provides_files_set = TRUE;
+	g_object_unref (config);
+}
+
+/**
+ * zif_package_ensure_files_for_depend:
+ *
+ * Loads the file list, unless the directory summary shows that the
+ * package cannot contain the file.
+ **/
+static gboolean
+zif_package_ensure_files_for_depend (ZifPackage *package,
+				     ZifDepend *depend,
+				     ZifState *state,
+				     GError **error)
+{
+	const gchar *filename;
+	const gchar *tmp;
+	gboolean ret = TRUE;
+	gchar *dirname;
+	GError *error_local = NULL;
+
+	/* get the directory summary, which is much cheaper than the
+	 * file list for packages that support it */
+	if (package->priv->file_dirs == NULL) {
+		ret = zif_package_ensure_data (package,
+					       ZIF_PACKAGE_ENSURE_TYPE_FILE_DIRS,
+					       state,
+					       &error_local);
+		if (!ret) {
+			if (error_local->domain != ZIF_PACKAGE_ERROR ||
+			    error_local->code != ZIF_PACKAGE_ERROR_NO_SUPPORT) {
+				g_propagate_error (error, error_local);
+				goto out;
+			}
+			g_error_free (error_local);
+		}
+	}
+
+	/* the package does not own the directory, so nothing to load */
+	if (package->priv->file_dirs != NULL) {
+		filename = zif_depend_get_name (depend);
+		tmp = g_strrstr (filename, "/");
+		dirname = g_strndup (filename, tmp - filename + 1);
+		ret = g_hash_table_lookup (package->priv->file_dirs, dirname) != NULL;
+		g_free (dirname);
+		if (!ret) {
+			ret = TRUE;
+			goto out;
+		}
+	}
+
+	/* get the full file list */
+	ret = zif_package_ensure_data (package,
+				       ZIF_PACKAGE_ENSURE_TYPE_FILES,
+				       state,
+				       error);
+out:
+	return ret;
+}
+
 /**
  * zif_package_provides:
  * @package: A #ZifPackage
@@ -627,11 +896,14 @@ zif_package_provides (ZifPackage *package,
 		if (!ret)
 			goto out;
 	}
-	if (package->priv->files == NULL) {
-		ret = zif_package_ensure_data (package,
-					       ZIF_PACKAGE_ENSURE_TYPE_FILES,
-					       state,
-					       error);
+
+	/* only a file depend can be satisfied by the file list */
+	if (zif_depend_get_name (depend)[0] == '/' &&
+	    package->priv->files == NULL) {
+		ret = zif_package_ensure_files_for_depend (package,
+							   depend,
+							   state,
+							   error);
 		if (!ret)
 			goto out;
 	}
@@ -655,6 +927,13 @@ zif_package_provides (ZifPackage *package,
 		if (ret) {
 			/* object is in the cache */
 			*satisfies = g_object_ref (depend_tmp);
+		} else if (depend_id[0] == '/') {
+			/* the file provides are only added when used */
+			ret = TRUE;
+			*satisfies = NULL;
+			depend_tmp = zif_package_get_file_provide (package, depend_id);
+			if (depend_tmp != NULL)
+				*satisfies = g_object_ref (depend_tmp);
 		} else {
 			/* object is not in the cache, but we already added all entries */
 			ret = TRUE;
@@ -676,6 +955,15 @@ zif_package_provides (ZifPackage *package,
 		}
 	}
 
+	/* file provides match any version */
+	if (*satisfies == NULL &&
+	    zif_depend_get_name (depend)[0] == '/') {
+		depend_tmp = zif_package_get_file_provide (package,
+							   zif_depend_get_name (depend));
+		if (depend_tmp != NULL)
+			*satisfies = g_object_ref (depend_tmp);
+	}
+
 	/* success either way */
 	ret = TRUE;
 out:
@@ -1244,6 +1532,8 @@ zif_package_ensure_type_to_string (ZifPackageEnsureType type)
 		return "cache-filename";
 	if (type == ZIF_PACKAGE_ENSURE_TYPE_SOURCE_FILENAME)
 		return "source-filename";
+	if (type == ZIF_PACKAGE_ENSURE_TYPE_FILE_DIRS)
+		return "file-dirs";
 	return "unknown";
 }
 
@@ -1727,15 +2017,42 @@ zif_package_get_size (ZifPackage *package, ZifState *state, GError **error)
  * @state: A #ZifState to use for progress reporting
  * @error: A #GError, or %NULL
  *
- * Gets the file list for the package.
+ * Gets the file list for the package. This builds the full path for
+ * every file, so use zif_package_get_file_list() where possible.
  *
- * Return value: (element-type utf8) (transfer container): An array of strings. The returned array should be
+ * Return value: (element-type utf8) (transfer full): An array of strings. The returned array should be
  * freed with g_ptr_array_unref() when no longer needed.
  *
  * Since: 0.1.0
  **/
 GPtrArray *
 zif_package_get_files (ZifPackage *package, ZifState *state, GError **error)
+{
+	ZifFileList *files;
+	GPtrArray *array;
+
+	files = zif_package_get_file_list (package, state, error);
+	if (files == NULL)
+		return NULL;
+	array = zif_file_list_to_array (files);
+	zif_file_list_unref (files);
+	return array;
+}
+
+/**
+ * zif_package_get_file_list:
+ * @package: A #ZifPackage
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Gets the compact file list for the package.
+ *
+ * Return value: A #ZifFileList, free with zif_file_list_unref()
+ *
+ * Since: 0.3.7
+ **/
+ZifFileList *
+zif_package_get_file_list (ZifPackage *package, ZifState *state, GError **error)
 {
 	gboolean ret;
 
@@ -1754,7 +2071,7 @@ zif_package_get_files (ZifPackage *package, ZifState *state, GError **error)
 	}
 
 	/* return refcounted */
-	return g_ptr_array_ref (package->priv->files);
+	return zif_file_list_ref (package->priv->files);
 }
 
 /**
@@ -1845,6 +2162,50 @@ zif_package_get_provides (ZifPackage *package, ZifState *state, GError **error)
 		}
 	}
 
+	/* add all the file provides to the array */
+	if (package->priv->files != NULL &&
+	    !package->priv->provides_files_set)
+		zif_package_add_file_provides (package);
+
+	/* return refcounted */
+	return g_ptr_array_ref (package->priv->provides);
+}
+
+/**
+ * zif_package_get_provides_no_files:
+ * @package: A #ZifPackage
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Get the package provides without loading the file list. The array
+ * will only contain file provides if the file list was already loaded
+ * or the package explicitly provides a file.
+ *
+ * Return value: (element-type ZifDepend) (transfer container): an array of ZifDepend's. The returned array should be
+ * freed with g_ptr_array_unref() when no longer needed.
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_package_get_provides_no_files (ZifPackage *package, ZifState *state, GError **error)
+{
+	gboolean ret;
+
+	g_return_val_if_fail (ZIF_IS_PACKAGE (package), NULL);
+	g_return_val_if_fail (package->priv->package_id_split != NULL, NULL);
+	g_return_val_if_fail (zif_state_valid (state), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* not exists */
+	if (!package->priv->provides_set) {
+		ret = zif_package_ensure_data (package,
+					       ZIF_PACKAGE_ENSURE_TYPE_PROVIDES,
+					       state,
+					       error);
+		if (!ret)
+			return NULL;
+	}
+
 	/* return refcounted */
 	return g_ptr_array_ref (package->priv->provides);
 }
@@ -2299,35 +2660,6 @@ zif_package_set_size (ZifPackage *package, guint64 size)
 }
 
 
-/**
- * zif_package_add_files_internal:
- **/
-static void
-zif_package_add_files_internal (ZifPackage *package, const gchar *filename)
-{
-	ZifDepend *depend_tmp;
-	ZifString *string;
-
-	depend_tmp = zif_depend_new ();
-	zif_depend_set_flag (depend_tmp, ZIF_DEPEND_FLAG_ANY);
-
-	/* add this as a static string, as we know that the files
-	 * cannot be ripped from under us, and it'll save a few
-	 * thousand allocatons per package created */
-	string = zif_string_new_static (filename);
-	zif_depend_set_name_str (depend_tmp, string);
-	zif_string_unref (string);
-
-	g_hash_table_insert (package->priv->provides_hash,
-			     (gpointer) filename,
-			     g_object_ref (depend_tmp));
-	g_ptr_array_add (package->priv->provides,
-			 g_object_ref (depend_tmp));
-	package->priv->any_file_provides = TRUE;
-
-	g_object_unref (depend_tmp);
-}
-
 /**
  * zif_package_add_file:
  * @package: A #ZifPackage
@@ -2340,17 +2672,26 @@ zif_package_add_files_internal (ZifPackage *package, const gchar *filename)
 void
 zif_package_add_file (ZifPackage *package, const gchar *filename)
 {
-	gchar *filename_copy;
+	ZifDepend *depend_tmp;
+
 	g_return_if_fail (ZIF_IS_PACKAGE (package));
 	g_return_if_fail (filename != NULL);
 
 	/* create if not already exists */
 	if (package->priv->files == NULL)
-		package->priv->files = g_ptr_array_new_with_free_func (g_free);
+		package->priv->files = zif_file_list_new ();
 
-	filename_copy = g_strdup (filename);
-	zif_package_add_files_internal (package, filename_copy);
-	g_ptr_array_add (package->priv->files, filename_copy);
+	zif_file_list_add_filename (package->priv->files, filename);
+	package->priv->any_file_provides = TRUE;
+
+	/* the file provides have already been added to the array */
+	if (package->priv->provides_files_set) {
+		depend_tmp = zif_package_get_file_provide (package, filename);
+		if (depend_tmp != NULL) {
+			g_ptr_array_add (package->priv->provides,
+					 g_object_ref (depend_tmp));
+		}
+	}
 }
 
 /**
@@ -2365,66 +2706,67 @@ zif_package_add_file (ZifPackage *package, const gchar *filename)
 void
 zif_package_set_files (ZifPackage *package, GPtrArray *files)
 {
+	ZifFileList *list;
+
 	g_return_if_fail (ZIF_IS_PACKAGE (package));
 	g_return_if_fail (files != NULL);
 	g_return_if_fail (package->priv->files == NULL);
 
-	package->priv->files = g_ptr_array_ref (files);
+	list = zif_file_list_new_from_array (files);
+	zif_package_set_file_list (package, list);
+	zif_file_list_unref (list);
 }
 
 /**
- * zif_package_str_has_prefix:
+ * zif_package_set_file_list:
+ * @package: A #ZifPackage
+ * @files: A #ZifFileList
+ *
+ * Sets the package file list. The files are also used as provides.
+ *
+ * Since: 0.3.7
  **/
-static gboolean
-zif_package_str_has_prefix (const gchar *filename, gchar **strv)
+void
+zif_package_set_file_list (ZifPackage *package, ZifFileList *files)
 {
-	guint i;
-	if (strv == NULL)
-		return FALSE;
-	for (i = 0; strv[i] != NULL; i++) {
-		if (g_str_has_prefix (filename, strv[i]))
-			return TRUE;
-	}
-	return FALSE;
+	g_return_if_fail (ZIF_IS_PACKAGE (package));
+	g_return_if_fail (files != NULL);
+	g_return_if_fail (package->priv->files == NULL);
+
+	package->priv->files = zif_file_list_ref (files);
+	if (zif_file_list_get_length (files) > 0)
+		package->priv->any_file_provides = TRUE;
 }
 
 /**
- * zif_package_set_provides_files:
+ * zif_package_set_file_dirs:
  * @package: A #ZifPackage
- * @files: The package provides
+ * @dirs: an array of directory names, each with a trailing '/'
  *
- * Sets the package file provides
+ * Sets the directories that contain the package files. This is used
+ * to rule out file depends without loading the full file list, and
+ * an empty array means the package has no files at all.
  *
- * Since: 0.2.9
+ * Since: 0.3.7
  **/
 void
-zif_package_set_provides_files (ZifPackage *package,
-				GPtrArray *files)
+zif_package_set_file_dirs (ZifPackage *package, GPtrArray *dirs)
 {
-	const gchar *filename;
-	gboolean ret;
-	gchar **file_prefixes;
 	guint i;
-	ZifConfig *config;
 
 	g_return_if_fail (ZIF_IS_PACKAGE (package));
-	g_return_if_fail (files != NULL);
+	g_return_if_fail (dirs != NULL);
+	g_return_if_fail (package->priv->file_dirs == NULL);
 
-	/* get the list of file prefixes to ignore */
-	config = zif_config_new ();
-	file_prefixes = zif_config_get_strv (config,
-					     "ignore_file_dep_prefixes",
-					     NULL);
-
-	/* add files as provides to 'any' cache */
-	for (i = 0; i < files->len; i++) {
-		filename = g_ptr_array_index (files, i);
-		ret = zif_package_str_has_prefix (filename, file_prefixes);
-		if (!ret)
-			zif_package_add_files_internal (package, filename);
+	package->priv->file_dirs = g_hash_table_new_full (g_str_hash,
+							  g_str_equal,
+							  g_free,
+							  NULL);
+	for (i = 0; i < dirs->len; i++) {
+		g_hash_table_insert (package->priv->file_dirs,
+				     g_strdup (g_ptr_array_index (dirs, i)),
+				     GINT_TO_POINTER (1));
 	}
-	g_strfreev (file_prefixes);
-	g_object_unref (config);
 }
 
 /**
@@ -2750,7 +3092,9 @@ zif_package_finalize (GObject *object)
 	if (package->priv->source_filename != NULL)
 		zif_string_unref (package->priv->source_filename);
 	if (package->priv->files != NULL)
-		g_ptr_array_unref (package->priv->files);
+		zif_file_list_unref (package->priv->files);
+	if (package->priv->file_dirs != NULL)
+		g_hash_table_unref (package->priv->file_dirs);
 	if (package->priv->requires != NULL)
 		g_ptr_array_unref (package->priv->requires);
 	if (package->priv->provides != NULL)
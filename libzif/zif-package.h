@@ -30,6 +30,8 @@
 #include <gio/gio.h>
 
 #include "zif-depend.h"
+#include "zif-file-list.h"
+#include "zif-memory.h"
 #include "zif-state.h"
 
 G_BEGIN_DECLS
@@ -63,6 +65,7 @@ typedef enum {
 	ZIF_PACKAGE_ENSURE_TYPE_OBSOLETES,
 	ZIF_PACKAGE_ENSURE_TYPE_CACHE_FILENAME,
 	ZIF_PACKAGE_ENSURE_TYPE_SOURCE_FILENAME, /* Since: 0.2.5 */
+	ZIF_PACKAGE_ENSURE_TYPE_FILE_DIRS,	/* Since: 0.3.7 */
 	ZIF_PACKAGE_ENSURE_TYPE_LAST
 } ZifPackageEnsureType;
 
@@ -171,6 +174,9 @@ guint64			 zif_package_get_size		(ZifPackage	*package,
 GPtrArray		*zif_package_get_files		(ZifPackage	*package,
 							 ZifState	*state,
 							 GError		**error);
+ZifFileList		*zif_package_get_file_list	(ZifPackage	*package,
+							 ZifState	*state,
+							 GError		**error);
 GPtrArray		*zif_package_get_requires	(ZifPackage	*package,
 							 ZifState	*state,
 							 GError		**error);
@@ -208,6 +214,8 @@ gboolean		 zif_package_obsoletes		(ZifPackage	*package,
 
 const gchar		*zif_package_get_package_id	(ZifPackage	*package);
 void			 zif_package_print		(ZifPackage	*package);
+void			 zif_package_get_memory_usage	(ZifPackage	*package,
+							 ZifMemory	*memory);
 gboolean		 zif_package_is_devel		(ZifPackage	*package);
 gboolean		 zif_package_is_gui		(ZifPackage	*package);
 gboolean		 zif_package_is_installed	(ZifPackage	*package);
@@ -24,11 +24,18 @@
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <glib-object.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <libsoup/soup.h>
+#include <string.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <attr/xattr.h>
 #include <utime.h>
 
 #include "zif-category.h"
 #include "zif-changeset-private.h"
+#include "zif-client.h"
 #include "zif-config.h"
 #include "zif-delta.h"
 #include "zif-depend.h"
@@ -46,12 +53,14 @@
 #include "zif-md-filelists-xml.h"
 #include "zif-md.h"
 #include "zif-md-metalink.h"
+#include "zif-md-private.h"
 #include "zif-md-mirrorlist.h"
 #include "zif-md-other-sql.h"
 #include "zif-md-primary-sql.h"
 #include "zif-md-primary-xml.h"
 #include "zif-md-updateinfo.h"
 #include "zif-media.h"
+#include "zif-memory.h"
 #include "zif-monitor.h"
 #include "zif-object-array.h"
 #include "zif-package.h"
@@ -61,13 +70,18 @@
 #include "zif-package-remote.h"
 #include "zif-release.h"
 #include "zif-repos.h"
+#include "zif-server.h"
+#include "zif-sql-stats.h"
 #include "zif-state-private.h"
 #include "zif-store-array.h"
 #include "zif-store-directory.h"
 #include "zif-store.h"
 #include "zif-store-local.h"
 #include "zif-store-meta.h"
+#include "zif-store-overlay.h"
 #include "zif-store-remote.h"
+#include "zif-store-remote-private.h"
+#include "zif-package-rhn.h"
 #include "zif-store-rhn.h"
 #include "zif-string.h"
 #include "zif-transaction.h"
@@ -174,6 +188,217 @@ zif_store_directory_func (void)
 	g_free (path);
 }
 
+static void
+zif_store_array_parallel_func (void)
+{
+	gboolean ret;
+	gchar *filename;
+	gchar *path;
+	GError *error = NULL;
+	GPtrArray *array_parallel;
+	GPtrArray *array_sequential;
+	GPtrArray *store_array;
+	guint i;
+	ZifConfig *config;
+	ZifPackage *pkg;
+	ZifState *state;
+	ZifStore *store;
+
+	config = zif_config_new ();
+	filename = zif_test_get_data_file ("zif.conf");
+	ret = zif_config_set_filename (config, filename, &error);
+	g_free (filename);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* a meta store and a directory store */
+	store_array = zif_store_array_new ();
+	store = zif_store_meta_new ();
+	pkg = zif_package_meta_new ();
+	filename = zif_test_get_data_file ("test.spec");
+	ret = zif_package_meta_set_from_filename (ZIF_PACKAGE_META (pkg), filename, &error);
+	g_free (filename);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = zif_store_add_package (store, pkg, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_object_unref (pkg);
+	zif_store_array_add_store (store_array, store);
+	g_object_unref (store);
+	store = zif_store_directory_new ();
+	path = zif_test_get_data_file (".");
+	ret = zif_store_directory_set_path (ZIF_STORE_DIRECTORY (store), path, TRUE, &error);
+	g_free (path);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_store_set_enabled (store, TRUE);
+	zif_store_array_add_store (store_array, store);
+	g_object_unref (store);
+
+	/* get the packages one store at a time */
+	state = zif_state_new ();
+	array_sequential = zif_store_array_get_packages (store_array, state, &error);
+	g_assert_no_error (error);
+	g_assert (array_sequential != NULL);
+	g_assert_cmpint (array_sequential->len, ==, 4);
+
+	/* get the packages from both stores at the same time */
+	ret = zif_config_set_boolean (config, "parallel_store_queries", TRUE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_state_reset (state);
+	array_parallel = zif_store_array_get_packages (store_array, state, &error);
+	g_assert_no_error (error);
+	g_assert (array_parallel != NULL);
+	g_assert_cmpint (zif_state_get_percentage (state), ==, 100);
+
+	/* the order must be the same */
+	g_assert_cmpint (array_parallel->len, ==, array_sequential->len);
+	for (i = 0; i < array_parallel->len; i++) {
+		g_assert_cmpstr (zif_package_get_id (g_ptr_array_index (array_parallel, i)), ==,
+				 zif_package_get_id (g_ptr_array_index (array_sequential, i)));
+	}
+	ret = zif_config_unset (config, "parallel_store_queries", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	g_ptr_array_unref (array_parallel);
+	g_ptr_array_unref (array_sequential);
+	g_ptr_array_unref (store_array);
+	g_object_unref (state);
+	g_object_unref (config);
+}
+
+static void
+zif_store_array_parallel_remote_func (void)
+{
+	const gchar *search[] = { "gnome-power-manager", "test", NULL };
+	const gchar *search_group[] = { "system", NULL };
+	gboolean ret;
+	gchar *filename;
+	GError *error = NULL;
+	GPtrArray *array_parallel;
+	GPtrArray *array_sequential;
+	GPtrArray *store_array;
+	guint i;
+	ZifConfig *config;
+	ZifGroups *groups;
+	ZifPackage *pkg;
+	ZifState *state;
+	ZifStore *store;
+	ZifStore *store_local;
+
+	config = zif_config_new ();
+	filename = zif_test_get_data_file ("zif.conf");
+	ret = zif_config_set_filename (config, filename, &error);
+	g_free (filename);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_config_set_uint (config, "metadata_expire", 0, NULL);
+	zif_config_set_uint (config, "mirrorlist_expire", 0, NULL);
+	filename = g_build_filename (zif_tmpdir, "zif.lock", NULL);
+	zif_config_set_string (config, "pidfile", filename, NULL);
+	g_free (filename);
+	filename = zif_test_get_data_file (".");
+	zif_config_set_string (config, "cachedir", filename, NULL);
+	g_free (filename);
+
+	/* a remote store that is not yet loaded, and a meta store */
+	state = zif_state_new ();
+	store_array = zif_store_array_new ();
+	store = zif_store_remote_new ();
+	filename = zif_test_get_data_file ("repos/fedora.repo");
+	ret = zif_store_remote_set_from_file (ZIF_STORE_REMOTE (store), filename, "fedora", state, &error);
+	g_free (filename);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_store_array_add_store (store_array, store);
+	g_object_unref (store);
+	store = zif_store_meta_new ();
+	pkg = zif_package_meta_new ();
+	filename = zif_test_get_data_file ("test.spec");
+	ret = zif_package_meta_set_from_filename (ZIF_PACKAGE_META (pkg), filename, &error);
+	g_free (filename);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = zif_store_add_package (store, pkg, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_object_unref (pkg);
+	zif_store_array_add_store (store_array, store);
+	g_object_unref (store);
+
+	/* the remote store loads its metadata in a worker thread */
+	ret = zif_config_set_boolean (config, "parallel_store_queries", TRUE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_state_reset (state);
+	array_parallel = zif_store_array_resolve (store_array, (gchar **) search, state, &error);
+	g_assert_no_error (error);
+	g_assert (array_parallel != NULL);
+	g_assert_cmpint (array_parallel->len, ==, 2);
+	ret = zif_config_unset (config, "parallel_store_queries", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* the same query one store at a time */
+	zif_state_reset (state);
+	array_sequential = zif_store_array_resolve (store_array, (gchar **) search, state, &error);
+	g_assert_no_error (error);
+	g_assert (array_sequential != NULL);
+	g_assert_cmpint (array_parallel->len, ==, array_sequential->len);
+	for (i = 0; i < array_parallel->len; i++) {
+		g_assert_cmpstr (zif_package_get_id (g_ptr_array_index (array_parallel, i)), ==,
+				 zif_package_get_id (g_ptr_array_index (array_sequential, i)));
+	}
+
+	g_ptr_array_unref (array_parallel);
+	g_ptr_array_unref (array_sequential);
+
+	/* searching by group uses the shared groups and local store, so
+	 * must give the same results when parallel queries are enabled */
+	groups = zif_groups_new ();
+	filename = zif_test_get_data_file ("yum-comps-groups.conf");
+	ret = zif_groups_set_mapping_file (groups, filename, &error);
+	g_free (filename);
+	g_assert_no_error (error);
+	g_assert (ret);
+	store_local = zif_store_local_new ();
+	filename = zif_test_get_data_file ("root");
+	ret = zif_store_local_set_prefix (ZIF_STORE_LOCAL (store_local), filename, &error);
+	g_free (filename);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = zif_config_set_boolean (config, "parallel_store_queries", TRUE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_state_reset (state);
+	array_parallel = zif_store_array_search_group (store_array, (gchar **) search_group, state, &error);
+	g_assert_no_error (error);
+	g_assert (array_parallel != NULL);
+	ret = zif_config_unset (config, "parallel_store_queries", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_state_reset (state);
+	array_sequential = zif_store_array_search_group (store_array, (gchar **) search_group, state, &error);
+	g_assert_no_error (error);
+	g_assert (array_sequential != NULL);
+	g_assert_cmpint (array_parallel->len, ==, array_sequential->len);
+	for (i = 0; i < array_parallel->len; i++) {
+		g_assert_cmpstr (zif_package_get_id (g_ptr_array_index (array_parallel, i)), ==,
+				 zif_package_get_id (g_ptr_array_index (array_sequential, i)));
+	}
+	g_ptr_array_unref (array_parallel);
+	g_ptr_array_unref (array_sequential);
+	g_object_unref (store_local);
+	g_object_unref (groups);
+
+	g_ptr_array_unref (store_array);
+	g_object_unref (state);
+	g_object_unref (config);
+}
+
 static void
 zif_package_array_func (void)
 {
@@ -684,6 +909,31 @@ zif_config_func (void)
 	g_assert_cmpstr (value, ==, "/var/cache/zif/$basearch/$releasever");
 	g_free (value);
 
+	/* cached string arrays are only split once */
+	ret = zif_config_set_string (config, "test_prefixes", "/usr/share/,/opt/", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	array = zif_config_get_strv_cached (config, "test_prefixes", &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (g_strv_length (array), ==, 2);
+	g_assert_cmpstr (array[1], ==, "/opt/");
+	g_assert (zif_config_get_strv_cached (config, "test_prefixes", NULL) == array);
+
+	/* changing the value invalidates the cache */
+	ret = zif_config_unset (config, "test_prefixes", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = zif_config_set_string (config, "test_prefixes", "/srv/", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	array = zif_config_get_strv_cached (config, "test_prefixes", &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (g_strv_length (array), ==, 1);
+	g_assert_cmpstr (array[0], ==, "/srv/");
+	ret = zif_config_unset (config, "test_prefixes", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
 	value = zif_config_expand_substitutions (config, "http://fedora/4/6/moo.rpm", &error);
 	g_assert_no_error (error);
 	g_assert_cmpstr (value, ==, "http://fedora/4/6/moo.rpm");
@@ -1083,6 +1333,7 @@ zif_download_func (void)
 	gboolean ret;
 	gchar *filename;
 	GError *error = NULL;
+	GByteArray *data;
 
 	download = zif_download_new ();
 	g_object_add_weak_pointer (G_OBJECT (download), (gpointer *) &download);
@@ -1103,6 +1354,24 @@ zif_download_func (void)
 	/* turn off slow mirror detection */
 	zif_config_set_uint (config, "slow_server_speed", 0, NULL);
 
+	/* get part of a local file */
+	data = g_byte_array_new ();
+	filename = zif_test_get_data_file ("data.txt");
+	ret = zif_download_file_range (download, filename, 5, 4, data, state, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (data->len, ==, 4);
+	g_assert (memcmp (data->data, "is a", 4) == 0);
+
+	/* past the end of the file */
+	ret = zif_download_file_range (download, filename, 10, 100, data, state, &error);
+	g_assert_error (error, ZIF_DOWNLOAD_ERROR, ZIF_DOWNLOAD_ERROR_WRONG_SIZE);
+	g_assert (!ret);
+	g_assert_cmpint (data->len, ==, 4);
+	g_clear_error (&error);
+	g_byte_array_unref (data);
+	g_free (filename);
+
 	/* add something sensible, but it won't resolve later on */
 	ret = zif_download_location_add_uri (download, "http://www.bbc.co.uk/pub/", &error);
 	g_assert_no_error (error);
@@ -1217,6 +1486,54 @@ out:
 	g_assert (config == NULL);
 }
 
+static void
+zif_file_list_func (void)
+{
+	gchar *filename;
+	GPtrArray *array;
+	ZifFileList *list1;
+	ZifFileList *list2;
+
+	list1 = zif_file_list_new ();
+	zif_file_list_add (list1, "/usr/bin/", "hal");
+	zif_file_list_add_filename (list1, "/usr/bin/lshal");
+	zif_file_list_add_filename (list1, "/etc/hal.conf");
+	g_assert_cmpint (zif_file_list_get_length (list1), ==, 3);
+	g_assert_cmpstr (zif_file_list_get_dirname (list1, 1), ==, "/usr/bin/");
+	g_assert_cmpstr (zif_file_list_get_basename (list1, 1), ==, "lshal");
+	filename = zif_file_list_get_filename (list1, 2);
+	g_assert_cmpstr (filename, ==, "/etc/hal.conf");
+	g_free (filename);
+
+	/* lookups */
+	g_assert (zif_file_list_contains (list1, "/usr/bin/hal"));
+	g_assert (zif_file_list_contains (list1, "/etc/hal.conf"));
+	g_assert (!zif_file_list_contains (list1, "/usr/bin/hal.conf"));
+	g_assert (!zif_file_list_contains (list1, "/usr/sbin/hal"));
+	g_assert (!zif_file_list_contains (list1, "/not/a/directory/hal"));
+
+	/* adding a file after a lookup invalidates the index */
+	zif_file_list_add_filename (list1, "/usr/bin/halctl");
+	g_assert (zif_file_list_contains (list1, "/usr/bin/halctl"));
+	g_assert (zif_file_list_contains (list1, "/usr/bin/lshal"));
+	g_assert_cmpint (zif_file_list_get_length (list1), ==, 4);
+
+	/* directory names are shared between lists */
+	array = zif_file_list_to_array (list1);
+	g_assert_cmpint (array->len, ==, 4);
+	g_assert_cmpstr (g_ptr_array_index (array, 0), ==, "/usr/bin/hal");
+	list2 = zif_file_list_new_from_array (array);
+	g_assert (zif_file_list_get_dirname (list1, 0) ==
+		  zif_file_list_get_dirname (list2, 1));
+	g_assert_cmpint (zif_file_list_get_size (list2), >, 0);
+	g_ptr_array_unref (array);
+
+	zif_file_list_ref (list2);
+	g_assert (zif_file_list_unref (list2) != NULL);
+	g_assert (zif_file_list_unref (list2) == NULL);
+	zif_file_list_unref (list1);
+}
+
 static void
 zif_groups_func (void)
 {
@@ -1490,6 +1807,68 @@ zif_lock_threads_func (void)
 	g_assert (config == NULL);
 }
 
+static void
+zif_memory_func (void)
+{
+	gboolean ret;
+	gchar *report;
+	GError *error = NULL;
+	guint64 strings;
+	guint64 total;
+	ZifDepend *depend;
+	ZifMemory *memory;
+	ZifPackage *package1;
+	ZifPackage *package2;
+	ZifString *license;
+
+	/* two packages sharing the same license */
+	license = zif_string_new ("GPLv2+");
+	package1 = zif_package_new ();
+	ret = zif_package_set_id (package1, "hal;0.1-1.fc13;i386;fedora", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_package_set_license (package1, license);
+	zif_package_add_file (package1, "/usr/bin/hal");
+	depend = zif_depend_new_from_values ("hal", ZIF_DEPEND_FLAG_ANY, "");
+	zif_package_add_provide (package1, depend);
+	g_object_unref (depend);
+	package2 = zif_package_new ();
+	ret = zif_package_set_id (package2, "dave;0.1-1.fc13;i386;fedora", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_package_set_license (package2, license);
+
+	memory = zif_memory_new ();
+	zif_package_get_memory_usage (package1, memory);
+	g_assert_cmpint (zif_memory_get_size (memory, ZIF_MEMORY_KIND_PACKAGES), >, 0);
+	g_assert_cmpint (zif_memory_get_size (memory, ZIF_MEMORY_KIND_FILES), >, 0);
+	g_assert_cmpint (zif_memory_get_size (memory, ZIF_MEMORY_KIND_DEPENDS), >, 0);
+	g_assert_cmpint (zif_memory_get_size (memory, ZIF_MEMORY_KIND_HASHES), >, 0);
+	g_assert_cmpint (zif_memory_get_size (memory, ZIF_MEMORY_KIND_MD), ==, 0);
+	strings = zif_memory_get_size (memory, ZIF_MEMORY_KIND_STRINGS);
+	g_assert_cmpint (strings, >, 0);
+
+	/* counting the same package again changes nothing */
+	total = zif_memory_get_total (memory);
+	zif_package_get_memory_usage (package1, memory);
+	g_assert_cmpint (zif_memory_get_total (memory), ==, total);
+
+	/* the shared license is not counted twice */
+	zif_package_get_memory_usage (package2, memory);
+	g_assert_cmpint (zif_memory_get_size (memory, ZIF_MEMORY_KIND_STRINGS), <,
+			 strings * 2);
+
+	report = zif_memory_to_string (memory);
+	g_assert (g_strstr_len (report, -1, "files") != NULL);
+	g_assert (g_strstr_len (report, -1, "total") != NULL);
+	g_free (report);
+
+	g_object_unref (memory);
+	g_object_unref (package1);
+	g_object_unref (package2);
+	zif_string_unref (license);
+}
+
 static void
 zif_md_func (void)
 {
@@ -1583,6 +1962,18 @@ zif_md_comps_func (void)
 	g_assert_cmpstr (id, ==, "test");
 	g_ptr_array_unref (array);
 
+	/* unknown ids are not in the index */
+	zif_state_reset (state);
+	array = zif_md_comps_get_packages_for_group (ZIF_MD_COMPS (md), "dave", state, &error);
+	g_assert_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED);
+	g_assert (array == NULL);
+	g_clear_error (&error);
+	zif_state_reset (state);
+	array = zif_md_comps_get_groups_for_category (ZIF_MD_COMPS (md), "dave", state, &error);
+	g_assert_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED);
+	g_assert (array == NULL);
+	g_clear_error (&error);
+
 	g_object_unref (md);
 	g_object_unref (state);
 	g_assert (state == NULL);
@@ -1646,7 +2037,11 @@ zif_md_filelists_xml_func (void)
 	gchar *pkgid;
 	const gchar *data[] = { "/usr/lib/debug/usr/bin/gpk-prefs.debug", NULL };
 	gchar *filename;
+	struct stat stat_index;
+	struct stat stat_tmp;
 	ZifConfig *config;
+	ZifPackage *package;
+	ZifString *string;
 
 	state = zif_state_new ();
 	g_object_add_weak_pointer (G_OBJECT (state), (gpointer *) &state);
@@ -1683,6 +2078,51 @@ zif_md_filelists_xml_func (void)
 	g_assert_cmpstr (pkgid, ==, "cec62d49c26d27b8584112d7d046782c578a097b81fe628d269d8afd7f1d54f4");
 	g_ptr_array_unref (array);
 
+	/* the files were written to an index next to the XML */
+	g_assert (g_file_test (zif_md_get_filename_index (md), G_FILE_TEST_EXISTS));
+
+	/* get the files from the index */
+	package = zif_package_remote_new ();
+	string = zif_string_new ("cec62d49c26d27b8584112d7d046782c578a097b81fe628d269d8afd7f1d54f4");
+	zif_package_set_pkgid (package, string);
+	zif_string_unref (string);
+	zif_state_reset (state);
+	array = zif_md_get_files (md, package, state, &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 138);
+	g_ptr_array_unref (array);
+	g_object_unref (package);
+
+	/* the index is only valid for the data it was built from */
+	g_assert (zif_md_index_is_valid (zif_md_get_filename_index (md), 1,
+					 "8018e177379ada1d380b4ebf800e7caa95ff8cf90fdd6899528266719bbfdeab"));
+	g_assert (!zif_md_index_is_valid (zif_md_get_filename_index (md), 1, "dead"));
+	g_assert (!zif_md_index_is_valid (zif_md_get_filename_index (md), 1, NULL));
+	g_assert_cmpint (g_stat (zif_md_get_filename_index (md), &stat_index), ==, 0);
+	g_object_unref (md);
+
+	/* a new instance reuses the index */
+	md = zif_md_filelists_xml_new ();
+	zif_md_set_id (md, "fedora");
+	zif_md_set_checksum_type (md, G_CHECKSUM_SHA256);
+	zif_md_set_checksum (md, "cadb324b10d395058ed22c9d984038927a3ea4ff9e0e798116be44b0233eaa49");
+	zif_md_set_checksum_uncompressed (md, "8018e177379ada1d380b4ebf800e7caa95ff8cf90fdd6899528266719bbfdeab");
+	filename = zif_test_get_data_file ("fedora/filelists.xml.gz");
+	zif_md_set_filename (md, filename);
+	g_free (filename);
+	zif_state_reset (state);
+	array = zif_md_search_file (md, (gchar**)data, state, &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 1);
+	g_ptr_array_unref (array);
+
+	/* rebuilding would have renamed a new file into place */
+	g_assert_cmpint (g_stat (zif_md_get_filename_index (md), &stat_tmp), ==, 0);
+	g_assert_cmpint (stat_tmp.st_ino, ==, stat_index.st_ino);
+	g_assert_cmpint (stat_tmp.st_mtime, ==, stat_index.st_mtime);
+
 	g_object_unref (state);
 	g_assert (state == NULL);
 	g_object_unref (md);
@@ -1807,6 +2247,13 @@ zif_md_other_sql_func (void)
 	ZifState *state;
 	ZifConfig *config;
 	gchar *filename;
+	const gchar *pkgids[] = { NULL, NULL, NULL };
+	gchar *report;
+	GHashTable *hash;
+	guint64 statements = 0;
+
+	/* collect statistics for the database */
+	zif_sql_stats_set_enabled (TRUE);
 
 	state = zif_state_new ();
 	g_object_add_weak_pointer (G_OBJECT (state), (gpointer *) &state);
@@ -1841,6 +2288,18 @@ zif_md_other_sql_func (void)
 	g_assert (array != NULL);
 	g_assert_cmpint (array->len, ==, 10);
 
+	/* the query was recorded */
+	filename = g_strdup_printf ("other_db:%s", zif_md_get_filename_uncompressed (md));
+	ret = zif_sql_stats_get (filename, &statements, NULL, NULL);
+	g_free (filename);
+	g_assert (ret);
+	g_assert_cmpint (statements, >, 0);
+	report = zif_sql_stats_to_string ();
+	g_assert (g_strstr_len (report, -1, "changelog") != NULL);
+	g_free (report);
+	zif_sql_stats_reset ();
+	zif_sql_stats_set_enabled (FALSE);
+
 	/* get first entry */
 	changeset = g_ptr_array_index (array, 1);
 	g_assert_cmpstr (zif_changeset_get_version (changeset), ==, "2.10.0-1");
@@ -1850,6 +2309,44 @@ zif_md_other_sql_func (void)
 	/* remove array */
 	g_ptr_array_unref (array);
 
+	/* get a batch, limiting the number of entries */
+	zif_state_reset (state);
+	pkgids[0] = "3f75d650e5fe874713627c16081fe8134d0f1bd57f1810c5ce426757a9d0bc88";
+	pkgids[1] = "dave";
+	hash = zif_md_other_sql_get_changelogs (ZIF_MD_OTHER_SQL (md),
+						(gchar **) pkgids, 3,
+						state, &error);
+	g_assert_no_error (error);
+	g_assert (hash != NULL);
+	g_assert_cmpint (g_hash_table_size (hash), ==, 2);
+	array = g_hash_table_lookup (hash, pkgids[0]);
+	g_assert_cmpint (array->len, ==, 3);
+	changeset = g_ptr_array_index (array, 1);
+	g_assert_cmpstr (zif_changeset_get_version (changeset), ==, "2.10.0-1");
+	array = g_hash_table_lookup (hash, pkgids[1]);
+	g_assert_cmpint (array->len, ==, 0);
+	g_hash_table_unref (hash);
+
+	/* only get the entries newer than the installed version */
+	zif_state_reset (state);
+	array = zif_md_other_sql_get_changelog_since (ZIF_MD_OTHER_SQL (md),
+						      pkgids[0], "2.10.0-1", 0,
+						      state, &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 2);
+	g_ptr_array_unref (array);
+
+	/* and nothing if the installed package was built later */
+	zif_state_reset (state);
+	array = zif_md_other_sql_get_changelog_since (ZIF_MD_OTHER_SQL (md),
+						      pkgids[0], NULL, 4000000000,
+						      state, &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 0);
+	g_ptr_array_unref (array);
+
 	g_object_unref (state);
 	g_assert (state == NULL);
 	g_object_unref (md);
@@ -1984,6 +2481,8 @@ zif_md_primary_xml_func (void)
 	GError *error = NULL;
 	GPtrArray *array;
 	GPtrArray *depends;
+	struct stat stat_index;
+	struct stat stat_tmp;
 	ZifConfig *config;
 	ZifDepend *depend;
 	ZifMd *md;
@@ -2029,6 +2528,9 @@ zif_md_primary_xml_func (void)
 	g_assert (ret);
 	g_assert (zif_md_get_is_loaded (md));
 
+	/* the packages were written to an index next to the XML */
+	g_assert (g_file_test (zif_md_get_filename_index (md), G_FILE_TEST_EXISTS));
+
 	/* resolving by name and globbing */
 	zif_state_reset (state);
 	array = zif_md_resolve_full (md,
@@ -2151,14 +2653,42 @@ zif_md_primary_xml_func (void)
 	g_object_unref (depend);
 	g_ptr_array_unref (depends);
 	g_ptr_array_unref (array);
-
-	g_object_unref (store_remote);
-	g_object_unref (state);
-	g_assert (state == NULL);
+	g_assert_cmpint (g_stat (zif_md_get_filename_index (md), &stat_index), ==, 0);
 	g_object_unref (md);
-	g_object_unref (config);
-	g_assert (config == NULL);
-}
+
+	/* a new instance reuses the index */
+	md = zif_md_primary_xml_new ();
+	zif_md_set_store (md, ZIF_STORE (store_remote));
+	zif_md_set_id (md, "fedora");
+	zif_md_set_checksum_type (md, G_CHECKSUM_SHA256);
+	zif_md_set_checksum (md, "33a0eed8e12f445618756b18aa49d05ee30069d280d37b03a7a15d1ec954f833");
+	zif_md_set_checksum_uncompressed (md, "52e4c37b13b4b23ae96432962186e726550b19e93cf3cbf7bf55c2a673a20086");
+	filename = zif_test_get_data_file ("fedora/primary.xml.gz");
+	zif_md_set_filename (md, filename);
+	g_free (filename);
+	zif_state_reset (state);
+	array = zif_md_resolve_full (md,
+				     (gchar**)data,
+				     ZIF_STORE_RESOLVE_FLAG_USE_NAME_ARCH,
+				     state,
+				     &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 1);
+	g_ptr_array_unref (array);
+
+	/* rebuilding would have renamed a new file into place */
+	g_assert_cmpint (g_stat (zif_md_get_filename_index (md), &stat_tmp), ==, 0);
+	g_assert_cmpint (stat_tmp.st_ino, ==, stat_index.st_ino);
+	g_assert_cmpint (stat_tmp.st_mtime, ==, stat_index.st_mtime);
+
+	g_object_unref (store_remote);
+	g_object_unref (state);
+	g_assert (state == NULL);
+	g_object_unref (md);
+	g_object_unref (config);
+	g_assert (config == NULL);
+}
 
 static void
 zif_md_updateinfo_func (void)
@@ -2194,8 +2724,23 @@ zif_md_updateinfo_func (void)
 	g_assert_cmpstr (zif_update_get_id (update), ==, "FEDORA-2008-9969");
 	g_assert_cmpstr (zif_update_get_title (update), ==, "lvm2-2.02.39-7.fc10");
 	g_assert_cmpstr (zif_update_get_description (update), ==, "Fix an incorrect path that prevents the clvmd init script from working and include licence files with the sub-packages.");
-
 	g_ptr_array_unref (array);
+
+	/* get by update ID */
+	zif_state_reset (state);
+	update = zif_md_updateinfo_get_detail_for_id (ZIF_MD_UPDATEINFO (md), "FEDORA-2008-9969", state, &error);
+	g_assert_no_error (error);
+	g_assert (update != NULL);
+	g_assert_cmpstr (zif_update_get_title (update), ==, "lvm2-2.02.39-7.fc10");
+	g_object_unref (update);
+
+	/* unknown update ID */
+	zif_state_reset (state);
+	update = zif_md_updateinfo_get_detail_for_id (ZIF_MD_UPDATEINFO (md), "FEDORA-0000-0000", state, &error);
+	g_assert_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED);
+	g_assert (update == NULL);
+	g_clear_error (&error);
+
 	g_object_unref (md);
 	g_object_unref (state);
 	g_assert (state == NULL);
@@ -2209,6 +2754,7 @@ zif_md_delta_func (void)
 	ZifState *state;
 	ZifDelta *delta;
 	gchar *filename;
+	const gchar *names[] = { "hal", NULL };
 
 	state = zif_state_new ();
 	g_object_add_weak_pointer (G_OBJECT (state), (gpointer *) &state);
@@ -2236,8 +2782,39 @@ zif_md_delta_func (void)
 	g_assert_cmpstr (zif_delta_get_sequence (delta), ==, "test-0.1-1.fc13-9942652a8896b437f4ad8ab930cd32080230");
 	g_assert_cmpstr (zif_delta_get_checksum (delta), ==, "000a2b879f9e52e96a6b3c7279b32afbf163cd90ec3887d03aef8aa115f45000");
 	g_assert_cmpint (zif_delta_get_size (delta), ==, 81396);
-
 	g_object_unref (delta);
+
+	/* no delta from this installed version */
+	zif_state_reset (state);
+	delta = zif_md_delta_search_for_package (ZIF_MD_DELTA (md),
+						 "test;0.1-3.fc13;noarch;fedora",
+						 "test;0.1-2.fc13;noarch;installed",
+						 state, &error);
+	g_assert_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED);
+	g_assert (delta == NULL);
+	g_clear_error (&error);
+	g_object_unref (md);
+
+	/* do not parse deltas for packages that are not installed */
+	md = zif_md_delta_new ();
+	zif_md_set_id (md, "fedora");
+	filename = zif_test_get_data_file ("fedora/prestodelta.xml.gz");
+	zif_md_set_filename (md, filename);
+	g_free (filename);
+	zif_md_set_checksum_type (md, G_CHECKSUM_SHA256);
+	zif_md_set_checksum (md, "157db37dce190775ff083cb51043e55da6e4abcabfe00584d2a69cc8fd327cae");
+	zif_md_set_checksum_uncompressed (md, "64b7472f40d355efde22c2156bdebb9c5babe8f35a9f26c6c1ca6b510031d485");
+	zif_md_delta_set_installed_names (ZIF_MD_DELTA (md), (gchar **) names);
+	zif_state_reset (state);
+	delta = zif_md_delta_search_for_package (ZIF_MD_DELTA (md),
+						 "test;0.1-3.fc13;noarch;fedora",
+						 "test;0.1-1.fc13;noarch;installed",
+						 state, &error);
+	g_assert_error (error, ZIF_MD_ERROR, ZIF_MD_ERROR_FAILED);
+	g_assert (delta == NULL);
+	g_assert (zif_md_get_is_loaded (md));
+	g_clear_error (&error);
+
 	g_object_unref (md);
 	g_object_unref (state);
 	g_assert (state == NULL);
@@ -2409,6 +2986,75 @@ zif_package_local_func (void)
 	g_object_unref (pkg);
 }
 
+static void
+zif_package_local_files_func (void)
+{
+	gboolean ret;
+	gchar *filename;
+	GError *error = NULL;
+	ZifDepend *depend;
+	ZifDepend *satisfies = NULL;
+	ZifMemory *memory;
+	ZifPackage *pkg;
+	ZifState *state;
+
+	state = zif_state_new ();
+	pkg = zif_package_local_new ();
+	filename = zif_test_get_data_file ("test-0.1-1.fc13.noarch.rpm");
+	ret = zif_package_local_set_from_filename (ZIF_PACKAGE_LOCAL (pkg), filename, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_free (filename);
+
+	/* a normal depend does not need the file list */
+	depend = zif_depend_new ();
+	zif_depend_set_name (depend, "test");
+	zif_depend_set_flag (depend, ZIF_DEPEND_FLAG_ANY);
+	ret = zif_package_provides (pkg, depend, &satisfies, state, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (satisfies != NULL);
+	g_object_unref (satisfies);
+	g_object_unref (depend);
+
+	/* a file in a directory the package does not own */
+	zif_state_reset (state);
+	depend = zif_depend_new ();
+	zif_depend_set_name (depend, "/usr/bin/test");
+	zif_depend_set_flag (depend, ZIF_DEPEND_FLAG_ANY);
+	ret = zif_package_provides (pkg, depend, &satisfies, state, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (satisfies == NULL);
+	g_object_unref (depend);
+
+	/* so the file list was never loaded */
+	memory = zif_memory_new ();
+	zif_package_get_memory_usage (pkg, memory);
+	g_assert_cmpint (zif_memory_get_size (memory, ZIF_MEMORY_KIND_FILES), ==, 0);
+	g_object_unref (memory);
+
+	/* a file the package does own */
+	zif_state_reset (state);
+	depend = zif_depend_new ();
+	zif_depend_set_name (depend, "/usr/share/test-0.1/README");
+	zif_depend_set_flag (depend, ZIF_DEPEND_FLAG_ANY);
+	ret = zif_package_provides (pkg, depend, &satisfies, state, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (satisfies != NULL);
+	g_object_unref (satisfies);
+	g_object_unref (depend);
+
+	memory = zif_memory_new ();
+	zif_package_get_memory_usage (pkg, memory);
+	g_assert_cmpint (zif_memory_get_size (memory, ZIF_MEMORY_KIND_FILES), >, 0);
+	g_object_unref (memory);
+
+	g_object_unref (pkg);
+	g_object_unref (state);
+}
+
 static void
 zif_package_meta_func (void)
 {
@@ -3354,6 +4000,69 @@ zif_state_finished_func (void)
 	g_assert (state == NULL);
 }
 
+static void
+zif_state_trace_func (void)
+{
+	ZifState *state_local;
+	ZifState *state;
+	gboolean ret;
+	gchar **split;
+	gchar *trace;
+	GError *error = NULL;
+
+	zif_state_clear_trace ();
+
+	state = zif_state_new ();
+	g_object_add_weak_pointer (G_OBJECT (state), (gpointer *) &state);
+
+	/* nothing recorded when disabled */
+	ret = zif_state_set_number_steps (state, 1);
+	g_assert (ret);
+	ret = zif_state_done (state, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	trace = zif_state_get_trace ();
+	g_assert (g_strstr_len (trace, -1, "traceEvents") != NULL);
+	g_assert (g_strstr_len (trace, -1, "\"ph\":\"X\"") == NULL);
+	g_free (trace);
+
+	/* parent with two steps, the first has a child with one step */
+	zif_state_reset (state);
+	zif_state_set_enable_trace (state, TRUE);
+	ret = zif_state_set_number_steps (state, 2);
+	g_assert (ret);
+	zif_state_action_start (state, ZIF_STATE_ACTION_LOADING_RPMDB, "/");
+	state_local = zif_state_get_child (state);
+	g_assert (zif_state_get_enable_trace (state_local));
+	ret = zif_state_set_number_steps (state_local, 1);
+	g_assert (ret);
+	ret = zif_state_done (state_local, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = zif_state_done (state, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = zif_state_done (state, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* two states and three steps */
+	trace = zif_state_get_trace ();
+	split = g_strsplit (trace, "\"ph\":\"X\"", -1);
+	g_assert_cmpint (g_strv_length (split), ==, 5 + 1);
+	g_assert (g_strstr_len (trace, -1, "\"package\":\"/\"") != NULL);
+	g_strfreev (split);
+	g_free (trace);
+
+	zif_state_clear_trace ();
+	trace = zif_state_get_trace ();
+	g_assert (g_strstr_len (trace, -1, "\"ph\":\"X\"") == NULL);
+	g_free (trace);
+
+	g_object_unref (state);
+	g_assert (state == NULL);
+}
+
 static void
 zif_state_locking_func (void)
 {
@@ -3402,6 +4111,81 @@ zif_state_locking_func (void)
 	g_assert (config == NULL);
 }
 
+static void
+zif_store_local_threads_func (void)
+{
+	gboolean ret;
+	GCancellable *cancellable;
+	gchar *filename;
+	gchar *pidfile;
+	GError *error = NULL;
+	GPtrArray *array;
+	GPtrArray *array_serial;
+	guint i;
+	guint j;
+	ZifConfig *config;
+	ZifState *state;
+	ZifStore *store;
+
+	config = zif_config_new ();
+	g_object_add_weak_pointer (G_OBJECT (config), (gpointer *) &config);
+	filename = zif_test_get_data_file ("zif.conf");
+	zif_config_set_filename (config, filename, NULL);
+	g_free (filename);
+	pidfile = g_build_filename (zif_tmpdir, "zif.lock", NULL);
+	zif_config_set_string (config, "pidfile", pidfile, NULL);
+	g_free (pidfile);
+	zif_config_set_string (config, "history_db", "/dev/mapper/foobar", NULL);
+
+	/* set a cancellable, as we're using the store directly */
+	state = zif_state_new ();
+	cancellable = g_cancellable_new ();
+	zif_state_set_cancellable (state, cancellable);
+	g_object_unref (cancellable);
+
+	/* load in one thread, then in many */
+	for (i = 0; i < 2; i++) {
+		ret = zif_config_set_uint (config, "rpmdb_load_threads", i == 0 ? 1 : 4, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		store = zif_store_local_new ();
+		g_object_add_weak_pointer (G_OBJECT (store), (gpointer *) &store);
+		filename = zif_test_get_data_file ("root");
+		ret = zif_store_local_set_prefix (ZIF_STORE_LOCAL (store), filename, &error);
+		g_free (filename);
+		g_assert_no_error (error);
+		g_assert (ret);
+
+		zif_state_reset (state);
+		array = zif_store_get_packages (store, state, &error);
+		g_assert_no_error (error);
+		g_assert (array != NULL);
+		g_assert_cmpint (array->len, >, 0);
+		g_object_unref (store);
+		g_assert (store == NULL);
+		ret = zif_config_unset (config, "rpmdb_load_threads", &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		if (i == 0) {
+			array_serial = array;
+			continue;
+		}
+
+		/* the same packages in the same order */
+		g_assert_cmpint (array->len, ==, array_serial->len);
+		for (j = 0; j < array->len; j++) {
+			g_assert_cmpstr (zif_package_get_id (g_ptr_array_index (array, j)), ==,
+					 zif_package_get_id (g_ptr_array_index (array_serial, j)));
+		}
+		g_ptr_array_unref (array);
+	}
+
+	g_ptr_array_unref (array_serial);
+	g_object_unref (state);
+	g_object_unref (config);
+	g_assert (config == NULL);
+}
+
 static void
 zif_store_local_func (void)
 {
@@ -3690,50 +4474,301 @@ zif_store_local_func (void)
 	g_assert (config == NULL);
 }
 
+typedef struct {
+	GMainLoop	*loop;
+	ZifClient	*client;
+	GPtrArray	*array;
+	GError		*error;
+	const gchar	*socket_path;
+	gchar		*reply_invalid;
+	gchar		*reply_unknown;
+} ZifSelfTestServerHelper;
+
+static GSocketConnection *
+zif_self_test_server_connect (const gchar *socket_path)
+{
+	GSocketAddress *address;
+	GSocketClient *socket_client;
+	GSocketConnection *connection;
+
+	socket_client = g_socket_client_new ();
+	address = g_unix_socket_address_new (socket_path);
+	connection = g_socket_client_connect (socket_client,
+					      G_SOCKET_CONNECTABLE (address),
+					      NULL, NULL);
+	g_object_unref (address);
+	g_object_unref (socket_client);
+	return connection;
+}
+
+static gchar *
+zif_self_test_server_request (const gchar *socket_path, const gchar *request)
+{
+	gboolean ret;
+	gchar *line;
+	GDataInputStream *input;
+	GSocketConnection *connection;
+
+	connection = zif_self_test_server_connect (socket_path);
+	g_assert (connection != NULL);
+	ret = g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (connection)),
+					 request, strlen (request), NULL, NULL, NULL);
+	g_assert (ret);
+	input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (connection)));
+	line = g_data_input_stream_read_line (input, NULL, NULL, NULL);
+	g_object_unref (input);
+	g_io_stream_close (G_IO_STREAM (connection), NULL, NULL);
+	g_object_unref (connection);
+	return line;
+}
+
+static gpointer
+zif_self_test_server_client_thread (gpointer data)
+{
+	const gchar *to_array[] = { "test", NULL };
+	GSocketConnection *connection_idle;
+	ZifSelfTestServerHelper *helper = (ZifSelfTestServerHelper *) data;
+	ZifState *state;
+
+	/* a client that never sends a request must not block the others */
+	connection_idle = zif_self_test_server_connect (helper->socket_path);
+	g_assert (connection_idle != NULL);
+
+	state = zif_state_new ();
+	helper->array = zif_client_resolve_full (helper->client,
+						 (gchar **) to_array,
+						 ZIF_STORE_RESOLVE_FLAG_USE_NAME,
+						 state,
+						 &helper->error);
+	g_object_unref (state);
+
+	/* speak the protocol directly to get the replies for bad requests */
+	helper->reply_unknown = zif_self_test_server_request (helper->socket_path,
+							      "not-a-command\n");
+	helper->reply_invalid = zif_self_test_server_request (helper->socket_path,
+							      "resolve\n");
+
+	g_io_stream_close (G_IO_STREAM (connection_idle), NULL, NULL);
+	g_object_unref (connection_idle);
+	g_main_loop_quit (helper->loop);
+	return NULL;
+}
+
 static void
-zif_store_meta_func (void)
+zif_server_func (void)
 {
-	ZifStore *store;
-	ZifPackage *pkg;
 	gboolean ret;
-	GError *error = NULL;
 	gchar *filename;
-	ZifState *state;
-	const gchar *to_array[] = {NULL, NULL};
+	gchar *pidfile;
+	gchar *socket_path;
+	GError *error = NULL;
 	GPtrArray *array;
+	GPtrArray *store_array;
+	GThread *thread;
+	ZifConfig *config;
+	ZifPackage *package;
+	ZifSelfTestServerHelper helper;
+	ZifServer *server;
+	ZifServer *server_tmp;
+	ZifState *state;
+	ZifStore *store;
 
-	store = zif_store_meta_new ();
-	g_object_add_weak_pointer (G_OBJECT (store), (gpointer *) &store);
+	config = zif_config_new ();
+	filename = zif_test_get_data_file ("zif.conf");
+	zif_config_set_filename (config, filename, NULL);
+	g_free (filename);
+	pidfile = g_build_filename (zif_tmpdir, "zif.lock", NULL);
+	zif_config_set_string (config, "pidfile", pidfile, NULL);
+	g_free (pidfile);
 
-	/* create virtal package to add to the store */
+	/* load the local store */
 	state = zif_state_new ();
-	g_object_add_weak_pointer (G_OBJECT (state), (gpointer *) &state);
-	pkg = zif_package_meta_new ();
-	filename = zif_test_get_data_file ("test.spec");
-	ret = zif_package_meta_set_from_filename (ZIF_PACKAGE_META(pkg), filename, &error);
+	store = zif_store_local_new ();
+	filename = zif_test_get_data_file ("root");
+	zif_store_local_set_prefix (ZIF_STORE_LOCAL (store), filename, &error);
+	g_assert_no_error (error);
+	g_free (filename);
+	ret = zif_store_load (store, state, &error);
 	g_assert_no_error (error);
 	g_assert (ret);
 
-	g_assert_cmpstr (zif_package_get_id (pkg), ==, "test;0.1-1%{?dist};i386;meta");
-
-	/* add to array */
-	ret = zif_store_add_package (store, pkg, &error);
+	/* start the server with no remote stores */
+	socket_path = g_build_filename (zif_tmpdir, "zif-server.socket", NULL);
+	server = zif_server_new ();
+	zif_server_set_socket_path (server, socket_path);
+	store_array = zif_store_array_new ();
+	zif_server_set_stores (server, store, store_array);
+	ret = zif_server_start (server, &error);
 	g_assert_no_error (error);
 	g_assert (ret);
 
-	/* add to array, again */
-	ret = zif_store_add_package (store, pkg, &error);
-	g_assert_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED);
+	/* a second server must not take over the live socket */
+	server_tmp = zif_server_new ();
+	zif_server_set_socket_path (server_tmp, socket_path);
+	ret = zif_server_start (server_tmp, &error);
+	g_assert_error (error, ZIF_SERVER_ERROR, ZIF_SERVER_ERROR_FAILED);
 	g_assert (!ret);
 	g_clear_error (&error);
+	g_object_unref (server_tmp);
+	g_assert (g_file_test (socket_path, G_FILE_TEST_EXISTS));
 
-	/* ensure we can find it */
-	to_array[0] = "test";
+	/* no server on this socket */
+	helper.client = zif_client_new ();
+	zif_client_set_socket_path (helper.client, "/dev/null/nothing");
 	zif_state_reset (state);
-	array = zif_store_resolve (store, (gchar**) to_array, state, &error);
-	g_assert_no_error (error);
-	g_assert (array != NULL);
-	g_assert_cmpint (array->len, ==, 1);
+	array = zif_client_get_updates (helper.client, state, &error);
+	g_assert_error (error, ZIF_SERVER_ERROR, ZIF_SERVER_ERROR_NO_SERVER);
+	g_assert (array == NULL);
+	g_clear_error (&error);
+
+	/* the server answers in the main thread, so query from another */
+	zif_client_set_socket_path (helper.client, socket_path);
+	g_assert (zif_client_is_available (helper.client));
+	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.array = NULL;
+	helper.error = NULL;
+	helper.socket_path = socket_path;
+	helper.reply_invalid = NULL;
+	helper.reply_unknown = NULL;
+	thread = g_thread_new ("zif-self-test-client",
+			       zif_self_test_server_client_thread,
+			       &helper);
+	g_main_loop_run (helper.loop);
+	g_thread_join (thread);
+	g_assert_no_error (helper.error);
+	g_assert (helper.array != NULL);
+	g_assert_cmpint (helper.array->len, ==, 1);
+	package = g_ptr_array_index (helper.array, 0);
+	g_assert_cmpstr (zif_package_get_id (package), ==, "test;0.1-1.fc14;noarch;installed");
+	g_assert (zif_package_is_installed (package));
+	g_ptr_array_unref (helper.array);
+
+	/* bad requests get an error reply */
+	g_assert_cmpstr (helper.reply_unknown, ==, "error\tfailed\tcommand 'not-a-command' not supported");
+	g_assert_cmpstr (helper.reply_invalid, ==, "error\tfailed\tno resolve flags specified");
+	g_assert_cmpint (zif_server_get_requests (server), ==, 3);
+	g_free (helper.reply_unknown);
+	g_free (helper.reply_invalid);
+
+	zif_server_stop (server);
+	g_assert (!g_file_test (socket_path, G_FILE_TEST_EXISTS));
+
+	/* the cancelled requests are freed */
+	while (g_main_context_iteration (NULL, FALSE));
+
+	/* a file that is not a socket is never removed */
+	ret = g_file_set_contents (socket_path, "data", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	server_tmp = zif_server_new ();
+	zif_server_set_socket_path (server_tmp, socket_path);
+	ret = zif_server_start (server_tmp, &error);
+	g_assert_error (error, ZIF_SERVER_ERROR, ZIF_SERVER_ERROR_FAILED);
+	g_assert (!ret);
+	g_clear_error (&error);
+	g_object_unref (server_tmp);
+	g_assert (g_file_test (socket_path, G_FILE_TEST_IS_REGULAR));
+	g_unlink (socket_path);
+
+	g_main_loop_unref (helper.loop);
+	g_object_unref (helper.client);
+	g_object_unref (server);
+	g_ptr_array_unref (store_array);
+	g_object_unref (store);
+	g_object_unref (state);
+	g_object_unref (config);
+	g_free (socket_path);
+}
+
+static void
+zif_store_meta_func (void)
+{
+	ZifStore *store;
+	ZifPackage *pkg;
+	gboolean ret;
+	GError *error = NULL;
+	gchar *filename;
+	ZifState *state;
+	const gchar *to_array[] = {NULL, NULL};
+	GPtrArray *array;
+
+	store = zif_store_meta_new ();
+	g_object_add_weak_pointer (G_OBJECT (store), (gpointer *) &store);
+
+	/* create virtal package to add to the store */
+	state = zif_state_new ();
+	g_object_add_weak_pointer (G_OBJECT (state), (gpointer *) &state);
+	pkg = zif_package_meta_new ();
+	filename = zif_test_get_data_file ("test.spec");
+	ret = zif_package_meta_set_from_filename (ZIF_PACKAGE_META(pkg), filename, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	g_assert_cmpstr (zif_package_get_id (pkg), ==, "test;0.1-1%{?dist};i386;meta");
+
+	/* add to array */
+	ret = zif_store_add_package (store, pkg, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* add to array, again */
+	ret = zif_store_add_package (store, pkg, &error);
+	g_assert_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* ensure we can find it */
+	to_array[0] = "test";
+	zif_state_reset (state);
+	array = zif_store_resolve (store, (gchar**) to_array, state, &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 1);
+	g_ptr_array_unref (array);
+
+	/* find it using the name.arch index */
+	to_array[0] = "test.i386";
+	zif_state_reset (state);
+	array = zif_store_resolve_full (store, (gchar**) to_array,
+					ZIF_STORE_RESOLVE_FLAG_USE_NAME_ARCH,
+					state, &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 1);
+	g_ptr_array_unref (array);
+
+	/* the name.arch is not a name */
+	zif_state_reset (state);
+	array = zif_store_resolve_full (store, (gchar**) to_array,
+					ZIF_STORE_RESOLVE_FLAG_USE_NAME,
+					state, &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 0);
+	g_ptr_array_unref (array);
+
+	/* find it using a glob, which narrows using the name index */
+	to_array[0] = "te*";
+	zif_state_reset (state);
+	array = zif_store_resolve_full (store, (gchar**) to_array,
+					ZIF_STORE_RESOLVE_FLAG_USE_ALL |
+					ZIF_STORE_RESOLVE_FLAG_USE_GLOB,
+					state, &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 1);
+	g_ptr_array_unref (array);
+
+	/* find it using an anchored regex */
+	to_array[0] = "^tes?t-0";
+	zif_state_reset (state);
+	array = zif_store_resolve_full (store, (gchar**) to_array,
+					ZIF_STORE_RESOLVE_FLAG_USE_NAME_VERSION |
+					ZIF_STORE_RESOLVE_FLAG_USE_REGEX,
+					state, &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 1);
 	g_ptr_array_unref (array);
 
 	/* ensure we can find it */
@@ -3763,6 +4798,256 @@ zif_store_meta_func (void)
 	g_assert (store == NULL);
 }
 
+static void
+zif_store_overlay_func (void)
+{
+	gboolean ret;
+	const gchar *to_array[] = { "hal", NULL };
+	GError *error = NULL;
+	GPtrArray *array;
+	GPtrArray *array_tmp;
+	ZifPackage *package;
+	ZifPackage *pkg_dave;
+	ZifPackage *pkg_hal;
+	ZifPackage *pkg_hal_new;
+	ZifPackage *pkg_kernel;
+	ZifState *state;
+	ZifStore *base;
+	ZifStore *store;
+
+	/* the installed packages */
+	base = zif_store_meta_new ();
+	pkg_hal = zif_package_new ();
+	ret = zif_package_set_id (pkg_hal, "hal;0.1-1.fc13;i386;installed", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_store_add_package (base, pkg_hal, NULL);
+	pkg_dave = zif_package_new ();
+	ret = zif_package_set_id (pkg_dave, "dave;0.1-1.fc13;i386;installed", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_store_add_package (base, pkg_dave, NULL);
+	pkg_hal_new = zif_package_new ();
+	ret = zif_package_set_id (pkg_hal_new, "hal;0.2-1.fc13;i386;fedora", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	store = zif_store_overlay_new ();
+	zif_store_overlay_set_base (ZIF_STORE_OVERLAY (store), base);
+	state = zif_state_new ();
+
+	/* no changes */
+	array = zif_store_get_packages (store, state, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (array->len, ==, 2);
+	g_ptr_array_unref (array);
+
+	/* already installed */
+	ret = zif_store_add_package (store, pkg_hal, &error);
+	g_assert_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* update hal */
+	ret = zif_store_remove_package (store, pkg_hal, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = zif_store_add_package (store, pkg_hal_new, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* already removed */
+	ret = zif_store_remove_package (store, pkg_hal, &error);
+	g_assert_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* the base store is not modified */
+	g_assert_cmpint (zif_store_get_size (base), ==, 2);
+
+	/* the view has the new hal */
+	zif_state_reset (state);
+	array = zif_store_get_packages (store, state, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (array->len, ==, 2);
+
+	/* the view is cached until the next change */
+	zif_state_reset (state);
+	array_tmp = zif_store_get_packages (store, state, &error);
+	g_assert_no_error (error);
+	g_assert (array_tmp == array);
+	g_ptr_array_unref (array_tmp);
+
+	/* the size and lookups see the changes without the view */
+	g_assert_cmpint (zif_store_get_size (store), ==, 2);
+	g_assert (!zif_store_has_package (store, pkg_hal));
+	g_assert (zif_store_has_package (store, pkg_hal_new));
+	g_assert (zif_store_has_package (store, pkg_dave));
+
+	/* the cached view is dropped when the base store changes */
+	pkg_kernel = zif_package_new ();
+	ret = zif_package_set_id (pkg_kernel, "kernel;2.6.35-1.fc13;i386;installed", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_store_add_package (base, pkg_kernel, NULL);
+	zif_state_reset (state);
+	array_tmp = zif_store_get_packages (store, state, &error);
+	g_assert_no_error (error);
+	g_assert (array_tmp != array);
+	g_assert_cmpint (array_tmp->len, ==, 3);
+	g_assert_cmpint (zif_store_get_size (store), ==, 3);
+	g_assert (zif_store_has_package (store, pkg_kernel));
+	g_ptr_array_unref (array_tmp);
+	g_ptr_array_unref (array);
+
+	zif_state_reset (state);
+	array = zif_store_resolve (store, (gchar **) to_array, state, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (array->len, ==, 1);
+	package = g_ptr_array_index (array, 0);
+	g_assert_cmpstr (zif_package_get_version (package), ==, "0.2-1.fc13");
+	g_ptr_array_unref (array);
+
+	/* the removed package cannot be found */
+	zif_state_reset (state);
+	package = zif_store_find_package (store, "hal;0.1-1.fc13;i386;installed", state, &error);
+	g_assert_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED_TO_FIND);
+	g_assert (package == NULL);
+	g_clear_error (&error);
+	zif_state_reset (state);
+	package = zif_store_find_package (store, "dave;0.1-1.fc13;i386;installed", state, &error);
+	g_assert_no_error (error);
+	g_assert (package == pkg_dave);
+	g_object_unref (package);
+
+	/* removing an added package just forgets it */
+	ret = zif_store_remove_package (store, pkg_hal_new, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_state_reset (state);
+	array = zif_store_resolve (store, (gchar **) to_array, state, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (array->len, ==, 0);
+	g_ptr_array_unref (array);
+
+	g_object_unref (state);
+	g_object_unref (store);
+	g_object_unref (base);
+	g_object_unref (pkg_hal);
+	g_object_unref (pkg_hal_new);
+	g_object_unref (pkg_kernel);
+	g_object_unref (pkg_dave);
+}
+
+static void
+zif_store_remote_category_newest_func (void)
+{
+	gboolean ret;
+	GError *error = NULL;
+	GHashTable *hash;
+	GPtrArray *array;
+	ZifPackage *pkg;
+
+	/* two versions of the same package */
+	array = zif_package_array_new ();
+	pkg = zif_package_new ();
+	ret = zif_package_set_id (pkg, "hal;0.1-1.fc13;i386;fedora", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_ptr_array_add (array, pkg);
+	pkg = zif_package_new ();
+	ret = zif_package_set_id (pkg, "hal;0.2-1.fc13;i386;fedora", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_ptr_array_add (array, pkg);
+	pkg = zif_package_new ();
+	ret = zif_package_set_id (pkg, "dave;1.0-1.fc13;i386;fedora", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_ptr_array_add (array, pkg);
+
+	/* the names have to be valid after the packages are freed */
+	hash = zif_store_remote_search_category_newest (array);
+	g_ptr_array_unref (array);
+	g_assert_cmpint (g_hash_table_size (hash), ==, 2);
+	pkg = g_hash_table_lookup (hash, "hal");
+	g_assert (pkg != NULL);
+	g_assert_cmpstr (zif_package_get_id (pkg), ==, "hal;0.2-1.fc13;i386;fedora");
+	pkg = g_hash_table_lookup (hash, "dave");
+	g_assert (pkg != NULL);
+	g_assert (g_hash_table_lookup (hash, "moo") == NULL);
+	g_hash_table_unref (hash);
+}
+
+static void
+zif_store_remote_chunks_func (void)
+{
+	gboolean ret;
+	gchar *comment = NULL;
+	GError *error = NULL;
+	GOutputStream *stream;
+	GPtrArray *chunks;
+	ZifStoreRemoteChunk *chunk;
+
+	/* valid index */
+	chunks = zif_store_remote_chunks_parse ("# primary.xml.gz\n"
+						"2cf24dba5fb0a30e26e83b2ac5b9e29e1b161e5c1fa7425e73043362938b9824 0 5\n"
+						"486ea46224d1bb4fb680f34f7c9ad96a8f24ec88be73ea8e5a6c65260e9cb8a7 5 5\n",
+						&comment, &error);
+	g_assert_no_error (error);
+	g_assert (chunks != NULL);
+	g_assert_cmpstr (comment, ==, "primary.xml.gz");
+	g_assert_cmpint (chunks->len, ==, 2);
+	chunk = g_ptr_array_index (chunks, 1);
+	g_assert_cmpint (chunk->offset, ==, 5);
+	g_assert_cmpint (chunk->length, ==, 5);
+	g_free (comment);
+
+	/* reassemble using the correct data */
+	stream = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+	chunk = g_ptr_array_index (chunks, 0);
+	ret = zif_store_remote_chunks_write (stream, chunk, "hello", NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	chunk = g_ptr_array_index (chunks, 1);
+	ret = zif_store_remote_chunks_write (stream, chunk, "world", NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (stream)), ==, 10);
+
+	/* data does not match the chunk checksum */
+	ret = zif_store_remote_chunks_write (stream, chunk, "w0rld", NULL, &error);
+	g_assert_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED);
+	g_assert (!ret);
+	g_clear_error (&error);
+	g_assert_cmpint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (stream)), ==, 10);
+	g_object_unref (stream);
+	g_ptr_array_unref (chunks);
+
+	/* truncated index */
+	chunks = zif_store_remote_chunks_parse ("# primary.xml.gz\n"
+						"2cf24dba5fb0a30e26e83b2ac5b9e29e1b161e5c1fa7425e73043362938b9824 0 5\n"
+						"486ea46224d1bb4fb680f34f7c9ad96a8f24ec",
+						NULL, &error);
+	g_assert_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED);
+	g_assert (chunks == NULL);
+	g_clear_error (&error);
+
+	/* chunks with a gap */
+	chunks = zif_store_remote_chunks_parse ("2cf24dba5fb0a30e26e83b2ac5b9e29e1b161e5c1fa7425e73043362938b9824 0 5\n"
+						"486ea46224d1bb4fb680f34f7c9ad96a8f24ec88be73ea8e5a6c65260e9cb8a7 6 5\n",
+						NULL, &error);
+	g_assert_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED);
+	g_assert (chunks == NULL);
+	g_clear_error (&error);
+
+	/* empty index */
+	chunks = zif_store_remote_chunks_parse ("# primary.xml.gz\n", NULL, &error);
+	g_assert_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED);
+	g_assert (chunks == NULL);
+	g_clear_error (&error);
+}
+
 static void
 zif_store_remote_func (void)
 {
@@ -4172,6 +5457,257 @@ zif_store_rhn_func (void)
 	g_assert (config == NULL);
 }
 
+typedef struct {
+	gint			 calls;
+	gint			 multicalls;
+} ZifSelfTestRhnHelper;
+
+static void
+zif_self_test_rhn_get_result (const gchar *method, gint id, GValue *value)
+{
+	gchar *tmp;
+	GHashTable *hash;
+	GValueArray *array;
+
+	if (g_strcmp0 (method, "packages.getDetails") == 0) {
+		hash = soup_value_hash_new_with_vals ("package_summary", G_TYPE_STRING, "Test package",
+						      "package_file", G_TYPE_STRING, "test.rpm",
+						      "package_license", G_TYPE_STRING, "GPLv2+",
+						      "package_description", G_TYPE_STRING, "Test",
+						      "package_md5sum", G_TYPE_STRING, "deadbeef",
+						      "package_size", G_TYPE_STRING, "1024",
+						      NULL);
+		g_value_init (value, G_TYPE_HASH_TABLE);
+		g_value_take_boxed (value, hash);
+		return;
+	}
+	array = g_value_array_new (1);
+	if (g_strcmp0 (method, "packages.listFiles") == 0) {
+		tmp = g_strdup_printf ("/usr/bin/test%i", id);
+		hash = soup_value_hash_new_with_vals ("file_path", G_TYPE_STRING, tmp,
+						      NULL);
+	} else {
+		tmp = g_strdup_printf ("test%i", id);
+		hash = soup_value_hash_new_with_vals ("dependency", G_TYPE_STRING, tmp,
+						      "dependency_modifier", G_TYPE_STRING, "",
+						      "dependency_type", G_TYPE_STRING, "provides",
+						      NULL);
+	}
+	soup_value_array_append (array, G_TYPE_HASH_TABLE, hash);
+	g_hash_table_unref (hash);
+	g_free (tmp);
+	g_value_init (value, G_TYPE_VALUE_ARRAY);
+	g_value_take_boxed (value, array);
+}
+
+static void
+zif_self_test_rhn_server_cb (SoupServer *server,
+			     SoupMessage *msg,
+			     const char *path,
+			     GHashTable *query,
+			     SoupClientContext *client,
+			     gpointer user_data)
+{
+	gchar *data;
+	gchar *method = NULL;
+	GHashTable *call;
+	GHashTable *hash;
+	guint i;
+	GValue *method_name;
+	GValue result = { 0, };
+	GValue value = { 0, };
+	GValueArray *array;
+	GValueArray *calls;
+	GValueArray *call_params;
+	GValueArray *params = NULL;
+	GValueArray *wrapper;
+	ZifSelfTestRhnHelper *helper = (ZifSelfTestRhnHelper *) user_data;
+
+	if (!soup_xmlrpc_parse_method_call (msg->request_body->data,
+					    msg->request_body->length,
+					    &method, &params)) {
+		soup_message_set_status (msg, SOUP_STATUS_BAD_REQUEST);
+		return;
+	}
+	soup_message_set_status (msg, SOUP_STATUS_OK);
+
+	if (g_strcmp0 (method, "auth.login") == 0) {
+		soup_xmlrpc_set_response (msg, G_TYPE_STRING, "dave");
+	} else if (g_strcmp0 (method, "channel.software.listLatestPackages") == 0) {
+		array = g_value_array_new (2);
+		for (i = 1; i <= 2; i++) {
+			data = g_strdup_printf ("test%i", i);
+			hash = soup_value_hash_new_with_vals ("package_name", G_TYPE_STRING, data,
+							      "package_epoch", G_TYPE_STRING, "0",
+							      "package_version", G_TYPE_STRING, "0.1",
+							      "package_release", G_TYPE_STRING, "1",
+							      "package_arch_label", G_TYPE_STRING, "noarch",
+							      "package_id", G_TYPE_INT, i,
+							      NULL);
+			soup_value_array_append (array, G_TYPE_HASH_TABLE, hash);
+			g_hash_table_unref (hash);
+			g_free (data);
+		}
+		soup_xmlrpc_set_response (msg, G_TYPE_VALUE_ARRAY, array);
+		g_value_array_free (array);
+	} else if (g_strcmp0 (method, "system.multicall") == 0) {
+		g_atomic_int_inc (&helper->multicalls);
+		calls = g_value_get_boxed (g_value_array_get_nth (params, 0));
+		array = g_value_array_new (calls->n_values);
+		for (i = 0; i < calls->n_values; i++) {
+			call = g_value_get_boxed (g_value_array_get_nth (calls, i));
+			method_name = g_hash_table_lookup (call, "methodName");
+			call_params = g_value_get_boxed (g_hash_table_lookup (call, "params"));
+			zif_self_test_rhn_get_result (g_value_get_string (method_name),
+						      g_value_get_int (g_value_array_get_nth (call_params, 1)),
+						      &value);
+			wrapper = g_value_array_new (1);
+			g_value_array_append (wrapper, &value);
+			soup_value_array_append (array, G_TYPE_VALUE_ARRAY, wrapper);
+			g_value_array_free (wrapper);
+			g_value_unset (&value);
+		}
+		soup_xmlrpc_set_response (msg, G_TYPE_VALUE_ARRAY, array);
+		g_value_array_free (array);
+	} else {
+		g_atomic_int_inc (&helper->calls);
+		zif_self_test_rhn_get_result (method,
+					      g_value_get_int (g_value_array_get_nth (params, 1)),
+					      &result);
+		data = soup_xmlrpc_build_method_response (&result);
+		soup_message_set_response (msg, "text/xml",
+					   SOUP_MEMORY_TAKE,
+					   data, strlen (data));
+		g_value_unset (&result);
+	}
+	g_free (method);
+	g_value_array_free (params);
+}
+
+static void
+zif_store_rhn_multicall_func (void)
+{
+	const gchar *summary;
+	gboolean ret;
+	gchar *cachedir;
+	gchar *filename;
+	gchar *server_uri;
+	GError *error = NULL;
+	GMainContext *context;
+	GMainLoop *loop;
+	GPtrArray *array;
+	GPtrArray *files;
+	GThread *thread;
+	SoupServer *server;
+	ZifConfig *config;
+	ZifPackage *package;
+	ZifSelfTestRhnHelper helper = { 0, 0 };
+	ZifState *state;
+	ZifStore *store;
+
+	/* set this up as dummy */
+	config = zif_config_new ();
+	g_object_add_weak_pointer (G_OBJECT (config), (gpointer *) &config);
+	filename = zif_test_get_data_file ("zif.conf");
+	zif_config_set_filename (config, filename, NULL);
+	g_free (filename);
+	cachedir = g_build_filename (zif_tmpdir, "rhn-cache", NULL);
+	zif_config_set_string (config, "cachedir", cachedir, NULL);
+
+	/* run a stand-in XML-RPC server in a thread */
+	context = g_main_context_new ();
+	server = soup_server_new (SOUP_SERVER_PORT, 0,
+				  SOUP_SERVER_ASYNC_CONTEXT, context,
+				  NULL);
+	g_assert (server != NULL);
+	soup_server_add_handler (server, "/rpc/api",
+				 zif_self_test_rhn_server_cb,
+				 &helper, NULL);
+	soup_server_run_async (server);
+	loop = g_main_loop_new (context, FALSE);
+	thread = g_thread_new ("rhn-server", (GThreadFunc) g_main_loop_run, loop);
+	server_uri = g_strdup_printf ("http://127.0.0.1:%i/rpc/api",
+				      soup_server_get_port (server));
+
+	state = zif_state_new ();
+	store = zif_store_rhn_new ();
+	zif_store_rhn_set_server (ZIF_STORE_RHN (store), server_uri);
+	zif_store_rhn_set_channel (ZIF_STORE_RHN (store), "test-channel");
+	zif_store_rhn_set_precache (ZIF_STORE_RHN (store),
+				    ZIF_PACKAGE_RHN_PRECACHE_GET_DETAILS |
+				    ZIF_PACKAGE_RHN_PRECACHE_LIST_FILES |
+				    ZIF_PACKAGE_RHN_PRECACHE_LIST_DEPS);
+	ret = zif_store_rhn_login (ZIF_STORE_RHN (store), "test", "test", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* all the data is fetched in one request */
+	ret = zif_store_load (store, state, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (zif_store_get_size (store), ==, 2);
+	g_assert_cmpint (helper.multicalls, ==, 1);
+	g_assert_cmpint (helper.calls, ==, 0);
+
+	/* nothing else is requested */
+	zif_state_reset (state);
+	array = zif_store_get_packages (store, state, &error);
+	g_assert_no_error (error);
+	package = g_ptr_array_index (array, 0);
+	zif_state_reset (state);
+	summary = zif_package_get_summary (package, state, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (summary, ==, "Test package");
+	zif_state_reset (state);
+	files = zif_package_get_files (package, state, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (files->len, ==, 1);
+	g_ptr_array_unref (files);
+	g_ptr_array_unref (array);
+	g_assert_cmpint (helper.calls, ==, 0);
+	g_object_unref (store);
+
+	/* a new store uses the cache */
+	store = zif_store_rhn_new ();
+	zif_store_rhn_set_server (ZIF_STORE_RHN (store), server_uri);
+	zif_store_rhn_set_channel (ZIF_STORE_RHN (store), "test-channel");
+	zif_store_rhn_set_precache (ZIF_STORE_RHN (store),
+				    ZIF_PACKAGE_RHN_PRECACHE_GET_DETAILS);
+	ret = zif_store_rhn_login (ZIF_STORE_RHN (store), "test", "test", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	zif_state_reset (state);
+	ret = zif_store_load (store, state, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (helper.multicalls, ==, 1);
+
+	/* not precached this time, but still in the cache */
+	zif_state_reset (state);
+	package = zif_store_find_package (store, "test2;0.1-1;noarch;rhn", state, &error);
+	g_assert_no_error (error);
+	zif_state_reset (state);
+	files = zif_package_get_files (package, state, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (g_ptr_array_index (files, 0), ==, "/usr/bin/test2");
+	g_ptr_array_unref (files);
+	g_object_unref (package);
+	g_assert_cmpint (helper.calls, ==, 0);
+
+	g_main_loop_quit (loop);
+	g_thread_join (thread);
+	g_main_loop_unref (loop);
+	soup_server_quit (server);
+	g_object_unref (server);
+	g_main_context_unref (context);
+	g_object_unref (store);
+	g_object_unref (state);
+	g_object_unref (config);
+	g_assert (config == NULL);
+	g_free (server_uri);
+	g_free (cachedir);
+}
+
 static void
 zif_string_func (void)
 {
@@ -4207,6 +5743,59 @@ zif_update_info_func (void)
 	g_object_unref (update_info);
 }
 
+static gboolean
+zif_utils_decompress_cb (const guchar *data,
+			 gsize len,
+			 gpointer user_data,
+			 GError **error)
+{
+	GString *str = (GString *) user_data;
+	g_string_append_len (str, (const gchar *) data, len);
+	return TRUE;
+}
+
+static void
+zif_utils_matcher_func (void)
+{
+	ZifStrMatcher *matcher;
+	const gchar *search[] = { "kernel-*", "^gnome-(power|session)", "hal", NULL };
+	const gchar *search_equal[] = { "hal", NULL };
+
+	/* glob */
+	matcher = zif_str_matcher_new (ZIF_STR_MATCHER_KIND_GLOB, (gchar **) search);
+	g_assert_cmpint (zif_str_matcher_get_size (matcher), ==, 3);
+	g_assert_cmpstr (zif_str_matcher_get_prefix (matcher, 0), ==, "kernel-");
+	g_assert (zif_str_matcher_match (matcher, "kernel-devel"));
+	g_assert (zif_str_matcher_match (matcher, "hal"));
+	g_assert (!zif_str_matcher_match (matcher, "kernel"));
+	g_assert (!zif_str_matcher_match (matcher, "halt"));
+	zif_str_matcher_free (matcher);
+
+	/* regex */
+	matcher = zif_str_matcher_new (ZIF_STR_MATCHER_KIND_REGEX, (gchar **) search);
+	g_assert_cmpstr (zif_str_matcher_get_prefix (matcher, 0), ==, NULL);
+	g_assert_cmpstr (zif_str_matcher_get_prefix (matcher, 1), ==, NULL);
+	g_assert (zif_str_matcher_match_term (matcher, 1, "gnome-power-manager"));
+	g_assert (!zif_str_matcher_match_term (matcher, 1, "gnome-shell"));
+	g_assert (zif_str_matcher_match_term (matcher, 2, "halt"));
+	zif_str_matcher_free (matcher);
+
+	/* regex prefix where the last literal is optional */
+	search_equal[0] = "^gnome-x?";
+	matcher = zif_str_matcher_new (ZIF_STR_MATCHER_KIND_REGEX, (gchar **) search_equal);
+	g_assert_cmpstr (zif_str_matcher_get_prefix (matcher, 0), ==, "gnome-");
+	g_assert (zif_str_matcher_match (matcher, "gnome-shell"));
+	zif_str_matcher_free (matcher);
+
+	/* equal */
+	search_equal[0] = "hal";
+	matcher = zif_str_matcher_new (ZIF_STR_MATCHER_KIND_EQUAL, (gchar **) search_equal);
+	g_assert_cmpstr (zif_str_matcher_get_prefix (matcher, 0), ==, "hal");
+	g_assert (zif_str_matcher_match (matcher, "hal"));
+	g_assert (!zif_str_matcher_match (matcher, "halt"));
+	zif_str_matcher_free (matcher);
+}
+
 static void
 zif_utils_func (void)
 {
@@ -4217,6 +5806,7 @@ zif_utils_func (void)
 	const gchar *d;
 	const guint iterations = 100000;
 	gboolean ret;
+	gchar *checksum;
 	gchar *evr;
 	gchar *filename;
 	gchar *filename_tmp;
@@ -4228,10 +5818,13 @@ zif_utils_func (void)
 	gdouble time_iter;
 	gdouble time_split;
 	GError *error = NULL;
+	gboolean xattr_supported;
+	FILE *fp;
 	GString *str;
 	GTimer *timer;
 	guint i;
 	guint se;
+	struct utimbuf utime_buf;
 	ZifState *state;
 
 	state = zif_state_new ();
@@ -4344,6 +5937,35 @@ zif_utils_func (void)
 	g_free (filename);
 	g_free (filename_tmp);
 
+	/* a missing input must not leave an empty output behind */
+	filename_tmp = g_build_filename (zif_tmpdir, "missing.txt", NULL);
+	g_unlink (filename_tmp);
+	ret = zif_file_decompress ("/dev/null/missing.txt.gz", filename_tmp, state, &error);
+	g_assert_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_READ);
+	g_assert (!ret);
+	g_assert (!g_file_test (filename_tmp, G_FILE_TEST_EXISTS));
+	g_clear_error (&error);
+
+	/* neither must an unsupported format */
+	ret = zif_file_decompress ("/dev/null/unsupported.txt.zip", filename_tmp, state, &error);
+	g_assert_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED);
+	g_assert (!ret);
+	g_assert (!g_file_test (filename_tmp, G_FILE_TEST_EXISTS));
+	g_clear_error (&error);
+	g_free (filename_tmp);
+
+	/* stream without writing an uncompressed copy */
+	filename = zif_test_get_data_file ("compress.txt.xz");
+	str = g_string_new ("");
+	ret = zif_file_decompress_full (filename, NULL,
+					zif_utils_decompress_cb, str,
+					state, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpstr (str->str, ==, "this is a test\n");
+	g_string_free (str, TRUE);
+	g_free (filename);
+
 	g_assert_cmpint (zif_time_string_to_seconds (""), ==, 0);
 	g_assert_cmpint (zif_time_string_to_seconds ("10"), ==, 0);
 	g_assert_cmpint (zif_time_string_to_seconds ("10f"), ==, 0);
@@ -4455,6 +6077,66 @@ zif_utils_func (void)
 	g_assert_cmpint (str->len, ==, strlen (str->str));
 
 	g_string_free (str, TRUE);
+
+	/* get the checksum of a file */
+	filename_tmp = g_build_filename (zif_tmpdir, "checksum.txt", NULL);
+	ret = g_file_set_contents (filename_tmp, "hello", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	checksum = zif_file_get_checksum (filename_tmp, G_CHECKSUM_SHA256, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (checksum, ==, "2cf24dba5fb0a30e26e83b2ac5b9e29e1b161e5c1fa7425e73043362938b9824");
+	g_free (checksum);
+
+	/* the cache is used when the file is unchanged, which we can
+	 * only check if the filesystem supports extended attributes */
+	xattr_supported = (setxattr (filename_tmp, "user.zif.test", "1", 1, 0) == 0);
+	zif_file_set_cached_checksum (filename_tmp, G_CHECKSUM_SHA256, "dead");
+	checksum = zif_file_get_checksum (filename_tmp, G_CHECKSUM_SHA256, NULL, &error);
+	g_assert_no_error (error);
+	if (xattr_supported)
+		g_assert_cmpstr (checksum, ==, "dead");
+	else
+		g_assert_cmpstr (checksum, ==, "2cf24dba5fb0a30e26e83b2ac5b9e29e1b161e5c1fa7425e73043362938b9824");
+	g_free (checksum);
+
+	/* changing the file in place with the same size invalidates the
+	 * cache, and the mtime is set explicitly in case the write lands
+	 * within the timestamp granularity of the filesystem */
+	fp = fopen (filename_tmp, "r+");
+	g_assert (fp != NULL);
+	g_assert_cmpint (fputs ("j", fp), >=, 0);
+	g_assert_cmpint (fclose (fp), ==, 0);
+	utime_buf.actime = 1;
+	utime_buf.modtime = 1;
+	g_assert_cmpint (utime (filename_tmp, &utime_buf), ==, 0);
+	checksum = zif_file_get_checksum (filename_tmp, G_CHECKSUM_SHA256, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (checksum, ==, "187c9bceeb919e1b3e6d20fa50ecabf7d9d50b5343e8f9a3d912abb13929102e");
+	g_free (checksum);
+
+	/* the new checksum was cached */
+	if (xattr_supported) {
+		zif_file_set_cached_checksum (filename_tmp, G_CHECKSUM_SHA256, "beef");
+		checksum = zif_file_get_checksum (filename_tmp, G_CHECKSUM_SHA256, NULL, &error);
+		g_assert_no_error (error);
+		g_assert_cmpstr (checksum, ==, "beef");
+		g_free (checksum);
+	}
+
+	/* appending to the file invalidates the cache even if the mtime
+	 * is unchanged, as the size is part of the key */
+	fp = fopen (filename_tmp, "a");
+	g_assert (fp != NULL);
+	g_assert_cmpint (fputs (" world", fp), >=, 0);
+	g_assert_cmpint (fclose (fp), ==, 0);
+	g_assert_cmpint (utime (filename_tmp, &utime_buf), ==, 0);
+	checksum = zif_file_get_checksum (filename_tmp, G_CHECKSUM_SHA256, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (checksum, ==, "cf1b2b8bccc960a8ffd092ca60843c35e8be79b42ab083f55c9e7375d46f2151");
+	g_free (checksum);
+	g_unlink (filename_tmp);
+	g_free (filename_tmp);
 }
 
 static void
@@ -4692,6 +6374,7 @@ main (int argc, char **argv)
 
 	/* tests go here */
 	g_test_add_func ("/zif/utils", zif_utils_func);
+	g_test_add_func ("/zif/utils[matcher]", zif_utils_matcher_func);
 	g_test_add_func ("/zif/state", zif_state_func);
 	g_test_add_func ("/zif/state[child]", zif_state_child_func);
 	g_test_add_func ("/zif/state[parent-1-step]", zif_state_parent_one_step_proxy_func);
@@ -4702,18 +6385,21 @@ main (int argc, char **argv)
 	g_test_add_func ("/zif/state[speed]", zif_state_speed_func);
 	g_test_add_func ("/zif/state[locking]", zif_state_locking_func);
 	g_test_add_func ("/zif/state[finished]", zif_state_finished_func);
+	g_test_add_func ("/zif/state[trace]", zif_state_trace_func);
 	g_test_add_func ("/zif/changeset", zif_changeset_func);
 	g_test_add_func ("/zif/config", zif_config_func);
 	g_test_add_func ("/zif/config[changed]", zif_config_changed_func);
 	g_test_add_func ("/zif/db", zif_db_func);
 	g_test_add_func ("/zif/depend", zif_depend_func);
 	g_test_add_func ("/zif/download", zif_download_func);
+	g_test_add_func ("/zif/file-list", zif_file_list_func);
 	g_test_add_func ("/zif/groups", zif_groups_func);
 	g_test_add_func ("/zif/history", zif_history_func);
 	g_test_add_func ("/zif/legal", zif_legal_func);
 	g_test_add_func ("/zif/lock", zif_lock_func);
 	g_test_add_func ("/zif/lock[threads]", zif_lock_threads_func);
 	g_test_add_func ("/zif/manifest", zif_manifest_func);
+	g_test_add_func ("/zif/memory", zif_memory_func);
 	g_test_add_func ("/zif/md", zif_md_func);
 	g_test_add_func ("/zif/md-comps", zif_md_comps_func);
 	g_test_add_func ("/zif/md-delta", zif_md_delta_func);
@@ -4727,17 +6413,26 @@ main (int argc, char **argv)
 	g_test_add_func ("/zif/md-updateinfo", zif_md_updateinfo_func);
 	g_test_add_func ("/zif/monitor", zif_monitor_func);
 	g_test_add_func ("/zif/package-local", zif_package_local_func);
+	g_test_add_func ("/zif/package-local-files", zif_package_local_files_func);
 	g_test_add_func ("/zif/package-remote", zif_package_remote_func);
 	g_test_add_func ("/zif/package-meta", zif_package_meta_func);
 	g_test_add_func ("/zif/package", zif_package_func);
 	g_test_add_func ("/zif/package-array", zif_package_array_func);
 	g_test_add_func ("/zif/release", zif_release_func);
 	g_test_add_func ("/zif/repos", zif_repos_func);
+	g_test_add_func ("/zif/server", zif_server_func);
 	g_test_add_func ("/zif/store-local", zif_store_local_func);
+	g_test_add_func ("/zif/store-local-threads", zif_store_local_threads_func);
 	g_test_add_func ("/zif/store-meta", zif_store_meta_func);
+	g_test_add_func ("/zif/store-overlay", zif_store_overlay_func);
+	g_test_add_func ("/zif/store-array[parallel]", zif_store_array_parallel_func);
+	g_test_add_func ("/zif/store-array[parallel-remote]", zif_store_array_parallel_remote_func);
 	g_test_add_func ("/zif/store-remote", zif_store_remote_func);
+	g_test_add_func ("/zif/store-remote[chunks]", zif_store_remote_chunks_func);
+	g_test_add_func ("/zif/store-remote[category-newest]", zif_store_remote_category_newest_func);
 	g_test_add_func ("/zif/store-directory", zif_store_directory_func);
 	g_test_add_func ("/zif/store-rhn", zif_store_rhn_func);
+	g_test_add_func ("/zif/store-rhn-multicall", zif_store_rhn_multicall_func);
 	g_test_add_func ("/zif/string", zif_string_func);
 	g_test_add_func ("/zif/transaction", zif_transaction_func);
 	g_test_add_func ("/zif/update-info", zif_update_info_func);
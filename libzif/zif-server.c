@@ -0,0 +1,733 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2013 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * SECTION:zif-server
+ * @short_description: Share loaded stores with other processes
+ *
+ * #ZifServer listens on a local UNIX socket and answers simple read-only
+ * queries such as resolve, what-provides, search and get-updates using
+ * stores that are only loaded once for all clients.
+ *
+ * The protocol is line based: a client sends a single request line of
+ * tab separated values, and the server replies with either
+ * "ok<tab>count" followed by that number of "package_id<tab>summary"
+ * lines, or "error<tab>code<tab>message".
+ *
+ * Requests are not answered while another process holds the rpmdb or
+ * metadata locks, as the data may be changing. In this case the client
+ * gets %ZIF_SERVER_ERROR_BUSY and should load the stores itself.
+ *
+ * See also: #ZifClient
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <sys/stat.h>
+#include <gio/gunixsocketaddress.h>
+
+#include "zif-depend.h"
+#include "zif-lock.h"
+#include "zif-package.h"
+#include "zif-server.h"
+#include "zif-state.h"
+#include "zif-store-array.h"
+
+#define ZIF_SERVER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_SERVER, ZifServerPrivate))
+
+/* close connections from clients that stop responding */
+#define ZIF_SERVER_SOCKET_TIMEOUT	10 /* seconds */
+
+struct _ZifServerPrivate
+{
+	gchar			*socket_path;
+	GCancellable		*cancellable;
+	GPtrArray		*store_array;
+	GPtrArray		*store_array_all;
+	GSocketService		*service;
+	guint			 requests;
+	ZifLock			*lock;
+	ZifStore		*store_local;
+};
+
+typedef struct {
+	ZifServer		*server;
+	GSocketConnection	*connection;
+	GDataInputStream	*input;
+	gchar			*request;
+	GTimer			*timer;
+} ZifServerRequest;
+
+G_DEFINE_TYPE (ZifServer, zif_server, G_TYPE_OBJECT)
+
+/**
+ * zif_server_error_quark:
+ *
+ * Return value: An error quark.
+ *
+ * Since: 0.3.7
+ **/
+GQuark
+zif_server_error_quark (void)
+{
+	static GQuark quark = 0;
+	if (!quark)
+		quark = g_quark_from_static_string ("zif_server_error");
+	return quark;
+}
+
+/**
+ * zif_server_error_to_string:
+ **/
+static const gchar *
+zif_server_error_to_string (ZifServerError error_enum)
+{
+	if (error_enum == ZIF_SERVER_ERROR_BUSY)
+		return "busy";
+	if (error_enum == ZIF_SERVER_ERROR_INVALID)
+		return "invalid";
+	return "failed";
+}
+
+/**
+ * zif_server_append_error:
+ **/
+static void
+zif_server_append_error (GString *reply,
+			 ZifServerError error_enum,
+			 const gchar *message)
+{
+	gchar *tmp;
+
+	/* the message has to fit on one line */
+	tmp = g_strdup (message);
+	g_strdelimit (tmp, "\t\n", ' ');
+	g_string_append_printf (reply, "error\t%s\t%s\n",
+				zif_server_error_to_string (error_enum),
+				tmp);
+	g_free (tmp);
+}
+
+/**
+ * zif_server_append_packages:
+ **/
+static void
+zif_server_append_packages (GString *reply, GPtrArray *array)
+{
+	const gchar *summary;
+	gchar *tmp;
+	guint i;
+	ZifPackage *package;
+	ZifState *state;
+
+	state = zif_state_new ();
+	g_string_append_printf (reply, "ok\t%i\n", array->len);
+	for (i = 0; i < array->len; i++) {
+		package = g_ptr_array_index (array, i);
+		zif_state_reset (state);
+		summary = zif_package_get_summary (package, state, NULL);
+		tmp = g_strdup (summary != NULL ? summary : "");
+		g_strdelimit (tmp, "\t\n", ' ');
+		g_string_append_printf (reply, "%s\t%s\n",
+					zif_package_get_id (package),
+					tmp);
+		g_free (tmp);
+	}
+	g_object_unref (state);
+}
+
+/**
+ * zif_server_query:
+ **/
+static GPtrArray *
+zif_server_query (ZifServer *server,
+		  const gchar *command,
+		  gchar **args,
+		  ZifState *state,
+		  GError **error)
+{
+	gboolean ret;
+	GPtrArray *array = NULL;
+	GPtrArray *depends = NULL;
+	guint i;
+	ZifDepend *depend;
+	ZifStoreResolveFlags flags;
+
+	/* resolve, where the first argument is the flags */
+	if (g_strcmp0 (command, "resolve") == 0) {
+		if (args[0] == NULL) {
+			g_set_error_literal (error,
+					     ZIF_SERVER_ERROR,
+					     ZIF_SERVER_ERROR_INVALID,
+					     "no resolve flags specified");
+			goto out;
+		}
+		flags = g_ascii_strtoull (args[0], NULL, 10);
+		array = zif_store_array_resolve_full (server->priv->store_array_all,
+						      &args[1],
+						      flags,
+						      state,
+						      error);
+		goto out;
+	}
+
+	/* what-provides, where each argument is a depend description */
+	if (g_strcmp0 (command, "what-provides") == 0) {
+		depends = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+		for (i = 0; args[i] != NULL; i++) {
+			depend = zif_depend_new ();
+			g_ptr_array_add (depends, depend);
+			ret = zif_depend_parse_description (depend, args[i], error);
+			if (!ret)
+				goto out;
+		}
+		array = zif_store_array_what_provides (server->priv->store_array_all,
+						       depends,
+						       state,
+						       error);
+		goto out;
+	}
+
+	/* search */
+	if (g_strcmp0 (command, "search-name") == 0) {
+		array = zif_store_array_search_name (server->priv->store_array_all,
+						     args, state, error);
+		goto out;
+	}
+	if (g_strcmp0 (command, "search-details") == 0) {
+		array = zif_store_array_search_details (server->priv->store_array_all,
+							args, state, error);
+		goto out;
+	}
+	if (g_strcmp0 (command, "search-file") == 0) {
+		array = zif_store_array_search_file (server->priv->store_array_all,
+						     args, state, error);
+		goto out;
+	}
+
+	/* updates, where the remote stores are checked against the local one */
+	if (g_strcmp0 (command, "get-updates") == 0) {
+		if (server->priv->store_local == NULL) {
+			g_set_error_literal (error,
+					     ZIF_SERVER_ERROR,
+					     ZIF_SERVER_ERROR_INVALID,
+					     "no local store");
+			goto out;
+		}
+		array = zif_store_array_get_updates (server->priv->store_array,
+						     server->priv->store_local,
+						     state,
+						     error);
+		goto out;
+	}
+
+	/* not recognised */
+	g_set_error (error,
+		     ZIF_SERVER_ERROR,
+		     ZIF_SERVER_ERROR_INVALID,
+		     "command '%s' not supported",
+		     command);
+out:
+	if (depends != NULL)
+		g_ptr_array_unref (depends);
+	return array;
+}
+
+/**
+ * zif_server_handle_request:
+ **/
+static void
+zif_server_handle_request (ZifServer *server,
+			   const gchar *request,
+			   GString *reply)
+{
+	gchar **split = NULL;
+	GCancellable *cancellable;
+	GError *error = NULL;
+	GPtrArray *array = NULL;
+	guint lock_metadata = 0;
+	guint lock_rpmdb = 0;
+	ZifState *state = NULL;
+
+	split = g_strsplit (request, "\t", -1);
+	if (split[0] == NULL) {
+		zif_server_append_error (reply,
+					 ZIF_SERVER_ERROR_INVALID,
+					 "no command");
+		goto out;
+	}
+
+	/* another process may be changing the data we're serving */
+	lock_rpmdb = zif_lock_take (server->priv->lock,
+				    ZIF_LOCK_TYPE_RPMDB,
+				    ZIF_LOCK_MODE_PROCESS,
+				    &error);
+	if (lock_rpmdb == 0) {
+		zif_server_append_error (reply,
+					 ZIF_SERVER_ERROR_BUSY,
+					 error->message);
+		goto out;
+	}
+	lock_metadata = zif_lock_take (server->priv->lock,
+				       ZIF_LOCK_TYPE_METADATA,
+				       ZIF_LOCK_MODE_PROCESS,
+				       &error);
+	if (lock_metadata == 0) {
+		zif_server_append_error (reply,
+					 ZIF_SERVER_ERROR_BUSY,
+					 error->message);
+		goto out;
+	}
+
+	/* run the query */
+	state = zif_state_new ();
+	cancellable = g_cancellable_new ();
+	zif_state_set_cancellable (state, cancellable);
+	g_object_unref (cancellable);
+	array = zif_server_query (server, split[0], &split[1], state, &error);
+	if (array == NULL) {
+		zif_server_append_error (reply,
+					 ZIF_SERVER_ERROR_FAILED,
+					 error->message);
+		goto out;
+	}
+	zif_server_append_packages (reply, array);
+out:
+	if (lock_metadata != 0)
+		zif_lock_release_noerror (server->priv->lock, lock_metadata);
+	if (lock_rpmdb != 0)
+		zif_lock_release_noerror (server->priv->lock, lock_rpmdb);
+	if (error != NULL)
+		g_error_free (error);
+	if (array != NULL)
+		g_ptr_array_unref (array);
+	if (state != NULL)
+		g_object_unref (state);
+	g_strfreev (split);
+}
+
+/**
+ * zif_server_request_free:
+ **/
+static void
+zif_server_request_free (ZifServerRequest *req)
+{
+	g_io_stream_close (G_IO_STREAM (req->connection), NULL, NULL);
+	g_object_unref (req->connection);
+	g_object_unref (req->input);
+	g_object_unref (req->server);
+	g_timer_destroy (req->timer);
+	g_free (req->request);
+	g_free (req);
+}
+
+/**
+ * zif_server_write_cb:
+ **/
+static void
+zif_server_write_cb (GObject *source_object,
+		     GAsyncResult *res,
+		     gpointer user_data)
+{
+	GError *error = NULL;
+	ZifServerRequest *req = (ZifServerRequest *) user_data;
+
+	if (g_output_stream_splice_finish (G_OUTPUT_STREAM (source_object), res, &error) < 0) {
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_warning ("failed to write reply: %s", error->message);
+		g_error_free (error);
+		goto out;
+	}
+	g_debug ("answered '%s' in %.1fms",
+		 req->request, g_timer_elapsed (req->timer, NULL) * 1000);
+out:
+	zif_server_request_free (req);
+}
+
+/**
+ * zif_server_read_cb:
+ *
+ * This is run in the main thread, as none of the stores are threadsafe.
+ **/
+static void
+zif_server_read_cb (GObject *source_object,
+		    GAsyncResult *res,
+		    gpointer user_data)
+{
+	GError *error = NULL;
+	GInputStream *reply_stream;
+	GString *reply;
+	ZifServerRequest *req = (ZifServerRequest *) user_data;
+
+	/* get the single request line */
+	req->request = g_data_input_stream_read_line_finish (req->input, res, NULL, &error);
+	if (req->request == NULL) {
+		if (error != NULL) {
+			if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+				g_warning ("failed to read request: %s", error->message);
+			g_error_free (error);
+		}
+		zif_server_request_free (req);
+		return;
+	}
+
+	/* get the reply */
+	reply = g_string_new ("");
+	zif_server_handle_request (req->server, req->request, reply);
+	req->server->priv->requests++;
+
+	/* send it back without waiting for the client to read it */
+	reply_stream = g_memory_input_stream_new_from_data (reply->str,
+							    reply->len,
+							    g_free);
+	g_string_free (reply, FALSE);
+	g_output_stream_splice_async (g_io_stream_get_output_stream (G_IO_STREAM (req->connection)),
+				      reply_stream,
+				      G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE,
+				      G_PRIORITY_DEFAULT,
+				      req->server->priv->cancellable,
+				      zif_server_write_cb,
+				      req);
+	g_object_unref (reply_stream);
+}
+
+/**
+ * zif_server_incoming_cb:
+ *
+ * The request is read asynchronously so that a slow or idle client does
+ * not stop the others being answered.
+ **/
+static gboolean
+zif_server_incoming_cb (GSocketService *service,
+			GSocketConnection *connection,
+			GObject *source_object,
+			ZifServer *server)
+{
+	ZifServerRequest *req;
+
+	g_socket_set_timeout (g_socket_connection_get_socket (connection),
+			      ZIF_SERVER_SOCKET_TIMEOUT);
+	req = g_new0 (ZifServerRequest, 1);
+	req->server = g_object_ref (server);
+	req->connection = g_object_ref (connection);
+	req->input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (connection)));
+	req->timer = g_timer_new ();
+	g_data_input_stream_read_line_async (req->input,
+					     G_PRIORITY_DEFAULT,
+					     server->priv->cancellable,
+					     zif_server_read_cb,
+					     req);
+	return TRUE;
+}
+
+/**
+ * zif_server_remove_stale_socket:
+ *
+ * Removes the socket left behind by a previous instance, but only if
+ * nothing is listening on it any more.
+ **/
+static gboolean
+zif_server_remove_stale_socket (ZifServer *server, GError **error)
+{
+	gboolean ret = TRUE;
+	GSocketAddress *address = NULL;
+	GSocketClient *socket_client = NULL;
+	GSocketConnection *connection = NULL;
+	struct stat buf;
+
+	/* nothing there */
+	if (g_lstat (server->priv->socket_path, &buf) != 0)
+		goto out;
+
+	/* do not remove something that is not ours */
+	if (!S_ISSOCK (buf.st_mode)) {
+		g_set_error (error,
+			     ZIF_SERVER_ERROR,
+			     ZIF_SERVER_ERROR_FAILED,
+			     "%s exists and is not a socket",
+			     server->priv->socket_path);
+		ret = FALSE;
+		goto out;
+	}
+
+	/* another server is still listening */
+	socket_client = g_socket_client_new ();
+	address = g_unix_socket_address_new (server->priv->socket_path);
+	connection = g_socket_client_connect (socket_client,
+					      G_SOCKET_CONNECTABLE (address),
+					      NULL,
+					      NULL);
+	if (connection != NULL) {
+		g_set_error (error,
+			     ZIF_SERVER_ERROR,
+			     ZIF_SERVER_ERROR_FAILED,
+			     "already running on %s",
+			     server->priv->socket_path);
+		ret = FALSE;
+		goto out;
+	}
+
+	/* stale */
+	g_debug ("removing stale socket %s", server->priv->socket_path);
+	g_unlink (server->priv->socket_path);
+out:
+	if (connection != NULL) {
+		g_io_stream_close (G_IO_STREAM (connection), NULL, NULL);
+		g_object_unref (connection);
+	}
+	if (address != NULL)
+		g_object_unref (address);
+	if (socket_client != NULL)
+		g_object_unref (socket_client);
+	return ret;
+}
+
+/**
+ * zif_server_set_socket_path:
+ * @server: A #ZifServer
+ * @socket_path: A filename, e.g. "/var/run/zif-server.socket"
+ *
+ * Sets the UNIX socket the server should listen on.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_server_set_socket_path (ZifServer *server, const gchar *socket_path)
+{
+	g_return_if_fail (ZIF_IS_SERVER (server));
+	g_return_if_fail (server->priv->service == NULL);
+	g_free (server->priv->socket_path);
+	server->priv->socket_path = g_strdup (socket_path);
+}
+
+/**
+ * zif_server_set_stores:
+ * @server: A #ZifServer
+ * @store_local: The #ZifStoreLocal, or %NULL
+ * @store_array: (element-type ZifStore): The remote stores to use
+ *
+ * Sets the stores that are used to answer client queries. The stores
+ * are kept loaded for the lifetime of the server.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_server_set_stores (ZifServer *server,
+		       ZifStore *store_local,
+		       GPtrArray *store_array)
+{
+	g_return_if_fail (ZIF_IS_SERVER (server));
+	g_return_if_fail (store_array != NULL);
+
+	/* remote stores */
+	g_ptr_array_set_size (server->priv->store_array, 0);
+	zif_store_array_add_stores (server->priv->store_array, store_array);
+
+	/* local store */
+	if (server->priv->store_local != NULL)
+		g_object_unref (server->priv->store_local);
+	server->priv->store_local = NULL;
+	if (store_local != NULL)
+		server->priv->store_local = g_object_ref (store_local);
+
+	/* local and remote stores for resolving */
+	g_ptr_array_set_size (server->priv->store_array_all, 0);
+	if (store_local != NULL)
+		zif_store_array_add_store (server->priv->store_array_all, store_local);
+	zif_store_array_add_stores (server->priv->store_array_all, store_array);
+}
+
+/**
+ * zif_server_start:
+ * @server: A #ZifServer
+ * @error: A #GError, or %NULL
+ *
+ * Starts listening for client connections. Requests are answered from
+ * the default main context, so the caller needs to run a main loop.
+ *
+ * Return value: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_server_start (ZifServer *server, GError **error)
+{
+	gboolean ret;
+	GError *error_local = NULL;
+	GSocketAddress *address = NULL;
+
+	g_return_val_if_fail (ZIF_IS_SERVER (server), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* already started */
+	if (server->priv->service != NULL) {
+		g_set_error_literal (error,
+				     ZIF_SERVER_ERROR,
+				     ZIF_SERVER_ERROR_FAILED,
+				     "already started");
+		ret = FALSE;
+		goto out;
+	}
+
+	/* remove any stale socket from a previous instance */
+	ret = zif_server_remove_stale_socket (server, error);
+	if (!ret)
+		goto out;
+
+	/* listen */
+	server->priv->service = g_socket_service_new ();
+	address = g_unix_socket_address_new (server->priv->socket_path);
+	ret = g_socket_listener_add_address (G_SOCKET_LISTENER (server->priv->service),
+					     address,
+					     G_SOCKET_TYPE_STREAM,
+					     G_SOCKET_PROTOCOL_DEFAULT,
+					     NULL,
+					     NULL,
+					     &error_local);
+	if (!ret) {
+		g_set_error (error,
+			     ZIF_SERVER_ERROR,
+			     ZIF_SERVER_ERROR_FAILED,
+			     "failed to listen on %s: %s",
+			     server->priv->socket_path,
+			     error_local->message);
+		g_error_free (error_local);
+		g_object_unref (server->priv->service);
+		server->priv->service = NULL;
+		goto out;
+	}
+	server->priv->cancellable = g_cancellable_new ();
+	g_signal_connect (server->priv->service, "incoming",
+			  G_CALLBACK (zif_server_incoming_cb), server);
+	g_socket_service_start (server->priv->service);
+	g_debug ("listening on %s", server->priv->socket_path);
+out:
+	if (address != NULL)
+		g_object_unref (address);
+	return ret;
+}
+
+/**
+ * zif_server_stop:
+ * @server: A #ZifServer
+ *
+ * Stops listening for client connections.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_server_stop (ZifServer *server)
+{
+	g_return_if_fail (ZIF_IS_SERVER (server));
+
+	if (server->priv->service == NULL)
+		return;
+	g_cancellable_cancel (server->priv->cancellable);
+	g_object_unref (server->priv->cancellable);
+	server->priv->cancellable = NULL;
+	g_socket_service_stop (server->priv->service);
+	g_socket_listener_close (G_SOCKET_LISTENER (server->priv->service));
+	g_object_unref (server->priv->service);
+	server->priv->service = NULL;
+	g_unlink (server->priv->socket_path);
+}
+
+/**
+ * zif_server_get_requests:
+ * @server: A #ZifServer
+ *
+ * Gets the number of requests that have been answered.
+ *
+ * Return value: the number of requests
+ *
+ * Since: 0.3.7
+ **/
+guint
+zif_server_get_requests (ZifServer *server)
+{
+	g_return_val_if_fail (ZIF_IS_SERVER (server), 0);
+	return server->priv->requests;
+}
+
+/**
+ * zif_server_finalize:
+ **/
+static void
+zif_server_finalize (GObject *object)
+{
+	ZifServer *server;
+	g_return_if_fail (ZIF_IS_SERVER (object));
+	server = ZIF_SERVER (object);
+
+	zif_server_stop (server);
+	g_free (server->priv->socket_path);
+	g_ptr_array_unref (server->priv->store_array);
+	g_ptr_array_unref (server->priv->store_array_all);
+	if (server->priv->store_local != NULL)
+		g_object_unref (server->priv->store_local);
+	g_object_unref (server->priv->lock);
+
+	G_OBJECT_CLASS (zif_server_parent_class)->finalize (object);
+}
+
+/**
+ * zif_server_class_init:
+ **/
+static void
+zif_server_class_init (ZifServerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = zif_server_finalize;
+	g_type_class_add_private (klass, sizeof (ZifServerPrivate));
+}
+
+/**
+ * zif_server_init:
+ **/
+static void
+zif_server_init (ZifServer *server)
+{
+	server->priv = ZIF_SERVER_GET_PRIVATE (server);
+	server->priv->socket_path = g_strdup (ZIF_SERVER_SOCKET_PATH);
+	server->priv->store_array = zif_store_array_new ();
+	server->priv->store_array_all = zif_store_array_new ();
+	server->priv->lock = zif_lock_new ();
+}
+
+/**
+ * zif_server_new:
+ *
+ * Return value: A new #ZifServer instance.
+ *
+ * Since: 0.3.7
+ **/
+ZifServer *
+zif_server_new (void)
+{
+	ZifServer *server;
+	server = g_object_new (ZIF_TYPE_SERVER, NULL);
+	return ZIF_SERVER (server);
+}
@@ -0,0 +1,88 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2013 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#if !defined (__ZIF_H_INSIDE__) && !defined (ZIF_COMPILATION)
+#error "Only <zif.h> can be included directly."
+#endif
+
+#ifndef __ZIF_SERVER_H
+#define __ZIF_SERVER_H
+
+#include <glib-object.h>
+
+#include "zif-store.h"
+
+G_BEGIN_DECLS
+
+#define ZIF_TYPE_SERVER		(zif_server_get_type ())
+#define ZIF_SERVER(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), ZIF_TYPE_SERVER, ZifServer))
+#define ZIF_SERVER_CLASS(k)	(G_TYPE_CHECK_CLASS_CAST((k), ZIF_TYPE_SERVER, ZifServerClass))
+#define ZIF_IS_SERVER(o)	(G_TYPE_CHECK_INSTANCE_TYPE ((o), ZIF_TYPE_SERVER))
+#define ZIF_IS_SERVER_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), ZIF_TYPE_SERVER))
+#define ZIF_SERVER_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), ZIF_TYPE_SERVER, ZifServerClass))
+#define ZIF_SERVER_ERROR	(zif_server_error_quark ())
+
+#define ZIF_SERVER_SOCKET_PATH	"/var/run/zif-server.socket"
+
+typedef struct _ZifServer		ZifServer;
+typedef struct _ZifServerPrivate	ZifServerPrivate;
+typedef struct _ZifServerClass		ZifServerClass;
+
+struct _ZifServer
+{
+	GObject			 parent;
+	ZifServerPrivate	*priv;
+};
+
+struct _ZifServerClass
+{
+	GObjectClass		 parent_class;
+	/* Padding for future expansion */
+	void (*_zif_reserved1) (void);
+	void (*_zif_reserved2) (void);
+	void (*_zif_reserved3) (void);
+	void (*_zif_reserved4) (void);
+};
+
+typedef enum {
+	ZIF_SERVER_ERROR_FAILED,
+	ZIF_SERVER_ERROR_BUSY,
+	ZIF_SERVER_ERROR_NO_SERVER,
+	ZIF_SERVER_ERROR_INVALID,
+	ZIF_SERVER_ERROR_LAST
+} ZifServerError;
+
+GQuark		 zif_server_error_quark		(void);
+GType		 zif_server_get_type		(void);
+ZifServer	*zif_server_new			(void);
+void		 zif_server_set_socket_path	(ZifServer	*server,
+						 const gchar	*socket_path);
+void		 zif_server_set_stores		(ZifServer	*server,
+						 ZifStore	*store_local,
+						 GPtrArray	*store_array);
+gboolean	 zif_server_start		(ZifServer	*server,
+						 GError		**error);
+void		 zif_server_stop		(ZifServer	*server);
+guint		 zif_server_get_requests	(ZifServer	*server);
+
+G_END_DECLS
+
+#endif /* __ZIF_SERVER_H */
@@ -0,0 +1,392 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2011 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * SECTION:zif-sql-stats
+ * @short_description: Statistics for the SQLite databases
+ *
+ * When enabled with zif_sql_stats_set_enabled(), each SQLite database
+ * opened by the metadata and history objects records the number of
+ * statements executed, the number of rows returned, the total time spent
+ * and the text of the slowest statements.
+ *
+ * Databases are identified by a name of the form "kind:filename", e.g.
+ * "primary_db:/var/cache/zif/fedora/primary.sqlite".
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+#include <sqlite3.h>
+
+#include "zif-sql-stats.h"
+#include "zif-sql-stats-private.h"
+
+#define ZIF_SQL_STATS_SLOWEST_MAX	10
+
+typedef struct {
+	gchar			*statement;
+	guint64			 elapsed;	/* ns */
+} ZifSqlStatsQuery;
+
+typedef struct {
+	gchar			*name;
+	guint64			 statements;
+	guint64			 rows;
+	guint64			 elapsed;	/* ns */
+	ZifSqlStatsQuery	 slowest[ZIF_SQL_STATS_SLOWEST_MAX];
+} ZifSqlStatsItem;
+
+static GMutex		 zif_sql_stats_mutex;
+static GHashTable	*zif_sql_stats_hash = NULL;
+static gboolean		 zif_sql_stats_enabled = FALSE;
+
+/**
+ * zif_sql_stats_item_free:
+ **/
+static void
+zif_sql_stats_item_free (ZifSqlStatsItem *item)
+{
+	guint i;
+	for (i = 0; i < ZIF_SQL_STATS_SLOWEST_MAX; i++)
+		g_free (item->slowest[i].statement);
+	g_free (item->name);
+	g_free (item);
+}
+
+/**
+ * zif_sql_stats_item_clear:
+ **/
+static void
+zif_sql_stats_item_clear (ZifSqlStatsItem *item)
+{
+	guint i;
+	item->statements = 0;
+	item->rows = 0;
+	item->elapsed = 0;
+	for (i = 0; i < ZIF_SQL_STATS_SLOWEST_MAX; i++) {
+		g_free (item->slowest[i].statement);
+		item->slowest[i].statement = NULL;
+		item->slowest[i].elapsed = 0;
+	}
+}
+
+/**
+ * zif_sql_stats_item_add_statement:
+ *
+ * The slowest array is kept sorted, slowest first.
+ **/
+static void
+zif_sql_stats_item_add_statement (ZifSqlStatsItem *item,
+				  const gchar *statement,
+				  guint64 elapsed)
+{
+	guint i;
+
+	g_mutex_lock (&zif_sql_stats_mutex);
+	item->statements++;
+	item->elapsed += elapsed;
+
+	/* not slow enough to be interesting */
+	if (statement == NULL ||
+	    elapsed <= item->slowest[ZIF_SQL_STATS_SLOWEST_MAX - 1].elapsed)
+		goto out;
+
+	/* shuffle the faster statements down */
+	g_free (item->slowest[ZIF_SQL_STATS_SLOWEST_MAX - 1].statement);
+	for (i = ZIF_SQL_STATS_SLOWEST_MAX - 1; i > 0; i--) {
+		if (item->slowest[i - 1].elapsed >= elapsed)
+			break;
+		item->slowest[i] = item->slowest[i - 1];
+	}
+	item->slowest[i].statement = g_strdup (statement);
+	item->slowest[i].elapsed = elapsed;
+out:
+	g_mutex_unlock (&zif_sql_stats_mutex);
+}
+
+#if SQLITE_VERSION_NUMBER >= 3014000
+/**
+ * zif_sql_stats_trace_cb:
+ **/
+static int
+zif_sql_stats_trace_cb (unsigned type, void *ctx, void *p, void *x)
+{
+	ZifSqlStatsItem *item = (ZifSqlStatsItem *) ctx;
+
+	if (type == SQLITE_TRACE_ROW) {
+		g_mutex_lock (&zif_sql_stats_mutex);
+		item->rows++;
+		g_mutex_unlock (&zif_sql_stats_mutex);
+	} else if (type == SQLITE_TRACE_PROFILE) {
+		zif_sql_stats_item_add_statement (item,
+						  sqlite3_sql ((sqlite3_stmt *) p),
+						  *((sqlite3_int64 *) x));
+	}
+	return 0;
+}
+#else
+/**
+ * zif_sql_stats_profile_cb:
+ *
+ * Older versions of sqlite cannot tell us about rows.
+ **/
+static void
+zif_sql_stats_profile_cb (void *ctx, const char *statement, sqlite3_uint64 elapsed)
+{
+	zif_sql_stats_item_add_statement ((ZifSqlStatsItem *) ctx,
+					  statement,
+					  elapsed);
+}
+#endif
+
+/**
+ * zif_sql_stats_attach:
+ * @db: A sqlite database
+ * @kind: The kind of database, e.g. "primary_db"
+ * @filename: The database filename
+ *
+ * Starts collecting statistics for the database, if enabled.
+ **/
+void
+zif_sql_stats_attach (sqlite3 *db, const gchar *kind, const gchar *filename)
+{
+	gchar *name;
+	ZifSqlStatsItem *item;
+
+	g_return_if_fail (db != NULL);
+	g_return_if_fail (kind != NULL);
+
+	/* do not slow down every statement when nobody is looking */
+	if (!zif_sql_stats_enabled)
+		return;
+
+	/* items are never freed, as the db may still refer to them */
+	name = g_strdup_printf ("%s:%s", kind, filename);
+	g_mutex_lock (&zif_sql_stats_mutex);
+	if (zif_sql_stats_hash == NULL) {
+		zif_sql_stats_hash = g_hash_table_new_full (g_str_hash,
+							    g_str_equal,
+							    NULL,
+							    (GDestroyNotify) zif_sql_stats_item_free);
+	}
+	item = g_hash_table_lookup (zif_sql_stats_hash, name);
+	if (item == NULL) {
+		item = g_new0 (ZifSqlStatsItem, 1);
+		item->name = name;
+		g_hash_table_insert (zif_sql_stats_hash, item->name, item);
+	} else {
+		g_free (name);
+	}
+	g_mutex_unlock (&zif_sql_stats_mutex);
+
+#if SQLITE_VERSION_NUMBER >= 3014000
+	sqlite3_trace_v2 (db,
+			  SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW,
+			  zif_sql_stats_trace_cb,
+			  item);
+#else
+	sqlite3_profile (db, zif_sql_stats_profile_cb, item);
+#endif
+}
+
+/**
+ * zif_sql_stats_set_enabled:
+ * @enabled: If statistics should be collected
+ *
+ * Enables collecting statistics for any databases opened after this
+ * function is called.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_sql_stats_set_enabled (gboolean enabled)
+{
+	zif_sql_stats_enabled = enabled;
+}
+
+/**
+ * zif_sql_stats_get_enabled:
+ *
+ * Return value: %TRUE if statistics are being collected
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_sql_stats_get_enabled (void)
+{
+	return zif_sql_stats_enabled;
+}
+
+/**
+ * zif_sql_stats_get_names:
+ *
+ * Gets the names of all the databases that have statistics.
+ *
+ * Return value: (transfer container): An array of names, free with g_ptr_array_unref()
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_sql_stats_get_names (void)
+{
+	GList *l;
+	GList *list = NULL;
+	GPtrArray *array;
+
+	array = g_ptr_array_new_with_free_func (g_free);
+	g_mutex_lock (&zif_sql_stats_mutex);
+	if (zif_sql_stats_hash != NULL)
+		list = g_hash_table_get_keys (zif_sql_stats_hash);
+	for (l = list; l != NULL; l = l->next)
+		g_ptr_array_add (array, g_strdup (l->data));
+	g_mutex_unlock (&zif_sql_stats_mutex);
+	g_list_free (list);
+	return array;
+}
+
+/**
+ * zif_sql_stats_get:
+ * @name: A database name, e.g. "primary_db:/var/cache/zif/fedora/primary.sqlite"
+ * @statements: (out) (allow-none): The number of statements executed
+ * @rows: (out) (allow-none): The number of rows returned
+ * @elapsed: (out) (allow-none): The time spent executing statements in us
+ *
+ * Gets the statistics for a specific database.
+ *
+ * Return value: %TRUE if the database was found
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_sql_stats_get (const gchar *name,
+		   guint64 *statements,
+		   guint64 *rows,
+		   guint64 *elapsed)
+{
+	gboolean ret = FALSE;
+	ZifSqlStatsItem *item = NULL;
+
+	g_return_val_if_fail (name != NULL, FALSE);
+
+	g_mutex_lock (&zif_sql_stats_mutex);
+	if (zif_sql_stats_hash != NULL)
+		item = g_hash_table_lookup (zif_sql_stats_hash, name);
+	if (item == NULL)
+		goto out;
+	if (statements != NULL)
+		*statements = item->statements;
+	if (rows != NULL)
+		*rows = item->rows;
+	if (elapsed != NULL)
+		*elapsed = item->elapsed / 1000;
+	ret = TRUE;
+out:
+	g_mutex_unlock (&zif_sql_stats_mutex);
+	return ret;
+}
+
+/**
+ * zif_sql_stats_sort_cb:
+ **/
+static gint
+zif_sql_stats_sort_cb (gconstpointer a, gconstpointer b)
+{
+	const ZifSqlStatsItem *item_a = a;
+	const ZifSqlStatsItem *item_b = b;
+	if (item_a->elapsed > item_b->elapsed)
+		return -1;
+	if (item_a->elapsed < item_b->elapsed)
+		return 1;
+	return 0;
+}
+
+/**
+ * zif_sql_stats_to_string:
+ *
+ * Gets a report of all the collected statistics, with the database
+ * that spent the most time listed first.
+ *
+ * Return value: A string, free with g_free()
+ *
+ * Since: 0.3.7
+ **/
+gchar *
+zif_sql_stats_to_string (void)
+{
+	GList *l;
+	GList *list = NULL;
+	GString *string;
+	guint i;
+	ZifSqlStatsItem *item;
+
+	string = g_string_new ("");
+	g_mutex_lock (&zif_sql_stats_mutex);
+	if (zif_sql_stats_hash != NULL)
+		list = g_hash_table_get_values (zif_sql_stats_hash);
+	list = g_list_sort (list, zif_sql_stats_sort_cb);
+	for (l = list; l != NULL; l = l->next) {
+		item = l->data;
+		g_string_append_printf (string,
+					"%s\n"
+					"  statements: %" G_GUINT64_FORMAT "\n"
+					"  rows:       %" G_GUINT64_FORMAT "\n"
+					"  time:       %.3fms\n",
+					item->name,
+					item->statements,
+					item->rows,
+					(gdouble) item->elapsed / 1000000.0f);
+		for (i = 0; i < ZIF_SQL_STATS_SLOWEST_MAX; i++) {
+			if (item->slowest[i].statement == NULL)
+				break;
+			g_string_append_printf (string, "  %9.3fms  %s\n",
+						(gdouble) item->slowest[i].elapsed / 1000000.0f,
+						item->slowest[i].statement);
+		}
+	}
+	g_mutex_unlock (&zif_sql_stats_mutex);
+	g_list_free (list);
+	return g_string_free (string, FALSE);
+}
+
+/**
+ * zif_sql_stats_reset:
+ *
+ * Clears all the collected statistics.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_sql_stats_reset (void)
+{
+	GList *l;
+	GList *list = NULL;
+
+	g_mutex_lock (&zif_sql_stats_mutex);
+	if (zif_sql_stats_hash != NULL)
+		list = g_hash_table_get_values (zif_sql_stats_hash);
+	for (l = list; l != NULL; l = l->next)
+		zif_sql_stats_item_clear (l->data);
+	g_mutex_unlock (&zif_sql_stats_mutex);
+	g_list_free (list);
+}
@@ -0,0 +1,45 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2011 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#if !defined (__ZIF_H_INSIDE__) && !defined (ZIF_COMPILATION)
+#error "Only <zif.h> can be included directly."
+#endif
+
+#ifndef __ZIF_SQL_STATS_H
+#define __ZIF_SQL_STATS_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void		 zif_sql_stats_set_enabled	(gboolean	 enabled);
+gboolean	 zif_sql_stats_get_enabled	(void);
+GPtrArray	*zif_sql_stats_get_names	(void);
+gboolean	 zif_sql_stats_get		(const gchar	*name,
+						 guint64	*statements,
+						 guint64	*rows,
+						 guint64	*elapsed);
+gchar		*zif_sql_stats_to_string	(void);
+void		 zif_sql_stats_reset		(void);
+
+G_END_DECLS
+
+#endif /* __ZIF_SQL_STATS_H */
@@ -42,6 +42,11 @@
  * There are a few nice touches in this module, so that if a module only has
  * one progress step, the child progress is used for updates.
  *
+ * If tracing is enabled using zif_state_set_enable_trace() then each state
+ * and each step records when it started and stopped into a process-wide
+ * ring buffer, which can be saved using zif_state_get_trace() and viewed
+ * in a trace-event viewer such as chrome://tracing.
+ *
  * <example>
  *   <title>Using a #ZifState.</title>
  *   <programlisting>
@@ -81,6 +86,7 @@
 #include <glib.h>
 #include <glib-unix.h>
 #include <signal.h>
+#include <unistd.h>
 #include <rpm/rpmsq.h>
 
 #include "zif-utils.h"
@@ -94,6 +100,7 @@ struct _ZifStatePrivate
 	gboolean		 allow_cancel_changed_state;
 	gboolean		 allow_cancel_child;
 	gboolean		 enable_profile;
+	gboolean		 enable_trace;
 	gboolean		 report_progress;
 	gboolean		 process_event_sources;
 	GCancellable		*cancellable;
@@ -110,6 +117,9 @@ struct _ZifStatePrivate
 	guint			 last_percentage;
 	guint			*step_data;
 	guint			 steps;
+	const gchar		*trace_strloc;
+	gint64			 trace_start;
+	gint64			 trace_step_start;
 	gulong			 action_child_id;
 	gulong			 package_progress_child_id;
 	gulong			 notify_speed_child_id;
@@ -147,6 +157,28 @@ static guint signals [SIGNAL_LAST] = { 0 };
 G_DEFINE_TYPE (ZifState, zif_state, G_TYPE_OBJECT)
 
 #define ZIF_STATE_SPEED_SMOOTHING_ITEMS		5
+#define ZIF_STATE_TRACE_MAX_EVENTS		65536
+
+typedef enum {
+	ZIF_STATE_TRACE_KIND_STATE,
+	ZIF_STATE_TRACE_KIND_STEP,
+	ZIF_STATE_TRACE_KIND_ABORTED
+} ZifStateTraceKind;
+
+typedef struct {
+	const gchar		*strloc;	/* static, from G_STRLOC */
+	gchar			*action_hint;
+	gint64			 start;
+	gint64			 stop;
+	gpointer		 thread;
+	ZifStateAction		 action;
+	ZifStateTraceKind	 kind;
+} ZifStateTraceEvent;
+
+static GMutex		 zif_state_trace_mutex;
+static ZifStateTraceEvent *zif_state_trace_events = NULL;
+static guint		 zif_state_trace_head = 0;
+static guint		 zif_state_trace_len = 0;
 
 /**
  * zif_state_error_quark:
@@ -203,6 +235,203 @@ zif_state_set_enable_profile (ZifState *state, gboolean enable_profile)
 	state->priv->enable_profile = enable_profile;
 }
 
+/**
+ * zif_state_get_enable_profile:
+ * @state: A #ZifState
+ *
+ * Gets if profiling is enabled for this #ZifState.
+ *
+ * Return value: %TRUE if profiling is enabled
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_state_get_enable_profile (ZifState *state)
+{
+	g_return_val_if_fail (ZIF_IS_STATE (state), FALSE);
+	return state->priv->enable_profile;
+}
+
+/**
+ * zif_state_set_enable_trace:
+ * @state: A #ZifState
+ * @enable_trace: if tracing should be enabled
+ *
+ * This enables recording the start and stop times of this #ZifState,
+ * all of its steps and all of its children. The events can be retrieved
+ * using zif_state_get_trace().
+ *
+ * When tracing is disabled the only overhead is a boolean check.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_state_set_enable_trace (ZifState *state, gboolean enable_trace)
+{
+	g_return_if_fail (ZIF_IS_STATE (state));
+	state->priv->enable_trace = enable_trace;
+}
+
+/**
+ * zif_state_get_enable_trace:
+ * @state: A #ZifState
+ *
+ * Gets if tracing is enabled for this #ZifState.
+ *
+ * Return value: %TRUE if tracing is enabled
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_state_get_enable_trace (ZifState *state)
+{
+	g_return_val_if_fail (ZIF_IS_STATE (state), FALSE);
+	return state->priv->enable_trace;
+}
+
+/**
+ * zif_state_trace_add:
+ *
+ * Adds an event to the ring buffer, overwriting the oldest event if the
+ * buffer is full.
+ **/
+static void
+zif_state_trace_add (ZifState *state,
+		     ZifStateTraceKind kind,
+		     const gchar *strloc,
+		     gint64 start)
+{
+	ZifStateTraceEvent *event;
+
+	g_mutex_lock (&zif_state_trace_mutex);
+	if (zif_state_trace_events == NULL)
+		zif_state_trace_events = g_new0 (ZifStateTraceEvent, ZIF_STATE_TRACE_MAX_EVENTS);
+	event = &zif_state_trace_events[zif_state_trace_head];
+	g_free (event->action_hint);
+	event->strloc = strloc;
+	event->action_hint = g_strdup (state->priv->action_hint);
+	event->start = start;
+	event->stop = g_get_monotonic_time ();
+	event->thread = g_thread_self ();
+	event->action = state->priv->action;
+	event->kind = kind;
+	zif_state_trace_head = (zif_state_trace_head + 1) % ZIF_STATE_TRACE_MAX_EVENTS;
+	if (zif_state_trace_len < ZIF_STATE_TRACE_MAX_EVENTS)
+		zif_state_trace_len++;
+	g_mutex_unlock (&zif_state_trace_mutex);
+}
+
+/**
+ * zif_state_trace_append_escaped:
+ **/
+static void
+zif_state_trace_append_escaped (GString *str, const gchar *value)
+{
+	guint i;
+
+	for (i = 0; value[i] != '\0'; i++) {
+		if (value[i] == '"' || value[i] == '\\') {
+			g_string_append_c (str, '\\');
+			g_string_append_c (str, value[i]);
+		} else if ((guchar) value[i] < 0x20) {
+			g_string_append_printf (str, "\\u%04x", (guchar) value[i]);
+		} else {
+			g_string_append_c (str, value[i]);
+		}
+	}
+}
+
+/**
+ * zif_state_get_trace:
+ *
+ * Gets all the recorded trace events in the Chrome trace-event JSON
+ * format. Each #ZifState is one complete event, and each step is another
+ * complete event nested inside it. Events are recorded for all the
+ * #ZifState objects in the process that have tracing enabled.
+ *
+ * Return value: A JSON document, free with g_free()
+ *
+ * Since: 0.3.7
+ **/
+gchar *
+zif_state_get_trace (void)
+{
+	gpointer tid;
+	GHashTable *threads;
+	GString *str;
+	guint i;
+	guint idx;
+	ZifStateTraceEvent *event;
+
+	str = g_string_new ("{\"traceEvents\":[");
+	threads = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_mutex_lock (&zif_state_trace_mutex);
+	for (i = 0; i < zif_state_trace_len; i++) {
+		idx = (zif_state_trace_head + ZIF_STATE_TRACE_MAX_EVENTS -
+		       zif_state_trace_len + i) % ZIF_STATE_TRACE_MAX_EVENTS;
+		event = &zif_state_trace_events[idx];
+
+		/* use small stable numbers for the threads */
+		tid = g_hash_table_lookup (threads, event->thread);
+		if (tid == NULL) {
+			tid = GUINT_TO_POINTER (g_hash_table_size (threads) + 1);
+			g_hash_table_insert (threads, event->thread, tid);
+		}
+
+		if (i > 0)
+			g_string_append_c (str, ',');
+		g_string_append (str, "\n{\"name\":\"");
+		zif_state_trace_append_escaped (str, event->strloc);
+		g_string_append_printf (str, "\",\"cat\":\"%s\",\"ph\":\"X\","
+					"\"ts\":%" G_GINT64_FORMAT ","
+					"\"dur\":%" G_GINT64_FORMAT ","
+					"\"pid\":%i,\"tid\":%u,\"args\":{",
+					event->kind == ZIF_STATE_TRACE_KIND_STEP ? "step" : "state",
+					event->start,
+					event->stop - event->start,
+					getpid (),
+					GPOINTER_TO_UINT (tid));
+		g_string_append_printf (str, "\"action\":\"%s\"",
+					zif_state_action_to_string (event->action));
+		if (event->action_hint != NULL) {
+			g_string_append (str, ",\"package\":\"");
+			zif_state_trace_append_escaped (str, event->action_hint);
+			g_string_append_c (str, '"');
+		}
+		if (event->kind == ZIF_STATE_TRACE_KIND_ABORTED)
+			g_string_append (str, ",\"aborted\":true");
+		g_string_append (str, "}}");
+	}
+	g_mutex_unlock (&zif_state_trace_mutex);
+	g_string_append (str, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	g_hash_table_unref (threads);
+	return g_string_free (str, FALSE);
+}
+
+/**
+ * zif_state_clear_trace:
+ *
+ * Removes all the recorded trace events.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_state_clear_trace (void)
+{
+	guint i;
+
+	g_mutex_lock (&zif_state_trace_mutex);
+	if (zif_state_trace_events != NULL) {
+		for (i = 0; i < ZIF_STATE_TRACE_MAX_EVENTS; i++) {
+			g_free (zif_state_trace_events[i].action_hint);
+			zif_state_trace_events[i].action_hint = NULL;
+		}
+	}
+	zif_state_trace_head = 0;
+	zif_state_trace_len = 0;
+	g_mutex_unlock (&zif_state_trace_mutex);
+}
+
 /**
  * zif_state_set_error_handler:
  * @state: A #ZifState
@@ -1016,6 +1245,15 @@ zif_state_reset (ZifState *state)
 		goto out;
 	}
 
+	/* the state never completed */
+	if (state->priv->trace_start != 0) {
+		zif_state_trace_add (state,
+				     ZIF_STATE_TRACE_KIND_ABORTED,
+				     state->priv->trace_strloc,
+				     state->priv->trace_start);
+		state->priv->trace_start = 0;
+	}
+
 	/* reset values */
 	state->priv->steps = 0;
 	state->priv->current = 0;
@@ -1199,6 +1437,8 @@ zif_state_get_child (ZifState *state)
 	/* set the profile state */
 	zif_state_set_enable_profile (child,
 				      state->priv->enable_profile);
+	zif_state_set_enable_trace (child,
+				    state->priv->enable_trace);
 
 	/* set the mainloop clearing */
 	zif_state_set_process_event_sources (child,
@@ -1302,6 +1542,13 @@ zif_state_set_number_steps_real (ZifState *state, guint steps, const gchar *strl
 	/* set steps */
 	state->priv->steps = steps;
 
+	/* start recording */
+	if (state->priv->enable_trace) {
+		state->priv->trace_strloc = strloc;
+		state->priv->trace_start = g_get_monotonic_time ();
+		state->priv->trace_step_start = state->priv->trace_start;
+	}
+
 	/* global share just got smaller */
 	state->priv->global_share /= steps;
 
@@ -1595,6 +1842,22 @@ zif_state_done_real (ZifState *state, GError **error, const gchar *strloc)
 	/* another */
 	state->priv->current++;
 
+	/* record the step, and the state if this was the last step */
+	if (state->priv->trace_start != 0) {
+		zif_state_trace_add (state,
+				     ZIF_STATE_TRACE_KIND_STEP,
+				     strloc,
+				     state->priv->trace_step_start);
+		state->priv->trace_step_start = g_get_monotonic_time ();
+		if (state->priv->current == state->priv->steps) {
+			zif_state_trace_add (state,
+					     ZIF_STATE_TRACE_KIND_STATE,
+					     state->priv->trace_strloc,
+					     state->priv->trace_start);
+			state->priv->trace_start = 0;
+		}
+	}
+
 	/* find new percentage */
 	if (state->priv->step_data == NULL) {
 		percentage = zif_state_discrete_to_percent (state->priv->current,
@@ -1649,6 +1912,13 @@ zif_state_finished_real (ZifState *state, GError **error, const gchar *strloc)
 
 	/* all done */
 	state->priv->current = state->priv->steps;
+	if (state->priv->trace_start != 0) {
+		zif_state_trace_add (state,
+				     ZIF_STATE_TRACE_KIND_STATE,
+				     state->priv->trace_strloc,
+				     state->priv->trace_start);
+		state->priv->trace_start = 0;
+	}
 
 	/* set new percentage */
 	zif_state_set_percentage (state, 100);
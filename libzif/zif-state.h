@@ -158,6 +158,12 @@ gboolean	 zif_state_reset			(ZifState		*state);
 gboolean	 zif_state_valid			(ZifState		*state);
 void		 zif_state_set_enable_profile		(ZifState		*state,
 							 gboolean		 enable_profile);
+gboolean	 zif_state_get_enable_profile		(ZifState		*state);
+void		 zif_state_set_enable_trace		(ZifState		*state,
+							 gboolean		 enable_trace);
+gboolean	 zif_state_get_enable_trace		(ZifState		*state);
+gchar		*zif_state_get_trace			(void);
+void		 zif_state_clear_trace			(void);
 
 /* cancellation */
 GCancellable	*zif_state_get_cancellable		(ZifState		*state);
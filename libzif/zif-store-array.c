@@ -28,6 +28,10 @@
  *
  * IMPORTANT: any errors that happen on the ZifStores are fatal unless you're
  * using zif_state_set_error_handler().
+ *
+ * If the parallel_store_queries config key is set then each store is
+ * queried in its own thread, although the results are still returned
+ * in the order of the stores in the array.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -47,8 +51,11 @@
 #include "zif-utils.h"
 #include "zif-repos.h"
 #include "zif-category.h"
+#include "zif-lock.h"
 #include "zif-object-array.h"
 
+#define ZIF_STORE_ARRAY_MAX_THREADS	8
+
 typedef enum {
 	ZIF_ROLE_GET_PACKAGES,
 	ZIF_ROLE_RESOLVE,
@@ -289,6 +296,305 @@ out:
 	return ret;
 }
 
+/**
+ * zif_store_array_query_store:
+ **/
+static GPtrArray *
+zif_store_array_query_store (ZifStore *store,
+			     ZifRole role,
+			     gpointer search,
+			     guint flags,
+			     ZifState *state,
+			     GError **error)
+{
+	GPtrArray *part = NULL;
+
+	if (role == ZIF_ROLE_RESOLVE)
+		part = zif_store_resolve_full (store, (gchar**)search, flags, state, error);
+	else if (role == ZIF_ROLE_SEARCH_NAME)
+		part = zif_store_search_name (store, (gchar**)search, state, error);
+	else if (role == ZIF_ROLE_SEARCH_DETAILS)
+		part = zif_store_search_details (store, (gchar**)search, state, error);
+	else if (role == ZIF_ROLE_SEARCH_GROUP)
+		part = zif_store_search_group (store, (gchar**)search, state, error);
+	else if (role == ZIF_ROLE_SEARCH_CATEGORY)
+		part = zif_store_search_category (store, (gchar**)search, state, error);
+	else if (role == ZIF_ROLE_SEARCH_FILE)
+		part = zif_store_search_file (store, (gchar**)search, state, error);
+	else if (role == ZIF_ROLE_GET_PACKAGES)
+		part = zif_store_get_packages (store, state, error);
+	else if (role == ZIF_ROLE_WHAT_PROVIDES)
+		part = zif_store_what_provides (store, (GPtrArray*) search, state, error);
+	else if (role == ZIF_ROLE_WHAT_REQUIRES)
+		part = zif_store_what_requires (store, (GPtrArray*) search, state, error);
+	else if (role == ZIF_ROLE_WHAT_OBSOLETES)
+		part = zif_store_what_obsoletes (store, (GPtrArray*) search, state, error);
+	else if (role == ZIF_ROLE_WHAT_CONFLICTS)
+		part = zif_store_what_conflicts (store, (GPtrArray*) search, state, error);
+	else if (role == ZIF_ROLE_GET_CATEGORIES)
+		part = zif_store_get_categories (store, state, error);
+	else {
+		g_set_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED,
+			     "internal error, no such role: %s", zif_role_to_string (role));
+	}
+	return part;
+}
+
+/**
+ * zif_store_array_merge_part:
+ *
+ * Adds the results from one store, or decides if the error from the
+ * store is fatal.
+ *
+ * Return value: %FALSE if the error was fatal
+ **/
+static gboolean
+zif_store_array_merge_part (GPtrArray *array,
+			    ZifStore *store,
+			    ZifRole role,
+			    GPtrArray *part,
+			    GError *error_local,
+			    ZifState *state,
+			    GError **error)
+{
+	guint i;
+	ZifPackage *package;
+
+	if (part == NULL) {
+
+		/* the store get disabled whilst being used */
+		if (g_error_matches (error_local,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_NOT_ENABLED)) {
+			g_debug ("repo %s disabled whilst being used: %s",
+				 zif_store_get_id (store),
+				 error_local->message);
+			g_error_free (error_local);
+			return TRUE;
+		}
+
+		/* do we need to skip this error */
+		if (zif_state_error_handler (state, error_local)) {
+			g_error_free (error_local);
+			return TRUE;
+		}
+		g_propagate_prefixed_error (error,
+					    error_local,
+					    "failed to %s in %s: ",
+					    zif_role_to_string (role),
+					    zif_store_get_id (store));
+		return FALSE;
+	}
+
+	for (i = 0; i < part->len; i++) {
+		package = g_ptr_array_index (part, i);
+		g_ptr_array_add (array, g_object_ref (package));
+	}
+	return TRUE;
+}
+
+typedef struct {
+	ZifStore	*store;
+	ZifRole		 role;
+	gpointer	 search;
+	guint		 flags;
+	gboolean	 dispatched;
+	GCancellable	*cancellable;
+	gboolean	 enable_profile;
+	gboolean	 enable_trace;
+	GPtrArray	*part;
+	GError		*error;
+} ZifStoreArrayJob;
+
+/**
+ * zif_store_array_job_cb:
+ **/
+static void
+zif_store_array_job_cb (ZifStoreArrayJob *job, GAsyncQueue *queue)
+{
+	ZifState *state;
+
+	/* ZifState is not threadsafe, so use a private one */
+	state = zif_state_new ();
+	if (job->cancellable != NULL)
+		zif_state_set_cancellable (state, job->cancellable);
+	zif_state_set_enable_profile (state, job->enable_profile);
+	zif_state_set_enable_trace (state, job->enable_trace);
+	job->part = zif_store_array_query_store (job->store,
+						 job->role,
+						 job->search,
+						 job->flags,
+						 state,
+						 &job->error);
+	g_object_unref (state);
+
+	/* tell the caller this store is complete */
+	g_async_queue_push (queue, job);
+}
+
+/**
+ * zif_store_array_use_parallel:
+ *
+ * Queries are only done in parallel when enabled in the config file,
+ * there is more than one store to query, and the role cannot touch the
+ * shared local store or groups from a remote store, as the group and
+ * category searches do.
+ **/
+static gboolean
+zif_store_array_use_parallel (GPtrArray *store_array, ZifRole role)
+{
+	gboolean ret;
+	guint enabled = 0;
+	guint i;
+	ZifConfig *config;
+
+	if (role == ZIF_ROLE_SEARCH_GROUP ||
+	    role == ZIF_ROLE_SEARCH_CATEGORY ||
+	    role == ZIF_ROLE_GET_CATEGORIES)
+		return FALSE;
+	for (i = 0; i < store_array->len; i++) {
+		if (zif_store_get_enabled (g_ptr_array_index (store_array, i)))
+			enabled++;
+	}
+	if (enabled < 2)
+		return FALSE;
+	config = zif_config_new ();
+	ret = zif_config_get_boolean (config, "parallel_store_queries", NULL);
+	g_object_unref (config);
+	return ret;
+}
+
+/**
+ * zif_store_array_repos_search_parallel:
+ *
+ * Runs the query on each store in a thread pool, where each store uses
+ * its own metadata connection. Progress is reported as each store
+ * completes, and the results are merged in store order so the output is
+ * identical to the sequential search.
+ **/
+static GPtrArray *
+zif_store_array_repos_search_parallel (GPtrArray *store_array,
+				       ZifRole role,
+				       gpointer search,
+				       guint flags,
+				       ZifState *state,
+				       GError **error)
+{
+	gboolean ret = TRUE;
+	GAsyncQueue *queue;
+	GError *error_local = NULL;
+	GPtrArray *array = NULL;
+	GThreadPool *pool;
+	guint i;
+	guint pushed = 0;
+	ZifState *state_local;
+	ZifStoreArrayJob *job;
+	ZifStoreArrayJob *jobs;
+
+	/* set number of stores */
+	zif_state_set_number_steps (state, store_array->len);
+
+	/* dispatch each enabled store */
+	queue = g_async_queue_new ();
+	pool = g_thread_pool_new ((GFunc) zif_store_array_job_cb,
+				  queue,
+				  ZIF_STORE_ARRAY_MAX_THREADS,
+				  FALSE,
+				  NULL);
+	jobs = g_new0 (ZifStoreArrayJob, store_array->len);
+	for (i = 0; i < store_array->len; i++) {
+		job = &jobs[i];
+		job->store = g_ptr_array_index (store_array, i);
+		if (!zif_store_get_enabled (job->store))
+			continue;
+		job->dispatched = TRUE;
+		job->role = role;
+		job->search = search;
+		job->flags = flags;
+		job->cancellable = zif_state_get_cancellable (state);
+		job->enable_profile = zif_state_get_enable_profile (state);
+		job->enable_trace = zif_state_get_enable_trace (state);
+		g_thread_pool_push (pool, job, NULL);
+		pushed++;
+	}
+
+	/* disabled stores are already done */
+	for (i = 0; i < store_array->len - pushed; i++) {
+		ret = zif_state_done (state, error);
+		if (!ret)
+			break;
+	}
+
+	/* report progress as each store completes; if cancelled we
+	 * still have to wait for the workers to return */
+	for (i = 0; i < pushed; i++) {
+		g_async_queue_pop (queue);
+		if (!ret)
+			continue;
+		ret = zif_state_done (state, error);
+	}
+	g_thread_pool_free (pool, FALSE, TRUE);
+	g_async_queue_unref (queue);
+
+	/* merge in store order */
+	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; i < store_array->len; i++) {
+		job = &jobs[i];
+		if (!ret) {
+			if (job->part != NULL)
+				g_ptr_array_unref (job->part);
+			if (job->error != NULL)
+				g_error_free (job->error);
+			continue;
+		}
+		if (!job->dispatched)
+			continue;
+
+		/* a lock held by another worker is not an error when
+		 * done sequentially, so try again in this thread */
+		if (job->part == NULL &&
+		    job->error->domain == ZIF_LOCK_ERROR) {
+			g_debug ("retrying %s in %s: %s",
+				 zif_role_to_string (role),
+				 zif_store_get_id (job->store),
+				 job->error->message);
+			g_clear_error (&job->error);
+			state_local = zif_state_new ();
+			zif_state_set_cancellable (state_local,
+						   zif_state_get_cancellable (state));
+			job->part = zif_store_array_query_store (job->store,
+								 role,
+								 search,
+								 flags,
+								 state_local,
+								 &job->error);
+			g_object_unref (state_local);
+		}
+		ret = zif_store_array_merge_part (array,
+						  job->store,
+						  role,
+						  job->part,
+						  job->error,
+						  state,
+						  &error_local);
+		if (job->part != NULL)
+			g_ptr_array_unref (job->part);
+		if (!ret)
+			g_propagate_error (error, error_local);
+	}
+	g_free (jobs);
+	if (!ret) {
+		g_ptr_array_unref (array);
+		array = NULL;
+		goto out;
+	}
+
+	/* we're done */
+	zif_package_array_filter_duplicates (array);
+out:
+	return array;
+}
+
 /**
  * zif_store_array_repos_search:
  **/
@@ -301,12 +607,11 @@ zif_store_array_repos_search (GPtrArray *store_array,
 			      GError **error)
 {
 	gboolean ret;
-	guint i, j;
+	guint i;
 	GPtrArray *array = NULL;
 	GPtrArray *array_results = NULL;
 	GPtrArray *part;
 	ZifStore *store;
-	ZifPackage *package;
 	GError *error_local = NULL;
 	ZifState *state_local = NULL;
 
@@ -319,6 +624,17 @@ zif_store_array_repos_search (GPtrArray *store_array,
 		goto out;
 	}
 
+	/* query all the stores at the same time */
+	if (zif_store_array_use_parallel (store_array, role)) {
+		array_results = zif_store_array_repos_search_parallel (store_array,
+								       role,
+								       search,
+								       flags,
+								       state,
+								       error);
+		goto out;
+	}
+
 	/* set number of stores */
 	zif_state_set_number_steps (state, store_array->len);
 
@@ -335,73 +651,28 @@ zif_store_array_repos_search (GPtrArray *store_array,
 		state_local = zif_state_get_child (state);
 
 		/* get results for this store */
-		if (role == ZIF_ROLE_RESOLVE)
-			part = zif_store_resolve_full (store, (gchar**)search, flags, state_local, &error_local);
-		else if (role == ZIF_ROLE_SEARCH_NAME)
-			part = zif_store_search_name (store, (gchar**)search, state_local, &error_local);
-		else if (role == ZIF_ROLE_SEARCH_DETAILS)
-			part = zif_store_search_details (store, (gchar**)search, state_local, &error_local);
-		else if (role == ZIF_ROLE_SEARCH_GROUP)
-			part = zif_store_search_group (store, (gchar**)search, state_local, &error_local);
-		else if (role == ZIF_ROLE_SEARCH_CATEGORY)
-			part = zif_store_search_category (store, (gchar**)search, state_local, &error_local);
-		else if (role == ZIF_ROLE_SEARCH_FILE)
-			part = zif_store_search_file (store, (gchar**)search, state_local, &error_local);
-		else if (role == ZIF_ROLE_GET_PACKAGES)
-			part = zif_store_get_packages (store, state_local, &error_local);
-		else if (role == ZIF_ROLE_WHAT_PROVIDES)
-			part = zif_store_what_provides (store, (GPtrArray*) search, state_local, &error_local);
-		else if (role == ZIF_ROLE_WHAT_REQUIRES)
-			part = zif_store_what_requires (store, (GPtrArray*) search, state_local, &error_local);
-		else if (role == ZIF_ROLE_WHAT_OBSOLETES)
-			part = zif_store_what_obsoletes (store, (GPtrArray*) search, state_local, &error_local);
-		else if (role == ZIF_ROLE_WHAT_CONFLICTS)
-			part = zif_store_what_conflicts (store, (GPtrArray*) search, state_local, &error_local);
-		else if (role == ZIF_ROLE_GET_CATEGORIES)
-			part = zif_store_get_categories (store, state_local, &error_local);
-		else {
-			g_set_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED,
-				     "internal error, no such role: %s", zif_role_to_string (role));
+		part = zif_store_array_query_store (store,
+						    role,
+						    search,
+						    flags,
+						    state_local,
+						    &error_local);
+		ret = zif_store_array_merge_part (array,
+						  store,
+						  role,
+						  part,
+						  error_local,
+						  state,
+						  error);
+		if (!ret)
 			goto out;
-		}
 		if (part == NULL) {
-
-			/* the store get disabled whilst being used */
-			if (g_error_matches (error_local,
-					     ZIF_STORE_ERROR,
-					     ZIF_STORE_ERROR_NOT_ENABLED)) {
-				g_debug ("repo %s disabled whilst being used: %s",
-					 zif_store_get_id (store),
-					 error_local->message);
-				g_clear_error (&error_local);
-				ret = zif_state_finished (state_local, error);
-				if (!ret)
-					goto out;
-				goto skip_error;
-			}
-
-			/* do we need to skip this error */
-			ret = zif_state_error_handler (state, error_local);
-			if (ret) {
-				g_clear_error (&error_local);
-				ret = zif_state_finished (state_local, error);
-				if (!ret)
-					goto out;
-				goto skip_error;
-			}
-			g_propagate_prefixed_error (error,
-						    error_local,
-						    "failed to %s in %s: ",
-						    zif_role_to_string (role),
-						    zif_store_get_id (store));
-			goto out;
-		}
-
-		for (j = 0; j < part->len; j++) {
-			package = g_ptr_array_index (part, j);
-			g_ptr_array_add (array, g_object_ref (package));
+			ret = zif_state_finished (state_local, error);
+			if (!ret)
+				goto out;
+		} else {
+			g_ptr_array_unref (part);
 		}
-		g_ptr_array_unref (part);
 skip_error:
 		/* this section done */
 		ret = zif_state_done (state, error);
@@ -60,6 +60,17 @@ struct _ZifStoreLocalPrivate
 	guint			 monitor_changed_id;
 };
 
+typedef struct {
+	Header			 header;
+	ZifPackage		*package;
+	GError			*error;
+} ZifStoreLocalJob;
+
+typedef struct {
+	ZifPackageLocalFlags	 flags;
+	GCancellable		*cancellable;
+} ZifStoreLocalDecode;
+
 G_DEFINE_TYPE (ZifStoreLocal, zif_store_local, ZIF_TYPE_STORE)
 static gpointer zif_store_local_object = NULL;
 
@@ -308,6 +319,89 @@ out:
 	return ret;
 }
 
+/**
+ * zif_store_local_job_cb:
+ **/
+static void
+zif_store_local_job_cb (ZifStoreLocalJob *job, ZifStoreLocalDecode *decode)
+{
+	/* don't do any more work once cancelled */
+	if (g_cancellable_is_cancelled (decode->cancellable)) {
+		g_set_error_literal (&job->error,
+				     ZIF_STATE_ERROR,
+				     ZIF_STATE_ERROR_CANCELLED,
+				     "cancelled by user action");
+		return;
+	}
+	zif_package_local_set_from_header (ZIF_PACKAGE_LOCAL (job->package),
+					   job->header,
+					   decode->flags,
+					   &job->error);
+}
+
+/**
+ * zif_store_local_decode_headers:
+ *
+ * Converting the headers into packages is much slower than reading
+ * them from the rpmdb, so this is optionally done in a thread pool.
+ * Each package only touches its own header, and the results are kept
+ * in rpmdb order so the store is identical to a serial load.
+ **/
+static void
+zif_store_local_decode_headers (GArray *jobs,
+				ZifPackageLocalFlags flags,
+				guint threads,
+				GCancellable *cancellable)
+{
+	GThreadPool *pool;
+	guint i;
+	ZifStoreLocalDecode decode;
+	ZifStoreLocalJob *job;
+
+	decode.flags = flags;
+	decode.cancellable = cancellable;
+
+	/* librpm sets up its tag tables and ZifDb finds the yumdb on
+	 * first use, neither of which is thread safe, so decode in this
+	 * thread until the first package has been set up */
+	for (i = 0; i < jobs->len; i++) {
+		job = &g_array_index (jobs, ZifStoreLocalJob, i);
+		zif_store_local_job_cb (job, &decode);
+		if (threads > 1 && job->error == NULL)
+			break;
+	}
+	if (i + 1 >= jobs->len)
+		return;
+
+	pool = g_thread_pool_new ((GFunc) zif_store_local_job_cb,
+				  &decode,
+				  threads,
+				  TRUE,
+				  NULL);
+	for (i = i + 1; i < jobs->len; i++)
+		g_thread_pool_push (pool, &g_array_index (jobs, ZifStoreLocalJob, i), NULL);
+	g_thread_pool_free (pool, FALSE, TRUE);
+}
+
+/**
+ * zif_store_local_jobs_free:
+ **/
+static void
+zif_store_local_jobs_free (GArray *jobs)
+{
+	guint i;
+	ZifStoreLocalJob *job;
+
+	for (i = 0; i < jobs->len; i++) {
+		job = &g_array_index (jobs, ZifStoreLocalJob, i);
+		headerFree (job->header);
+		g_object_unref (job->package);
+		if (job->error != NULL)
+			g_error_free (job->error);
+	}
+	g_array_unref (jobs);
+}
+
 /**
  * zif_store_local_load:
  **/
@@ -319,14 +413,18 @@ zif_store_local_load (ZifStore *store, ZifState *state, GError **error)
 	gboolean yumdb_allow_read;
 	GError *error_local = NULL;
 	gint rc;
+	GArray *jobs = NULL;
 	guint existing_releasever;
+	guint i;
+	guint threads;
 	Header header;
 	rpmdbMatchIterator mi = NULL;
 	rpmts ts = NULL;
 	ZifHistory *history = NULL;
 	ZifPackageCompareMode compare_mode;
 	ZifPackageLocalFlags flags = 0;
-	ZifPackage *package;
+	ZifStoreLocalJob job;
+	ZifStoreLocalJob *job_tmp;
 	ZifState *state_local;
 	ZifStoreLocal *local = ZIF_STORE_LOCAL (store);
 
@@ -421,39 +519,17 @@ zif_store_local_load (ZifStore *store, ZifState *state, GError **error)
 	 * the transaction in a nice way */
 	zif_state_cancel_on_signal (state, SIGINT);
 
-	/* add each package from the rpmdb */
+	/* read each header from the rpmdb */
+	jobs = g_array_new (FALSE, FALSE, sizeof (ZifStoreLocalJob));
 	do {
 		header = rpmdbNextIterator (mi);
 		if (header == NULL)
 			break;
-		package = zif_package_local_new ();
-		zif_package_set_installed (package, TRUE);
-		ret = zif_package_local_set_from_header (ZIF_PACKAGE_LOCAL (package),
-							 header,
-							 flags,
-							 &error_local);
-		if (!ret) {
-			/* we ignore this one */
-			if (error_local->domain == ZIF_PACKAGE_ERROR &&
-			    error_local->code == ZIF_PACKAGE_ERROR_NO_SUPPORT) {
-				g_clear_error (&error_local);
-				g_object_unref (package);
-			} else {
-				g_set_error (error,
-					     ZIF_STORE_ERROR,
-					     ZIF_STORE_ERROR_FAILED,
-						     "failed to set from header: %s",
-					     error_local->message);
-				g_error_free (error_local);
-				g_object_unref (package);
-				goto out;
-			}
-		} else {
-			zif_package_set_compare_mode (package,
-						      compare_mode);
-			zif_store_add_package (store, package, NULL);
-			g_object_unref (package);
-		}
+		job.header = headerLink (header);
+		job.package = zif_package_local_new ();
+		job.error = NULL;
+		zif_package_set_installed (job.package, TRUE);
+		g_array_append_val (jobs, job);
 
 		/* check cancelled */
 		ret = zif_state_check (state, error);
@@ -461,6 +537,41 @@ zif_store_local_load (ZifStore *store, ZifState *state, GError **error)
 			goto out;
 	} while (TRUE);
 
+	/* convert them to packages */
+	threads = zif_config_get_uint (local->priv->config,
+				       "rpmdb_load_threads",
+				       NULL);
+	if (threads == G_MAXUINT)
+		threads = 0;
+	zif_store_local_decode_headers (jobs, flags, threads,
+					zif_state_get_cancellable (state));
+
+	/* check cancelled */
+	ret = zif_state_check (state, error);
+	if (!ret)
+		goto out;
+
+	/* add each package in rpmdb order */
+	for (i = 0; i < jobs->len; i++) {
+		job_tmp = &g_array_index (jobs, ZifStoreLocalJob, i);
+		if (job_tmp->error != NULL) {
+			/* we ignore this one */
+			if (job_tmp->error->domain == ZIF_PACKAGE_ERROR &&
+			    job_tmp->error->code == ZIF_PACKAGE_ERROR_NO_SUPPORT)
+				continue;
+			ret = FALSE;
+			g_set_error (error,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_FAILED,
+				     "failed to set from header: %s",
+				     job_tmp->error->message);
+			goto out;
+		}
+		zif_package_set_compare_mode (job_tmp->package,
+					      compare_mode);
+		zif_store_add_package (store, job_tmp->package, NULL);
+	}
+
 	/* lookup in history database */
 	use_installed_history = zif_config_get_boolean (local->priv->config,
 							"use_installed_history",
@@ -516,6 +627,8 @@ zif_store_local_load (ZifStore *store, ZifState *state, GError **error)
 	if (!ret)
 		goto out;
 out:
+	if (jobs != NULL)
+		zif_store_local_jobs_free (jobs);
 	if (history != NULL)
 		g_object_unref (history);
 	if (mi != NULL)
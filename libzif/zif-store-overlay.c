@@ -0,0 +1,895 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2011 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * SECTION:zif-store-overlay
+ * @short_description: A store that layers changes over another store
+ *
+ * A #ZifStoreOverlay presents the packages of a base store with some
+ * packages added and some removed, without copying the base store.
+ * Packages added with zif_store_add_package() are kept in a small
+ * in-memory store, and packages removed with zif_store_remove_package()
+ * are hidden from the results of the base store.
+ *
+ * Packages may still be added to the base store while the overlay is in
+ * use, and will be seen by the next query, but packages hidden by the
+ * overlay should not be removed from the base store.
+ *
+ * A #ZifStoreOverlay is a subclassed #ZifStore and operates on packages.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "zif-object-array.h"
+#include "zif-store.h"
+#include "zif-store-meta.h"
+#include "zif-store-private.h"
+#include "zif-store-overlay.h"
+#include "zif-utils.h"
+
+#define ZIF_STORE_OVERLAY_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_STORE_OVERLAY, ZifStoreOverlayPrivate))
+
+struct _ZifStoreOverlayPrivate
+{
+	ZifStore		*base;
+	ZifStore		*added;
+	GHashTable		*removed;	/* id_basic */
+	GPtrArray		*packages;	/* cached view, or NULL */
+	guint			 base_changes;	/* of base when cached */
+};
+
+typedef enum {
+	ZIF_STORE_OVERLAY_QUERY_RESOLVE,
+	ZIF_STORE_OVERLAY_QUERY_SEARCH_NAME,
+	ZIF_STORE_OVERLAY_QUERY_SEARCH_CATEGORY,
+	ZIF_STORE_OVERLAY_QUERY_SEARCH_DETAILS,
+	ZIF_STORE_OVERLAY_QUERY_SEARCH_GROUP,
+	ZIF_STORE_OVERLAY_QUERY_SEARCH_FILE,
+	ZIF_STORE_OVERLAY_QUERY_WHAT_PROVIDES,
+	ZIF_STORE_OVERLAY_QUERY_WHAT_REQUIRES,
+	ZIF_STORE_OVERLAY_QUERY_WHAT_OBSOLETES,
+	ZIF_STORE_OVERLAY_QUERY_WHAT_CONFLICTS,
+	ZIF_STORE_OVERLAY_QUERY_LAST
+} ZifStoreOverlayQuery;
+
+G_DEFINE_TYPE (ZifStoreOverlay, zif_store_overlay, ZIF_TYPE_STORE)
+
+/**
+ * zif_store_overlay_set_base:
+ * @store: A #ZifStoreOverlay
+ * @base: A #ZifStore, typically a #ZifStoreLocal
+ *
+ * Sets the store that the added and removed packages are layered over.
+ * Any previous changes are discarded.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_store_overlay_set_base (ZifStoreOverlay *store, ZifStore *base)
+{
+	g_return_if_fail (ZIF_IS_STORE_OVERLAY (store));
+	g_return_if_fail (ZIF_IS_STORE (base));
+
+	g_object_ref (base);
+	if (store->priv->base != NULL)
+		g_object_unref (store->priv->base);
+	store->priv->base = base;
+
+	/* start again */
+	g_object_unref (store->priv->added);
+	store->priv->added = zif_store_meta_new ();
+	g_hash_table_remove_all (store->priv->removed);
+	if (store->priv->packages != NULL) {
+		g_ptr_array_unref (store->priv->packages);
+		store->priv->packages = NULL;
+	}
+}
+
+/**
+ * zif_store_overlay_get_base:
+ * @store: A #ZifStoreOverlay
+ *
+ * Gets the store that the added and removed packages are layered over.
+ *
+ * Return value: (transfer none): A #ZifStore, or %NULL if unset
+ *
+ * Since: 0.3.7
+ **/
+ZifStore *
+zif_store_overlay_get_base (ZifStoreOverlay *store)
+{
+	g_return_val_if_fail (ZIF_IS_STORE_OVERLAY (store), NULL);
+	return store->priv->base;
+}
+
+/**
+ * zif_store_overlay_invalidate:
+ **/
+static void
+zif_store_overlay_invalidate (ZifStoreOverlay *overlay)
+{
+	if (overlay->priv->packages == NULL)
+		return;
+	g_ptr_array_unref (overlay->priv->packages);
+	overlay->priv->packages = NULL;
+}
+
+/**
+ * zif_store_overlay_add_package:
+ **/
+static gboolean
+zif_store_overlay_add_package (ZifStore *store,
+			       ZifPackage *package,
+			       GError **error)
+{
+	gboolean ret = FALSE;
+	ZifStoreOverlay *overlay = ZIF_STORE_OVERLAY (store);
+	ZifStoreOverlayPrivate *priv = overlay->priv;
+
+	/* already visible in the base store */
+	if (priv->base != NULL &&
+	    g_hash_table_lookup (priv->removed,
+				 zif_package_get_id_basic (package)) == NULL &&
+	    zif_store_has_package (priv->base, package)) {
+		g_set_error (error,
+			     ZIF_STORE_ERROR,
+			     ZIF_STORE_ERROR_FAILED,
+			     "already added %s",
+			     zif_package_get_printable (package));
+		goto out;
+	}
+
+	/* this checks for duplicates in the added packages */
+	ret = zif_store_add_package (priv->added, package, error);
+	if (!ret)
+		goto out;
+	zif_store_overlay_invalidate (overlay);
+out:
+	return ret;
+}
+
+/**
+ * zif_store_overlay_remove_package:
+ **/
+static gboolean
+zif_store_overlay_remove_package (ZifStore *store,
+				  ZifPackage *package,
+				  GError **error)
+{
+	const gchar *key;
+	gboolean ret = TRUE;
+	ZifStoreOverlay *overlay = ZIF_STORE_OVERLAY (store);
+	ZifStoreOverlayPrivate *priv = overlay->priv;
+
+	/* added by us, so just forget it */
+	if (zif_store_has_package (priv->added, package)) {
+		ret = zif_store_remove_package (priv->added, package, error);
+		if (!ret)
+			goto out;
+		zif_store_overlay_invalidate (overlay);
+		goto out;
+	}
+
+	/* hide the base store copy */
+	key = zif_package_get_id_basic (package);
+	if (priv->base == NULL ||
+	    g_hash_table_lookup (priv->removed, key) != NULL ||
+	    !zif_store_has_package (priv->base, package)) {
+		ret = FALSE;
+		g_set_error (error,
+			     ZIF_STORE_ERROR,
+			     ZIF_STORE_ERROR_FAILED,
+			     "package not found in array %s",
+			     zif_package_get_printable (package));
+		goto out;
+	}
+	g_hash_table_insert (priv->removed,
+			     g_strdup (key),
+			     GINT_TO_POINTER (1));
+	zif_store_overlay_invalidate (overlay);
+out:
+	return ret;
+}
+
+/**
+ * zif_store_overlay_merge:
+ *
+ * Filters the removed packages out of the base store results and
+ * appends the results from the added packages.
+ **/
+static GPtrArray *
+zif_store_overlay_merge (ZifStoreOverlay *overlay,
+			 GPtrArray *base,
+			 GPtrArray *added)
+{
+	GPtrArray *array;
+	guint i;
+	ZifPackage *package;
+
+	array = zif_object_array_new ();
+	if (base != NULL) {
+		for (i = 0; i < base->len; i++) {
+			package = g_ptr_array_index (base, i);
+			if (g_hash_table_lookup (overlay->priv->removed,
+						 zif_package_get_id_basic (package)) != NULL)
+				continue;
+			zif_object_array_add (array, package);
+		}
+	}
+	if (added != NULL)
+		zif_object_array_add_array (array, added);
+	return array;
+}
+
+/**
+ * zif_store_overlay_query_store:
+ **/
+static GPtrArray *
+zif_store_overlay_query_store (ZifStore *store,
+			       ZifStoreOverlayQuery query,
+			       gchar **search,
+			       GPtrArray *depends,
+			       ZifStoreResolveFlags flags,
+			       ZifState *state,
+			       GError **error)
+{
+	GPtrArray *array = NULL;
+
+	switch (query) {
+	case ZIF_STORE_OVERLAY_QUERY_RESOLVE:
+		array = zif_store_resolve_full (store, search, flags, state, error);
+		break;
+	case ZIF_STORE_OVERLAY_QUERY_SEARCH_NAME:
+		array = zif_store_search_name (store, search, state, error);
+		break;
+	case ZIF_STORE_OVERLAY_QUERY_SEARCH_CATEGORY:
+		array = zif_store_search_category (store, search, state, error);
+		break;
+	case ZIF_STORE_OVERLAY_QUERY_SEARCH_DETAILS:
+		array = zif_store_search_details (store, search, state, error);
+		break;
+	case ZIF_STORE_OVERLAY_QUERY_SEARCH_GROUP:
+		array = zif_store_search_group (store, search, state, error);
+		break;
+	case ZIF_STORE_OVERLAY_QUERY_SEARCH_FILE:
+		array = zif_store_search_file (store, search, state, error);
+		break;
+	case ZIF_STORE_OVERLAY_QUERY_WHAT_PROVIDES:
+		array = zif_store_what_provides (store, depends, state, error);
+		break;
+	case ZIF_STORE_OVERLAY_QUERY_WHAT_REQUIRES:
+		array = zif_store_what_requires (store, depends, state, error);
+		break;
+	case ZIF_STORE_OVERLAY_QUERY_WHAT_OBSOLETES:
+		array = zif_store_what_obsoletes (store, depends, state, error);
+		break;
+	case ZIF_STORE_OVERLAY_QUERY_WHAT_CONFLICTS:
+		array = zif_store_what_conflicts (store, depends, state, error);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+	return array;
+}
+
+/**
+ * zif_store_overlay_query:
+ *
+ * Runs the query on the base store and on the added packages. An empty
+ * store is not an error, as the other store may have results.
+ **/
+static GPtrArray *
+zif_store_overlay_query (ZifStore *store,
+			 ZifStoreOverlayQuery query,
+			 gchar **search,
+			 GPtrArray *depends,
+			 ZifStoreResolveFlags flags,
+			 ZifState *state,
+			 GError **error)
+{
+	gboolean ret;
+	GError *error_local = NULL;
+	GPtrArray *array = NULL;
+	GPtrArray *array_added = NULL;
+	GPtrArray *array_base = NULL;
+	ZifState *state_local;
+	ZifStoreOverlay *overlay = ZIF_STORE_OVERLAY (store);
+
+	g_return_val_if_fail (ZIF_IS_STORE_OVERLAY (store), NULL);
+
+	if (overlay->priv->base == NULL) {
+		g_set_error_literal (error,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_FAILED,
+				     "no base store set");
+		goto out;
+	}
+
+	/* setup state */
+	ret = zif_state_set_steps (state,
+				   error,
+				   90, /* base */
+				   10, /* added */
+				   -1);
+	if (!ret)
+		goto out;
+
+	/* query the base store */
+	state_local = zif_state_get_child (state);
+	array_base = zif_store_overlay_query_store (overlay->priv->base,
+						    query,
+						    search,
+						    depends,
+						    flags,
+						    state_local,
+						    &error_local);
+	if (array_base == NULL) {
+		if (error_local->domain != ZIF_STORE_ERROR ||
+		    error_local->code != ZIF_STORE_ERROR_ARRAY_IS_EMPTY) {
+			g_propagate_error (error, error_local);
+			goto out;
+		}
+		g_clear_error (&error_local);
+	}
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
+
+	/* query the added packages, which is usually a small set */
+	if (zif_store_get_size (overlay->priv->added) > 0) {
+		state_local = zif_state_get_child (state);
+		array_added = zif_store_overlay_query_store (overlay->priv->added,
+							     query,
+							     search,
+							     depends,
+							     flags,
+							     state_local,
+							     error);
+		if (array_added == NULL)
+			goto out;
+	}
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
+
+	/* success */
+	array = zif_store_overlay_merge (overlay, array_base, array_added);
+out:
+	if (array_base != NULL)
+		g_ptr_array_unref (array_base);
+	if (array_added != NULL)
+		g_ptr_array_unref (array_added);
+	return array;
+}
+
+/**
+ * zif_store_overlay_resolve:
+ **/
+static GPtrArray *
+zif_store_overlay_resolve (ZifStore *store,
+			   gchar **search,
+			   ZifStoreResolveFlags flags,
+			   ZifState *state,
+			   GError **error)
+{
+	return zif_store_overlay_query (store,
+					ZIF_STORE_OVERLAY_QUERY_RESOLVE,
+					search, NULL, flags, state, error);
+}
+
+/**
+ * zif_store_overlay_search_name:
+ **/
+static GPtrArray *
+zif_store_overlay_search_name (ZifStore *store,
+			       gchar **search,
+			       ZifState *state,
+			       GError **error)
+{
+	return zif_store_overlay_query (store,
+					ZIF_STORE_OVERLAY_QUERY_SEARCH_NAME,
+					search, NULL, 0, state, error);
+}
+
+/**
+ * zif_store_overlay_search_category:
+ **/
+static GPtrArray *
+zif_store_overlay_search_category (ZifStore *store,
+				   gchar **search,
+				   ZifState *state,
+				   GError **error)
+{
+	return zif_store_overlay_query (store,
+					ZIF_STORE_OVERLAY_QUERY_SEARCH_CATEGORY,
+					search, NULL, 0, state, error);
+}
+
+/**
+ * zif_store_overlay_search_details:
+ **/
+static GPtrArray *
+zif_store_overlay_search_details (ZifStore *store,
+				  gchar **search,
+				  ZifState *state,
+				  GError **error)
+{
+	return zif_store_overlay_query (store,
+					ZIF_STORE_OVERLAY_QUERY_SEARCH_DETAILS,
+					search, NULL, 0, state, error);
+}
+
+/**
+ * zif_store_overlay_search_group:
+ **/
+static GPtrArray *
+zif_store_overlay_search_group (ZifStore *store,
+				gchar **search,
+				ZifState *state,
+				GError **error)
+{
+	return zif_store_overlay_query (store,
+					ZIF_STORE_OVERLAY_QUERY_SEARCH_GROUP,
+					search, NULL, 0, state, error);
+}
+
+/**
+ * zif_store_overlay_search_file:
+ **/
+static GPtrArray *
+zif_store_overlay_search_file (ZifStore *store,
+			       gchar **search,
+			       ZifState *state,
+			       GError **error)
+{
+	return zif_store_overlay_query (store,
+					ZIF_STORE_OVERLAY_QUERY_SEARCH_FILE,
+					search, NULL, 0, state, error);
+}
+
+/**
+ * zif_store_overlay_what_provides:
+ **/
+static GPtrArray *
+zif_store_overlay_what_provides (ZifStore *store,
+				 GPtrArray *depends,
+				 ZifState *state,
+				 GError **error)
+{
+	return zif_store_overlay_query (store,
+					ZIF_STORE_OVERLAY_QUERY_WHAT_PROVIDES,
+					NULL, depends, 0, state, error);
+}
+
+/**
+ * zif_store_overlay_what_requires:
+ **/
+static GPtrArray *
+zif_store_overlay_what_requires (ZifStore *store,
+				 GPtrArray *depends,
+				 ZifState *state,
+				 GError **error)
+{
+	return zif_store_overlay_query (store,
+					ZIF_STORE_OVERLAY_QUERY_WHAT_REQUIRES,
+					NULL, depends, 0, state, error);
+}
+
+/**
+ * zif_store_overlay_what_obsoletes:
+ **/
+static GPtrArray *
+zif_store_overlay_what_obsoletes (ZifStore *store,
+				  GPtrArray *depends,
+				  ZifState *state,
+				  GError **error)
+{
+	return zif_store_overlay_query (store,
+					ZIF_STORE_OVERLAY_QUERY_WHAT_OBSOLETES,
+					NULL, depends, 0, state, error);
+}
+
+/**
+ * zif_store_overlay_what_conflicts:
+ **/
+static GPtrArray *
+zif_store_overlay_what_conflicts (ZifStore *store,
+				  GPtrArray *depends,
+				  ZifState *state,
+				  GError **error)
+{
+	return zif_store_overlay_query (store,
+					ZIF_STORE_OVERLAY_QUERY_WHAT_CONFLICTS,
+					NULL, depends, 0, state, error);
+}
+
+/**
+ * zif_store_overlay_get_packages:
+ *
+ * The merged view is cached until the next change to either the overlay
+ * or the base store, so repeated calls only cost a reference when
+ * nothing has been added or removed.
+ **/
+static GPtrArray *
+zif_store_overlay_get_packages (ZifStore *store,
+				ZifState *state,
+				GError **error)
+{
+	gboolean ret;
+	GError *error_local = NULL;
+	GPtrArray *array = NULL;
+	GPtrArray *array_base = NULL;
+	GPtrArray *array_added = NULL;
+	ZifState *state_local;
+	ZifStoreOverlay *overlay = ZIF_STORE_OVERLAY (store);
+	ZifStoreOverlayPrivate *priv = overlay->priv;
+
+	g_return_val_if_fail (ZIF_IS_STORE_OVERLAY (store), NULL);
+
+	if (priv->base == NULL) {
+		g_set_error_literal (error,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_FAILED,
+				     "no base store set");
+		goto out;
+	}
+
+	/* the base store changed under us */
+	if (priv->packages != NULL &&
+	    priv->base_changes != zif_store_get_changes (priv->base))
+		zif_store_overlay_invalidate (overlay);
+
+	/* nothing changed since last time */
+	if (priv->packages != NULL) {
+		array = g_ptr_array_ref (priv->packages);
+		goto out;
+	}
+
+	/* setup state */
+	ret = zif_state_set_steps (state,
+				   error,
+				   90, /* base */
+				   10, /* added */
+				   -1);
+	if (!ret)
+		goto out;
+
+	/* get the base packages */
+	state_local = zif_state_get_child (state);
+	array_base = zif_store_get_packages (priv->base, state_local, &error_local);
+	if (array_base == NULL) {
+		if (error_local->domain != ZIF_STORE_ERROR ||
+		    error_local->code != ZIF_STORE_ERROR_ARRAY_IS_EMPTY) {
+			g_propagate_error (error, error_local);
+			goto out;
+		}
+		g_clear_error (&error_local);
+	}
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
+
+	/* get the added packages */
+	state_local = zif_state_get_child (state);
+	array_added = zif_store_get_packages (priv->added, state_local, error);
+	if (array_added == NULL)
+		goto out;
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
+
+	/* no changes, so the base array can be shared */
+	if (array_base != NULL &&
+	    array_added->len == 0 &&
+	    g_hash_table_size (priv->removed) == 0) {
+		array = g_ptr_array_ref (array_base);
+		goto out;
+	}
+
+	/* cache the view until the next change */
+	priv->packages = zif_store_overlay_merge (overlay, array_base, array_added);
+	priv->base_changes = zif_store_get_changes (priv->base);
+	array = g_ptr_array_ref (priv->packages);
+out:
+	if (array_base != NULL)
+		g_ptr_array_unref (array_base);
+	if (array_added != NULL)
+		g_ptr_array_unref (array_added);
+	return array;
+}
+
+/**
+ * zif_store_overlay_find_package:
+ **/
+static ZifPackage *
+zif_store_overlay_find_package (ZifStore *store,
+				const gchar *package_id,
+				ZifState *state,
+				GError **error)
+{
+	gboolean ret;
+	gchar *package_id_basic = NULL;
+	GError *error_local = NULL;
+	ZifPackage *package = NULL;
+	ZifState *state_local;
+	ZifStoreOverlay *overlay = ZIF_STORE_OVERLAY (store);
+	ZifStoreOverlayPrivate *priv = overlay->priv;
+
+	g_return_val_if_fail (ZIF_IS_STORE_OVERLAY (store), NULL);
+
+	if (priv->base == NULL) {
+		g_set_error_literal (error,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_FAILED,
+				     "no base store set");
+		goto out;
+	}
+
+	/* setup state */
+	ret = zif_state_set_steps (state,
+				   error,
+				   10, /* added */
+				   90, /* base */
+				   -1);
+	if (!ret)
+		goto out;
+
+	/* try the added packages first */
+	if (zif_store_get_size (priv->added) > 0) {
+		state_local = zif_state_get_child (state);
+		package = zif_store_find_package (priv->added,
+						  package_id,
+						  state_local,
+						  &error_local);
+		if (package != NULL)
+			goto out;
+		if (error_local->domain != ZIF_STORE_ERROR ||
+		    error_local->code != ZIF_STORE_ERROR_FAILED_TO_FIND) {
+			g_propagate_error (error, error_local);
+			goto out;
+		}
+		g_clear_error (&error_local);
+	}
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
+
+	/* removed from the base store */
+	package_id_basic = zif_package_id_convert_basic (package_id);
+	if (g_hash_table_lookup (priv->removed, package_id_basic) != NULL) {
+		g_set_error_literal (error,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_FAILED_TO_FIND,
+				     "failed to find package");
+		goto out;
+	}
+
+	/* try the base store */
+	state_local = zif_state_get_child (state);
+	package = zif_store_find_package (priv->base,
+					  package_id,
+					  state_local,
+					  error);
+	if (package == NULL)
+		goto out;
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret) {
+		g_object_unref (package);
+		package = NULL;
+		goto out;
+	}
+out:
+	g_free (package_id_basic);
+	return package;
+}
+
+/**
+ * zif_store_overlay_has_package:
+ **/
+static gboolean
+zif_store_overlay_has_package (ZifStore *store, ZifPackage *package)
+{
+	ZifStoreOverlay *overlay = ZIF_STORE_OVERLAY (store);
+	ZifStoreOverlayPrivate *priv = overlay->priv;
+
+	if (zif_store_has_package (priv->added, package))
+		return TRUE;
+	if (priv->base == NULL)
+		return FALSE;
+	if (g_hash_table_lookup (priv->removed,
+				 zif_package_get_id_basic (package)) != NULL)
+		return FALSE;
+	return zif_store_has_package (priv->base, package);
+}
+
+/**
+ * zif_store_overlay_get_size:
+ *
+ * Packages are only hidden if they were in the base store, so the size
+ * can be worked out without building the merged view.
+ **/
+static guint
+zif_store_overlay_get_size (ZifStore *store)
+{
+	guint size;
+	guint size_base;
+	guint size_removed;
+	ZifStoreOverlay *overlay = ZIF_STORE_OVERLAY (store);
+	ZifStoreOverlayPrivate *priv = overlay->priv;
+
+	size = zif_store_get_size (priv->added);
+	if (priv->base == NULL)
+		return size;
+	size_base = zif_store_get_size (priv->base);
+	size_removed = g_hash_table_size (priv->removed);
+	if (size_base > size_removed)
+		size += size_base - size_removed;
+	return size;
+}
+
+/**
+ * zif_store_overlay_get_id:
+ **/
+static const gchar *
+zif_store_overlay_get_id (ZifStore *store)
+{
+	return "overlay";
+}
+
+/**
+ * zif_store_overlay_load:
+ **/
+static gboolean
+zif_store_overlay_load (ZifStore *store, ZifState *state, GError **error)
+{
+	ZifStoreOverlay *overlay = ZIF_STORE_OVERLAY (store);
+
+	g_return_val_if_fail (ZIF_IS_STORE_OVERLAY (store), FALSE);
+
+	if (overlay->priv->base == NULL) {
+		g_set_error_literal (error,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_FAILED,
+				     "no base store set");
+		return FALSE;
+	}
+	return zif_store_load (overlay->priv->base, state, error);
+}
+
+/**
+ * zif_store_overlay_get_memory_usage:
+ **/
+static void
+zif_store_overlay_get_memory_usage (ZifStore *store, ZifMemory *memory)
+{
+	ZifStoreOverlay *overlay = ZIF_STORE_OVERLAY (store);
+
+	if (overlay->priv->base != NULL)
+		zif_store_get_memory_usage (overlay->priv->base, memory);
+	zif_store_get_memory_usage (overlay->priv->added, memory);
+	zif_memory_add_hash_table (memory, overlay->priv->removed);
+	zif_memory_add_ptr_array (memory,
+				  ZIF_MEMORY_KIND_PACKAGES,
+				  overlay->priv->packages);
+}
+
+/**
+ * zif_store_overlay_finalize:
+ **/
+static void
+zif_store_overlay_finalize (GObject *object)
+{
+	ZifStoreOverlay *store;
+
+	g_return_if_fail (object != NULL);
+	g_return_if_fail (ZIF_IS_STORE_OVERLAY (object));
+	store = ZIF_STORE_OVERLAY (object);
+
+	if (store->priv->base != NULL)
+		g_object_unref (store->priv->base);
+	if (store->priv->packages != NULL)
+		g_ptr_array_unref (store->priv->packages);
+	g_object_unref (store->priv->added);
+	g_hash_table_unref (store->priv->removed);
+
+	G_OBJECT_CLASS (zif_store_overlay_parent_class)->finalize (object);
+}
+
+/**
+ * zif_store_overlay_class_init:
+ **/
+static void
+zif_store_overlay_class_init (ZifStoreOverlayClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	ZifStoreClass *store_class = ZIF_STORE_CLASS (klass);
+	object_class->finalize = zif_store_overlay_finalize;
+
+	/* map */
+	store_class->add_package = zif_store_overlay_add_package;
+	store_class->find_package = zif_store_overlay_find_package;
+	store_class->get_id = zif_store_overlay_get_id;
+	store_class->get_memory_usage = zif_store_overlay_get_memory_usage;
+	store_class->get_packages = zif_store_overlay_get_packages;
+	store_class->get_size = zif_store_overlay_get_size;
+	store_class->has_package = zif_store_overlay_has_package;
+	store_class->load = zif_store_overlay_load;
+	store_class->remove_package = zif_store_overlay_remove_package;
+	store_class->resolve = zif_store_overlay_resolve;
+	store_class->search_category = zif_store_overlay_search_category;
+	store_class->search_details = zif_store_overlay_search_details;
+	store_class->search_file = zif_store_overlay_search_file;
+	store_class->search_group = zif_store_overlay_search_group;
+	store_class->search_name = zif_store_overlay_search_name;
+	store_class->what_conflicts = zif_store_overlay_what_conflicts;
+	store_class->what_obsoletes = zif_store_overlay_what_obsoletes;
+	store_class->what_provides = zif_store_overlay_what_provides;
+	store_class->what_requires = zif_store_overlay_what_requires;
+
+	g_type_class_add_private (klass, sizeof (ZifStoreOverlayPrivate));
+}
+
+/**
+ * zif_store_overlay_init:
+ **/
+static void
+zif_store_overlay_init (ZifStoreOverlay *store)
+{
+	store->priv = ZIF_STORE_OVERLAY_GET_PRIVATE (store);
+	store->priv->added = zif_store_meta_new ();
+	store->priv->removed = g_hash_table_new_full (g_str_hash,
+						      g_str_equal,
+						      g_free,
+						      NULL);
+}
+
+/**
+ * zif_store_overlay_new:
+ *
+ * Return value: A new #ZifStoreOverlay instance.
+ *
+ * Since: 0.3.7
+ **/
+ZifStore *
+zif_store_overlay_new (void)
+{
+	ZifStoreOverlay *store_overlay;
+	store_overlay = g_object_new (ZIF_TYPE_STORE_OVERLAY,
+				      "enabled", TRUE,
+				      NULL);
+	return ZIF_STORE (store_overlay);
+}
@@ -0,0 +1,72 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2011 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#if !defined (__ZIF_H_INSIDE__) && !defined (ZIF_COMPILATION)
+#error "Only <zif.h> can be included directly."
+#endif
+
+#ifndef __ZIF_STORE_OVERLAY_H
+#define __ZIF_STORE_OVERLAY_H
+
+#include <glib-object.h>
+
+#include "zif-store.h"
+#include "zif-package.h"
+
+G_BEGIN_DECLS
+
+#define ZIF_TYPE_STORE_OVERLAY		(zif_store_overlay_get_type ())
+#define ZIF_STORE_OVERLAY(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), ZIF_TYPE_STORE_OVERLAY, ZifStoreOverlay))
+#define ZIF_STORE_OVERLAY_CLASS(k)	(G_TYPE_CHECK_CLASS_CAST((k), ZIF_TYPE_STORE_OVERLAY, ZifStoreOverlayClass))
+#define ZIF_IS_STORE_OVERLAY(o)		(G_TYPE_CHECK_INSTANCE_TYPE ((o), ZIF_TYPE_STORE_OVERLAY))
+#define ZIF_IS_STORE_OVERLAY_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), ZIF_TYPE_STORE_OVERLAY))
+#define ZIF_STORE_OVERLAY_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), ZIF_TYPE_STORE_OVERLAY, ZifStoreOverlayClass))
+
+typedef struct _ZifStoreOverlay		ZifStoreOverlay;
+typedef struct _ZifStoreOverlayPrivate	ZifStoreOverlayPrivate;
+typedef struct _ZifStoreOverlayClass	ZifStoreOverlayClass;
+
+struct _ZifStoreOverlay
+{
+	ZifStore		 parent;
+	ZifStoreOverlayPrivate	*priv;
+};
+
+struct _ZifStoreOverlayClass
+{
+	ZifStoreClass		 parent_class;
+	/* Padding for future expansion */
+	void (*_zif_reserved1) (void);
+	void (*_zif_reserved2) (void);
+	void (*_zif_reserved3) (void);
+	void (*_zif_reserved4) (void);
+};
+
+GType		 zif_store_overlay_get_type	(void);
+ZifStore	*zif_store_overlay_new		(void);
+void		 zif_store_overlay_set_base	(ZifStoreOverlay	*store,
+						 ZifStore		*base);
+ZifStore	*zif_store_overlay_get_base	(ZifStoreOverlay	*store);
+
+G_END_DECLS
+
+#endif /* __ZIF_STORE_OVERLAY_H */
+
@@ -31,6 +31,12 @@
 
 G_BEGIN_DECLS
 
+typedef struct {
+	gchar		*checksum;
+	guint64		 offset;
+	guint64		 length;
+} ZifStoreRemoteChunk;
+
 GPtrArray	*zif_store_remote_get_files		(ZifStoreRemote		*store,
 							 ZifPackage		*package,
 							 ZifState		*state,
@@ -57,6 +63,15 @@ gboolean	 zif_store_remote_download_repomd	(ZifStoreRemote		*store,
 const gchar	*zif_store_remote_get_local_directory	(ZifStoreRemote		*store);
 ZifMd		*zif_store_remote_get_md_from_type	(ZifStoreRemote		*store,
 							 ZifMdKind		 type);
+GPtrArray	*zif_store_remote_chunks_parse		(const gchar		*data,
+							 gchar			**comment,
+							 GError			**error);
+GHashTable	*zif_store_remote_search_category_newest (GPtrArray		*array);
+gboolean	 zif_store_remote_chunks_write		(GOutputStream		*stream,
+							 ZifStoreRemoteChunk	*chunk,
+							 const gchar		*data,
+							 GCancellable		*cancellable,
+							 GError			**error);
 
 G_END_DECLS
 
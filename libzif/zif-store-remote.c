@@ -34,6 +34,8 @@
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <gio/gio.h>
 
 #include "zif-category.h"
@@ -111,7 +113,9 @@ struct _ZifStoreRemotePrivate
 	ZifGroups		*groups;
 	GPtrArray		*packages;
 	ZifMdKind		 parser_type;
+	gchar			*chunks_location[ZIF_MD_KIND_LAST];
 	/* temp data for the xml parser */
+	gboolean		 parser_chunks;
 	ZifStoreRemoteParserSection parser_section;
 	GKeyFile		*file;
 };
@@ -239,6 +243,7 @@ zif_store_remote_parser_start_element (GMarkupParseContext *context, const gchar
 				       gpointer user_data, GError **error)
 {
 	guint i, j;
+	gchar *type = NULL;
 	ZifMd *md;
 	ZifStoreRemote *store = user_data;
 	GString *string;
@@ -248,36 +253,47 @@ zif_store_remote_parser_start_element (GMarkupParseContext *context, const gchar
 
 		/* reset */
 		store->priv->parser_type = ZIF_MD_KIND_UNKNOWN;
+		store->priv->parser_chunks = FALSE;
 
 		/* find type */
 		for (i = 0; attribute_names[i] != NULL; i++) {
 			if (g_strcmp0 (attribute_names[i], "type") == 0) {
-				if (g_strcmp0 (attribute_values[i], "primary") == 0)
+
+				/* chunk index for one of the other types */
+				if (g_str_has_suffix (attribute_values[i], "_chunks")) {
+					type = g_strndup (attribute_values[i],
+							  strlen (attribute_values[i]) - 7);
+					store->priv->parser_chunks = TRUE;
+				} else {
+					type = g_strdup (attribute_values[i]);
+				}
+
+				if (g_strcmp0 (type, "primary") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_PRIMARY_XML;
-				else if (g_strcmp0 (attribute_values[i], "primary_db") == 0)
+				else if (g_strcmp0 (type, "primary_db") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_PRIMARY_SQL;
-				else if (g_strcmp0 (attribute_values[i], "filelists") == 0)
+				else if (g_strcmp0 (type, "filelists") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_FILELISTS_XML;
-				else if (g_strcmp0 (attribute_values[i], "filelists_db") == 0)
+				else if (g_strcmp0 (type, "filelists_db") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_FILELISTS_SQL;
-				else if (g_strcmp0 (attribute_values[i], "other") == 0)
+				else if (g_strcmp0 (type, "other") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_OTHER_XML;
-				else if (g_strcmp0 (attribute_values[i], "other_db") == 0)
+				else if (g_strcmp0 (type, "other_db") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_OTHER_SQL;
-				else if (g_strcmp0 (attribute_values[i], "group") == 0)
+				else if (g_strcmp0 (type, "group") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_COMPS;
-				else if (g_strcmp0 (attribute_values[i], "group_gz") == 0)
+				else if (g_strcmp0 (type, "group_gz") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_COMPS_GZ;
-				else if (g_strcmp0 (attribute_values[i], "prestodelta") == 0)
+				else if (g_strcmp0 (type, "prestodelta") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_PRESTODELTA;
-				else if (g_strcmp0 (attribute_values[i], "updateinfo") == 0)
+				else if (g_strcmp0 (type, "updateinfo") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_UPDATEINFO;
-				else if (g_strcmp0 (attribute_values[i], "pkgtags") == 0)
+				else if (g_strcmp0 (type, "pkgtags") == 0)
 					store->priv->parser_type = ZIF_MD_KIND_PKGTAGS;
 				else {
 					/* we ignore anything else, but print an error to the console */
 					string = g_string_new ("");
-					g_string_append_printf (string, "unhandled data type '%s', expecting ", attribute_values[i]);
+					g_string_append_printf (string, "unhandled data type '%s', expecting ", type);
 
 					/* list all the types we support */
 					for (j=1; j < ZIF_MD_KIND_LAST; j++)
@@ -306,6 +322,19 @@ zif_store_remote_parser_start_element (GMarkupParseContext *context, const gchar
 	if (md == NULL)
 		goto out;
 
+	/* we only need to know where the chunk index is */
+	if (store->priv->parser_chunks) {
+		if (g_strcmp0 (element_name, "location") != 0)
+			goto out;
+		for (i = 0; attribute_names[i] != NULL; i++) {
+			if (g_strcmp0 (attribute_names[i], "href") == 0) {
+				g_free (store->priv->chunks_location[store->priv->parser_type]);
+				store->priv->chunks_location[store->priv->parser_type] = g_strdup (attribute_values[i]);
+			}
+		}
+		goto out;
+	}
+
 	/* location */
 	if (g_strcmp0 (element_name, "location") == 0) {
 		for (i = 0; attribute_names[i] != NULL; i++) {
@@ -353,6 +382,7 @@ zif_store_remote_parser_start_element (GMarkupParseContext *context, const gchar
 		goto out;
 	}
 out:
+	g_free (type);
 	return;
 }
 
@@ -367,8 +397,10 @@ zif_store_remote_parser_end_element (GMarkupParseContext *context, const gchar *
 
 	/* reset */
 	store->priv->parser_section = ZIF_STORE_REMOTE_PARSER_SECTION_UNKNOWN;
-	if (g_strcmp0 (element_name, "data") == 0)
+	if (g_strcmp0 (element_name, "data") == 0) {
 		store->priv->parser_type = ZIF_MD_KIND_UNKNOWN;
+		store->priv->parser_chunks = FALSE;
+	}
 }
 
 /**
@@ -386,6 +418,8 @@ zif_store_remote_parser_text (GMarkupParseContext *context, const gchar *text, g
 
 	if (store->priv->parser_type == ZIF_MD_KIND_UNKNOWN)
 		return;
+	if (store->priv->parser_chunks)
+		return;
 
 	/* get MetaData object */
 	md = zif_store_remote_get_md_from_type (store, store->priv->parser_type);
@@ -451,7 +485,15 @@ zif_store_remote_find_delta (ZifStoreRemote *store,
 			     ZifState *state,
 			     GError **error)
 {
+	gboolean ret;
+	gchar **names = NULL;
+	GError *error_local = NULL;
+	GPtrArray *array = NULL;
+	guint i;
 	ZifDelta *delta = NULL;
+	ZifPackage *package;
+	ZifState *state_local;
+	ZifStore *store_local = NULL;
 
 	/* nothing */
 	if (store->priv->md_delta == NULL) {
@@ -463,13 +505,66 @@ zif_store_remote_find_delta (ZifStoreRemote *store,
 		goto out;
 	}
 
+	/* setup steps */
+	if (zif_md_get_is_loaded (store->priv->md_delta)) {
+		zif_state_set_number_steps (state, 1);
+	} else {
+		ret = zif_state_set_steps (state,
+					   error,
+					   20, /* get installed */
+					   80, /* search */
+					   -1);
+		if (!ret)
+			goto out;
+
+		/* only parse deltas for packages that are installed */
+		store_local = zif_store_local_new ();
+		state_local = zif_state_get_child (state);
+		array = zif_store_get_packages (store_local, state_local, &error_local);
+		if (array == NULL) {
+			/* this is only an optimisation, so parse them all */
+			g_debug ("failed to get installed packages, not filtering deltas: %s",
+				 error_local->message);
+			g_clear_error (&error_local);
+		} else {
+			names = g_new0 (gchar *, array->len + 1);
+			for (i = 0; i < array->len; i++) {
+				package = g_ptr_array_index (array, i);
+				names[i] = g_strdup (zif_package_get_name (package));
+			}
+			zif_md_delta_set_installed_names (ZIF_MD_DELTA (store->priv->md_delta),
+							  names);
+		}
+
+		/* this section done */
+		ret = zif_state_done (state, error);
+		if (!ret)
+			goto out;
+	}
+
 	/* get delta if it exists */
+	state_local = zif_state_get_child (state);
 	delta = zif_md_delta_search_for_package (ZIF_MD_DELTA (store->priv->md_delta),
 						 zif_package_get_id (update),
 						 zif_package_get_id (installed),
-						 state,
+						 state_local,
 						 error);
+	if (delta == NULL)
+		goto out;
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret) {
+		g_object_unref (delta);
+		delta = NULL;
+		goto out;
+	}
 out:
+	g_strfreev (names);
+	if (array != NULL)
+		g_ptr_array_unref (array);
+	if (store_local != NULL)
+		g_object_unref (store_local);
 	return delta;
 }
 
@@ -678,6 +773,97 @@ zif_store_remote_download (ZifStoreRemote *store,
 					       error);
 }
 
+/**
+ * zif_store_remote_get_changelog:
+ * @store: A #ZifStoreRemote
+ * @package: A #ZifPackage from this repo
+ * @installed: The installed #ZifPackage, or %NULL
+ * @state: A #ZifState to use for progress reporting
+ * @error: A #GError, or %NULL
+ *
+ * Gets the changelog for a package. If @installed is set then only the
+ * entries newer than the installed package are returned, and the cut-off
+ * is done in the metadata query using the time the installed package was
+ * built, so packages with a very long changelog remain fast.
+ *
+ * Return value: (element-type ZifChangeset) (transfer container): the
+ * changesets, newest first, or %NULL for failure
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_store_remote_get_changelog (ZifStoreRemote *store,
+				ZifPackage *package,
+				ZifPackage *installed,
+				ZifState *state,
+				GError **error)
+{
+	gboolean ret;
+	GError *error_local = NULL;
+	GPtrArray *array = NULL;
+	ZifState *state_local;
+
+	g_return_val_if_fail (ZIF_IS_STORE_REMOTE (store), NULL);
+	g_return_val_if_fail (ZIF_IS_PACKAGE (package), NULL);
+	g_return_val_if_fail (installed == NULL || ZIF_IS_PACKAGE (installed), NULL);
+	g_return_val_if_fail (zif_state_valid (state), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* setup steps */
+	if (store->priv->loaded_metadata) {
+		zif_state_set_number_steps (state, 1);
+	} else {
+		ret = zif_state_set_steps (state,
+					   error,
+					   80, /* load metadata */
+					   20, /* get changelog */
+					   -1);
+		if (!ret)
+			goto out;
+	}
+
+	/* load metadata */
+	if (!store->priv->loaded_metadata) {
+		state_local = zif_state_get_child (state);
+		ret = zif_store_remote_load_metadata (store, state_local, error);
+		if (!ret)
+			goto out;
+
+		/* this section done */
+		ret = zif_state_done (state, error);
+		if (!ret)
+			goto out;
+	}
+
+	/* get the bounded changelog */
+	state_local = zif_state_get_child (state);
+	array = zif_md_other_sql_get_changelog_since (ZIF_MD_OTHER_SQL (store->priv->md_other_sql),
+						      zif_package_get_pkgid (package),
+						      installed != NULL ? zif_package_get_version (installed) : NULL,
+						      installed != NULL ? zif_package_get_time_file (installed) : 0,
+						      state_local,
+						      &error_local);
+	if (array == NULL) {
+		g_set_error (error,
+			     ZIF_STORE_ERROR,
+			     ZIF_STORE_ERROR_FAILED,
+			     "failed to get changelog: %s",
+			     error_local->message);
+		g_error_free (error_local);
+		goto out;
+	}
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret) {
+		g_ptr_array_unref (array);
+		array = NULL;
+		goto out;
+	}
+out:
+	return array;
+}
+
 /**
  * zif_store_remote_add_changelog:
  **/
@@ -686,10 +872,7 @@ zif_store_remote_add_changelog (ZifStoreRemote *store, ZifUpdate *update,
 				ZifPackageRemote *package_remote,
 				ZifState *state, GError **error)
 {
-	const gchar *pkgid;
-	const gchar *version;
 	gboolean ret = TRUE;
-	gchar **split_installed = NULL;
 	gchar *to_array[] = { NULL, NULL };
 	GError *error_local = NULL;
 	GPtrArray *array_installed = NULL;
@@ -709,36 +892,13 @@ zif_store_remote_add_changelog (ZifStoreRemote *store, ZifUpdate *update,
 	/* setup state */
 	ret = zif_state_set_steps (state,
 				   error,
-				   30, /* get changelog */
 				   60, /* resolve */
+				   30, /* get changelog */
 				   10, /* add changeset */
 				   -1);
 	if (!ret)
 		goto out;
 
-	/* get pkgid */
-	pkgid = zif_package_get_pkgid (ZIF_PACKAGE (package_remote));
-
-	/* get changelog and add to ZifUpdate */
-	state_local = zif_state_get_child (state);
-	changelog = zif_md_get_changelog (ZIF_MD (store->priv->md_other_sql),
-					  pkgid, state_local, &error_local);
-	if (changelog == NULL) {
-		ret = FALSE;
-		g_set_error (error,
-			     ZIF_STORE_ERROR,
-			     ZIF_STORE_ERROR_FAILED,
-			     "failed to get changelog: %s",
-			     error_local->message);
-		g_error_free (error_local);
-		goto out;
-	}
-
-	/* this section done */
-	ret = zif_state_done (state, error);
-	if (!ret)
-		goto out;
-
 	/* get the newest installed package with this name and arch */
 	state_local = zif_state_get_child (state);
 	store_local = zif_store_local_new ();
@@ -779,22 +939,29 @@ zif_store_remote_add_changelog (ZifStoreRemote *store, ZifUpdate *update,
 			g_error_free (error_local);
 			goto out;
 		}
-		split_installed = zif_package_id_split (zif_package_get_id (package_installed));
 	}
 
+	/* get only the changelog newer than what we have installed */
+	state_local = zif_state_get_child (state);
+	changelog = zif_store_remote_get_changelog (store,
+						    ZIF_PACKAGE (package_remote),
+						    package_installed,
+						    state_local,
+						    error);
+	if (changelog == NULL) {
+		ret = FALSE;
+		goto out;
+	}
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
+
 	/* add the changesets (the changelog) to the update */
 	for (i = 0; i < changelog->len; i++) {
 		changeset = g_ptr_array_index (changelog, i);
 		zif_update_add_changeset (update, changeset);
-
-		/* abort when the changeset is older than what we have installed */
-		if (split_installed != NULL) {
-			version = zif_changeset_get_version (changeset);
-			if (version != NULL &&
-			    zif_compare_evr (split_installed[ZIF_PACKAGE_ID_VERSION],
-					     version) >= 0)
-				break;
-		}
 	}
 
 	/* this section done */
@@ -802,7 +969,6 @@ zif_store_remote_add_changelog (ZifStoreRemote *store, ZifUpdate *update,
 	if (!ret)
 		goto out;
 out:
-	g_strfreev (split_installed);
 	if (package_installed != NULL)
 		g_object_unref (package_installed);
 	if (array_installed != NULL)
@@ -1136,6 +1302,12 @@ zif_store_remote_parse_repomd (ZifStoreRemote *store,
 	if (!ret)
 		goto out;
 
+	/* the repomd may have stopped offering chunk indexes */
+	for (i = 0; i < ZIF_MD_KIND_LAST; i++) {
+		g_free (store->priv->chunks_location[i]);
+		store->priv->chunks_location[i] = NULL;
+	}
+
 	/* create parser */
 	context = g_markup_parse_context_new (&gpk_store_remote_markup_parser,
 					      G_MARKUP_PREFIX_ERROR_POSITION,
@@ -1814,6 +1986,529 @@ out:
 	return ret;
 }
 
+typedef struct {
+	gchar		*filename;
+	GCancellable	*cancellable;
+	gboolean	 enable_profile;
+	gboolean	 enable_trace;
+	GError		*error;
+} ZifStoreRemoteDecompressItem;
+
+/**
+ * zif_store_remote_decompress_thread_cb:
+ **/
+static void
+zif_store_remote_decompress_thread_cb (gpointer data, gpointer user_data)
+{
+	ZifState *state;
+	ZifStoreRemoteDecompressItem *item = (ZifStoreRemoteDecompressItem *) data;
+
+	/* ZifState is not threadsafe, so use a private one */
+	state = zif_state_new ();
+	if (item->cancellable != NULL)
+		zif_state_set_cancellable (state, item->cancellable);
+	zif_state_set_enable_profile (state, item->enable_profile);
+	zif_state_set_enable_trace (state, item->enable_trace);
+	zif_store_file_decompress (item->filename, state, &item->error);
+	g_object_unref (state);
+}
+
+/**
+ * zif_store_remote_decompress_files:
+ *
+ * Decompress the independent metadata files in parallel, as for large
+ * repos this is dominated by CPU rather than disk time. No more
+ * threads than there are processors are used.
+ **/
+static gboolean
+zif_store_remote_decompress_files (GPtrArray *filenames,
+				   ZifState *state,
+				   GError **error)
+{
+	gboolean ret = TRUE;
+	glong cpus;
+	GThreadPool *pool;
+	guint i;
+	ZifStoreRemoteDecompressItem *items = NULL;
+
+	g_return_val_if_fail (zif_state_valid (state), FALSE);
+
+	/* nothing to do */
+	if (filenames->len == 0)
+		goto out;
+
+	/* queue each file */
+	cpus = sysconf (_SC_NPROCESSORS_ONLN);
+	if (cpus < 1)
+		cpus = 1;
+	zif_state_action_start (state, ZIF_STATE_ACTION_DECOMPRESSING, NULL);
+	items = g_new0 (ZifStoreRemoteDecompressItem, filenames->len);
+	pool = g_thread_pool_new (zif_store_remote_decompress_thread_cb,
+				  NULL,
+				  MIN ((guint) cpus, filenames->len),
+				  TRUE,
+				  NULL);
+	for (i = 0; i < filenames->len; i++) {
+		items[i].filename = g_ptr_array_index (filenames, i);
+		items[i].cancellable = zif_state_get_cancellable (state);
+		items[i].enable_profile = zif_state_get_enable_profile (state);
+		items[i].enable_trace = zif_state_get_enable_trace (state);
+		g_thread_pool_push (pool, &items[i], NULL);
+	}
+
+	/* wait for them all to finish, and report the first error */
+	g_thread_pool_free (pool, FALSE, TRUE);
+	for (i = 0; i < filenames->len; i++) {
+		if (items[i].error == NULL)
+			continue;
+		if (ret) {
+			ret = FALSE;
+			g_set_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED,
+				     "failed to decompress %s: %s",
+				     items[i].filename,
+				     items[i].error->message);
+		}
+		g_error_free (items[i].error);
+	}
+	zif_state_action_stop (state);
+out:
+	g_free (items);
+	return ret;
+}
+
+/**
+ * zif_store_remote_chunk_free:
+ **/
+static void
+zif_store_remote_chunk_free (ZifStoreRemoteChunk *chunk)
+{
+	g_free (chunk->checksum);
+	g_free (chunk);
+}
+
+/**
+ * zif_store_remote_chunks_parse:
+ * @data: The contents of the chunk index
+ * @comment: The location to store the first comment, or %NULL
+ * @error: A #GError, or %NULL
+ *
+ * Parses a chunk index, where each line describes a byte range of the
+ * compressed metadata file, in order, and without any gaps:
+ *
+ * # comment
+ * <sha256> <offset> <length>
+ *
+ * Each chunk is compressed independently on the server so that chunks
+ * for unchanged packages have the same checksum in each new version.
+ *
+ * Return value: (element-type ZifStoreRemoteChunk): The chunks, or %NULL
+ *
+ * Since: 0.3.7
+ **/
+GPtrArray *
+zif_store_remote_chunks_parse (const gchar *data, gchar **comment, GError **error)
+{
+	gchar **lines;
+	gchar **split;
+	GPtrArray *array = NULL;
+	GPtrArray *chunks;
+	guint64 offset = 0;
+	guint i;
+	ZifStoreRemoteChunk *chunk;
+
+	chunks = g_ptr_array_new_with_free_func ((GDestroyNotify) zif_store_remote_chunk_free);
+	lines = g_strsplit (data, "\n", -1);
+	for (i = 0; lines[i] != NULL; i++) {
+		if (lines[i][0] == '\0')
+			continue;
+
+		/* the first comment is the basename of the file */
+		if (lines[i][0] == '#') {
+			if (comment != NULL && *comment == NULL)
+				*comment = g_strdup (g_strstrip (lines[i] + 1));
+			continue;
+		}
+
+		split = g_strsplit (lines[i], " ", -1);
+		if (g_strv_length (split) != 3 ||
+		    strlen (split[0]) != 64) {
+			g_set_error (error,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_FAILED,
+				     "invalid chunk index line: %s",
+				     lines[i]);
+			g_strfreev (split);
+			goto out;
+		}
+		chunk = g_new0 (ZifStoreRemoteChunk, 1);
+		chunk->checksum = g_strdup (split[0]);
+		chunk->offset = g_ascii_strtoull (split[1], NULL, 10);
+		chunk->length = g_ascii_strtoull (split[2], NULL, 10);
+		g_ptr_array_add (chunks, chunk);
+		g_strfreev (split);
+
+		/* the chunks have to describe the whole file */
+		if (chunk->offset != offset || chunk->length == 0) {
+			g_set_error (error,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_FAILED,
+				     "chunk at %" G_GUINT64_FORMAT " is not contiguous",
+				     chunk->offset);
+			goto out;
+		}
+		offset += chunk->length;
+	}
+
+	/* nothing */
+	if (chunks->len == 0) {
+		g_set_error_literal (error,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_FAILED,
+				     "chunk index is empty");
+		goto out;
+	}
+
+	/* success */
+	array = g_ptr_array_ref (chunks);
+out:
+	g_strfreev (lines);
+	g_ptr_array_unref (chunks);
+	return array;
+}
+
+/**
+ * zif_store_remote_chunks_save:
+ **/
+static gboolean
+zif_store_remote_chunks_save (GPtrArray *chunks,
+			      const gchar *basename,
+			      const gchar *filename,
+			      GError **error)
+{
+	gboolean ret;
+	GString *string;
+	guint i;
+	ZifStoreRemoteChunk *chunk;
+
+	string = g_string_new ("");
+	g_string_append_printf (string, "# %s\n", basename);
+	for (i = 0; i < chunks->len; i++) {
+		chunk = g_ptr_array_index (chunks, i);
+		g_string_append_printf (string,
+					"%s %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT "\n",
+					chunk->checksum,
+					chunk->offset,
+					chunk->length);
+	}
+	ret = g_file_set_contents (filename, string->str, -1, error);
+	g_string_free (string, TRUE);
+	return ret;
+}
+
+/**
+ * zif_store_remote_chunks_write:
+ * @stream: A #GOutputStream
+ * @chunk: A #ZifStoreRemoteChunk
+ * @data: The chunk data, which must be at least the length of @chunk
+ * @cancellable: a #GCancellable, or %NULL
+ * @error: A #GError, or %NULL
+ *
+ * Verifies the data against the checksum in the index, and then
+ * writes it to the reassembled file.
+ *
+ * Return value: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_store_remote_chunks_write (GOutputStream *stream,
+			       ZifStoreRemoteChunk *chunk,
+			       const gchar *data,
+			       GCancellable *cancellable,
+			       GError **error)
+{
+	gboolean ret;
+	gchar *checksum;
+
+	/* never trust the index */
+	checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+						(const guchar *) data,
+						chunk->length);
+	if (g_strcmp0 (checksum, chunk->checksum) != 0) {
+		ret = FALSE;
+		g_set_error (error,
+			     ZIF_STORE_ERROR,
+			     ZIF_STORE_ERROR_FAILED,
+			     "chunk at %" G_GUINT64_FORMAT " has checksum %s, expected %s",
+			     chunk->offset, checksum, chunk->checksum);
+		goto out;
+	}
+	ret = g_output_stream_write_all (stream, data, chunk->length,
+					 NULL, cancellable, error);
+out:
+	g_free (checksum);
+	return ret;
+}
+
+/**
+ * zif_store_remote_refresh_md_chunked:
+ *
+ * Reassembles the new compressed metadata file using the chunks that are
+ * unchanged in the previous version, and only downloads the changed
+ * chunks using Range requests.
+ **/
+static gboolean
+zif_store_remote_refresh_md_chunked (ZifStoreRemote *remote,
+				     ZifMd *md,
+				     ZifState *state,
+				     GError **error)
+{
+	const gchar *chunks_location;
+	const gchar *data_tmp;
+	gboolean *have_local = NULL;
+	gboolean ret;
+	gchar *basename = NULL;
+	gchar *basename_old = NULL;
+	gchar *contents = NULL;
+	gchar *filename_index = NULL;
+	gchar *filename_local_index = NULL;
+	gchar *filename_old = NULL;
+	gchar *filename_tmp = NULL;
+	GByteArray *data = NULL;
+	GCancellable *cancellable;
+	GFile *file = NULL;
+	GFileOutputStream *stream = NULL;
+	GHashTable *hash_old = NULL;
+	GMappedFile *mapped_old = NULL;
+	GPtrArray *chunks = NULL;
+	GPtrArray *chunks_old = NULL;
+	guint64 length;
+	guint64 size_downloaded = 0;
+	guint64 size_reused = 0;
+	guint i;
+	guint j;
+	guint runs = 0;
+	ZifStoreRemoteChunk *chunk;
+	ZifStoreRemoteChunk *chunk_old;
+	ZifState *state_local;
+
+	/* setup steps */
+	ret = zif_state_set_steps (state,
+				   error,
+				   5, /* download index */
+				   5, /* load old index */
+				   80, /* reassemble */
+				   10, /* check */
+				   -1);
+	if (!ret)
+		goto out;
+
+	/* get the new chunk index */
+	chunks_location = remote->priv->chunks_location[zif_md_get_kind (md)];
+	basename = g_path_get_basename (chunks_location);
+	filename_index = g_build_filename (remote->priv->directory, basename, NULL);
+	g_free (basename);
+	state_local = zif_state_get_child (state);
+	ret = zif_download_location (remote->priv->download,
+				     chunks_location,
+				     filename_index,
+				     state_local,
+				     error);
+	if (!ret)
+		goto out;
+	ret = g_file_get_contents (filename_index, &contents, NULL, error);
+	if (!ret)
+		goto out;
+	chunks = zif_store_remote_chunks_parse (contents, NULL, error);
+	if (chunks == NULL) {
+		ret = FALSE;
+		goto out;
+	}
+	g_free (contents);
+	contents = NULL;
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
+
+	/* get the chunk index for the previous version, which is not fatal */
+	hash_old = g_hash_table_new (g_str_hash, g_str_equal);
+	filename_local_index = g_strdup_printf ("%s/%s.chunks",
+						remote->priv->directory,
+						zif_md_kind_to_text (zif_md_get_kind (md)));
+	if (g_file_get_contents (filename_local_index, &contents, NULL, NULL)) {
+		chunks_old = zif_store_remote_chunks_parse (contents, &basename_old, NULL);
+		if (chunks_old != NULL && basename_old != NULL) {
+			filename_old = g_build_filename (remote->priv->directory,
+							 basename_old, NULL);
+			mapped_old = g_mapped_file_new (filename_old, FALSE, NULL);
+		}
+		if (mapped_old != NULL) {
+			for (i = 0; i < chunks_old->len; i++) {
+				chunk_old = g_ptr_array_index (chunks_old, i);
+				if (chunk_old->offset + chunk_old->length > g_mapped_file_get_length (mapped_old))
+					break;
+				g_hash_table_insert (hash_old, chunk_old->checksum, chunk_old);
+			}
+		}
+	}
+
+	/* work out which chunks we already have */
+	have_local = g_new0 (gboolean, chunks->len);
+	for (i = 0; i < chunks->len; i++) {
+		chunk = g_ptr_array_index (chunks, i);
+		chunk_old = g_hash_table_lookup (hash_old, chunk->checksum);
+		if (chunk_old != NULL && chunk_old->length == chunk->length)
+			have_local[i] = TRUE;
+		if (i == 0 || have_local[i] != have_local[i-1])
+			runs++;
+	}
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
+
+	/* write to a temp file */
+	cancellable = zif_state_get_cancellable (state);
+	filename_tmp = g_strdup_printf ("%s.tmp", zif_md_get_filename (md));
+	file = g_file_new_for_path (filename_tmp);
+	stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE,
+				 cancellable, error);
+	if (stream == NULL) {
+		ret = FALSE;
+		goto out;
+	}
+
+	/* copy or download each run of chunks */
+	state_local = zif_state_get_child (state);
+	zif_state_set_number_steps (state_local, runs);
+	data = g_byte_array_new ();
+	for (i = 0; i < chunks->len; i = j) {
+
+		/* copy each chunk from the old file */
+		if (have_local[i]) {
+			for (j = i; j < chunks->len && have_local[j]; j++) {
+				chunk = g_ptr_array_index (chunks, j);
+				chunk_old = g_hash_table_lookup (hash_old, chunk->checksum);
+				data_tmp = g_mapped_file_get_contents (mapped_old) + chunk_old->offset;
+				ret = zif_store_remote_chunks_write (G_OUTPUT_STREAM (stream),
+								     chunk, data_tmp,
+								     cancellable, error);
+				if (!ret)
+					goto out;
+				size_reused += chunk->length;
+			}
+		} else {
+			/* download the changed chunks in one request */
+			length = 0;
+			for (j = i; j < chunks->len && !have_local[j]; j++) {
+				chunk = g_ptr_array_index (chunks, j);
+				length += chunk->length;
+			}
+			chunk = g_ptr_array_index (chunks, i);
+			g_byte_array_set_size (data, 0);
+			ret = zif_download_location_range (remote->priv->download,
+							   zif_md_get_location (md),
+							   chunk->offset,
+							   length,
+							   data,
+							   zif_state_get_child (state_local),
+							   error);
+			if (!ret)
+				goto out;
+			size_downloaded += length;
+
+			/* verify and write each chunk */
+			data_tmp = (const gchar *) data->data;
+			for (; i < j; i++) {
+				chunk = g_ptr_array_index (chunks, i);
+				ret = zif_store_remote_chunks_write (G_OUTPUT_STREAM (stream),
+								     chunk, data_tmp,
+								     cancellable, error);
+				if (!ret)
+					goto out;
+				data_tmp += chunk->length;
+			}
+		}
+
+		/* this run done */
+		ret = zif_state_done (state_local, error);
+		if (!ret)
+			goto out;
+	}
+	ret = g_output_stream_close (G_OUTPUT_STREAM (stream), cancellable, error);
+	if (!ret)
+		goto out;
+	g_debug ("reused %" G_GUINT64_FORMAT " bytes and downloaded %" G_GUINT64_FORMAT " bytes for %s",
+		 size_reused, size_downloaded,
+		 zif_md_kind_to_text (zif_md_get_kind (md)));
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
+
+	/* the reassembled file has to match what repomd says */
+	if (g_rename (filename_tmp, zif_md_get_filename (md)) != 0) {
+		ret = FALSE;
+		g_set_error (error,
+			     ZIF_STORE_ERROR,
+			     ZIF_STORE_ERROR_FAILED,
+			     "failed to rename %s",
+			     filename_tmp);
+		goto out;
+	}
+	state_local = zif_state_get_child (state);
+	ret = zif_md_check_compressed (md, state_local, error);
+	if (!ret)
+		goto out;
+
+	/* save the index for next time, and remove the old file */
+	basename = g_path_get_basename (zif_md_get_filename (md));
+	ret = zif_store_remote_chunks_save (chunks, basename,
+					    filename_local_index, error);
+	if (ret && filename_old != NULL &&
+	    g_strcmp0 (basename_old, basename) != 0)
+		g_unlink (filename_old);
+	g_free (basename);
+	if (!ret)
+		goto out;
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
+out:
+	if (filename_index != NULL)
+		g_unlink (filename_index);
+	if (!ret && filename_tmp != NULL)
+		g_unlink (filename_tmp);
+	if (data != NULL)
+		g_byte_array_unref (data);
+	if (stream != NULL)
+		g_object_unref (stream);
+	if (file != NULL)
+		g_object_unref (file);
+	if (mapped_old != NULL)
+		g_mapped_file_unref (mapped_old);
+	if (hash_old != NULL)
+		g_hash_table_unref (hash_old);
+	if (chunks != NULL)
+		g_ptr_array_unref (chunks);
+	if (chunks_old != NULL)
+		g_ptr_array_unref (chunks_old);
+	g_free (have_local);
+	g_free (contents);
+	g_free (basename_old);
+	g_free (filename_index);
+	g_free (filename_local_index);
+	g_free (filename_old);
+	g_free (filename_tmp);
+	return ret;
+}
+
 /**
  * zif_store_remote_refresh_md:
  **/
@@ -1821,6 +2516,7 @@ static gboolean
 zif_store_remote_refresh_md (ZifStoreRemote *remote,
 			     ZifMd *md,
 			     gboolean force,
+			     GPtrArray *decompress_queue,
 			     ZifState *state,
 			     GError **error)
 {
@@ -1878,8 +2574,26 @@ zif_store_remote_refresh_md (ZifStoreRemote *remote,
 	if (!ret)
 		goto out;
 
-	/* download new file */
+	/* only download the chunks that have changed */
 	state_local = zif_state_get_child (state);
+	if (remote->priv->chunks_location[zif_md_get_kind (md)] != NULL) {
+		ret = zif_store_remote_refresh_md_chunked (remote,
+							   md,
+							   state_local,
+							   &error_local);
+		if (ret)
+			goto downloaded;
+		g_debug ("failed to refresh %s using chunks, "
+			 "falling back to full download: %s",
+			 zif_md_kind_to_text (zif_md_get_kind (md)),
+			 error_local->message);
+		g_clear_error (&error_local);
+		ret = zif_state_reset (state_local);
+		if (!ret)
+			goto out;
+	}
+
+	/* download new file */
 	filename = zif_md_get_location (md);
 	ret = zif_store_remote_download_full (remote,
 					      filename,
@@ -1899,15 +2613,24 @@ zif_store_remote_refresh_md (ZifStoreRemote *remote,
 		g_error_free (error_local);
 		goto out;
 	}
+downloaded:
 
 	/* this section done */
 	ret = zif_state_done (state, error);
 	if (!ret)
 		goto out;
 
+	/* decompress later, along with the other md files */
+	filename = zif_md_get_filename (md);
+	if (decompress_queue != NULL) {
+		if (zif_file_is_compressed_name (filename))
+			g_ptr_array_add (decompress_queue, g_strdup (filename));
+		ret = zif_state_done (state, error);
+		goto out;
+	}
+
 	/* decompress */
 	state_local = zif_state_get_child (state);
-	filename = zif_md_get_filename (md);
 	ret = zif_store_file_decompress (filename, state_local, &error_local);
 	if (!ret) {
 		g_set_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED,
@@ -1941,6 +2664,7 @@ zif_store_remote_refresh (ZifStore *store, gboolean force, ZifState *state, GErr
 	ZifMd *md;
 	guint i;
 	gboolean md_priority[ZIF_MD_KIND_LAST];
+	GPtrArray *decompress_queue = NULL;
 
 	g_return_val_if_fail (ZIF_IS_STORE_REMOTE (store), FALSE);
 	g_return_val_if_fail (remote->priv->id != NULL, FALSE);
@@ -1967,7 +2691,8 @@ zif_store_remote_refresh (ZifStore *store, gboolean force, ZifState *state, GErr
 				   error,
 				   15, /* download repomd */
 				   5, /* load metadata */
-				   80, /* refresh each metadata */
+				   65, /* refresh each metadata */
+				   15, /* decompress each metadata */
 				   -1);
 	if (!ret)
 		goto out;
@@ -2038,6 +2763,7 @@ zif_store_remote_refresh (ZifStore *store, gboolean force, ZifState *state, GErr
 	/* initialize failed state */
 	for (i = 0; i < ZIF_MD_KIND_LAST; i++)
 		md_priority[i] = FALSE;
+	decompress_queue = g_ptr_array_new_with_free_func (g_free);
 
 	/* refresh each repo type in a specific order, so we can avoid
 	 * downloading duplicate copies of the same data */
@@ -2070,7 +2796,12 @@ zif_store_remote_refresh (ZifStore *store, gboolean force, ZifState *state, GErr
 		if (md != NULL) {
 			/* refresh this md object */
 			state_loop = zif_state_get_child (state_local);
-			ret = zif_store_remote_refresh_md (remote, md, force, state_loop, error);
+			ret = zif_store_remote_refresh_md (remote,
+							   md,
+							   force,
+							   decompress_queue,
+							   state_loop,
+							   error);
 			if (!ret)
 				goto out;
 
@@ -2088,7 +2819,22 @@ skip:
 	ret = zif_state_done (state, error);
 	if (!ret)
 		goto out;
+
+	/* decompress all the new files in parallel */
+	state_local = zif_state_get_child (state);
+	ret = zif_store_remote_decompress_files (decompress_queue,
+						 state_local,
+						 error);
+	if (!ret)
+		goto out;
+
+	/* this section done */
+	ret = zif_state_done (state, error);
+	if (!ret)
+		goto out;
 out:
+	if (decompress_queue != NULL)
+		g_ptr_array_unref (decompress_queue);
 	return ret;
 }
 
@@ -2809,6 +3555,26 @@ zif_store_remote_print (ZifStore *store)
 	g_print ("enabled: %i\n", remote->priv->enabled);
 }
 
+/**
+ * zif_store_remote_get_memory_usage:
+ **/
+static void
+zif_store_remote_get_memory_usage (ZifStore *store, ZifMemory *memory)
+{
+	ZifStoreRemote *remote = ZIF_STORE_REMOTE (store);
+
+	g_return_if_fail (ZIF_IS_STORE_REMOTE (store));
+
+	zif_md_get_memory_usage (remote->priv->md_primary_sql, memory);
+	zif_md_get_memory_usage (remote->priv->md_primary_xml, memory);
+	zif_md_get_memory_usage (remote->priv->md_filelists_sql, memory);
+	zif_md_get_memory_usage (remote->priv->md_filelists_xml, memory);
+	zif_md_get_memory_usage (remote->priv->md_other_sql, memory);
+	zif_md_get_memory_usage (remote->priv->md_comps, memory);
+	zif_md_get_memory_usage (remote->priv->md_updateinfo, memory);
+	zif_md_get_memory_usage (remote->priv->md_delta, memory);
+}
+
 /**
  * zif_store_remote_resolve:
  **/
@@ -3018,19 +3784,72 @@ out:
 	return array;
 }
 
+/**
+ * zif_store_remote_search_category_newest:
+ * @array: (element-type ZifPackage): An array of packages
+ *
+ * Splits the results of a batched resolve by package name, keeping only
+ * the newest package for each name. The hash owns copies of the names,
+ * so it remains valid after @array and its packages are freed.
+ *
+ * Return value: A #GHashTable of name to #ZifPackage
+ *
+ * Since: 0.3.7
+ **/
+GHashTable *
+zif_store_remote_search_category_newest (GPtrArray *array)
+{
+	const gchar *name;
+	GHashTable *hash;
+	guint i;
+	ZifPackage *package;
+	ZifPackage *package_tmp;
+
+	hash = g_hash_table_new_full (g_str_hash, g_str_equal,
+				      g_free, (GDestroyNotify) g_object_unref);
+	for (i = 0; i < array->len; i++) {
+		package = g_ptr_array_index (array, i);
+		name = zif_package_get_name (package);
+		package_tmp = g_hash_table_lookup (hash, name);
+		if (package_tmp != NULL &&
+		    zif_package_compare_full (package, package_tmp,
+					      ZIF_PACKAGE_COMPARE_FLAG_CHECK_VERSION |
+					      ZIF_PACKAGE_COMPARE_FLAG_CHECK_ARCH) <= 0)
+			continue;
+		g_hash_table_insert (hash, g_strdup (name), g_object_ref (package));
+	}
+	return hash;
+}
+
 /**
  * zif_store_remote_search_category_resolve:
+ *
+ * Resolves all the package names in a group using one query on the
+ * local store and one query on the remote store, preferring the
+ * installed package if it exists.
+ *
+ * Return value: the packages in the same order as @names, where names
+ * that could not be found either installed or in this repo are ignored.
  **/
-static ZifPackage *
-zif_store_remote_search_category_resolve (ZifStore *store, const gchar *name, ZifState *state, GError **error)
+static GPtrArray *
+zif_store_remote_search_category_resolve (ZifStore *store,
+					  GPtrArray *names,
+					  ZifState *state,
+					  GError **error)
 {
+	const gchar *name;
 	gboolean ret;
-	ZifStore *store_local = NULL;
+	gchar **search = NULL;
 	GError *error_local = NULL;
+	GHashTable *hash_local = NULL;
+	GHashTable *hash_remote = NULL;
 	GPtrArray *array = NULL;
-	ZifPackage *package = NULL;
+	GPtrArray *array_missing = NULL;
+	GPtrArray *array_tmp = NULL;
+	guint i;
+	ZifPackage *package;
 	ZifState *state_local;
-	const gchar *to_array[] = { NULL, NULL };
+	ZifStore *store_local = NULL;
 
 	g_return_val_if_fail (zif_state_valid (state), NULL);
 
@@ -3045,65 +3864,87 @@ zif_store_remote_search_category_resolve (ZifStore *store, const gchar *name, Zi
 	if (!ret)
 		goto out;
 
-	/* is already installed? */
+	/* are they already installed? */
 	state_local = zif_state_get_child (state);
-	to_array[0] = name;
-	array = zif_store_resolve (store_local, (gchar**) to_array, state_local, &error_local);
-	if (array == NULL) {
+	search = g_new0 (gchar *, names->len + 1);
+	for (i = 0; i < names->len; i++)
+		search[i] = g_ptr_array_index (names, i);
+	array_tmp = zif_store_resolve (store_local, search, state_local, &error_local);
+	if (array_tmp == NULL) {
 		g_set_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED,
-			     "failed to resolve installed package %s: %s", name, error_local->message);
+			     "failed to resolve installed packages: %s",
+			     error_local->message);
 		g_error_free (error_local);
 		goto out;
 	}
+	hash_local = zif_store_remote_search_category_newest (array_tmp);
+	g_ptr_array_unref (array_tmp);
 
 	/* this section done */
 	ret = zif_state_done (state, error);
 	if (!ret)
 		goto out;
 
-	/* get newest, ignore error */
-	package = zif_package_array_get_newest (array, NULL);
-	if (package != NULL) {
-		/* we don't need to do the second part */
+	/* only look in the repo for the ones that are not installed */
+	array_missing = g_ptr_array_new ();
+	for (i = 0; i < names->len; i++) {
+		name = g_ptr_array_index (names, i);
+		if (g_hash_table_lookup (hash_local, name) == NULL)
+			g_ptr_array_add (array_missing, (gpointer) name);
+	}
+	if (array_missing->len == 0) {
+		hash_remote = g_hash_table_new (g_str_hash, g_str_equal);
 		ret = zif_state_done (state, error);
 		if (!ret)
 			goto out;
-		goto out;
-	}
-
-	/* clear array */
-	g_ptr_array_unref (array);
+	} else {
+		state_local = zif_state_get_child (state);
+		g_ptr_array_add (array_missing, NULL);
+		array_tmp = zif_store_resolve (store,
+					       (gchar **) array_missing->pdata,
+					       state_local,
+					       &error_local);
+		if (array_tmp == NULL) {
+			g_set_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED,
+				     "failed to resolve available packages: %s",
+				     error_local->message);
+			g_error_free (error_local);
+			goto out;
+		}
+		hash_remote = zif_store_remote_search_category_newest (array_tmp);
+		g_ptr_array_unref (array_tmp);
 
-	/* is available in this repo? */
-	state_local = zif_state_get_child (state);
-	to_array[0] = name;
-	array = zif_store_resolve (ZIF_STORE (store), (gchar**)to_array, state_local, &error_local);
-	if (array == NULL) {
-		g_set_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED,
-			     "failed to resolve installed package %s: %s", name, error_local->message);
-		g_error_free (error_local);
-		goto out;
+		/* this section done */
+		ret = zif_state_done (state, error);
+		if (!ret)
+			goto out;
 	}
 
-	/* this section done */
-	ret = zif_state_done (state, error);
-	if (!ret)
-		goto out;
-
-	/* get newest, ignore error */
-	package = zif_package_array_get_newest (array, NULL);
-	if (package != NULL)
-		goto out;
-
-	/* we suck */
-	g_set_error (error, ZIF_STORE_ERROR, ZIF_STORE_ERROR_FAILED_TO_FIND,
-		     "failed to resolve installed package %s installed or in this repo", name);
+	/* keep the order of the group */
+	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; i < names->len; i++) {
+		name = g_ptr_array_index (names, i);
+		package = g_hash_table_lookup (hash_local, name);
+		if (package == NULL)
+			package = g_hash_table_lookup (hash_remote, name);
+		if (package == NULL) {
+			g_debug ("Failed to find %s installed or in repo %s",
+				 name, zif_store_get_id (store));
+			continue;
+		}
+		g_ptr_array_add (array, g_object_ref (package));
+	}
 out:
-	if (array != NULL)
-		g_ptr_array_unref (array);
+	g_free (search);
+	if (array_missing != NULL)
+		g_ptr_array_unref (array_missing);
+	if (hash_local != NULL)
+		g_hash_table_unref (hash_local);
+	if (hash_remote != NULL)
+		g_hash_table_unref (hash_remote);
 	if (store_local != NULL)
 		g_object_unref (store_local);
-	return package;
+	return array;
 }
 
 /**
@@ -3118,11 +3959,7 @@ zif_store_remote_search_category (ZifStore *store, gchar **group_id, ZifState *s
 	GPtrArray *array_names = NULL;
 	ZifStoreRemote *remote = ZIF_STORE_REMOTE (store);
 	ZifState *state_local;
-	ZifState *state_loop;
-	ZifPackage *package;
-	const gchar *name;
 	const gchar *location;
-	guint i;
 
 	g_return_val_if_fail (ZIF_IS_STORE_REMOTE (store), NULL);
 	g_return_val_if_fail (remote->priv->id != NULL, NULL);
@@ -3203,48 +4040,18 @@ zif_store_remote_search_category (ZifStore *store, gchar **group_id, ZifState *s
 	if (!ret)
 		goto out;
 
-	/* setup state */
+	/* resolve all the names at once */
 	state_local = zif_state_get_child (state);
-	zif_state_set_number_steps (state_local, array_names->len);
-
-	/* results array */
-	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-
-	/* resolve names */
-	for (i = 0; i < array_names->len; i++) {
-		name = g_ptr_array_index (array_names, i);
-
-		/* state */
-		state_loop = zif_state_get_child (state_local);
-		package = zif_store_remote_search_category_resolve (store, name, state_loop, &error_local);
-		if (package == NULL) {
-			/* ignore when package isn't present */
-			if (error_local->code == ZIF_STORE_ERROR_FAILED_TO_FIND) {
-				g_clear_error (&error_local);
-				g_debug ("Failed to find %s installed or in repo %s", name, remote->priv->id);
-				ret = zif_state_finished (state_loop, error);
-				if (!ret)
-					goto out;
-				goto ignore_error;
-			}
-
-			g_set_error (error, error_local->domain, error_local->code,
-				     "failed to get resolve %s for %s: %s", name, group_id[0], error_local->message);
-			g_error_free (error_local);
-
-			/* undo all our hard work */
-			g_ptr_array_unref (array);
-			array = NULL;
-			goto out;
-		}
-
-		/* add to array */
-		g_ptr_array_add (array, package);
-ignore_error:
-		/* this section done */
-		ret = zif_state_done (state_local, error);
-		if (!ret)
-			goto out;
+	array = zif_store_remote_search_category_resolve (store,
+							  array_names,
+							  state_local,
+							  &error_local);
+	if (array == NULL) {
+		g_set_error (error, error_local->domain, error_local->code,
+			     "failed to resolve packages for %s: %s",
+			     group_id[0], error_local->message);
+		g_error_free (error_local);
+		goto out;
 	}
 
 	/* this section done */
@@ -4503,6 +5310,7 @@ zif_store_remote_file_monitor_cb (ZifMonitor *monitor, ZifStoreRemote *store)
 static void
 zif_store_remote_finalize (GObject *object)
 {
+	guint i;
 	ZifStoreRemote *store;
 
 	g_return_if_fail (object != NULL);
@@ -4520,6 +5328,8 @@ zif_store_remote_finalize (GObject *object)
 	g_free (store->priv->cache_dir);
 	g_free (store->priv->repomd_filename);
 	g_free (store->priv->directory);
+	for (i = 0; i < ZIF_MD_KIND_LAST; i++)
+		g_free (store->priv->chunks_location[i]);
 
 	if (store->priv->file != NULL)
 		g_key_file_free (store->priv->file);
@@ -4573,6 +5383,7 @@ zif_store_remote_class_init (ZifStoreRemoteClass *klass)
 	store_class->get_categories = zif_store_remote_get_categories;
 	store_class->get_id = zif_store_remote_get_id;
 	store_class->print = zif_store_remote_print;
+	store_class->get_memory_usage = zif_store_remote_get_memory_usage;
 
 	g_type_class_add_private (klass, sizeof (ZifStoreRemotePrivate));
 }
@@ -102,6 +102,11 @@ ZifUpdate	*zif_store_remote_get_update_detail	(ZifStoreRemote		*store,
 							 const gchar		*package_id,
 							 ZifState		*state,
 							 GError			**error);
+GPtrArray	*zif_store_remote_get_changelog		(ZifStoreRemote		*store,
+							 ZifPackage		*package,
+							 ZifPackage		*installed,
+							 ZifState		*state,
+							 GError			**error);
 void		 zif_store_remote_set_id		(ZifStoreRemote		*store,
 							 const gchar		*id);
 ZifDelta	*zif_store_remote_find_delta	 	(ZifStoreRemote		*store,
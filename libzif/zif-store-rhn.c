@@ -35,8 +35,10 @@
 #include <libsoup/soup.h>
 
 #include "zif-config.h"
+#include "zif-object-array.h"
 #include "zif-package-private.h"
 #include "zif-package-rhn.h"
+#include "zif-package-rhn-private.h"
 #include "zif-store-rhn.h"
 #include "zif-utils.h"
 
@@ -44,6 +46,7 @@
 
 struct _ZifStoreRhnPrivate
 {
+	gchar			*cache_dir;
 	gchar			*channel;
 	gchar			*server;
 	gchar			*session_key;
@@ -53,7 +56,8 @@ struct _ZifStoreRhnPrivate
 };
 
 /* picked from thin air */
-#define ZIF_STORE_RHN_MAX_THREADS	50
+#define ZIF_STORE_RHN_MAX_REQUESTS	4
+#define ZIF_STORE_RHN_BATCH_SIZE	50
 
 G_DEFINE_TYPE (ZifStoreRhn, zif_store_rhn, ZIF_TYPE_STORE)
 static gpointer zif_store_rhn_object = NULL;
@@ -102,8 +106,10 @@ zif_store_rhn_set_channel (ZifStoreRhn *store,
  * @precache: The data to cache, e.g. %ZIF_PACKAGE_RHN_PRECACHE_GET_DETAILS
  *
  * Sets the precache policy. Precaching slows down zif_store_load() but
- * dramatically speeds up any data access because each request is
- * multithreaded on up to 50 threads at once.
+ * dramatically speeds up any data access because the data for up to
+ * 50 packages is fetched in each multicall request, and up to 4
+ * requests are sent at once. The results are saved in the cache
+ * directory so they only have to be downloaded once.
  *
  * Since: 0.1.6
  **/
@@ -400,6 +406,10 @@ zif_store_rhn_add_package (ZifStore *store,
 					 rhn->priv->session_key);
 	zif_package_rhn_set_server (ZIF_PACKAGE_RHN (package_tmp),
 				    rhn->priv->server);
+	zif_package_rhn_set_session (ZIF_PACKAGE_RHN (package_tmp),
+				     rhn->priv->session);
+	zif_package_rhn_set_cache_dir (ZIF_PACKAGE_RHN (package_tmp),
+				       rhn->priv->cache_dir);
 
 	/* add it to the generic store */
 	ret = zif_store_add_package (store, package_tmp, error);
@@ -415,34 +425,237 @@ out:
 	return package;
 }
 
+/**
+ * zif_store_rhn_multicall_add:
+ **/
+static void
+zif_store_rhn_multicall_add (ZifStoreRhn *rhn,
+			     GValueArray *calls,
+			     ZifPackageRhn *package,
+			     ZifPackageRhnPrecache precache)
+{
+	GHashTable *call;
+	GValueArray *params;
+
+	params = soup_value_array_new_with_vals (G_TYPE_STRING, rhn->priv->session_key,
+						 G_TYPE_INT, zif_package_rhn_get_id (package),
+						 G_TYPE_INVALID);
+	call = soup_value_hash_new_with_vals ("methodName", G_TYPE_STRING,
+					      zif_package_rhn_precache_to_method (precache),
+					      "params", G_TYPE_VALUE_ARRAY, params,
+					      NULL);
+	soup_value_array_append (calls, G_TYPE_HASH_TABLE, call);
+	g_hash_table_unref (call);
+	g_value_array_free (params);
+}
+
+/**
+ * zif_store_rhn_multicall:
+ *
+ * Gets the data for a batch of packages using one system.multicall
+ * request, using any data already saved in the cache directory.
+ **/
+static gboolean
+zif_store_rhn_multicall (ZifStoreRhn *rhn,
+			 GPtrArray *packages,
+			 GError **error)
+{
+	const ZifPackageRhnPrecache kinds[] = {
+		ZIF_PACKAGE_RHN_PRECACHE_GET_DETAILS,
+		ZIF_PACKAGE_RHN_PRECACHE_LIST_FILES,
+		ZIF_PACKAGE_RHN_PRECACHE_LIST_DEPS };
+	gboolean ret = TRUE;
+	GArray *call_kinds;
+	GError *error_local = NULL;
+	GHashTable *fault;
+	GPtrArray *call_packages;
+	guint i;
+	guint j;
+	GValue *value;
+	GValueArray *calls;
+	GValueArray *results = NULL;
+	SoupMessage *msg = NULL;
+	ZifPackageRhn *package;
+	ZifPackageRhnPrecache kind;
+
+	/* build the list of calls */
+	calls = g_value_array_new (packages->len * G_N_ELEMENTS (kinds));
+	call_packages = g_ptr_array_new ();
+	call_kinds = g_array_new (FALSE, FALSE, sizeof (ZifPackageRhnPrecache));
+	for (i = 0; i < packages->len; i++) {
+		package = g_ptr_array_index (packages, i);
+		for (j = 0; j < G_N_ELEMENTS (kinds); j++) {
+			if ((rhn->priv->precache & kinds[j]) == 0)
+				continue;
+
+			/* read this from disk, or ask the server again if
+			 * the saved file is invalid */
+			if (zif_package_rhn_is_cached (package, kinds[j])) {
+				if (zif_package_rhn_load_cache (package,
+								kinds[j],
+								&error_local))
+					continue;
+				g_debug ("ignoring invalid cache: %s",
+					 error_local->message);
+				g_clear_error (&error_local);
+			}
+			zif_store_rhn_multicall_add (rhn, calls, package, kinds[j]);
+			g_ptr_array_add (call_packages, package);
+			g_array_append_val (call_kinds, kinds[j]);
+		}
+	}
+
+	/* everything was in the cache */
+	if (calls->n_values == 0)
+		goto out;
+
+	/* create request */
+	msg = soup_xmlrpc_request_new (rhn->priv->server,
+				       "system.multicall",
+				       G_TYPE_VALUE_ARRAY, calls,
+				       G_TYPE_INVALID);
+
+	/* send message */
+	soup_session_send_message (rhn->priv->session, msg);
+	ret = SOUP_STATUS_IS_SUCCESSFUL (msg->status_code);
+	if (!ret) {
+		g_set_error (error,
+			     ZIF_STORE_ERROR,
+			     ZIF_STORE_ERROR_FAILED,
+			     "%s (error #%d)",
+			     msg->reason_phrase,
+			     msg->status_code);
+		goto out;
+	}
+
+	/* get response */
+	ret = soup_xmlrpc_extract_method_response (msg->response_body->data,
+						   msg->response_body->length,
+						   &error_local,
+						   G_TYPE_VALUE_ARRAY, &results);
+	if (!ret) {
+		g_set_error (error,
+			     ZIF_STORE_ERROR,
+			     ZIF_STORE_ERROR_FAILED,
+			     "Could not parse XML-RPC response for %s (%i): %s",
+			     msg->response_body->data,
+			     (guint) msg->response_body->length,
+			     error_local->message);
+		g_error_free (error_local);
+		goto out;
+	}
+	if (results->n_values != calls->n_values) {
+		ret = FALSE;
+		g_set_error (error,
+			     ZIF_STORE_ERROR,
+			     ZIF_STORE_ERROR_FAILED,
+			     "multicall returned %i results for %i calls",
+			     results->n_values,
+			     calls->n_values);
+		goto out;
+	}
+
+	/* each result is either an array of one value, or a fault */
+	for (i = 0; i < results->n_values; i++) {
+		package = g_ptr_array_index (call_packages, i);
+		kind = g_array_index (call_kinds, ZifPackageRhnPrecache, i);
+		value = g_value_array_get_nth (results, i);
+		if (G_VALUE_HOLDS (value, G_TYPE_HASH_TABLE)) {
+			fault = g_value_get_boxed (value);
+			value = g_hash_table_lookup (fault, "faultString");
+			g_warning ("failed to %s for %s: %s",
+				   zif_package_rhn_precache_to_method (kind),
+				   zif_package_get_printable (ZIF_PACKAGE (package)),
+				   value != NULL ? g_value_get_string (value) : "unknown");
+			continue;
+		}
+		if (!G_VALUE_HOLDS (value, G_TYPE_VALUE_ARRAY) ||
+		    ((GValueArray *) g_value_get_boxed (value))->n_values != 1) {
+			ret = FALSE;
+			g_set_error (error,
+				     ZIF_STORE_ERROR,
+				     ZIF_STORE_ERROR_FAILED,
+				     "invalid multicall result for %s",
+				     zif_package_get_printable (ZIF_PACKAGE (package)));
+			goto out;
+		}
+		value = g_value_array_get_nth (g_value_get_boxed (value), 0);
+		ret = zif_package_rhn_set_value (package, kind, value, error);
+		if (!ret)
+			goto out;
+	}
+out:
+	if (results != NULL)
+		g_value_array_free (results);
+	if (msg != NULL)
+		g_object_unref (msg);
+	g_value_array_free (calls);
+	g_ptr_array_unref (call_packages);
+	g_array_unref (call_kinds);
+	return ret;
+}
+
 /**
  * zif_store_rhn_coldplug_cb:
  **/
 static void
-zif_store_rhn_coldplug_cb (ZifPackage *package, ZifStoreRhn *rhn)
+zif_store_rhn_coldplug_cb (GPtrArray *packages, ZifStoreRhn *rhn)
 {
 	gboolean ret;
 	GError *error = NULL;
 	GTimer *timer = g_timer_new ();
 
 	/* coldplug */
-	ret = zif_package_rhn_precache (ZIF_PACKAGE_RHN (package),
-					rhn->priv->precache,
-					&error);
+	ret = zif_store_rhn_multicall (rhn, packages, &error);
 	if (!ret) {
-		g_warning ("failed to precache %s: %s",
-			   zif_package_get_printable (package),
+		g_warning ("failed to precache %i packages: %s",
+			   packages->len,
 			   error->message);
 		g_error_free (error);
 		goto out;
 	}
-	g_debug ("coldplug of %s took %fms",
-		 zif_package_get_printable (package),
+	g_debug ("coldplug of %i packages took %fms",
+		 packages->len,
 		 g_timer_elapsed (timer, NULL) * 1000);
 out:
+	g_ptr_array_unref (packages);
 	g_timer_destroy (timer);
 }
 
+/**
+ * zif_store_rhn_setup_cache_dir:
+ **/
+static void
+zif_store_rhn_setup_cache_dir (ZifStoreRhn *rhn)
+{
+	gchar *cachedir;
+	GError *error = NULL;
+
+	g_free (rhn->priv->cache_dir);
+	rhn->priv->cache_dir = NULL;
+
+	/* not fatal, we just ask the server each time */
+	cachedir = zif_config_get_string (rhn->priv->config,
+					  "cachedir",
+					  &error);
+	if (cachedir == NULL) {
+		g_debug ("not caching RHN data: %s", error->message);
+		g_error_free (error);
+		goto out;
+	}
+	rhn->priv->cache_dir = g_build_filename (cachedir,
+						 "rhn",
+						 rhn->priv->channel,
+						 NULL);
+	if (g_mkdir_with_parents (rhn->priv->cache_dir, 0755) != 0) {
+		g_warning ("failed to create %s", rhn->priv->cache_dir);
+		g_free (rhn->priv->cache_dir);
+		rhn->priv->cache_dir = NULL;
+	}
+out:
+	g_free (cachedir);
+}
+
 /**
  * zif_store_rhn_load:
  **/
@@ -454,9 +667,10 @@ zif_store_rhn_load (ZifStore *store,
 	gboolean ret = TRUE;
 	GError *error_local = NULL;
 	GHashTable *hash;
+	GPtrArray *batch = NULL;
 	GThreadPool *pool = NULL;
 	guint i;
-	GArray *array = NULL;
+	GValueArray *array = NULL;
 	SoupMessage *msg = NULL;
 	ZifPackage *package;
 	ZifStoreRhn *rhn = ZIF_STORE_RHN (store);
@@ -493,6 +707,9 @@ zif_store_rhn_load (ZifStore *store,
 		goto out;
 	}
 
+	/* results are saved per-channel */
+	zif_store_rhn_setup_cache_dir (rhn);
+
 	/* get all the packages */
 	msg = soup_xmlrpc_request_new (rhn->priv->server,
 				       "channel.software.listLatestPackages",
@@ -517,7 +734,7 @@ zif_store_rhn_load (ZifStore *store,
 	ret = soup_xmlrpc_extract_method_response (msg->response_body->data,
 						   msg->response_body->length,
 						   &error_local,
-						   G_TYPE_ARRAY, &array);
+						   G_TYPE_VALUE_ARRAY, &array);
 	if (!ret) {
 		g_set_error (error,
 			     ZIF_STORE_ERROR,
@@ -537,24 +754,35 @@ zif_store_rhn_load (ZifStore *store,
 
 	/* optionally coldplug all the RHN packages */
 	pool = g_thread_pool_new ((GFunc) zif_store_rhn_coldplug_cb,
-				  rhn, ZIF_STORE_RHN_MAX_THREADS, TRUE, NULL);
+				  rhn, ZIF_STORE_RHN_MAX_REQUESTS, TRUE, NULL);
 
 	/* get packages */
-	g_debug ("got %i elements", array->len);
-	for (i = 0; i < array->len; i++) {
-		hash = g_array_index (array, GHashTable *, i);
+	g_debug ("got %i elements", array->n_values);
+	for (i = 0; i < array->n_values; i++) {
+		hash = g_value_get_boxed (g_value_array_get_nth (array, i));
 		package = zif_store_rhn_add_package (store, hash, error);
 		if (package == NULL) {
 			ret = FALSE;
 			goto out;
 		}
 
-		/* coldplug this */
-		if (rhn->priv->precache > 0)
-			g_thread_pool_push (pool, package, NULL);
+		/* coldplug these in batches */
+		if (rhn->priv->precache > 0) {
+			if (batch == NULL)
+				batch = zif_object_array_new ();
+			zif_object_array_add (batch, package);
+			if (batch->len == ZIF_STORE_RHN_BATCH_SIZE) {
+				g_thread_pool_push (pool, batch, NULL);
+				batch = NULL;
+			}
+		}
 
 		g_object_unref (package);
 	}
+	if (batch != NULL) {
+		g_thread_pool_push (pool, batch, NULL);
+		batch = NULL;
+	}
 
 	/* this section done */
 	ret = zif_state_done (state, error);
@@ -563,8 +791,10 @@ zif_store_rhn_load (ZifStore *store,
 out:
 	if (pool != NULL)
 		g_thread_pool_free (pool, FALSE, TRUE);
+	if (batch != NULL)
+		g_ptr_array_unref (batch);
 	if (array != NULL)
-		g_array_free (array, TRUE);
+		g_value_array_free (array);
 	if (msg != NULL)
 		g_object_unref (msg);
 	return ret;
@@ -595,6 +825,7 @@ zif_store_rhn_finalize (GObject *object)
 	g_object_unref (store->priv->config);
 	g_object_unref (store->priv->session);
 	g_free (store->priv->session_key);
+	g_free (store->priv->cache_dir);
 	g_free (store->priv->channel);
 	g_free (store->priv->server);
 
@@ -626,7 +857,9 @@ zif_store_rhn_init (ZifStoreRhn *store)
 {
 	store->priv = ZIF_STORE_RHN_GET_PRIVATE (store);
 	store->priv->config = zif_config_new ();
-	store->priv->session = soup_session_sync_new ();
+	store->priv->session = soup_session_sync_new_with_options (SOUP_SESSION_MAX_CONNS_PER_HOST,
+								   ZIF_STORE_RHN_MAX_REQUESTS,
+								   NULL);
 }
 
 /**
@@ -40,6 +40,7 @@
 #include "zif-package-array-private.h"
 #include "zif-package.h"
 #include "zif-store.h"
+#include "zif-store-private.h"
 #include "zif-utils-private.h"
 
 #define ZIF_STORE_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), ZIF_TYPE_STORE, ZifStorePrivate))
@@ -48,9 +49,15 @@ struct _ZifStorePrivate
 {
 	GPtrArray		*packages;
 	GHashTable		*package_id_hash;
+	GArray			*name_index;		/* of guint, sorted by name */
+	GHashTable		*hash_name;		/* of GPtrArray of ZifPackage */
+	GHashTable		*hash_name_arch;
+	GHashTable		*hash_name_version;
+	GHashTable		*hash_name_version_arch;
 	gboolean		 is_local;
 	gboolean		 loaded;
 	gboolean		 enabled;
+	guint			 changes;		/* bumped when packages change */
 };
 
 enum {
@@ -62,6 +69,91 @@ enum {
 
 G_DEFINE_TYPE (ZifStore, zif_store, G_TYPE_OBJECT)
 
+/**
+ * zif_store_invalidate_index:
+ **/
+static void
+zif_store_invalidate_index (ZifStore *store)
+{
+	store->priv->changes++;
+	if (store->priv->name_index != NULL) {
+		g_array_unref (store->priv->name_index);
+		store->priv->name_index = NULL;
+	}
+}
+
+/**
+ * zif_store_hash_add:
+ **/
+static void
+zif_store_hash_add (GHashTable *hash, const gchar *key, ZifPackage *package)
+{
+	GPtrArray *array;
+
+	if (key == NULL)
+		return;
+	array = g_hash_table_lookup (hash, key);
+	if (array == NULL) {
+		array = g_ptr_array_new ();
+		g_hash_table_insert (hash, g_strdup (key), array);
+	}
+	g_ptr_array_add (array, package);
+}
+
+/**
+ * zif_store_hash_remove:
+ **/
+static void
+zif_store_hash_remove (GHashTable *hash, const gchar *key, ZifPackage *package)
+{
+	GPtrArray *array;
+
+	if (key == NULL)
+		return;
+	array = g_hash_table_lookup (hash, key);
+	if (array == NULL)
+		return;
+	g_ptr_array_remove (array, package);
+	if (array->len == 0)
+		g_hash_table_remove (hash, key);
+}
+
+/**
+ * zif_store_hash_update:
+ *
+ * Keeps the exact-match indexes in sync with the package array. The
+ * arrays in the indexes do not hold a reference as the package is
+ * always owned by priv->packages for as long as it is indexed.
+ **/
+static void
+zif_store_hash_update (ZifStore *store, ZifPackage *package, gboolean add)
+{
+	void (*func) (GHashTable *, const gchar *, ZifPackage *);
+	ZifStorePrivate *priv = store->priv;
+
+	func = add ? zif_store_hash_add : zif_store_hash_remove;
+	func (priv->hash_name,
+	      zif_package_get_name (package), package);
+	func (priv->hash_name_arch,
+	      zif_package_get_name_arch (package), package);
+	func (priv->hash_name_version,
+	      zif_package_get_name_version (package), package);
+	func (priv->hash_name_version_arch,
+	      zif_package_get_name_version_arch (package), package);
+}
+
+/**
+ * zif_store_hash_clear:
+ **/
+static void
+zif_store_hash_clear (ZifStore *store)
+{
+	g_hash_table_remove_all (store->priv->hash_name);
+	g_hash_table_remove_all (store->priv->hash_name_arch);
+	g_hash_table_remove_all (store->priv->hash_name_version);
+	g_hash_table_remove_all (store->priv->hash_name_version_arch);
+}
+
 /**
  * zif_store_error_quark:
  *
@@ -98,11 +190,18 @@ zif_store_add_package (ZifStore *store,
 	const gchar *key;
 	gboolean ret = TRUE;
 	ZifPackage *package_tmp;
+	ZifStoreClass *klass = ZIF_STORE_GET_CLASS (store);
 
 	g_return_val_if_fail (ZIF_IS_STORE (store), FALSE);
 	g_return_val_if_fail (ZIF_IS_PACKAGE (package), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* superclass */
+	if (klass->add_package != NULL) {
+		ret = klass->add_package (store, package, error);
+		goto out;
+	}
+
 	/* check it's not already added */
 	key = zif_package_get_id_basic (package);
 	package_tmp = g_hash_table_lookup (store->priv->package_id_hash, key);
@@ -117,10 +216,12 @@ zif_store_add_package (ZifStore *store,
 	}
 
 	/* just add */
+	zif_store_invalidate_index (store);
 	zif_object_array_add (store->priv->packages, package);
 	g_hash_table_insert (store->priv->package_id_hash,
 			     g_strdup (key),
 			     package);
+	zif_store_hash_update (store, package, TRUE);
 out:
 	return ret;
 }
@@ -180,11 +281,18 @@ zif_store_remove_package (ZifStore *store,
 	const gchar *key;
 	gboolean ret = TRUE;
 	GObject *package_tmp;
+	ZifStoreClass *klass = ZIF_STORE_GET_CLASS (store);
 
 	g_return_val_if_fail (ZIF_IS_STORE (store), FALSE);
 	g_return_val_if_fail (ZIF_IS_PACKAGE (package), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* superclass */
+	if (klass->remove_package != NULL) {
+		ret = klass->remove_package (store, package, error);
+		goto out;
+	}
+
 	/* check it's not already removed */
 	key = zif_package_get_id_basic (package);
 	package_tmp = g_hash_table_lookup (store->priv->package_id_hash, key);
@@ -199,6 +307,8 @@ zif_store_remove_package (ZifStore *store,
 	}
 
 	/* just remove */
+	zif_store_invalidate_index (store);
+	zif_store_hash_update (store, ZIF_PACKAGE (package_tmp), FALSE);
 	g_ptr_array_remove (store->priv->packages, package_tmp);
 	g_hash_table_remove (store->priv->package_id_hash, key);
 out:
@@ -240,6 +350,34 @@ zif_store_remove_packages (ZifStore *store,
 	return ret;
 }
 
+/**
+ * zif_store_has_package:
+ * @store: A #ZifStore
+ * @package: A #ZifPackage
+ *
+ * Finds out if a package with the same name, version and architecture
+ * has been added to the store. This does not load the store.
+ *
+ * Return value: %TRUE if the package is in the store
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_store_has_package (ZifStore *store, ZifPackage *package)
+{
+	ZifStoreClass *klass = ZIF_STORE_GET_CLASS (store);
+
+	g_return_val_if_fail (ZIF_IS_STORE (store), FALSE);
+	g_return_val_if_fail (ZIF_IS_PACKAGE (package), FALSE);
+
+	/* superclass */
+	if (klass->has_package != NULL)
+		return klass->has_package (store, package);
+
+	return g_hash_table_lookup (store->priv->package_id_hash,
+				    zif_package_get_id_basic (package)) != NULL;
+}
+
 /**
  * zif_store_load:
  * @store: A #ZifStore
@@ -270,8 +408,10 @@ zif_store_load (ZifStore *store, ZifState *state, GError **error)
 	}
 
 	/* ensure any previous store is cleared */
+	zif_store_invalidate_index (store);
 	g_ptr_array_set_size (store->priv->packages, 0);
 	g_hash_table_remove_all (store->priv->package_id_hash);
+	zif_store_hash_clear (store);
 
 	/* all superclasses must implement load */
 	if (klass->load == NULL) {
@@ -877,13 +1017,12 @@ zif_store_search_file (ZifStore *store,
 		       ZifState *state,
 		       GError **error)
 {
-	const gchar *filename;
 	gboolean ret;
 	GError *error_local = NULL;
 	GPtrArray *array = NULL;
 	GPtrArray *array_tmp = NULL;
-	GPtrArray *files;
-	guint i, j, l;
+	guint i, l;
+	ZifFileList *files;
 	ZifPackage *package;
 	ZifState *state_local = NULL;
 	ZifState *state_loop = NULL;
@@ -952,7 +1091,7 @@ zif_store_search_file (ZifStore *store,
 	for (i = 0; i < store->priv->packages->len; i++) {
 		package = g_ptr_array_index (store->priv->packages, i);
 		state_loop = zif_state_get_child (state_local);
-		files = zif_package_get_files (package, state_loop, &error_local);
+		files = zif_package_get_file_list (package, state_loop, &error_local);
 		if (files == NULL) {
 			g_set_error (error,
 				     ZIF_STORE_ERROR,
@@ -962,16 +1101,11 @@ zif_store_search_file (ZifStore *store,
 			g_error_free (error_local);
 			goto out;
 		}
-		for (j = 0; j < files->len; j++) {
-			filename = g_ptr_array_index (files, j);
-			for (l=0; search[l] != NULL; l++) {
-				if (g_strcmp0 (search[l], filename) == 0) {
-					g_ptr_array_add (array_tmp, g_object_ref (package));
-					break;
-				}
-			}
+		for (l = 0; search[l] != NULL; l++) {
+			if (zif_file_list_contains (files, search[l]))
+				g_ptr_array_add (array_tmp, g_object_ref (package));
 		}
-		g_ptr_array_unref (files);
+		zif_file_list_unref (files);
 
 		/* this section done */
 		ret = zif_state_done (state_local, error);
@@ -1008,6 +1142,201 @@ zif_store_has_search_arch_suffix (const gchar *search)
 	return FALSE;
 }
 
+/**
+ * zif_store_name_index_sort_cb:
+ **/
+static gint
+zif_store_name_index_sort_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	GPtrArray *packages = (GPtrArray *) user_data;
+	ZifPackage *package_a;
+	ZifPackage *package_b;
+	package_a = g_ptr_array_index (packages, *((const guint *) a));
+	package_b = g_ptr_array_index (packages, *((const guint *) b));
+	return g_strcmp0 (zif_package_get_name (package_a),
+			  zif_package_get_name (package_b));
+}
+
+/**
+ * zif_store_name_index_lower_bound:
+ *
+ * Returns the first position in the name index where the name is not
+ * less than @name.
+ **/
+static guint
+zif_store_name_index_lower_bound (ZifStore *store, const gchar *name, gsize len)
+{
+	guint idx;
+	guint lower = 0;
+	guint middle;
+	guint upper = store->priv->name_index->len;
+	ZifPackage *package;
+
+	while (lower < upper) {
+		middle = lower + (upper - lower) / 2;
+		idx = g_array_index (store->priv->name_index, guint, middle);
+		package = g_ptr_array_index (store->priv->packages, idx);
+		if (strncmp (zif_package_get_name (package), name, len) < 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return lower;
+}
+
+/**
+ * zif_store_name_index_mark:
+ *
+ * Marks all the packages where the name starts with @name, or where the
+ * name is exactly @name if @exact is set.
+ **/
+static void
+zif_store_name_index_mark (ZifStore *store,
+			   const gchar *name,
+			   gsize len,
+			   gboolean exact,
+			   guint8 *candidates)
+{
+	const gchar *tmp;
+	guint i;
+	guint idx;
+	ZifPackage *package;
+
+	for (i = zif_store_name_index_lower_bound (store, name, len);
+	     i < store->priv->name_index->len; i++) {
+		idx = g_array_index (store->priv->name_index, guint, i);
+		package = g_ptr_array_index (store->priv->packages, idx);
+		tmp = zif_package_get_name (package);
+		if (strncmp (tmp, name, len) != 0)
+			break;
+		if (exact && tmp[len] != '\0')
+			continue;
+		candidates[idx] = TRUE;
+	}
+}
+
+/**
+ * zif_store_resolve_get_candidates:
+ *
+ * Uses the literal prefix of each search term to find the packages that
+ * could possibly match using a sorted name index.
+ *
+ * Return value: an array of booleans for each package, or %NULL if all
+ * the packages have to be checked.
+ **/
+static guint8 *
+zif_store_resolve_get_candidates (ZifStore *store, ZifStrMatcher *matcher)
+{
+	const gchar *prefix;
+	guint8 *candidates;
+	guint i;
+	guint j;
+	ZifStorePrivate *priv = store->priv;
+
+	/* we can only narrow if every term has a prefix */
+	for (j = 0; j < zif_str_matcher_get_size (matcher); j++) {
+		if (zif_str_matcher_get_prefix (matcher, j) == NULL)
+			return NULL;
+	}
+
+	/* create the index on demand */
+	if (priv->name_index == NULL) {
+		priv->name_index = g_array_sized_new (FALSE, FALSE,
+						      sizeof (guint),
+						      priv->packages->len);
+		for (i = 0; i < priv->packages->len; i++)
+			g_array_append_val (priv->name_index, i);
+		g_array_sort_with_data (priv->name_index,
+					zif_store_name_index_sort_cb,
+					priv->packages);
+	}
+
+	candidates = g_new0 (guint8, priv->packages->len);
+	for (j = 0; j < zif_str_matcher_get_size (matcher); j++) {
+		prefix = zif_str_matcher_get_prefix (matcher, j);
+
+		/* the name starts with the prefix */
+		zif_store_name_index_mark (store, prefix, strlen (prefix),
+					   FALSE, candidates);
+
+		/* or the name is the start of the prefix, e.g. the
+		 * name "kernel" for the prefix "kernel-3.1" */
+		for (i = 1; prefix[i] != '\0'; i++) {
+			if (prefix[i] != '.' && prefix[i] != '-')
+				continue;
+			zif_store_name_index_mark (store, prefix, i,
+						   TRUE, candidates);
+		}
+	}
+	return candidates;
+}
+
+/**
+ * zif_store_resolve_exact:
+ *
+ * Finds the packages matching the search terms exactly using the hash
+ * indexes rather than comparing every package in the store.
+ *
+ * Return value: the matching packages in store order
+ **/
+static GPtrArray *
+zif_store_resolve_exact (ZifStore *store,
+			 gchar **search,
+			 ZifStoreResolveFlags flags)
+{
+	GHashTable *hash[4];
+	GHashTable *matched;
+	GHashTableIter iter;
+	GPtrArray *array;
+	GPtrArray *array_tmp;
+	gpointer package;
+	guint i, j, k;
+	ZifStorePrivate *priv = store->priv;
+
+	/* only use the indexes for the fields being searched */
+	hash[0] = (flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME) > 0 ?
+			priv->hash_name : NULL;
+	hash[1] = (flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_ARCH) > 0 ?
+			priv->hash_name_arch : NULL;
+	hash[2] = (flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_VERSION) > 0 ?
+			priv->hash_name_version : NULL;
+	hash[3] = (flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_VERSION_ARCH) > 0 ?
+			priv->hash_name_version_arch : NULL;
+
+	/* get the set of matching packages */
+	matched = g_hash_table_new (g_direct_hash, g_direct_equal);
+	for (i = 0; i < G_N_ELEMENTS (hash); i++) {
+		if (hash[i] == NULL)
+			continue;
+		for (j = 0; search[j] != NULL; j++) {
+			array_tmp = g_hash_table_lookup (hash[i], search[j]);
+			if (array_tmp == NULL)
+				continue;
+			for (k = 0; k < array_tmp->len; k++) {
+				g_hash_table_insert (matched,
+						     g_ptr_array_index (array_tmp, k),
+						     GUINT_TO_POINTER (1));
+			}
+		}
+	}
+
+	/* return in the same order as the store to match the slow path */
+	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	if (g_hash_table_size (matched) == 1) {
+		g_hash_table_iter_init (&iter, matched);
+		g_hash_table_iter_next (&iter, &package, NULL);
+		g_ptr_array_add (array, g_object_ref (package));
+	} else if (g_hash_table_size (matched) > 1) {
+		for (i = 0; i < priv->packages->len; i++) {
+			package = g_ptr_array_index (priv->packages, i);
+			if (g_hash_table_lookup (matched, package) != NULL)
+				g_ptr_array_add (array, g_object_ref (package));
+		}
+	}
+	g_hash_table_unref (matched);
+	return array;
+}
+
 /**
  * zif_store_resolve_full_try:
  **/
@@ -1025,8 +1354,11 @@ zif_store_resolve_full_try (ZifStore *store,
 	GPtrArray *array = NULL;
 	guint i, j;
 	ZifPackage *package;
+	guint8 *candidates = NULL;
+	guint n_candidates = 0;
 	ZifState *state_local = NULL;
-	ZifStrCompareFunc compare_func;
+	ZifStrMatcher *matcher = NULL;
+	ZifStrMatcherKind kind;
 	ZifStoreClass *klass = ZIF_STORE_GET_CLASS (store);
 
 	g_return_val_if_fail (klass != NULL, NULL);
@@ -1108,28 +1440,50 @@ zif_store_resolve_full_try (ZifStore *store,
 		goto out;
 	}
 
-	/* setup state with the correct number of steps */
-	state_local = zif_state_get_child (state);
-	zif_state_set_number_steps (state_local, store->priv->packages->len);
-
 	/* allow globbing (slow) or a regular expressions (much slower) */
 	if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_REGEX) > 0)
-		compare_func = zif_str_compare_regex;
+		kind = ZIF_STR_MATCHER_KIND_REGEX;
 	else if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_GLOB) > 0)
-		compare_func = zif_str_compare_glob;
+		kind = ZIF_STR_MATCHER_KIND_GLOB;
 	else
-		compare_func = zif_str_compare_equal;
+		kind = ZIF_STR_MATCHER_KIND_EQUAL;
+
+	/* exact matches can just use the hash indexes */
+	if (kind == ZIF_STR_MATCHER_KIND_EQUAL) {
+		array = zif_store_resolve_exact (store, search_native, flags);
+		ret = zif_state_done (state, error);
+		if (!ret) {
+			g_ptr_array_unref (array);
+			array = NULL;
+		}
+		goto out;
+	}
+	matcher = zif_str_matcher_new (kind, search_native);
+
+	/* only check the packages that could match */
+	candidates = zif_store_resolve_get_candidates (store, matcher);
+	for (i = 0; i < store->priv->packages->len; i++) {
+		if (candidates == NULL || candidates[i])
+			n_candidates++;
+	}
+
+	/* setup state with the correct number of steps */
+	state_local = zif_state_get_child (state);
+	if (n_candidates > 0)
+		zif_state_set_number_steps (state_local, n_candidates);
 
 	/* iterate list */
 	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	for (i = 0; i < store->priv->packages->len; i++) {
+		if (candidates != NULL && !candidates[i])
+			continue;
 		package = g_ptr_array_index (store->priv->packages, i);
 
 		/* name */
 		if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME) > 0) {
 			tmp = zif_package_get_name (package);
 			for (j = 0; search_native[j] != NULL; j++) {
-				if (compare_func (tmp, search_native[j]))
+				if (zif_str_matcher_match_term (matcher, j, tmp))
 					g_ptr_array_add (array, g_object_ref (package));
 			}
 		}
@@ -1138,7 +1492,7 @@ zif_store_resolve_full_try (ZifStore *store,
 		if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_ARCH) > 0) {
 			tmp = zif_package_get_name_arch (package);
 			for (j = 0; search_native[j] != NULL; j++) {
-				if (compare_func (tmp, search_native[j]))
+				if (zif_str_matcher_match_term (matcher, j, tmp))
 					g_ptr_array_add (array, g_object_ref (package));
 			}
 		}
@@ -1147,7 +1501,7 @@ zif_store_resolve_full_try (ZifStore *store,
 		if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_VERSION) > 0) {
 			tmp = zif_package_get_name_version (package);
 			for (j = 0; search_native[j] != NULL; j++) {
-				if (compare_func (tmp, search_native[j]))
+				if (zif_str_matcher_match_term (matcher, j, tmp))
 					g_ptr_array_add (array, g_object_ref (package));
 			}
 		}
@@ -1156,7 +1510,7 @@ zif_store_resolve_full_try (ZifStore *store,
 		if ((flags & ZIF_STORE_RESOLVE_FLAG_USE_NAME_VERSION_ARCH) > 0) {
 			tmp = zif_package_get_name_version_arch (package);
 			for (j = 0; search_native[j] != NULL; j++) {
-				if (compare_func (tmp, search_native[j]))
+				if (zif_str_matcher_match_term (matcher, j, tmp))
 					g_ptr_array_add (array, g_object_ref (package));
 			}
 		}
@@ -1175,6 +1529,8 @@ zif_store_resolve_full_try (ZifStore *store,
 	if (!ret)
 		goto out;
 out:
+	zif_str_matcher_free (matcher);
+	g_free (candidates);
 	g_strfreev (search_native);
 	return array;
 }
@@ -1905,10 +2261,34 @@ zif_store_get_id (ZifStore *store)
 guint
 zif_store_get_size (ZifStore *store)
 {
+	ZifStoreClass *klass = ZIF_STORE_GET_CLASS (store);
+
 	g_return_val_if_fail (ZIF_IS_STORE (store), 0);
+
+	/* superclass */
+	if (klass->get_size != NULL)
+		return klass->get_size (store);
+
 	return store->priv->packages->len;
 }
 
+/**
+ * zif_store_get_changes:
+ * @store: A #ZifStore
+ *
+ * Gets a counter that is incremented every time packages are added to
+ * or removed from the store, so that any view built over the store can
+ * tell when it is stale.
+ *
+ * Return value: the number of changes made to the store
+ **/
+guint
+zif_store_get_changes (ZifStore *store)
+{
+	g_return_val_if_fail (ZIF_IS_STORE (store), 0);
+	return store->priv->changes;
+}
+
 /**
  * zif_store_print:
  * @store: A #ZifStore
@@ -1939,6 +2319,86 @@ zif_store_print (ZifStore *store)
 	}
 }
 
+/**
+ * zif_store_get_memory_usage_hash_cb:
+ **/
+static void
+zif_store_get_memory_usage_hash_cb (gpointer key, gpointer value, gpointer user_data)
+{
+	ZifMemory *memory = ZIF_MEMORY (user_data);
+	zif_memory_add_string (memory, ZIF_MEMORY_KIND_HASHES, key);
+	zif_memory_add_ptr_array (memory, ZIF_MEMORY_KIND_HASHES, value);
+}
+
+/**
+ * zif_store_get_memory_usage:
+ * @store: A #ZifStore
+ * @memory: A #ZifMemory to add the sizes to
+ *
+ * Adds the memory used by the packages and indexes held by the store,
+ * and any metadata the store has loaded, to @memory.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_store_get_memory_usage (ZifStore *store, ZifMemory *memory)
+{
+	guint i;
+	GList *l;
+	GList *keys;
+	ZifStorePrivate *priv;
+	ZifStoreClass *klass = ZIF_STORE_GET_CLASS (store);
+
+	g_return_if_fail (ZIF_IS_STORE (store));
+	g_return_if_fail (ZIF_IS_MEMORY (memory));
+	g_return_if_fail (klass != NULL);
+
+	if (!zif_memory_visit (memory, store))
+		return;
+	priv = store->priv;
+
+	/* packages */
+	zif_memory_add_ptr_array (memory, ZIF_MEMORY_KIND_PACKAGES, priv->packages);
+	for (i = 0; i < priv->packages->len; i++) {
+		zif_package_get_memory_usage (g_ptr_array_index (priv->packages, i),
+					      memory);
+	}
+
+	/* package-id lookup, the values are owned by the array */
+	zif_memory_add_hash_table (memory, priv->package_id_hash);
+	keys = g_hash_table_get_keys (priv->package_id_hash);
+	for (l = keys; l != NULL; l = l->next)
+		zif_memory_add_string (memory, ZIF_MEMORY_KIND_HASHES, l->data);
+	g_list_free (keys);
+
+	/* resolve indexes */
+	if (priv->name_index != NULL) {
+		zif_memory_add (memory,
+				ZIF_MEMORY_KIND_HASHES,
+				sizeof (GArray) + priv->name_index->len * sizeof (guint));
+	}
+	zif_memory_add_hash_table (memory, priv->hash_name);
+	zif_memory_add_hash_table (memory, priv->hash_name_arch);
+	zif_memory_add_hash_table (memory, priv->hash_name_version);
+	zif_memory_add_hash_table (memory, priv->hash_name_version_arch);
+	g_hash_table_foreach (priv->hash_name,
+			      zif_store_get_memory_usage_hash_cb,
+			      memory);
+	g_hash_table_foreach (priv->hash_name_arch,
+			      zif_store_get_memory_usage_hash_cb,
+			      memory);
+	g_hash_table_foreach (priv->hash_name_version,
+			      zif_store_get_memory_usage_hash_cb,
+			      memory);
+	g_hash_table_foreach (priv->hash_name_version_arch,
+			      zif_store_get_memory_usage_hash_cb,
+			      memory);
+
+	/* superclass, e.g. metadata */
+	if (klass->get_memory_usage != NULL)
+		klass->get_memory_usage (store, memory);
+}
+
 /**
  * zif_store_get_enabled:
  * @store: A #ZifStore
@@ -2037,6 +2497,11 @@ zif_store_finalize (GObject *object)
 	store = ZIF_STORE (object);
 	g_ptr_array_unref (store->priv->packages);
 	g_hash_table_destroy (store->priv->package_id_hash);
+	g_hash_table_destroy (store->priv->hash_name);
+	g_hash_table_destroy (store->priv->hash_name_arch);
+	g_hash_table_destroy (store->priv->hash_name_version);
+	g_hash_table_destroy (store->priv->hash_name_version_arch);
+	zif_store_invalidate_index (store);
 
 	G_OBJECT_CLASS (zif_store_parent_class)->finalize (object);
 }
@@ -2088,6 +2553,22 @@ zif_store_init (ZifStore *store)
 							      g_str_equal,
 							      g_free,
 							      NULL);
+	store->priv->hash_name = g_hash_table_new_full (g_str_hash,
+							g_str_equal,
+							g_free,
+							(GDestroyNotify) g_ptr_array_unref);
+	store->priv->hash_name_arch = g_hash_table_new_full (g_str_hash,
+							     g_str_equal,
+							     g_free,
+							     (GDestroyNotify) g_ptr_array_unref);
+	store->priv->hash_name_version = g_hash_table_new_full (g_str_hash,
+								g_str_equal,
+								g_free,
+								(GDestroyNotify) g_ptr_array_unref);
+	store->priv->hash_name_version_arch = g_hash_table_new_full (g_str_hash,
+								     g_str_equal,
+								     g_free,
+								     (GDestroyNotify) g_ptr_array_unref);
 }
 
 /**
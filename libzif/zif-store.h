@@ -30,6 +30,7 @@
 #include <gio/gio.h>
 
 #include "zif-depend.h"
+#include "zif-memory.h"
 #include "zif-package.h"
 #include "zif-state.h"
 
@@ -129,12 +130,17 @@ struct _ZifStoreClass
 						 GError			**error);
 	const gchar	*(*get_id)		(ZifStore		*store);
 	void		 (*print)		(ZifStore		*store);
-
-	/* Padding for future expansion */
-	void (*_zif_reserved1) (void);
-	void (*_zif_reserved2) (void);
-	void (*_zif_reserved3) (void);
-	void (*_zif_reserved4) (void);
+	void		 (*get_memory_usage)	(ZifStore		*store,
+						 ZifMemory		*memory);
+	gboolean	 (*add_package)		(ZifStore		*store,
+						 ZifPackage		*package,
+						 GError			**error);
+	gboolean	 (*remove_package)	(ZifStore		*store,
+						 ZifPackage		*package,
+						 GError			**error);
+	gboolean	 (*has_package)		(ZifStore		*store,
+						 ZifPackage		*package);
+	guint		 (*get_size)		(ZifStore		*store);
 };
 
 typedef enum {
@@ -173,6 +179,8 @@ gboolean	 zif_store_remove_package	(ZifStore		*store,
 gboolean	 zif_store_remove_packages	(ZifStore		*store,
 						 GPtrArray		*array,
 						 GError			**error);
+gboolean	 zif_store_has_package		(ZifStore		*store,
+						 ZifPackage		*package);
 gboolean	 zif_store_load			(ZifStore		*store,
 						 ZifState		*state,
 						 GError			**error);
@@ -248,6 +256,8 @@ GPtrArray	*zif_store_get_categories	(ZifStore		*store,
 const gchar	*zif_store_get_id		(ZifStore		*store);
 guint		 zif_store_get_size		(ZifStore		*store);
 void		 zif_store_print		(ZifStore		*store);
+void		 zif_store_get_memory_usage	(ZifStore		*store,
+						 ZifMemory		*memory);
 gboolean	 zif_store_get_enabled		(ZifStore		*store);
 void		 zif_store_set_enabled		(ZifStore		*store,
 						 gboolean		 enabled);
@@ -32,6 +32,7 @@
 #endif
 
 #include <glib.h>
+#include <string.h>
 
 #include "zif-utils.h"
 #include "zif-string.h"
@@ -154,3 +155,24 @@ zif_string_unref (ZifString *string)
 	return (ZifString *) internal;
 }
 
+/**
+ * zif_string_get_size: (skip)
+ * @string: A #ZifString
+ *
+ * Gets the number of bytes used by the object, including the value if
+ * it is owned by the #ZifString.
+ *
+ * Return value: the size in bytes
+ *
+ * Since: 0.3.7
+ **/
+gsize
+zif_string_get_size (ZifString *string)
+{
+	ZifStringInternal *internal = (ZifStringInternal *) string;
+	gsize size = sizeof (ZifStringInternal);
+	g_return_val_if_fail (internal != NULL, 0);
+	if (!internal->is_static && internal->value != NULL)
+		size += strlen (internal->value) + 1;
+	return size;
+}
@@ -43,6 +43,7 @@ ZifString	*zif_string_new_value		(gchar		*value);
 ZifString	*zif_string_new_static		(const gchar	*value);
 ZifString	*zif_string_ref			(ZifString	*string);
 ZifString	*zif_string_unref		(ZifString	*string);
+gsize		 zif_string_get_size		(ZifString	*string);
 
 G_END_DECLS
 
@@ -75,6 +75,7 @@
 #include "zif-store.h"
 #include "zif-store-local.h"
 #include "zif-store-meta.h"
+#include "zif-store-overlay.h"
 #include "zif-store-remote-private.h"
 #include "zif-transaction.h"
 #include "zif-transaction-private.h"
@@ -109,6 +110,9 @@ typedef struct {
 	ZifTransaction		*transaction;
 	gboolean		 unresolved_dependencies;
 	ZifStore		*post_resolve_package_array;
+	GPtrArray		*post_resolve_packages;
+	GHashTable		*provides_index;	/* name:GPtrArray */
+	GHashTable		*conflicts_index;	/* name:GPtrArray */
 	guint			 resolve_count;
 	gboolean		 skip_broken;
 } ZifTransactionResolve;
@@ -3038,6 +3042,168 @@ out:
 	return ret;
 }
 
+/**
+ * zif_transaction_depend_index_clear:
+ **/
+static void
+zif_transaction_depend_index_clear (ZifTransactionResolve *data)
+{
+	if (data->post_resolve_packages != NULL) {
+		g_ptr_array_unref (data->post_resolve_packages);
+		data->post_resolve_packages = NULL;
+	}
+	if (data->provides_index != NULL) {
+		g_hash_table_unref (data->provides_index);
+		data->provides_index = NULL;
+	}
+	if (data->conflicts_index != NULL) {
+		g_hash_table_unref (data->conflicts_index);
+		data->conflicts_index = NULL;
+	}
+}
+
+/**
+ * zif_transaction_depend_index_add:
+ *
+ * The key is owned by the depend, which is kept alive by the package
+ * that is added to the value array.
+ **/
+static void
+zif_transaction_depend_index_add (GHashTable *index,
+				  ZifDepend *depend,
+				  ZifPackage *package)
+{
+	const gchar *name;
+	GPtrArray *array;
+
+	name = zif_depend_get_name (depend);
+	array = g_hash_table_lookup (index, name);
+	if (array == NULL) {
+		array = zif_package_array_new ();
+		g_hash_table_insert (index, (gpointer) name, array);
+	}
+
+	/* packages can provide the same name with different versions */
+	if (array->len > 0 &&
+	    g_ptr_array_index (array, array->len - 1) == package)
+		return;
+	g_ptr_array_add (array, g_object_ref (package));
+}
+
+/**
+ * zif_transaction_depend_index_setup:
+ *
+ * Indexes the post-resolve packages by the names they provide and
+ * conflict with, so that checking conflicts for each item is a lookup
+ * rather than a scan of every package.
+ *
+ * File provides are not indexed as there are so many of them, and
+ * file conflicts are rare enough to search the whole array.
+ **/
+static gboolean
+zif_transaction_depend_index_setup (ZifTransactionResolve *data,
+				    GError **error)
+{
+	gboolean ret = TRUE;
+	GError *error_local = NULL;
+	GPtrArray *conflicts;
+	GPtrArray *provides;
+	guint i;
+	guint j;
+	ZifDepend *depend;
+	ZifPackage *package;
+
+	/* already done this loop */
+	if (data->post_resolve_packages != NULL)
+		goto out;
+
+	/* get local base copy */
+	zif_state_reset (data->state);
+	data->post_resolve_packages = zif_store_get_packages (data->post_resolve_package_array,
+							      data->state,
+							      &error_local);
+	if (data->post_resolve_packages == NULL) {
+		if (error_local->domain != ZIF_STORE_ERROR ||
+		    error_local->code != ZIF_STORE_ERROR_ARRAY_IS_EMPTY) {
+			ret = FALSE;
+			g_propagate_error (error, error_local);
+			goto out;
+		}
+		g_clear_error (&error_local);
+		data->post_resolve_packages = zif_package_array_new ();
+	}
+
+	data->provides_index = g_hash_table_new_full (g_str_hash,
+						      g_str_equal,
+						      NULL,
+						      (GDestroyNotify) g_ptr_array_unref);
+	data->conflicts_index = g_hash_table_new_full (g_str_hash,
+						       g_str_equal,
+						       NULL,
+						       (GDestroyNotify) g_ptr_array_unref);
+	for (i = 0; i < data->post_resolve_packages->len; i++) {
+		package = g_ptr_array_index (data->post_resolve_packages, i);
+
+		/* add each provide, file provides are not indexed */
+		zif_state_reset (data->state);
+		provides = zif_package_get_provides_no_files (package,
+							      data->state,
+							      &error_local);
+		if (provides == NULL) {
+			ret = FALSE;
+			g_set_error (error,
+				     ZIF_TRANSACTION_ERROR,
+				     ZIF_TRANSACTION_ERROR_FAILED,
+				     "failed to get provides for %s: %s",
+				     zif_package_get_printable (package),
+				     error_local->message);
+			g_error_free (error_local);
+			goto out;
+		}
+		for (j = 0; j < provides->len; j++) {
+			depend = g_ptr_array_index (provides, j);
+			if (zif_depend_get_name (depend)[0] == '/')
+				continue;
+			zif_transaction_depend_index_add (data->provides_index,
+							  depend,
+							  package);
+		}
+		g_ptr_array_unref (provides);
+
+		/* add each conflict */
+		zif_state_reset (data->state);
+		conflicts = zif_package_get_conflicts (package,
+						       data->state,
+						       &error_local);
+		if (conflicts == NULL) {
+			ret = FALSE;
+			g_set_error (error,
+				     ZIF_TRANSACTION_ERROR,
+				     ZIF_TRANSACTION_ERROR_FAILED,
+				     "failed to get conflicts for %s: %s",
+				     zif_package_get_printable (package),
+				     error_local->message);
+			g_error_free (error_local);
+			goto out;
+		}
+		for (j = 0; j < conflicts->len; j++) {
+			depend = g_ptr_array_index (conflicts, j);
+			zif_transaction_depend_index_add (data->conflicts_index,
+							  depend,
+							  package);
+		}
+		g_ptr_array_unref (conflicts);
+	}
+	g_debug ("indexed %i provides and %i conflicts for %i packages",
+		 g_hash_table_size (data->provides_index),
+		 g_hash_table_size (data->conflicts_index),
+		 data->post_resolve_packages->len);
+out:
+	if (!ret)
+		zif_transaction_depend_index_clear (data);
+	return ret;
+}
+
 /**
  * zif_transaction_get_package_conflict_from_array:
  **/
@@ -3049,9 +3215,15 @@ zif_transaction_get_package_conflict_from_array (GPtrArray *array,
 						 GError **error)
 {
 	gboolean ret = TRUE;
-	GPtrArray *satisfy_array;
+	GPtrArray *satisfy_array = NULL;
 	GError *error_local = NULL;
 
+	/* nothing conflicts with this name */
+	if (array == NULL) {
+		*package = NULL;
+		goto out;
+	}
+
 	/* get an array of packages that provide this */
 	ret = zif_package_array_conflict (array, depend, NULL,
 					  &satisfy_array, state, error);
@@ -3082,7 +3254,8 @@ zif_transaction_get_package_conflict_from_array (GPtrArray *array,
 		goto out;
 	}
 out:
-	g_ptr_array_unref (satisfy_array);
+	if (satisfy_array != NULL)
+		g_ptr_array_unref (satisfy_array);
 	return ret;
 }
 
@@ -3102,7 +3275,7 @@ zif_transaction_resolve_conflicts_item (ZifTransactionResolve *data,
 	ZifDepend *depend;
 	GPtrArray *results_tmp;
 	GPtrArray *related_packages = NULL;
-	GPtrArray *post_resolve_package_array = NULL;
+	GPtrArray *candidates;
 	GError *error_local = NULL;
 
 	/* get provides for the package */
@@ -3135,11 +3308,10 @@ zif_transaction_resolve_conflicts_item (ZifTransactionResolve *data,
 		goto out;
 	}
 
-	/* get local base copy */
-	zif_state_reset (data->state);
-	post_resolve_package_array = zif_store_get_packages (data->post_resolve_package_array,
-							     data->state,
-							     NULL);
+	/* only built once per loop */
+	ret = zif_transaction_depend_index_setup (data, error);
+	if (!ret)
+		goto out;
 
 	g_debug ("checking %i provides for %s",
 		 provides->len,
@@ -3151,7 +3323,9 @@ zif_transaction_resolve_conflicts_item (ZifTransactionResolve *data,
 			 zif_depend_get_description (depend));
 
 		/* get packages that conflict with this */
-		ret = zif_transaction_get_package_conflict_from_array (post_resolve_package_array,
+		candidates = g_hash_table_lookup (data->conflicts_index,
+						  zif_depend_get_name (depend));
+		ret = zif_transaction_get_package_conflict_from_array (candidates,
 								       depend, &conflicting,
 								       data->state, error);
 		if (!ret) {
@@ -3185,7 +3359,15 @@ zif_transaction_resolve_conflicts_item (ZifTransactionResolve *data,
 
 		/* check if we conflict with something in the new
 		 * installed array */
-		ret = zif_package_array_provide (post_resolve_package_array,
+		if (zif_depend_get_name (depend)[0] == '/') {
+			candidates = data->post_resolve_packages;
+		} else {
+			candidates = g_hash_table_lookup (data->provides_index,
+							  zif_depend_get_name (depend));
+			if (candidates == NULL)
+				continue;
+		}
+		ret = zif_package_array_provide (candidates,
 						 depend,
 						 NULL,
 						 &results_tmp,
@@ -3230,8 +3412,6 @@ zif_transaction_resolve_conflicts_item (ZifTransactionResolve *data,
 			break;
 	}
 out:
-	if (post_resolve_package_array != NULL)
-		g_ptr_array_unref (post_resolve_package_array);
 	if (provides != NULL)
 		g_ptr_array_unref (provides);
 	if (related_packages != NULL)
@@ -3401,41 +3581,25 @@ zif_transaction_item_sort_cb (ZifPackage **a, ZifPackage **b)
  * We track the installed post resolve state to make conflicts checking
  * much quicker. We don't have to search entries that are already removed
  * and can do saner conflicts handling.
+ *
+ * The installed packages are not copied, only the changes are layered
+ * over the local store.
  **/
 static gboolean
 zif_transaction_setup_post_resolve_package_array (ZifTransactionResolve *data,
 						  GError **error)
 {
 	gboolean ret = FALSE;
-	GPtrArray *packages = NULL;
 	guint i;
 	ZifPackage *package_tmp;
-	GError *error_local = NULL;
 	ZifTransactionPrivate *priv = data->transaction->priv;
 
-	/* add existing installed packages */
-	packages = zif_store_get_packages (priv->store_local,
-					   data->state, &error_local);
-	if (packages == NULL) {
-		/* ignore this error */
-		if (error_local->domain == ZIF_STORE_ERROR &&
-		    error_local->code == ZIF_STORE_ERROR_ARRAY_IS_EMPTY) {
-			g_debug ("no packages in installed database");
-			g_error_free (error_local);
-			ret = TRUE;
-		} else {
-			ret = FALSE;
-			g_propagate_error (error, error_local);
-		}
+	/* the overlay needs the installed packages to hide removals */
+	ret = zif_store_load (priv->store_local, data->state, error);
+	if (!ret)
 		goto out;
-	}
-
-	for (i = 0; i < packages->len; i++) {
-		package_tmp = g_ptr_array_index (packages, i);
-		zif_store_add_package (data->post_resolve_package_array,
-				       package_tmp,
-				       NULL);
-	}
+	zif_store_overlay_set_base (ZIF_STORE_OVERLAY (data->post_resolve_package_array),
+				    priv->store_local);
 
 	/* coldplug */
 	for (i = 0; i < priv->install->len; i++) {
@@ -3452,12 +3616,11 @@ zif_transaction_setup_post_resolve_package_array (ZifTransactionResolve *data,
 	}
 
 	/* success */
-	ret = TRUE;
-	g_debug ("%i already in world state",
-		 zif_store_get_size (data->post_resolve_package_array));
+	g_debug ("%i installed, %i added and %i removed in world state",
+		 zif_store_get_size (priv->store_local),
+		 priv->install->len,
+		 priv->remove->len);
 out:
-	if (packages != NULL)
-		g_ptr_array_unref (packages);
 	return ret;
 }
 
@@ -3477,6 +3640,7 @@ zif_transaction_resolve_loop (ZifTransactionResolve *data, ZifState *state, GErr
 	/* reset here */
 	data->resolve_count++;
 	data->unresolved_dependencies = FALSE;
+	zif_transaction_depend_index_clear (data);
 
 	/* for each package set to be installed */
 	g_debug ("starting INSTALL on loop %i", data->resolve_count);
@@ -4225,7 +4389,7 @@ zif_transaction_resolve (ZifTransaction *transaction, ZifState *state, GError **
 
 	data = g_new0 (ZifTransactionResolve, 1);
 	data->state = zif_state_get_child (state);
-	data->post_resolve_package_array = zif_store_meta_new ();
+	data->post_resolve_package_array = zif_store_overlay_new ();
 
 	/* we can't do child progress in a sane way */
 	zif_state_set_report_progress (data->state, FALSE);
@@ -4285,8 +4449,11 @@ zif_transaction_resolve (ZifTransaction *transaction, ZifState *state, GError **
 out:
 	zif_transaction_show_array ("installing", priv->install);
 	zif_transaction_show_array ("removing", priv->remove);
-	if (data != NULL && data->post_resolve_package_array != NULL)
-		g_object_unref (data->post_resolve_package_array);
+	if (data != NULL) {
+		zif_transaction_depend_index_clear (data);
+		if (data->post_resolve_package_array != NULL)
+			g_object_unref (data->post_resolve_package_array);
+	}
 	g_free (data);
 	return ret;
 }
@@ -45,12 +45,40 @@ gboolean	 zif_str_compare_glob		(const gchar	*a,
 						 const gchar	*b);
 gboolean	 zif_str_compare_equal		(const gchar	*a,
 						 const gchar	*b);
+
+typedef enum {
+	ZIF_STR_MATCHER_KIND_EQUAL,
+	ZIF_STR_MATCHER_KIND_GLOB,
+	ZIF_STR_MATCHER_KIND_REGEX,
+	ZIF_STR_MATCHER_KIND_LAST
+} ZifStrMatcherKind;
+
+typedef struct _ZifStrMatcher ZifStrMatcher;
+
+ZifStrMatcher	*zif_str_matcher_new		(ZifStrMatcherKind kind,
+						 gchar		**search);
+void		 zif_str_matcher_free		(ZifStrMatcher	*matcher);
+gboolean	 zif_str_matcher_match		(ZifStrMatcher	*matcher,
+						 const gchar	*value);
+guint		 zif_str_matcher_get_size	(ZifStrMatcher	*matcher);
+gboolean	 zif_str_matcher_match_term	(ZifStrMatcher	*matcher,
+						 guint		 idx,
+						 const gchar	*value);
+const gchar	*zif_str_matcher_get_prefix	(ZifStrMatcher	*matcher,
+						 guint		 idx);
 guint		 zif_string_replace		(GString	*string,
 						 const gchar	*search,
 						 const gchar	*replace);
 gboolean	 zif_ensure_parent_dir_exists	(const gchar	*filename,
 						 GCancellable	*cancellable,
 						 GError		**error);
+gchar		*zif_file_get_checksum		(const gchar	*filename,
+						 GChecksumType	 checksum_type,
+						 GCancellable	*cancellable,
+						 GError		**error);
+void		 zif_file_set_cached_checksum	(const gchar	*filename,
+						 GChecksumType	 checksum_type,
+						 const gchar	*checksum);
 
 G_END_DECLS
 
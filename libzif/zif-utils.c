@@ -31,6 +31,9 @@
 #endif
 
 #include <glib.h>
+#include <glib/gstdio.h>
+#include <sys/stat.h>
+#include <attr/xattr.h>
 #include <rpm/rpmlib.h>
 #include <rpm/rpmdb.h>
 #include <archive.h>
@@ -38,6 +41,8 @@
 #include <bzlib.h>
 #include <zlib.h>
 #include <lzma.h>
+#include <string.h>
+#include <unistd.h>
 #include <fnmatch.h>
 #include <gpgme.h>
 
@@ -712,22 +717,74 @@ zif_arch_is_native (const gchar *a, const gchar *b)
 
 #define ZIF_BUFFER_SIZE 16384
 
+/* the xz decoder will only use more threads if this much memory is free */
+#define ZIF_LZMA_MEMLIMIT_THREADING	(256 * 1024 * 1024)
+
+typedef struct {
+	FILE			*f_out;
+	ZifFileDecompressFunc	 func;
+	gpointer		 user_data;
+} ZifFileDecompressHelper;
+
+typedef gboolean (*ZifFileDecompressFormatFunc)	(const gchar		*in,
+						 ZifFileDecompressHelper *helper,
+						 ZifState		*state,
+						 GError			**error);
+
+/**
+ * zif_file_decompress_write:
+ **/
+static gboolean
+zif_file_decompress_write (ZifFileDecompressHelper *helper,
+			   const guchar *buf,
+			   gsize size,
+			   GError **error)
+{
+	gboolean ret = TRUE;
+	gsize written;
+
+	/* nothing to do */
+	if (size == 0)
+		goto out;
+
+	/* write data */
+	if (helper->f_out != NULL) {
+		written = fwrite (buf, 1, size, helper->f_out);
+		if (written != size) {
+			ret = FALSE;
+			g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_WRITE,
+				     "only wrote %" G_GSIZE_FORMAT "/%" G_GSIZE_FORMAT " bytes",
+				     written, size);
+			goto out;
+		}
+	}
+
+	/* pass to consumer */
+	if (helper->func != NULL) {
+		ret = helper->func (buf, size, helper->user_data, error);
+		if (!ret)
+			goto out;
+	}
+out:
+	return ret;
+}
+
 /**
  * zif_file_decompress_zlib:
  **/
 static gboolean
-zif_file_decompress_zlib (const gchar *in, const gchar *out, ZifState *state, GError **error)
+zif_file_decompress_zlib (const gchar *in,
+			  ZifFileDecompressHelper *helper,
+			  ZifState *state,
+			  GError **error)
 {
 	gboolean ret = FALSE;
 	gint size;
-	gint written;
 	gzFile f_in = NULL;
-	FILE *f_out = NULL;
 	guchar buf[ZIF_BUFFER_SIZE];
 	GCancellable *cancellable;
 
 	g_return_val_if_fail (in != NULL, FALSE);
-	g_return_val_if_fail (out != NULL, FALSE);
 	g_return_val_if_fail (zif_state_valid (state), FALSE);
 
 	/* get cancellable */
@@ -743,13 +800,8 @@ zif_file_decompress_zlib (const gchar *in, const gchar *out, ZifState *state, GE
 		goto out;
 	}
 
-	/* open file for writing */
-	f_out = fopen (out, "w");
-	if (f_out == NULL) {
-		g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_WRITE,
-			     "cannot open %s for writing", out);
-		goto out;
-	}
+	/* use a bigger internal buffer than the 8k default */
+	gzbuffer (f_in, ZIF_BUFFER_SIZE * 8);
 
 	/* read in all data in chunks */
 	while (TRUE) {
@@ -766,12 +818,9 @@ zif_file_decompress_zlib (const gchar *in, const gchar *out, ZifState *state, GE
 		}
 
 		/* write data */
-		written = fwrite (buf, 1, size, f_out);
-		if (written != size) {
-			g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_WRITE,
-				     "only wrote %i/%i bytes", written, size);
+		ret = zif_file_decompress_write (helper, buf, size, error);
+		if (!ret)
 			goto out;
-		}
 
 		/* is cancelled */
 		ret = !g_cancellable_is_cancelled (cancellable);
@@ -786,8 +835,6 @@ zif_file_decompress_zlib (const gchar *in, const gchar *out, ZifState *state, GE
 out:
 	if (f_in != NULL)
 		gzclose (f_in);
-	if (f_out != NULL)
-		fclose (f_out);
 	return ret;
 }
 
@@ -795,20 +842,20 @@ out:
  * zif_file_decompress_bz2:
  **/
 static gboolean
-zif_file_decompress_bz2 (const gchar *in, const gchar *out, ZifState *state, GError **error)
+zif_file_decompress_bz2 (const gchar *in,
+			 ZifFileDecompressHelper *helper,
+			 ZifState *state,
+			 GError **error)
 {
 	gboolean ret = FALSE;
 	FILE *f_in = NULL;
-	FILE *f_out = NULL;
 	BZFILE *b = NULL;
 	gint size;
-	gint written;
-	gchar buf[ZIF_BUFFER_SIZE];
+	guchar buf[ZIF_BUFFER_SIZE];
 	gint bzerror = BZ_OK;
 	GCancellable *cancellable;
 
 	g_return_val_if_fail (in != NULL, FALSE);
-	g_return_val_if_fail (out != NULL, FALSE);
 	g_return_val_if_fail (zif_state_valid (state), FALSE);
 
 	/* get cancellable */
@@ -822,14 +869,6 @@ zif_file_decompress_bz2 (const gchar *in, const gchar *out, ZifState *state, GEr
 		goto out;
 	}
 
-	/* open file for writing */
-	f_out = fopen (out, "w");
-	if (f_out == NULL) {
-		g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_WRITE,
-			     "cannot open %s for writing", out);
-		goto out;
-	}
-
 	/* read in file */
 	b = BZ2_bzReadOpen (&bzerror, f_in, 0, 0, NULL, 0);
 	if (bzerror != BZ_OK) {
@@ -849,12 +888,9 @@ zif_file_decompress_bz2 (const gchar *in, const gchar *out, ZifState *state, GEr
 		}
 
 		/* write data */
-		written = fwrite (buf, 1, size, f_out);
-		if (written != size) {
-			g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_WRITE,
-				     "only wrote %i/%i bytes", written, size);
+		ret = zif_file_decompress_write (helper, buf, size, error);
+		if (!ret)
 			goto out;
-		}
 
 		/* is cancelled */
 		ret = !g_cancellable_is_cancelled (cancellable);
@@ -867,6 +903,7 @@ zif_file_decompress_bz2 (const gchar *in, const gchar *out, ZifState *state, GEr
 
 	/* failed to read */
 	if (bzerror != BZ_STREAM_END) {
+		ret = FALSE;
 		g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED,
 			     "did not decompress file: %s", in);
 		goto out;
@@ -879,22 +916,49 @@ out:
 		BZ2_bzReadClose (&bzerror, b);
 	if (f_in != NULL)
 		fclose (f_in);
-	if (f_out != NULL)
-		fclose (f_out);
 	return ret;
 }
 
+/**
+ * zif_file_decompress_lzma_decoder_init:
+ *
+ * Use the multi-threaded decoder for xz files where liblzma supports it.
+ * Only xz files created with more than one block (e.g. 'xz -T0') can
+ * actually be decoded in parallel, otherwise this is no slower than the
+ * single threaded decoder.
+ **/
+static lzma_ret
+zif_file_decompress_lzma_decoder_init (lzma_stream *strm, const gchar *in)
+{
+#if LZMA_VERSION >= 50040002
+	lzma_mt mt;
+
+	if (g_str_has_suffix (in, "xz")) {
+		memset (&mt, 0, sizeof (lzma_mt));
+		mt.threads = lzma_cputhreads ();
+		if (mt.threads == 0)
+			mt.threads = 1;
+		mt.memlimit_threading = ZIF_LZMA_MEMLIMIT_THREADING;
+		mt.memlimit_stop = UINT64_MAX;
+		g_debug ("using %i threads to decompress %s", mt.threads, in);
+		return lzma_stream_decoder_mt (strm, &mt);
+	}
+#endif
+	return lzma_auto_decoder (strm, UINT64_MAX, 0);
+}
+
 /**
  * zif_file_decompress_lzma:
  **/
 static gboolean
-zif_file_decompress_lzma (const gchar *in, const gchar *out, ZifState *state, GError **error)
+zif_file_decompress_lzma (const gchar *in,
+			  ZifFileDecompressHelper *helper,
+			  ZifState *state,
+			  GError **error)
 {
 	gboolean ret = FALSE;
 	gint size;
-	gint written;
 	FILE *f_in = NULL;
-	FILE *f_out = NULL;
 	guchar in_buf[ZIF_BUFFER_SIZE];
 	guchar out_buf[ZIF_BUFFER_SIZE];
 	GCancellable *cancellable;
@@ -905,13 +969,12 @@ zif_file_decompress_lzma (const gchar *in, const gchar *out, ZifState *state, GE
 	lzma_action action;
 
 	g_return_val_if_fail (in != NULL, FALSE);
-	g_return_val_if_fail (out != NULL, FALSE);
 	g_return_val_if_fail (zif_state_valid (state), FALSE);
 
 	/* get cancellable */
 	cancellable = zif_state_get_cancellable (state);
 
-	r = lzma_auto_decoder(strm, UINT64_MAX, 0);
+	r = zif_file_decompress_lzma_decoder_init (strm, in);
 	if (r == LZMA_MEM_ERROR) {
 		g_set_error (error,
 			     ZIF_UTILS_ERROR,
@@ -937,16 +1000,6 @@ zif_file_decompress_lzma (const gchar *in, const gchar *out, ZifState *state, GE
 		goto out;
 	}
 
-	/* open file for writing */
-	f_out = fopen (out, "w");
-	if (f_out == NULL) {
-		g_set_error (error,
-			     ZIF_UTILS_ERROR,
-			     ZIF_UTILS_ERROR_FAILED_TO_WRITE,
-			     "cannot open %s for writing", out);
-		goto out;
-	}
-
 	strm->avail_in = 0;
 	strm->next_out = out_buf;
 	strm->avail_out = ZIF_BUFFER_SIZE;
@@ -978,13 +1031,9 @@ zif_file_decompress_lzma (const gchar *in, const gchar *out, ZifState *state, GE
 		/* write data */
 		if (strm->avail_out == 0 || r != LZMA_OK) {
 			size = ZIF_BUFFER_SIZE - strm->avail_out;
-
-			written = fwrite (out_buf, 1, size, f_out);
-			if (written != size) {
-				g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_WRITE,
-					     "only wrote %i/%i bytes", written, size);
+			ret = zif_file_decompress_write (helper, out_buf, size, error);
+			if (!ret)
 				goto out;
-			}
 
 			strm->next_out = out_buf;
 			strm->avail_out = ZIF_BUFFER_SIZE;
@@ -1000,6 +1049,7 @@ zif_file_decompress_lzma (const gchar *in, const gchar *out, ZifState *state, GE
 
 	/* failed to read */
 	if (r != LZMA_STREAM_END) {
+		ret = FALSE;
 		g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED,
 			     "did not decompress file: %s", in);
 		goto out;
@@ -1011,63 +1061,146 @@ out:
 	lzma_end (strm);
 	if (f_in != NULL)
 		fclose (f_in);
-	if (f_out != NULL)
-		fclose (f_out);
 	return ret;
 }
 
 /**
- * zif_file_decompress:
+ * zif_file_decompress_full:
  * @in: A filename to unpack
- * @out: The file to create
+ * @out: The file to create, or %NULL
+ * @func: (scope call): A #ZifFileDecompressFunc, or %NULL
+ * @user_data: User data to pass to @func
  * @state: A #ZifState to use for progress reporting
  * @error: A %GError
  *
- * Decompress files into a directory
+ * Decompress a file, optionally writing the uncompressed data to @out
+ * and optionally passing each uncompressed chunk to @func as soon as it
+ * has been decoded. Using a %NULL @out allows the caller to stream the
+ * data into a parser without writing the uncompressed copy to disk.
+ *
+ * The uncompressed data is written to a temporary file which is only
+ * renamed to @out on success, so @out is never left truncated.
+ *
+ * xz files are decoded using multiple threads where the file was
+ * compressed using more than one block.
  *
  * Return value: %TRUE if the file was decompressed
  *
- * Since: 0.1.0
+ * Since: 0.3.7
  **/
 gboolean
-zif_file_decompress (const gchar *in, const gchar *out, ZifState *state, GError **error)
+zif_file_decompress_full (const gchar *in,
+			  const gchar *out,
+			  ZifFileDecompressFunc func,
+			  gpointer user_data,
+			  ZifState *state,
+			  GError **error)
 {
 	gboolean ret = FALSE;
+	gchar *out_tmp = NULL;
+	GTimer *timer = NULL;
+	ZifFileDecompressHelper helper;
+	ZifFileDecompressFormatFunc decompress;
 
 	g_return_val_if_fail (in != NULL, FALSE);
-	g_return_val_if_fail (out != NULL, FALSE);
+	g_return_val_if_fail (out != NULL || func != NULL, FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 	g_return_val_if_fail (zif_state_valid (state), FALSE);
 
 	/* set action */
 	zif_state_action_start (state, ZIF_STATE_ACTION_DECOMPRESSING, in);
 
-	/* bz2 */
+	/* only use the timer if profiling; it's expensive */
+	if (zif_state_get_enable_profile (state))
+		timer = g_timer_new ();
+
+	helper.f_out = NULL;
+	helper.func = func;
+	helper.user_data = user_data;
+
+	/* find the decoder before touching @out */
 	if (g_str_has_suffix (in, "bz2")) {
-		ret = zif_file_decompress_bz2 (in, out, state, error);
+		decompress = zif_file_decompress_bz2;
+	} else if (g_str_has_suffix (in, "gz")) {
+		decompress = zif_file_decompress_zlib;
+	} else if (g_str_has_suffix (in, "lzma") ||
+		   g_str_has_suffix (in, "xz")) {
+		decompress = zif_file_decompress_lzma;
+	} else {
+		g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED,
+			     "no support to decompress file: %s", in);
 		goto out;
 	}
 
-	/* zlib */
-	if (g_str_has_suffix (in, "gz")) {
-		ret = zif_file_decompress_zlib (in, out, state, error);
+	/* check the input exists */
+	if (!g_file_test (in, G_FILE_TEST_IS_REGULAR)) {
+		g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_READ,
+			     "cannot open %s for reading", in);
 		goto out;
 	}
 
-	/* lzma */
-	if (g_str_has_suffix (in, "lzma") ||
-	    g_str_has_suffix (in, "xz")) {
-		ret = zif_file_decompress_lzma (in, out, state, error);
-		goto out;
+	/* open a temporary file for writing so a failure never leaves
+	 * a truncated copy that looks like valid cached data */
+	if (out != NULL) {
+		out_tmp = g_strdup_printf ("%s.%i.tmp", out, getpid ());
+		helper.f_out = fopen (out_tmp, "w");
+		if (helper.f_out == NULL) {
+			g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_WRITE,
+				     "cannot open %s for writing", out_tmp);
+			goto out;
+		}
 	}
 
-	/* no support */
-	g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED,
-		     "no support to decompress file: %s", in);
+	/* decompress */
+	ret = decompress (in, &helper, state, error);
 out:
+	if (helper.f_out != NULL) {
+		if (fclose (helper.f_out) != 0 && ret) {
+			ret = FALSE;
+			g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_WRITE,
+				     "failed to close %s", out_tmp);
+		}
+	}
+
+	/* move into place only on success */
+	if (out_tmp != NULL) {
+		if (ret && g_rename (out_tmp, out) != 0) {
+			ret = FALSE;
+			g_set_error (error, ZIF_UTILS_ERROR, ZIF_UTILS_ERROR_FAILED_TO_WRITE,
+				     "failed to rename %s to %s", out_tmp, out);
+		}
+		if (!ret)
+			g_unlink (out_tmp);
+		g_free (out_tmp);
+	}
+	if (timer != NULL) {
+		g_debug ("decompressing %s took %.1fms",
+			 in, g_timer_elapsed (timer, NULL) * 1000);
+		g_timer_destroy (timer);
+	}
 	return ret;
 }
 
+/**
+ * zif_file_decompress:
+ * @in: A filename to unpack
+ * @out: The file to create
+ * @state: A #ZifState to use for progress reporting
+ * @error: A %GError
+ *
+ * Decompress files into a directory
+ *
+ * Return value: %TRUE if the file was decompressed
+ *
+ * Since: 0.1.0
+ **/
+gboolean
+zif_file_decompress (const gchar *in, const gchar *out, ZifState *state, GError **error)
+{
+	g_return_val_if_fail (out != NULL, FALSE);
+	return zif_file_decompress_full (in, out, NULL, NULL, state, error);
+}
+
 /**
  * zif_file_untar:
  * @filename: A filename to unpack
@@ -1456,6 +1589,239 @@ zif_str_compare_equal (const gchar *a, const gchar *b)
 	return strcmp (a, b) == 0;
 }
 
+typedef struct {
+	gchar			*pattern;
+	gchar			*prefix;
+	GRegex			*regex;
+	GPatternSpec		*pspec;
+} ZifStrMatcherTerm;
+
+struct _ZifStrMatcher {
+	ZifStrMatcherKind	 kind;
+	GPtrArray		*terms;
+};
+
+/**
+ * zif_str_matcher_term_free:
+ **/
+static void
+zif_str_matcher_term_free (ZifStrMatcherTerm *term)
+{
+	g_free (term->pattern);
+	g_free (term->prefix);
+	if (term->regex != NULL)
+		g_regex_unref (term->regex);
+	if (term->pspec != NULL)
+		g_pattern_spec_free (term->pspec);
+	g_free (term);
+}
+
+/**
+ * zif_str_matcher_get_glob_prefix:
+ *
+ * "kernel-*" -> "kernel-"
+ **/
+static gchar *
+zif_str_matcher_get_glob_prefix (const gchar *pattern)
+{
+	gsize len;
+	len = strcspn (pattern, "*?[\\");
+	if (len == 0)
+		return NULL;
+	return g_strndup (pattern, len);
+}
+
+/**
+ * zif_str_matcher_get_regex_prefix:
+ *
+ * "^kernel-[0-9]" -> "kernel-", but only for patterns anchored at the
+ * start and without alternation.
+ **/
+static gchar *
+zif_str_matcher_get_regex_prefix (const gchar *pattern)
+{
+	gsize len;
+
+	if (pattern[0] != '^')
+		return NULL;
+	if (strchr (pattern, '|') != NULL)
+		return NULL;
+	pattern++;
+	len = strcspn (pattern, ".[]()*+?{}|\\$^");
+
+	/* the last literal is optional, e.g. "^kernel-x?" */
+	if (len > 0 &&
+	    (pattern[len] == '*' || pattern[len] == '?' || pattern[len] == '{'))
+		len--;
+	if (len == 0)
+		return NULL;
+	return g_strndup (pattern, len);
+}
+
+/**
+ * zif_str_matcher_new:
+ * @kind: A #ZifStrMatcherKind, e.g. %ZIF_STR_MATCHER_KIND_GLOB
+ * @search: The patterns to match against
+ *
+ * Compiles the search patterns once so they can be matched against many
+ * strings quickly. Any literal prefix is also extracted so that matching
+ * can be rejected early, and so callers can narrow the candidates using
+ * a sorted index.
+ *
+ * Return value: A new #ZifStrMatcher, free with zif_str_matcher_free()
+ *
+ * Since: 0.3.7
+ **/
+ZifStrMatcher *
+zif_str_matcher_new (ZifStrMatcherKind kind, gchar **search)
+{
+	guint i;
+	GError *error = NULL;
+	ZifStrMatcher *matcher;
+	ZifStrMatcherTerm *term;
+
+	matcher = g_new0 (ZifStrMatcher, 1);
+	matcher->kind = kind;
+	matcher->terms = g_ptr_array_new_with_free_func ((GDestroyNotify) zif_str_matcher_term_free);
+	for (i = 0; search[i] != NULL; i++) {
+		term = g_new0 (ZifStrMatcherTerm, 1);
+		term->pattern = g_strdup (search[i]);
+		switch (kind) {
+		case ZIF_STR_MATCHER_KIND_EQUAL:
+			term->prefix = g_strdup (search[i]);
+			break;
+		case ZIF_STR_MATCHER_KIND_GLOB:
+			term->prefix = zif_str_matcher_get_glob_prefix (search[i]);
+
+			/* GPatternSpec does not do character classes or escapes */
+			if (strpbrk (search[i], "[\\") == NULL)
+				term->pspec = g_pattern_spec_new (search[i]);
+			break;
+		case ZIF_STR_MATCHER_KIND_REGEX:
+			term->prefix = zif_str_matcher_get_regex_prefix (search[i]);
+			term->regex = g_regex_new (search[i], G_REGEX_OPTIMIZE, 0, &error);
+			if (term->regex == NULL) {
+				g_debug ("failed to compile %s: %s",
+					 search[i], error->message);
+				g_clear_error (&error);
+			}
+			break;
+		default:
+			g_assert_not_reached ();
+		}
+		g_ptr_array_add (matcher->terms, term);
+	}
+	return matcher;
+}
+
+/**
+ * zif_str_matcher_free:
+ * @matcher: A #ZifStrMatcher
+ *
+ * Frees a matcher created with zif_str_matcher_new().
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_str_matcher_free (ZifStrMatcher *matcher)
+{
+	if (matcher == NULL)
+		return;
+	g_ptr_array_unref (matcher->terms);
+	g_free (matcher);
+}
+
+/**
+ * zif_str_matcher_get_size:
+ * @matcher: A #ZifStrMatcher
+ *
+ * Return value: the number of patterns in the matcher
+ *
+ * Since: 0.3.7
+ **/
+guint
+zif_str_matcher_get_size (ZifStrMatcher *matcher)
+{
+	return matcher->terms->len;
+}
+
+/**
+ * zif_str_matcher_get_prefix:
+ * @matcher: A #ZifStrMatcher
+ * @idx: The pattern index
+ *
+ * Gets the literal prefix that any matching string has to start with.
+ *
+ * Return value: the prefix, or %NULL if the pattern has no literal prefix
+ *
+ * Since: 0.3.7
+ **/
+const gchar *
+zif_str_matcher_get_prefix (ZifStrMatcher *matcher, guint idx)
+{
+	ZifStrMatcherTerm *term;
+	term = g_ptr_array_index (matcher->terms, idx);
+	return term->prefix;
+}
+
+/**
+ * zif_str_matcher_match_term:
+ * @matcher: A #ZifStrMatcher
+ * @idx: The pattern index
+ * @value: The string to match
+ *
+ * Matches a string against one of the patterns.
+ *
+ * Return value: %TRUE if the string matches
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_str_matcher_match_term (ZifStrMatcher *matcher,
+			    guint idx,
+			    const gchar *value)
+{
+	ZifStrMatcherTerm *term;
+
+	term = g_ptr_array_index (matcher->terms, idx);
+	if (matcher->kind == ZIF_STR_MATCHER_KIND_EQUAL)
+		return strcmp (value, term->pattern) == 0;
+
+	/* cheap rejection before any pattern matching */
+	if (term->prefix != NULL && !g_str_has_prefix (value, term->prefix))
+		return FALSE;
+	if (matcher->kind == ZIF_STR_MATCHER_KIND_GLOB) {
+		if (term->pspec != NULL)
+			return g_pattern_match_string (term->pspec, value);
+		return fnmatch (term->pattern, value, 0) == 0;
+	}
+	if (term->regex == NULL)
+		return FALSE;
+	return g_regex_match (term->regex, value, 0, NULL);
+}
+
+/**
+ * zif_str_matcher_match:
+ * @matcher: A #ZifStrMatcher
+ * @value: The string to match
+ *
+ * Matches a string against all of the patterns.
+ *
+ * Return value: %TRUE if the string matches any pattern
+ *
+ * Since: 0.3.7
+ **/
+gboolean
+zif_str_matcher_match (ZifStrMatcher *matcher, const gchar *value)
+{
+	guint i;
+	for (i = 0; i < matcher->terms->len; i++) {
+		if (zif_str_matcher_match_term (matcher, i, value))
+			return TRUE;
+	}
+	return FALSE;
+}
+
 /**
  * zif_load_multiline_key_file: (skip)
  * @filename: The repo file to load
@@ -1695,3 +2061,182 @@ out:
 	g_object_unref (file);
 	return ret;
 }
+
+/**
+ * zif_file_checksum_cache_key:
+ **/
+static const gchar *
+zif_file_checksum_cache_key (GChecksumType checksum_type)
+{
+	if (checksum_type == G_CHECKSUM_MD5)
+		return "user.Zif.Checksum.md5";
+	if (checksum_type == G_CHECKSUM_SHA1)
+		return "user.Zif.Checksum.sha1";
+	if (checksum_type == G_CHECKSUM_SHA256)
+		return "user.Zif.Checksum.sha256";
+	return NULL;
+}
+
+/**
+ * zif_file_checksum_cache_prefix:
+ *
+ * Gets the part of the cached value that identifies the file contents,
+ * so that any change to the file invalidates the cached checksum.
+ **/
+static gchar *
+zif_file_checksum_cache_prefix (const gchar *filename)
+{
+	struct stat buf;
+
+	if (g_stat (filename, &buf) != 0)
+		return NULL;
+	return g_strdup_printf ("%" G_GUINT64_FORMAT ".%09li:%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT ":",
+				(guint64) buf.st_mtim.tv_sec,
+				(glong) buf.st_mtim.tv_nsec,
+				(guint64) buf.st_size,
+				(guint64) buf.st_ino);
+}
+
+/**
+ * zif_file_set_cached_checksum:
+ * @filename: A full path
+ * @checksum_type: Checksum type, e.g. %G_CHECKSUM_SHA256
+ * @checksum: The checksum of the file contents
+ *
+ * Saves the checksum of a file in an extended attribute, along with
+ * the modification time, size and inode of the file.
+ * zif_file_get_checksum() will use this value rather than reading the
+ * file until any of these change.
+ *
+ * Failing to save the attribute is not an error, as not all
+ * filesystems support them.
+ *
+ * Since: 0.3.7
+ **/
+void
+zif_file_set_cached_checksum (const gchar *filename,
+			      GChecksumType checksum_type,
+			      const gchar *checksum)
+{
+	const gchar *key;
+	gchar *prefix;
+	gchar *value;
+	gint rc;
+
+	g_return_if_fail (filename != NULL);
+	g_return_if_fail (checksum != NULL);
+
+	key = zif_file_checksum_cache_key (checksum_type);
+	if (key == NULL)
+		return;
+	prefix = zif_file_checksum_cache_prefix (filename);
+	if (prefix == NULL)
+		return;
+	value = g_strconcat (prefix, checksum, NULL);
+	rc = setxattr (filename, key, value, strlen (value) + 1, 0);
+	if (rc < 0)
+		g_debug ("failed to set xattr '%s' on %s", key, filename);
+	g_free (prefix);
+	g_free (value);
+}
+
+/**
+ * zif_file_get_cached_checksum:
+ **/
+static gchar *
+zif_file_get_cached_checksum (const gchar *filename,
+			      GChecksumType checksum_type)
+{
+	const gchar *key;
+	gchar buffer[256];
+	gchar *checksum = NULL;
+	gchar *prefix = NULL;
+	gssize length;
+
+	key = zif_file_checksum_cache_key (checksum_type);
+	if (key == NULL)
+		goto out;
+	length = getxattr (filename, key, buffer, sizeof (buffer) - 1);
+	if (length <= 0)
+		goto out;
+	buffer[length] = '\0';
+
+	/* the file has changed since the checksum was saved */
+	prefix = zif_file_checksum_cache_prefix (filename);
+	if (prefix == NULL || !g_str_has_prefix (buffer, prefix)) {
+		g_debug ("ignoring stale xattr '%s' on %s", key, filename);
+		goto out;
+	}
+	checksum = g_strdup (buffer + strlen (prefix));
+out:
+	g_free (prefix);
+	return checksum;
+}
+
+/**
+ * zif_file_get_checksum:
+ * @filename: A full path
+ * @checksum_type: Checksum type, e.g. %G_CHECKSUM_SHA256
+ * @cancellable: a #GCancellable, or %NULL
+ * @error: A #GError, or %NULL
+ *
+ * Gets the checksum of a file. If the file has not changed since the
+ * checksum was last calculated then the cached value is returned,
+ * otherwise the file is read in chunks and the new checksum is cached
+ * using zif_file_set_cached_checksum().
+ *
+ * Return value: The checksum, or %NULL for error. Use g_free() to free.
+ *
+ * Since: 0.3.7
+ **/
+gchar *
+zif_file_get_checksum (const gchar *filename,
+		       GChecksumType checksum_type,
+		       GCancellable *cancellable,
+		       GError **error)
+{
+	gchar *buffer = NULL;
+	gchar *checksum = NULL;
+	GChecksum *csum = NULL;
+	GFile *file = NULL;
+	GFileInputStream *stream = NULL;
+	gssize len;
+
+	g_return_val_if_fail (filename != NULL, NULL);
+
+	/* already calculated */
+	checksum = zif_file_get_cached_checksum (filename, checksum_type);
+	if (checksum != NULL)
+		goto out;
+
+	/* read the file a chunk at a time */
+	file = g_file_new_for_path (filename);
+	stream = g_file_read (file, cancellable, error);
+	if (stream == NULL)
+		goto out;
+	csum = g_checksum_new (checksum_type);
+	buffer = g_new (gchar, 32 * 1024);
+	do {
+		len = g_input_stream_read (G_INPUT_STREAM (stream),
+					   buffer,
+					   32 * 1024,
+					   cancellable,
+					   error);
+		if (len < 0)
+			goto out;
+		g_checksum_update (csum, (const guchar *) buffer, len);
+	} while (len > 0);
+	checksum = g_strdup (g_checksum_get_string (csum));
+
+	/* save for next time */
+	zif_file_set_cached_checksum (filename, checksum_type, checksum);
+out:
+	if (csum != NULL)
+		g_checksum_free (csum);
+	if (stream != NULL)
+		g_object_unref (stream);
+	if (file != NULL)
+		g_object_unref (file);
+	g_free (buffer);
+	return checksum;
+}
@@ -49,6 +49,11 @@ typedef enum {
 #define ZIF_PACKAGE_ID_ARCH	2
 #define ZIF_PACKAGE_ID_DATA	3
 
+typedef gboolean (*ZifFileDecompressFunc)	(const guchar	*data,
+						 gsize		 len,
+						 gpointer	 user_data,
+						 GError		**error);
+
 GQuark		 zif_utils_error_quark		(void);
 void		 zif_list_print_array		(GPtrArray	*array);
 const gchar	*zif_guess_content_type		(const gchar	*filename);
@@ -77,6 +82,12 @@ gboolean	 zif_file_decompress		(const gchar	*in,
 						 const gchar	*out,
 						 ZifState	*state,
 						 GError		**error);
+gboolean	 zif_file_decompress_full	(const gchar	*in,
+						 const gchar	*out,
+						 ZifFileDecompressFunc func,
+						 gpointer	 user_data,
+						 ZifState	*state,
+						 GError		**error);
 gchar		*zif_file_get_uncompressed_name	(const gchar	*filename);
 gboolean	 zif_file_is_compressed_name	(const gchar	*filename);
 gchar		**zif_package_id_split		(const gchar	*package_id);
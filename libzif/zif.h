@@ -25,15 +25,18 @@
 #define __ZIF_H_INSIDE__
 
 #include <zif-category.h>
+#include <zif-client.h>
 #include <zif-config.h>
 #include <zif-db.h>
 #include <zif-depend.h>
 #include <zif-delta.h>
 #include <zif-download.h>
+#include <zif-file-list.h>
 #include <zif-groups.h>
 #include <zif-history.h>
 #include <zif-lock.h>
 #include <zif-manifest.h>
+#include <zif-memory.h>
 #include <zif-package.h>
 #include <zif-package-array.h>
 #include <zif-package-local.h>
@@ -41,11 +44,14 @@
 #include <zif-package-rhn.h>
 #include <zif-release.h>
 #include <zif-repos.h>
+#include <zif-server.h>
+#include <zif-sql-stats.h>
 #include <zif-state.h>
 #include <zif-store-array.h>
 #include <zif-store-directory.h>
 #include <zif-store-local.h>
 #include <zif-store-meta.h>
+#include <zif-store-overlay.h>
 #include <zif-store-remote.h>
 #include <zif-store-rhn.h>
 #include <zif-transaction.h>
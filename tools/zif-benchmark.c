@@ -0,0 +1,1333 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2011 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * zif-benchmark generates a synthetic repository of a configurable size and
+ * times the common library operations against it. The results are printed
+ * as tab separated values so that two builds can be compared with diff or
+ * a spreadsheet.
+ *
+ * The installed system is modelled with a local ZifStoreMeta rather than a
+ * real rpmdb, as creating the latter needs rpmbuild and a chroot.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <locale.h>
+#include <sqlite3.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zif.h>
+#include <zif-private.h>
+
+#include "zif-md.h"
+#include "zif-md-primary-sql.h"
+#include "zif-md-primary-xml.h"
+
+#define ZIF_BENCHMARK_REPO_ID		"benchmark"
+#define ZIF_BENCHMARK_SEED		20110901
+#define ZIF_BENCHMARK_VERSION_NEW	"2.0"
+#define ZIF_BENCHMARK_VERSION_OLD	"1.0"
+#define ZIF_BENCHMARK_RELEASE		"1"
+#define ZIF_BENCHMARK_ARCH		"noarch"
+
+#define ZIF_BENCHMARK_ERROR		(zif_benchmark_error_quark ())
+
+typedef struct {
+	guint			 packages;
+	guint			 fanout;
+	guint			 files;
+	guint			 iterations;
+	guint			 samples;
+	gdouble			 installed_fraction;
+	gchar			*directory;
+	gchar			*repo_dir;		/* <directory>/cache/benchmark */
+	gchar			*checksum_primary_sql;
+	gchar			*checksum_primary_xml;
+	gboolean		*installed;		/* per generated package */
+	GPtrArray		*requires;		/* per package, of gchar* */
+	gchar			**search_names;
+	gchar			**search_files;
+	GPtrArray		*search_provides;	/* of ZifDepend */
+	GPtrArray		*packages_installed;	/* of ZifPackage */
+	GPtrArray		*store_array;
+	ZifConfig		*config;
+	ZifState		*state;
+	ZifStore		*store_local;
+	ZifStore		*store_remote;
+} ZifBenchmarkPrivate;
+
+typedef gboolean (*ZifBenchmarkFunc)	(ZifBenchmarkPrivate	*priv,
+					 GError			**error);
+
+/**
+ * zif_benchmark_error_quark:
+ **/
+static GQuark
+zif_benchmark_error_quark (void)
+{
+	static GQuark quark = 0;
+	if (!quark)
+		quark = g_quark_from_static_string ("zif_benchmark_error");
+	return quark;
+}
+
+/**
+ * zif_benchmark_get_name:
+ **/
+static gchar *
+zif_benchmark_get_name (guint idx)
+{
+	return g_strdup_printf ("pkg%05u", idx);
+}
+
+/**
+ * zif_benchmark_get_pkgid:
+ **/
+static gchar *
+zif_benchmark_get_pkgid (guint idx)
+{
+	gchar *pkgid;
+	gchar *tmp;
+
+	tmp = g_strdup_printf ("pkg%05u-%s-%s",
+			       idx,
+			       ZIF_BENCHMARK_VERSION_NEW,
+			       ZIF_BENCHMARK_RELEASE);
+	pkgid = g_compute_checksum_for_string (G_CHECKSUM_SHA256, tmp, -1);
+	g_free (tmp);
+	return pkgid;
+}
+
+/**
+ * zif_benchmark_get_files:
+ *
+ * Every package ships one binary and one library, and then pads out the
+ * rest of the file list with data files in a private directory.
+ **/
+static GPtrArray *
+zif_benchmark_get_files (ZifBenchmarkPrivate *priv, guint idx)
+{
+	GPtrArray *files;
+	guint i;
+
+	files = g_ptr_array_new_with_free_func (g_free);
+	g_ptr_array_add (files, g_strdup_printf ("/usr/bin/pkg%05u", idx));
+	g_ptr_array_add (files, g_strdup_printf ("/usr/lib/libpkg%05u.so.1", idx));
+	for (i = 2; i < priv->files; i++) {
+		g_ptr_array_add (files, g_strdup_printf ("/usr/share/pkg%05u/data%03u.dat",
+							 idx, i));
+	}
+	return files;
+}
+
+/**
+ * zif_benchmark_generate:
+ *
+ * Packages only ever depend on packages with a lower index, so the
+ * dependency graph is always satisfiable. One in five dependencies is a
+ * file dependency on the binary of the other package.
+ **/
+static void
+zif_benchmark_generate (ZifBenchmarkPrivate *priv)
+{
+	GPtrArray *requires;
+	gchar *tmp;
+	GRand *rand;
+	guint i, j;
+	guint target;
+
+	rand = g_rand_new_with_seed (ZIF_BENCHMARK_SEED);
+	priv->installed = g_new0 (gboolean, priv->packages);
+	priv->requires = g_ptr_array_new_with_free_func ((GDestroyNotify) g_ptr_array_unref);
+	for (i = 0; i < priv->packages; i++) {
+		requires = g_ptr_array_new_with_free_func (g_free);
+		for (j = 0; i > 0 && j < priv->fanout; j++) {
+			target = g_rand_int_range (rand, 0, i);
+			if (g_rand_int_range (rand, 0, 5) == 0) {
+				g_ptr_array_add (requires,
+						 g_strdup_printf ("/usr/bin/pkg%05u", target));
+			} else {
+				g_ptr_array_add (requires,
+						 g_strdup_printf ("libpkg%05u.so.1", target));
+			}
+		}
+		g_ptr_array_add (priv->requires, requires);
+		priv->installed[i] = g_rand_double (rand) < priv->installed_fraction;
+	}
+
+	/* pick the things to search for */
+	priv->search_names = g_new0 (gchar *, priv->samples + 1);
+	priv->search_files = g_new0 (gchar *, priv->samples + 1);
+	priv->search_provides = zif_object_array_new ();
+	for (i = 0; i < priv->samples; i++) {
+		target = g_rand_int_range (rand, 0, priv->packages);
+		priv->search_names[i] = zif_benchmark_get_name (target);
+		priv->search_files[i] = g_strdup_printf ("/usr/bin/pkg%05u", target);
+		tmp = g_strdup_printf ("libpkg%05u.so.1", target);
+		g_ptr_array_add (priv->search_provides,
+				 zif_depend_new_from_values (tmp,
+							     ZIF_DEPEND_FLAG_ANY,
+							     ""));
+		g_free (tmp);
+	}
+	g_rand_free (rand);
+}
+
+/**
+ * zif_benchmark_sqlite_exec:
+ **/
+static gboolean
+zif_benchmark_sqlite_exec (sqlite3 *db, const gchar *statement, GError **error)
+{
+	gboolean ret = TRUE;
+	gchar *error_msg = NULL;
+	gint rc;
+
+	rc = sqlite3_exec (db, statement, NULL, NULL, &error_msg);
+	if (rc != SQLITE_OK) {
+		g_set_error (error,
+			     ZIF_BENCHMARK_ERROR, 0,
+			     "SQL error: %s", error_msg);
+		sqlite3_free (error_msg);
+		ret = FALSE;
+	}
+	return ret;
+}
+
+/**
+ * zif_benchmark_sqlite_prepare:
+ **/
+static sqlite3_stmt *
+zif_benchmark_sqlite_prepare (sqlite3 *db, const gchar *statement, GError **error)
+{
+	gint rc;
+	sqlite3_stmt *stmt = NULL;
+
+	rc = sqlite3_prepare_v2 (db, statement, -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error,
+			     ZIF_BENCHMARK_ERROR, 0,
+			     "failed to prepare: %s",
+			     sqlite3_errmsg (db));
+		stmt = NULL;
+	}
+	return stmt;
+}
+
+/**
+ * zif_benchmark_sqlite_open:
+ **/
+static sqlite3 *
+zif_benchmark_sqlite_open (const gchar *filename, const gchar *schema, GError **error)
+{
+	gboolean ret;
+	gint rc;
+	sqlite3 *db = NULL;
+
+	g_unlink (filename);
+	rc = sqlite3_open (filename, &db);
+	if (rc != SQLITE_OK) {
+		g_set_error (error,
+			     ZIF_BENCHMARK_ERROR, 0,
+			     "can't open database %s: %s",
+			     filename, sqlite3_errmsg (db));
+		sqlite3_close (db);
+		db = NULL;
+		goto out;
+	}
+	ret = zif_benchmark_sqlite_exec (db, schema, error);
+	if (!ret) {
+		sqlite3_close (db);
+		db = NULL;
+		goto out;
+	}
+out:
+	return db;
+}
+
+/**
+ * zif_benchmark_write_primary_sql:
+ **/
+static gboolean
+zif_benchmark_write_primary_sql (ZifBenchmarkPrivate *priv,
+				 const gchar *filename,
+				 GError **error)
+{
+	const gchar *tmp;
+	gboolean ret = FALSE;
+	gchar *name;
+	gchar *pkgid;
+	GPtrArray *files;
+	GPtrArray *requires;
+	guint i, j;
+	sqlite3 *db;
+	sqlite3_stmt *stmt_file = NULL;
+	sqlite3_stmt *stmt_package = NULL;
+	sqlite3_stmt *stmt_provide = NULL;
+	sqlite3_stmt *stmt_require = NULL;
+
+	db = zif_benchmark_sqlite_open (filename,
+		"CREATE TABLE db_info (dbversion INTEGER, checksum TEXT);"
+		"CREATE TABLE packages (pkgKey INTEGER PRIMARY KEY, pkgId TEXT, "
+		"name TEXT, arch TEXT, version TEXT, epoch TEXT, release TEXT, "
+		"summary TEXT, description TEXT, url TEXT, time_file INTEGER, "
+		"time_build INTEGER, rpm_license TEXT, rpm_vendor TEXT, "
+		"rpm_group TEXT, rpm_buildhost TEXT, rpm_sourcerpm TEXT, "
+		"rpm_header_start INTEGER, rpm_header_end INTEGER, "
+		"rpm_packager TEXT, size_package INTEGER, size_installed INTEGER, "
+		"size_archive INTEGER, location_href TEXT, location_base TEXT, "
+		"checksum_type TEXT);"
+		"CREATE TABLE files (name TEXT, type TEXT, pkgKey INTEGER);"
+		"CREATE TABLE requires (name TEXT, flags TEXT, epoch TEXT, "
+		"version TEXT, release TEXT, pkgKey INTEGER, pre BOOLEAN DEFAULT FALSE);"
+		"CREATE TABLE provides (name TEXT, flags TEXT, epoch TEXT, "
+		"version TEXT, release TEXT, pkgKey INTEGER);"
+		"CREATE TABLE conflicts (name TEXT, flags TEXT, epoch TEXT, "
+		"version TEXT, release TEXT, pkgKey INTEGER);"
+		"CREATE TABLE obsoletes (name TEXT, flags TEXT, epoch TEXT, "
+		"version TEXT, release TEXT, pkgKey INTEGER);"
+		"CREATE INDEX packagename ON packages (name);"
+		"CREATE INDEX packageId ON packages (pkgId);"
+		"CREATE INDEX filenames ON files (name);"
+		"CREATE INDEX pkgfiles ON files (pkgKey);"
+		"CREATE INDEX pkgrequires ON requires (pkgKey);"
+		"CREATE INDEX requiresname ON requires (name);"
+		"CREATE INDEX pkgprovides ON provides (pkgKey);"
+		"CREATE INDEX providesname ON provides (name);"
+		"INSERT INTO db_info VALUES (10, 'benchmark');",
+		error);
+	if (db == NULL)
+		goto out;
+
+	stmt_package = zif_benchmark_sqlite_prepare (db,
+		"INSERT INTO packages (pkgKey, pkgId, name, arch, version, "
+		"epoch, release, summary, description, url, time_file, "
+		"time_build, rpm_license, rpm_group, rpm_sourcerpm, "
+		"size_package, size_installed, location_href, checksum_type) "
+		"VALUES (?, ?, ?, '" ZIF_BENCHMARK_ARCH "', "
+		"'" ZIF_BENCHMARK_VERSION_NEW "', '0', '" ZIF_BENCHMARK_RELEASE "', "
+		"'Synthetic benchmark package', 'A package generated by zif-benchmark', "
+		"'http://example.com/', 1300000000, 1300000000, 'GPLv2+', "
+		"'Applications/System', ?, 1024, 4096, ?, 'sha256');",
+		error);
+	if (stmt_package == NULL)
+		goto out;
+	stmt_file = zif_benchmark_sqlite_prepare (db,
+		"INSERT INTO files (name, type, pkgKey) VALUES (?, 'file', ?);",
+		error);
+	if (stmt_file == NULL)
+		goto out;
+	stmt_provide = zif_benchmark_sqlite_prepare (db,
+		"INSERT INTO provides (name, flags, epoch, version, release, pkgKey) "
+		"VALUES (?, ?, ?, ?, ?, ?);",
+		error);
+	if (stmt_provide == NULL)
+		goto out;
+	stmt_require = zif_benchmark_sqlite_prepare (db,
+		"INSERT INTO requires (name, pkgKey) VALUES (?, ?);",
+		error);
+	if (stmt_require == NULL)
+		goto out;
+
+	ret = zif_benchmark_sqlite_exec (db, "BEGIN;", error);
+	if (!ret)
+		goto out;
+	for (i = 0; i < priv->packages; i++) {
+		name = zif_benchmark_get_name (i);
+		pkgid = zif_benchmark_get_pkgid (i);
+
+		/* package */
+		sqlite3_bind_int (stmt_package, 1, i + 1);
+		sqlite3_bind_text (stmt_package, 2, pkgid, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text (stmt_package, 3, name, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text (stmt_package, 4,
+				   g_strdup_printf ("%s-%s-%s.src.rpm", name,
+						    ZIF_BENCHMARK_VERSION_NEW,
+						    ZIF_BENCHMARK_RELEASE),
+				   -1, g_free);
+		sqlite3_bind_text (stmt_package, 5,
+				   g_strdup_printf ("Packages/%s-%s-%s.%s.rpm", name,
+						    ZIF_BENCHMARK_VERSION_NEW,
+						    ZIF_BENCHMARK_RELEASE,
+						    ZIF_BENCHMARK_ARCH),
+				   -1, g_free);
+		sqlite3_step (stmt_package);
+		sqlite3_reset (stmt_package);
+
+		/* provides itself and a library */
+		sqlite3_bind_text (stmt_provide, 1, name, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text (stmt_provide, 2, "EQ", -1, SQLITE_STATIC);
+		sqlite3_bind_text (stmt_provide, 3, "0", -1, SQLITE_STATIC);
+		sqlite3_bind_text (stmt_provide, 4, ZIF_BENCHMARK_VERSION_NEW, -1, SQLITE_STATIC);
+		sqlite3_bind_text (stmt_provide, 5, ZIF_BENCHMARK_RELEASE, -1, SQLITE_STATIC);
+		sqlite3_bind_int (stmt_provide, 6, i + 1);
+		sqlite3_step (stmt_provide);
+		sqlite3_reset (stmt_provide);
+		sqlite3_clear_bindings (stmt_provide);
+		sqlite3_bind_text (stmt_provide, 1,
+				   g_strdup_printf ("lib%s.so.1", name),
+				   -1, g_free);
+		sqlite3_bind_int (stmt_provide, 6, i + 1);
+		sqlite3_step (stmt_provide);
+		sqlite3_reset (stmt_provide);
+		sqlite3_clear_bindings (stmt_provide);
+
+		/* requires */
+		requires = g_ptr_array_index (priv->requires, i);
+		for (j = 0; j < requires->len; j++) {
+			tmp = g_ptr_array_index (requires, j);
+			sqlite3_bind_text (stmt_require, 1, tmp, -1, SQLITE_STATIC);
+			sqlite3_bind_int (stmt_require, 2, i + 1);
+			sqlite3_step (stmt_require);
+			sqlite3_reset (stmt_require);
+		}
+
+		/* like createrepo, only the primary files go in here */
+		files = zif_benchmark_get_files (priv, i);
+		for (j = 0; j < files->len; j++) {
+			tmp = g_ptr_array_index (files, j);
+			if (!g_str_has_prefix (tmp, "/usr/bin/"))
+				continue;
+			sqlite3_bind_text (stmt_file, 1, tmp, -1, SQLITE_STATIC);
+			sqlite3_bind_int (stmt_file, 2, i + 1);
+			sqlite3_step (stmt_file);
+			sqlite3_reset (stmt_file);
+		}
+		g_ptr_array_unref (files);
+		g_free (name);
+		g_free (pkgid);
+	}
+	ret = zif_benchmark_sqlite_exec (db, "COMMIT;", error);
+	if (!ret)
+		goto out;
+out:
+	if (stmt_package != NULL)
+		sqlite3_finalize (stmt_package);
+	if (stmt_file != NULL)
+		sqlite3_finalize (stmt_file);
+	if (stmt_provide != NULL)
+		sqlite3_finalize (stmt_provide);
+	if (stmt_require != NULL)
+		sqlite3_finalize (stmt_require);
+	if (db != NULL)
+		sqlite3_close (db);
+	return ret;
+}
+
+/**
+ * zif_benchmark_write_filelists_sql:
+ **/
+static gboolean
+zif_benchmark_write_filelists_sql (ZifBenchmarkPrivate *priv,
+				   const gchar *filename,
+				   GError **error)
+{
+	const gchar *tmp = NULL;
+	gboolean ret = FALSE;
+	gchar *dirname;
+	gchar *dirname_last = NULL;
+	GPtrArray *files;
+	GString *basenames;
+	GString *filetypes;
+	guint i, j;
+	sqlite3 *db;
+	sqlite3_stmt *stmt_filelist = NULL;
+	sqlite3_stmt *stmt_package = NULL;
+
+	db = zif_benchmark_sqlite_open (filename,
+		"CREATE TABLE db_info (dbversion INTEGER, checksum TEXT);"
+		"CREATE TABLE packages (pkgKey INTEGER PRIMARY KEY, pkgId TEXT);"
+		"CREATE TABLE filelist (pkgKey INTEGER, dirname TEXT, "
+		"filenames TEXT, filetypes TEXT);"
+		"CREATE INDEX keyfile ON filelist (pkgKey);"
+		"CREATE INDEX pkgId ON packages (pkgId);"
+		"CREATE INDEX dirnames ON filelist (dirname);"
+		"INSERT INTO db_info VALUES (10, 'benchmark');",
+		error);
+	if (db == NULL)
+		goto out;
+
+	stmt_package = zif_benchmark_sqlite_prepare (db,
+		"INSERT INTO packages (pkgKey, pkgId) VALUES (?, ?);",
+		error);
+	if (stmt_package == NULL)
+		goto out;
+	stmt_filelist = zif_benchmark_sqlite_prepare (db,
+		"INSERT INTO filelist (pkgKey, dirname, filenames, filetypes) "
+		"VALUES (?, ?, ?, ?);",
+		error);
+	if (stmt_filelist == NULL)
+		goto out;
+
+	ret = zif_benchmark_sqlite_exec (db, "BEGIN;", error);
+	if (!ret)
+		goto out;
+	basenames = g_string_new ("");
+	filetypes = g_string_new ("");
+	for (i = 0; i < priv->packages; i++) {
+		sqlite3_bind_int (stmt_package, 1, i + 1);
+		sqlite3_bind_text (stmt_package, 2,
+				   zif_benchmark_get_pkgid (i),
+				   -1, g_free);
+		sqlite3_step (stmt_package);
+		sqlite3_reset (stmt_package);
+
+		/* files are grouped by directory, and are sorted already */
+		files = zif_benchmark_get_files (priv, i);
+		for (j = 0; j <= files->len; j++) {
+			dirname = NULL;
+			if (j < files->len) {
+				tmp = g_ptr_array_index (files, j);
+				dirname = g_path_get_dirname (tmp);
+				if (g_strcmp0 (dirname, dirname_last) == 0) {
+					g_string_append_printf (basenames, "/%s",
+								strrchr (tmp, '/') + 1);
+					g_string_append_c (filetypes, 'f');
+					g_free (dirname);
+					continue;
+				}
+			}
+
+			/* flush the previous directory */
+			if (dirname_last != NULL) {
+				sqlite3_bind_int (stmt_filelist, 1, i + 1);
+				sqlite3_bind_text (stmt_filelist, 2, dirname_last, -1, SQLITE_STATIC);
+				sqlite3_bind_text (stmt_filelist, 3, basenames->str, -1, SQLITE_STATIC);
+				sqlite3_bind_text (stmt_filelist, 4, filetypes->str, -1, SQLITE_STATIC);
+				sqlite3_step (stmt_filelist);
+				sqlite3_reset (stmt_filelist);
+				g_free (dirname_last);
+			}
+			dirname_last = dirname;
+			if (dirname != NULL) {
+				g_string_assign (basenames, strrchr (tmp, '/') + 1);
+				g_string_assign (filetypes, "f");
+			}
+		}
+		g_ptr_array_unref (files);
+	}
+	g_string_free (basenames, TRUE);
+	g_string_free (filetypes, TRUE);
+	ret = zif_benchmark_sqlite_exec (db, "COMMIT;", error);
+	if (!ret)
+		goto out;
+out:
+	if (stmt_package != NULL)
+		sqlite3_finalize (stmt_package);
+	if (stmt_filelist != NULL)
+		sqlite3_finalize (stmt_filelist);
+	if (db != NULL)
+		sqlite3_close (db);
+	return ret;
+}
+
+/**
+ * zif_benchmark_write_primary_xml:
+ **/
+static gboolean
+zif_benchmark_write_primary_xml (ZifBenchmarkPrivate *priv,
+				 const gchar *filename,
+				 GError **error)
+{
+	const gchar *tmp;
+	gboolean ret;
+	gchar *name;
+	gchar *pkgid;
+	GPtrArray *files;
+	GPtrArray *requires;
+	GString *xml;
+	guint i, j;
+
+	xml = g_string_new ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	g_string_append_printf (xml, "<metadata xmlns=\"http://linux.duke.edu/metadata/common\" "
+				"xmlns:rpm=\"http://linux.duke.edu/metadata/rpm\" "
+				"packages=\"%u\">\n", priv->packages);
+	for (i = 0; i < priv->packages; i++) {
+		name = zif_benchmark_get_name (i);
+		pkgid = zif_benchmark_get_pkgid (i);
+		g_string_append (xml, "<package type=\"rpm\">\n");
+		g_string_append_printf (xml, "  <name>%s</name>\n", name);
+		g_string_append (xml, "  <arch>" ZIF_BENCHMARK_ARCH "</arch>\n");
+		g_string_append (xml, "  <version epoch=\"0\" ver=\"" ZIF_BENCHMARK_VERSION_NEW
+				 "\" rel=\"" ZIF_BENCHMARK_RELEASE "\"/>\n");
+		g_string_append_printf (xml, "  <checksum type=\"sha256\" pkgid=\"YES\">%s</checksum>\n",
+					pkgid);
+		g_string_append (xml, "  <summary>Synthetic benchmark package</summary>\n"
+				 "  <description>A package generated by zif-benchmark</description>\n"
+				 "  <packager></packager>\n"
+				 "  <url>http://example.com/</url>\n"
+				 "  <time file=\"1300000000\" build=\"1300000000\"/>\n"
+				 "  <size package=\"1024\" installed=\"4096\" archive=\"4096\"/>\n");
+		g_string_append_printf (xml, "  <location href=\"Packages/%s-%s-%s.%s.rpm\"/>\n",
+					name,
+					ZIF_BENCHMARK_VERSION_NEW,
+					ZIF_BENCHMARK_RELEASE,
+					ZIF_BENCHMARK_ARCH);
+		g_string_append (xml, "  <format>\n"
+				 "    <rpm:license>GPLv2+</rpm:license>\n"
+				 "    <rpm:vendor></rpm:vendor>\n"
+				 "    <rpm:group>Applications/System</rpm:group>\n"
+				 "    <rpm:buildhost>localhost</rpm:buildhost>\n");
+		g_string_append_printf (xml, "    <rpm:sourcerpm>%s-%s-%s.src.rpm</rpm:sourcerpm>\n",
+					name,
+					ZIF_BENCHMARK_VERSION_NEW,
+					ZIF_BENCHMARK_RELEASE);
+		g_string_append (xml, "    <rpm:header-range start=\"0\" end=\"0\"/>\n"
+				 "    <rpm:provides>\n");
+		g_string_append_printf (xml, "      <rpm:entry name=\"%s\" flags=\"EQ\" epoch=\"0\" "
+					"ver=\"%s\" rel=\"%s\"/>\n",
+					name,
+					ZIF_BENCHMARK_VERSION_NEW,
+					ZIF_BENCHMARK_RELEASE);
+		g_string_append_printf (xml, "      <rpm:entry name=\"lib%s.so.1\"/>\n", name);
+		g_string_append (xml, "    </rpm:provides>\n");
+		requires = g_ptr_array_index (priv->requires, i);
+		if (requires->len > 0) {
+			g_string_append (xml, "    <rpm:requires>\n");
+			for (j = 0; j < requires->len; j++) {
+				tmp = g_ptr_array_index (requires, j);
+				g_string_append_printf (xml, "      <rpm:entry name=\"%s\"/>\n", tmp);
+			}
+			g_string_append (xml, "    </rpm:requires>\n");
+		}
+		files = zif_benchmark_get_files (priv, i);
+		for (j = 0; j < files->len; j++) {
+			tmp = g_ptr_array_index (files, j);
+			if (!g_str_has_prefix (tmp, "/usr/bin/"))
+				continue;
+			g_string_append_printf (xml, "    <file>%s</file>\n", tmp);
+		}
+		g_ptr_array_unref (files);
+		g_string_append (xml, "  </format>\n</package>\n");
+		g_free (name);
+		g_free (pkgid);
+	}
+	g_string_append (xml, "</metadata>\n");
+	ret = g_file_set_contents (filename, xml->str, xml->len, error);
+	g_string_free (xml, TRUE);
+	return ret;
+}
+
+/**
+ * zif_benchmark_get_checksum:
+ **/
+static gchar *
+zif_benchmark_get_checksum (const gchar *filename, GError **error)
+{
+	gboolean ret;
+	gchar *checksum = NULL;
+	gchar *data = NULL;
+	gsize len;
+
+	ret = g_file_get_contents (filename, &data, &len, error);
+	if (!ret)
+		goto out;
+	checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+						(const guchar *) data, len);
+out:
+	g_free (data);
+	return checksum;
+}
+
+/**
+ * zif_benchmark_append_repomd:
+ *
+ * The files are not compressed, so the open-checksum is the same as the
+ * checksum of the file on disk.
+ **/
+static void
+zif_benchmark_append_repomd (GString *xml,
+			     const gchar *type,
+			     const gchar *basename,
+			     const gchar *checksum,
+			     gboolean is_database)
+{
+	g_string_append_printf (xml, "  <data type=\"%s\">\n", type);
+	g_string_append_printf (xml, "    <location href=\"repodata/%s\"/>\n", basename);
+	g_string_append_printf (xml, "    <checksum type=\"sha256\">%s</checksum>\n", checksum);
+	g_string_append (xml, "    <timestamp>1300000000</timestamp>\n");
+	g_string_append_printf (xml, "    <open-checksum type=\"sha256\">%s</open-checksum>\n", checksum);
+	if (is_database)
+		g_string_append (xml, "    <database_version>10</database_version>\n");
+	g_string_append (xml, "  </data>\n");
+}
+
+/**
+ * zif_benchmark_write_repo:
+ **/
+static gboolean
+zif_benchmark_write_repo (ZifBenchmarkPrivate *priv, GError **error)
+{
+	gboolean ret;
+	gchar *checksum_filelists = NULL;
+	gchar *filename;
+	gchar *repos_dir;
+	GString *xml;
+
+	/* everything lives in the cache, so nothing is ever downloaded */
+	priv->repo_dir = g_build_filename (priv->directory, "cache",
+					   ZIF_BENCHMARK_REPO_ID, NULL);
+	repos_dir = g_build_filename (priv->directory, "repos", NULL);
+	g_mkdir_with_parents (priv->repo_dir, 0755);
+	g_mkdir_with_parents (repos_dir, 0755);
+
+	filename = g_build_filename (priv->repo_dir, "primary.sqlite", NULL);
+	ret = zif_benchmark_write_primary_sql (priv, filename, error);
+	if (!ret)
+		goto out;
+	priv->checksum_primary_sql = zif_benchmark_get_checksum (filename, error);
+	if (priv->checksum_primary_sql == NULL) {
+		ret = FALSE;
+		goto out;
+	}
+	g_free (filename);
+
+	filename = g_build_filename (priv->repo_dir, "primary.xml", NULL);
+	ret = zif_benchmark_write_primary_xml (priv, filename, error);
+	if (!ret)
+		goto out;
+	priv->checksum_primary_xml = zif_benchmark_get_checksum (filename, error);
+	if (priv->checksum_primary_xml == NULL) {
+		ret = FALSE;
+		goto out;
+	}
+	g_free (filename);
+
+	filename = g_build_filename (priv->repo_dir, "filelists.sqlite", NULL);
+	ret = zif_benchmark_write_filelists_sql (priv, filename, error);
+	if (!ret)
+		goto out;
+	checksum_filelists = zif_benchmark_get_checksum (filename, error);
+	if (checksum_filelists == NULL) {
+		ret = FALSE;
+		goto out;
+	}
+	g_free (filename);
+
+	/* repomd.xml */
+	xml = g_string_new ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			    "<repomd xmlns=\"http://linux.duke.edu/metadata/repo\">\n"
+			    "  <revision>1300000000</revision>\n");
+	zif_benchmark_append_repomd (xml, "primary_db", "primary.sqlite",
+				     priv->checksum_primary_sql, TRUE);
+	zif_benchmark_append_repomd (xml, "primary", "primary.xml",
+				     priv->checksum_primary_xml, FALSE);
+	zif_benchmark_append_repomd (xml, "filelists_db", "filelists.sqlite",
+				     checksum_filelists, TRUE);
+	g_string_append (xml, "</repomd>\n");
+	filename = g_build_filename (priv->repo_dir, "repomd.xml", NULL);
+	ret = g_file_set_contents (filename, xml->str, xml->len, error);
+	g_string_free (xml, TRUE);
+	if (!ret)
+		goto out;
+	g_free (filename);
+
+	/* repo file */
+	filename = g_build_filename (repos_dir, ZIF_BENCHMARK_REPO_ID ".repo", NULL);
+	xml = g_string_new ("[" ZIF_BENCHMARK_REPO_ID "]\n");
+	g_string_append (xml, "name=Synthetic benchmark repository\n");
+	g_string_append_printf (xml, "baseurl=file://%s\n", priv->repo_dir);
+	g_string_append (xml, "enabled=1\ngpgcheck=0\n");
+	ret = g_file_set_contents (filename, xml->str, xml->len, error);
+	g_string_free (xml, TRUE);
+	if (!ret)
+		goto out;
+out:
+	g_free (filename);
+	g_free (checksum_filelists);
+	g_free (repos_dir);
+	return ret;
+}
+
+/**
+ * zif_benchmark_depend_array_new:
+ **/
+static GPtrArray *
+zif_benchmark_depend_array_new (GPtrArray *names)
+{
+	GPtrArray *depends;
+	guint i;
+
+	depends = zif_object_array_new ();
+	for (i = 0; i < names->len; i++) {
+		g_ptr_array_add (depends,
+				 zif_depend_new_from_values (g_ptr_array_index (names, i),
+							     ZIF_DEPEND_FLAG_ANY,
+							     ""));
+	}
+	return depends;
+}
+
+/**
+ * zif_benchmark_setup_local:
+ *
+ * Builds the installed system out of meta packages that carry the old
+ * version of each selected remote package.
+ **/
+static gboolean
+zif_benchmark_setup_local (ZifBenchmarkPrivate *priv, GError **error)
+{
+	gboolean ret = TRUE;
+	gchar *name;
+	gchar *package_id;
+	GPtrArray *depends;
+	GPtrArray *empty;
+	GPtrArray *files;
+	GPtrArray *names;
+	guint i;
+	ZifPackage *package;
+	ZifString *summary;
+
+	priv->store_local = zif_store_meta_new ();
+	zif_store_meta_set_is_local (ZIF_STORE_META (priv->store_local), TRUE);
+	priv->packages_installed = zif_object_array_new ();
+	empty = zif_object_array_new ();
+	summary = zif_string_new ("Synthetic benchmark package");
+	for (i = 0; i < priv->packages; i++) {
+		if (!priv->installed[i])
+			continue;
+
+		name = zif_benchmark_get_name (i);
+		package = zif_package_meta_new ();
+		package_id = zif_package_id_from_nevra (name, 0,
+							ZIF_BENCHMARK_VERSION_OLD,
+							ZIF_BENCHMARK_RELEASE,
+							ZIF_BENCHMARK_ARCH,
+							"installed");
+		ret = zif_package_set_id (package, package_id, error);
+		g_free (package_id);
+		if (!ret) {
+			g_free (name);
+			g_object_unref (package);
+			goto out;
+		}
+		zif_package_set_installed (package, TRUE);
+		zif_package_set_summary (package, summary);
+		zif_package_set_conflicts (package, empty);
+		zif_package_set_obsoletes (package, empty);
+
+		/* provides */
+		names = g_ptr_array_new_with_free_func (g_free);
+		g_ptr_array_add (names, g_strdup_printf ("lib%s.so.1", name));
+		depends = zif_benchmark_depend_array_new (names);
+		g_ptr_array_add (depends,
+				 zif_depend_new_from_values (name,
+							     ZIF_DEPEND_FLAG_EQUAL,
+							     ZIF_BENCHMARK_VERSION_OLD "-"
+							     ZIF_BENCHMARK_RELEASE));
+		zif_package_set_provides (package, depends);
+		g_ptr_array_unref (depends);
+		g_ptr_array_unref (names);
+
+		/* requires */
+		depends = zif_benchmark_depend_array_new (g_ptr_array_index (priv->requires, i));
+		zif_package_set_requires (package, depends);
+		g_ptr_array_unref (depends);
+
+		/* files */
+		files = zif_benchmark_get_files (priv, i);
+		zif_package_set_files (package, files);
+		g_ptr_array_unref (files);
+
+		ret = zif_store_add_package (priv->store_local, package, error);
+		if (!ret) {
+			g_free (name);
+			g_object_unref (package);
+			goto out;
+		}
+		g_ptr_array_add (priv->packages_installed, package);
+		g_free (name);
+	}
+out:
+	zif_string_unref (summary);
+	g_ptr_array_unref (empty);
+	return ret;
+}
+
+/**
+ * zif_benchmark_setup_config:
+ **/
+static gboolean
+zif_benchmark_setup_config (ZifBenchmarkPrivate *priv,
+			    const gchar *config_file,
+			    GError **error)
+{
+	gboolean ret;
+	gchar *tmp;
+
+	priv->config = zif_config_new ();
+	ret = zif_config_set_filename (priv->config, config_file, error);
+	if (!ret)
+		goto out;
+
+	/* keep everything inside the benchmark directory */
+	tmp = g_build_filename (priv->directory, "cache", NULL);
+	zif_config_set_string (priv->config, "cachedir", tmp, NULL);
+	g_free (tmp);
+	tmp = g_build_filename (priv->directory, "repos", NULL);
+	zif_config_set_string (priv->config, "reposdir", tmp, NULL);
+	g_free (tmp);
+	tmp = g_build_filename (priv->directory, "zif.lock", NULL);
+	zif_config_set_string (priv->config, "pidfile", tmp, NULL);
+	g_free (tmp);
+	tmp = g_build_filename (priv->directory, "history.db", NULL);
+	zif_config_set_string (priv->config, "history_db", tmp, NULL);
+	g_free (tmp);
+	tmp = g_build_filename (priv->directory, "yumdb", NULL);
+	zif_config_set_string (priv->config, "yumdb", tmp, NULL);
+	g_free (tmp);
+
+	/* never download or expire anything */
+	zif_config_set_boolean (priv->config, "network", FALSE, NULL);
+	zif_config_set_boolean (priv->config, "use_installed_history", FALSE, NULL);
+	zif_config_set_boolean (priv->config, "skip_broken", FALSE, NULL);
+	zif_config_set_uint (priv->config, "metadata_expire", 0, NULL);
+	zif_config_set_uint (priv->config, "mirrorlist_expire", 0, NULL);
+out:
+	return ret;
+}
+
+/**
+ * zif_benchmark_setup_remote:
+ **/
+static gboolean
+zif_benchmark_setup_remote (ZifBenchmarkPrivate *priv, GError **error)
+{
+	gboolean ret;
+	gchar *filename;
+
+	priv->store_remote = zif_store_remote_new ();
+	filename = g_build_filename (priv->directory, "repos",
+				     ZIF_BENCHMARK_REPO_ID ".repo", NULL);
+	zif_state_reset (priv->state);
+	ret = zif_store_remote_set_from_file (ZIF_STORE_REMOTE (priv->store_remote),
+					      filename,
+					      ZIF_BENCHMARK_REPO_ID,
+					      priv->state,
+					      error);
+	g_free (filename);
+	if (!ret)
+		goto out;
+	zif_state_reset (priv->state);
+	ret = zif_store_load (priv->store_remote, priv->state, error);
+	if (!ret)
+		goto out;
+	priv->store_array = zif_store_array_new ();
+	zif_store_array_add_store (priv->store_array, priv->store_remote);
+out:
+	return ret;
+}
+
+/**
+ * zif_benchmark_md_load:
+ **/
+static gboolean
+zif_benchmark_md_load (ZifBenchmarkPrivate *priv,
+		       ZifMd *md,
+		       const gchar *basename,
+		       const gchar *checksum,
+		       GError **error)
+{
+	gboolean ret;
+	gchar *filename;
+
+	filename = g_build_filename (priv->repo_dir, basename, NULL);
+	zif_md_set_store (md, priv->store_remote);
+	zif_md_set_id (md, ZIF_BENCHMARK_REPO_ID);
+	zif_md_set_checksum_type (md, G_CHECKSUM_SHA256);
+	zif_md_set_checksum (md, checksum);
+	zif_md_set_checksum_uncompressed (md, checksum);
+	zif_md_set_filename (md, filename);
+	ret = zif_md_load (md, priv->state, error);
+	g_free (filename);
+	return ret;
+}
+
+/**
+ * zif_benchmark_load_primary_sql:
+ **/
+static gboolean
+zif_benchmark_load_primary_sql (ZifBenchmarkPrivate *priv, GError **error)
+{
+	gboolean ret;
+	ZifMd *md;
+
+	md = zif_md_primary_sql_new ();
+	ret = zif_benchmark_md_load (priv, md, "primary.sqlite",
+				     priv->checksum_primary_sql, error);
+	g_object_unref (md);
+	return ret;
+}
+
+/**
+ * zif_benchmark_load_primary_xml:
+ **/
+static gboolean
+zif_benchmark_load_primary_xml (ZifBenchmarkPrivate *priv, GError **error)
+{
+	gboolean ret;
+	ZifMd *md;
+
+	md = zif_md_primary_xml_new ();
+	ret = zif_benchmark_md_load (priv, md, "primary.xml",
+				     priv->checksum_primary_xml, error);
+	g_object_unref (md);
+	return ret;
+}
+
+/**
+ * zif_benchmark_resolve:
+ **/
+static gboolean
+zif_benchmark_resolve (ZifBenchmarkPrivate *priv, GError **error)
+{
+	GPtrArray *array;
+
+	array = zif_store_resolve (priv->store_remote,
+				   priv->search_names,
+				   priv->state,
+				   error);
+	if (array == NULL)
+		return FALSE;
+	g_ptr_array_unref (array);
+	return TRUE;
+}
+
+/**
+ * zif_benchmark_what_provides:
+ **/
+static gboolean
+zif_benchmark_what_provides (ZifBenchmarkPrivate *priv, GError **error)
+{
+	GPtrArray *array;
+
+	array = zif_store_what_provides (priv->store_remote,
+					 priv->search_provides,
+					 priv->state,
+					 error);
+	if (array == NULL)
+		return FALSE;
+	g_ptr_array_unref (array);
+	return TRUE;
+}
+
+/**
+ * zif_benchmark_search_file:
+ **/
+static gboolean
+zif_benchmark_search_file (ZifBenchmarkPrivate *priv, GError **error)
+{
+	GPtrArray *array;
+
+	array = zif_store_search_file (priv->store_remote,
+				       priv->search_files,
+				       priv->state,
+				       error);
+	if (array == NULL)
+		return FALSE;
+	g_ptr_array_unref (array);
+	return TRUE;
+}
+
+/**
+ * zif_benchmark_get_updates:
+ **/
+static gboolean
+zif_benchmark_get_updates (ZifBenchmarkPrivate *priv, GError **error)
+{
+	GPtrArray *array;
+
+	array = zif_store_array_get_updates (priv->store_array,
+					     priv->store_local,
+					     priv->state,
+					     error);
+	if (array == NULL)
+		return FALSE;
+	g_ptr_array_unref (array);
+	return TRUE;
+}
+
+/**
+ * zif_benchmark_transaction_resolve:
+ *
+ * Updates every installed package, which pulls in any missing
+ * dependencies of the new versions.
+ **/
+static gboolean
+zif_benchmark_transaction_resolve (ZifBenchmarkPrivate *priv, GError **error)
+{
+	gboolean ret = TRUE;
+	guint i;
+	ZifPackage *package;
+	ZifTransaction *transaction;
+
+	transaction = zif_transaction_new ();
+	zif_transaction_set_store_local (transaction, priv->store_local);
+	zif_transaction_set_stores_remote (transaction, priv->store_array);
+	for (i = 0; i < priv->packages_installed->len; i++) {
+		package = g_ptr_array_index (priv->packages_installed, i);
+		ret = zif_transaction_add_update (transaction, package, error);
+		if (!ret)
+			goto out;
+	}
+	ret = zif_transaction_resolve (transaction, priv->state, error);
+	if (!ret)
+		goto out;
+out:
+	g_object_unref (transaction);
+	return ret;
+}
+
+/**
+ * zif_benchmark_run:
+ **/
+static gboolean
+zif_benchmark_run (ZifBenchmarkPrivate *priv,
+		   const gchar *name,
+		   ZifBenchmarkFunc func,
+		   GError **error)
+{
+	gboolean ret = TRUE;
+	gdouble elapsed;
+	gdouble max = 0.0f;
+	gdouble min = G_MAXDOUBLE;
+	gdouble total = 0.0f;
+	GTimer *timer;
+	guint i;
+
+	timer = g_timer_new ();
+	for (i = 0; i < priv->iterations; i++) {
+		zif_state_reset (priv->state);
+		g_timer_start (timer);
+		ret = func (priv, error);
+		if (!ret) {
+			g_prefix_error (error, "%s: ", name);
+			goto out;
+		}
+		elapsed = g_timer_elapsed (timer, NULL) * 1000.0f;
+		total += elapsed;
+		min = MIN (min, elapsed);
+		max = MAX (max, elapsed);
+	}
+	g_print ("%s\t%u\t%.3f\t%.3f\t%.3f\n",
+		 name, priv->iterations, min, total / priv->iterations, max);
+out:
+	g_timer_destroy (timer);
+	return ret;
+}
+
+/**
+ * zif_benchmark_ignore_cb:
+ **/
+static void
+zif_benchmark_ignore_cb (const gchar *log_domain, GLogLevelFlags log_level,
+			 const gchar *message, gpointer user_data)
+{
+}
+
+/**
+ * main:
+ **/
+int
+main (int argc, char *argv[])
+{
+	gboolean ret;
+	gboolean verbose = FALSE;
+	gchar *config_file = NULL;
+	gchar *directory = NULL;
+	gdouble installed = 0.5f;
+	GError *error = NULL;
+	GOptionContext *context;
+	gint retval = EXIT_FAILURE;
+	guint i;
+	gint fanout = 5;
+	gint files = 10;
+	gint iterations = 3;
+	gint packages = 1000;
+	gint samples = 100;
+	GTimer *timer;
+	ZifBenchmarkPrivate *priv;
+
+	const GOptionEntry options[] = {
+		{ "packages", '\0', 0, G_OPTION_ARG_INT, &packages,
+			"Number of packages in the synthetic repository", NULL },
+		{ "fanout", '\0', 0, G_OPTION_ARG_INT, &fanout,
+			"Number of dependencies for each package", NULL },
+		{ "files", '\0', 0, G_OPTION_ARG_INT, &files,
+			"Number of files in each package", NULL },
+		{ "installed", '\0', 0, G_OPTION_ARG_DOUBLE, &installed,
+			"Fraction of packages with an older version installed", NULL },
+		{ "iterations", '\0', 0, G_OPTION_ARG_INT, &iterations,
+			"Number of times to run each test", NULL },
+		{ "samples", '\0', 0, G_OPTION_ARG_INT, &samples,
+			"Number of items to search for in each query", NULL },
+		{ "directory", '\0', 0, G_OPTION_ARG_FILENAME, &directory,
+			"Directory to create the repository in", NULL },
+		{ "config", 'c', 0, G_OPTION_ARG_FILENAME, &config_file,
+			"Use different config file", NULL },
+		{ "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose,
+			"Show extra debugging information", NULL },
+		{ NULL}
+	};
+
+	setlocale (LC_ALL, "");
+
+	priv = g_new0 (ZifBenchmarkPrivate, 1);
+
+	context = g_option_context_new ("ZIF Benchmark Program");
+	g_option_context_add_main_entries (context, options, NULL);
+	ret = g_option_context_parse (context, &argc, &argv, &error);
+	g_option_context_free (context);
+	if (!ret) {
+		g_printerr ("Failed to parse options: %s\n", error->message);
+		g_error_free (error);
+		goto out;
+	}
+	if (packages < 2 || fanout < 0 || files < 2 || iterations < 1 || samples < 1) {
+		g_printerr ("Invalid benchmark parameters\n");
+		goto out;
+	}
+	priv->packages = packages;
+	priv->fanout = fanout;
+	priv->files = files;
+	priv->iterations = iterations;
+	priv->samples = samples;
+	priv->installed_fraction = CLAMP (installed, 0.0f, 1.0f);
+	priv->directory = directory;
+
+	/* hide all debugging */
+	if (!verbose) {
+		g_log_set_handler ("Zif", G_LOG_LEVEL_DEBUG,
+				   zif_benchmark_ignore_cb, NULL);
+	}
+
+	/* fallback */
+	if (config_file == NULL)
+		config_file = g_build_filename (SYSCONFDIR, "zif", "zif.conf", NULL);
+	if (priv->directory == NULL) {
+		priv->directory = g_dir_make_tmp ("zif-benchmark-XXXXXX", &error);
+		if (priv->directory == NULL) {
+			g_printerr ("Failed to create directory: %s\n", error->message);
+			g_error_free (error);
+			goto out;
+		}
+	}
+
+	/* generate the repository */
+	timer = g_timer_new ();
+	zif_benchmark_generate (priv);
+	ret = zif_benchmark_write_repo (priv, &error);
+	if (!ret) {
+		g_printerr ("Failed to write repository: %s\n", error->message);
+		g_error_free (error);
+		g_timer_destroy (timer);
+		goto out;
+	}
+
+	/* header, which is ignored by most tools */
+	g_print ("# zif-benchmark %s\n", PACKAGE_VERSION);
+	g_print ("# directory=%s\n", priv->directory);
+	g_print ("# packages=%u\tfanout=%u\tfiles=%u\tinstalled=%.2f\tsamples=%u\n",
+		 priv->packages, priv->fanout, priv->files,
+		 priv->installed_fraction, priv->samples);
+	g_print ("# generate_ms=%.3f\n", g_timer_elapsed (timer, NULL) * 1000.0f);
+	g_print ("name\titerations\tmin_ms\tmean_ms\tmax_ms\n");
+	g_timer_destroy (timer);
+
+	/* set up the stores */
+	ret = zif_benchmark_setup_config (priv, config_file, &error);
+	if (!ret) {
+		g_printerr ("Failed to set config: %s\n", error->message);
+		g_error_free (error);
+		goto out;
+	}
+	priv->state = zif_state_new ();
+	ret = zif_benchmark_setup_local (priv, &error);
+	if (!ret) {
+		g_printerr ("Failed to set up local store: %s\n", error->message);
+		g_error_free (error);
+		goto out;
+	}
+	ret = zif_benchmark_setup_remote (priv, &error);
+	if (!ret) {
+		g_printerr ("Failed to set up remote store: %s\n", error->message);
+		g_error_free (error);
+		goto out;
+	}
+
+	/* run each test */
+	{
+		const struct {
+			const gchar		*name;
+			ZifBenchmarkFunc	 func;
+		} tests[] = {
+			{ "load-primary-sql",	zif_benchmark_load_primary_sql },
+			{ "load-primary-xml",	zif_benchmark_load_primary_xml },
+			{ "resolve",		zif_benchmark_resolve },
+			{ "what-provides",	zif_benchmark_what_provides },
+			{ "search-file",	zif_benchmark_search_file },
+			{ "get-updates",	zif_benchmark_get_updates },
+			{ "transaction-resolve", zif_benchmark_transaction_resolve },
+			{ NULL,			NULL }
+		};
+		for (i = 0; tests[i].name != NULL; i++) {
+			ret = zif_benchmark_run (priv, tests[i].name, tests[i].func, &error);
+			if (!ret) {
+				g_printerr ("Failed to run benchmark: %s\n", error->message);
+				g_error_free (error);
+				goto out;
+			}
+		}
+	}
+
+	/* success */
+	retval = EXIT_SUCCESS;
+out:
+	if (priv->store_array != NULL)
+		g_ptr_array_unref (priv->store_array);
+	if (priv->store_remote != NULL)
+		g_object_unref (priv->store_remote);
+	if (priv->store_local != NULL)
+		g_object_unref (priv->store_local);
+	if (priv->packages_installed != NULL)
+		g_ptr_array_unref (priv->packages_installed);
+	if (priv->search_provides != NULL)
+		g_ptr_array_unref (priv->search_provides);
+	if (priv->requires != NULL)
+		g_ptr_array_unref (priv->requires);
+	if (priv->state != NULL)
+		g_object_unref (priv->state);
+	if (priv->config != NULL)
+		g_object_unref (priv->config);
+	g_strfreev (priv->search_names);
+	g_strfreev (priv->search_files);
+	g_free (priv->installed);
+	g_free (priv->checksum_primary_sql);
+	g_free (priv->checksum_primary_xml);
+	g_free (priv->repo_dir);
+	g_free (priv->directory);
+	g_free (priv);
+	g_free (config_file);
+	return retval;
+}
@@ -30,6 +30,8 @@
 #include <errno.h>
 #include <locale.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <termios.h>
@@ -419,6 +421,7 @@ zif_log_handler_cb (const gchar *log_domain, GLogLevelFlags log_level,
 
 typedef struct {
 	gboolean		 assume_no;
+	gboolean		 batch;
 	GOptionContext		*context;
 	GPtrArray		*cmd_array;
 	ZifConfig		*config;
@@ -2593,8 +2596,17 @@ zif_transaction_run (ZifCmdPrivate *priv, ZifTransaction *transaction, ZifState
 		g_free (size_str);
 	}
 
-	/* ask the question */
+	/* the commands are read from stdin in batch mode, so there is
+	 * nobody to answer the question */
 	assume_yes = zif_config_get_boolean (priv->config, "assumeyes", NULL);
+	if (!assume_yes && priv->batch) {
+		ret = FALSE;
+		/* TRANSLATORS: error message */
+		g_set_error_literal (error, 1, 0, _("Cannot ask for confirmation in batch mode, use --assume-yes or --assume-no"));
+		goto out;
+	}
+
+	/* ask the question */
 	if (!assume_yes) {
 		if (!zif_cmd_prompt (_("Run transaction?"))) {
 			ret = FALSE;
@@ -3669,6 +3681,87 @@ out:
 	return ret;
 }
 
+/**
+ * zif_cmd_memory_usage:
+ **/
+static gboolean
+zif_cmd_memory_usage (ZifCmdPrivate *priv, gchar **values, GError **error)
+{
+	gboolean ret = FALSE;
+	gchar *report = NULL;
+	GPtrArray *array = NULL;
+	GPtrArray *store_array = NULL;
+	guint i;
+	ZifMemory *memory = NULL;
+	ZifState *state_local;
+
+	/* TRANSLATORS: measuring how much memory the loaded packages use */
+	zif_progress_bar_start (priv->progressbar, _("Getting memory usage"));
+
+	/* setup state with the correct number of steps */
+	ret = zif_state_set_steps (priv->state,
+				   error,
+				   10, /* add local */
+				   10, /* add remote */
+				   80, /* load packages */
+				   -1);
+	if (!ret)
+		goto out;
+
+	/* add both local and remote packages */
+	store_array = zif_store_array_new ();
+	state_local = zif_state_get_child (priv->state);
+	ret = zif_store_array_add_local (store_array, state_local, error);
+	if (!ret)
+		goto out;
+
+	/* this section done */
+	ret = zif_state_done (priv->state, error);
+	if (!ret)
+		goto out;
+
+	state_local = zif_state_get_child (priv->state);
+	ret = zif_store_array_add_remote_enabled (store_array, state_local, error);
+	if (!ret)
+		goto out;
+
+	/* this section done */
+	ret = zif_state_done (priv->state, error);
+	if (!ret)
+		goto out;
+
+	/* ensure the packages and metadata are loaded */
+	state_local = zif_state_get_child (priv->state);
+	array = zif_store_array_get_packages (store_array, state_local, error);
+	if (array == NULL) {
+		ret = FALSE;
+		goto out;
+	}
+
+	/* this section done */
+	ret = zif_state_done (priv->state, error);
+	if (!ret)
+		goto out;
+
+	zif_progress_bar_end (priv->progressbar);
+
+	/* only count what the stores hold, not the results array */
+	memory = zif_memory_new ();
+	for (i = 0; i < store_array->len; i++)
+		zif_store_get_memory_usage (g_ptr_array_index (store_array, i), memory);
+	report = zif_memory_to_string (memory);
+	g_print ("%s", report);
+out:
+	g_free (report);
+	if (memory != NULL)
+		g_object_unref (memory);
+	if (store_array != NULL)
+		g_ptr_array_unref (store_array);
+	if (array != NULL)
+		g_ptr_array_unref (array);
+	return ret;
+}
+
 /**
  * zif_cmd_refresh_cache:
  **/
@@ -5599,21 +5692,305 @@ out:
 }
 
 /**
- * zif_cmd_shell:
+ * zif_cmd_server_cancelled_cb:
+ **/
+static void
+zif_cmd_server_cancelled_cb (GCancellable *cancellable, GMainLoop *loop)
+{
+	g_main_loop_quit (loop);
+}
+
+/**
+ * zif_cmd_server:
  **/
 static gboolean
-zif_cmd_shell (ZifCmdPrivate *priv, gchar **values, GError **error)
+zif_cmd_server (ZifCmdPrivate *priv, gchar **values, GError **error)
+{
+	gboolean ret;
+	GCancellable *cancellable;
+	GMainLoop *loop = NULL;
+	GPtrArray *store_array = NULL;
+	gulong cancelled_id = 0;
+	ZifServer *server = NULL;
+	ZifState *state_local;
+
+	/* TRANSLATORS: loading the stores before sharing them */
+	zif_progress_bar_start (priv->progressbar, _("Loading stores"));
+
+	/* setup state */
+	ret = zif_state_set_steps (priv->state,
+				   error,
+				   90, /* load local */
+				   10, /* add remote */
+				   -1);
+	if (!ret)
+		goto out;
+
+	/* load the local store once */
+	state_local = zif_state_get_child (priv->state);
+	ret = zif_store_load (priv->store_local, state_local, error);
+	if (!ret)
+		goto out;
+
+	/* this section done */
+	ret = zif_state_done (priv->state, error);
+	if (!ret)
+		goto out;
+
+	/* add remote stores */
+	store_array = zif_store_array_new ();
+	state_local = zif_state_get_child (priv->state);
+	ret = zif_store_array_add_remote_enabled (store_array, state_local, error);
+	if (!ret)
+		goto out;
+
+	/* this section done */
+	ret = zif_state_done (priv->state, error);
+	if (!ret)
+		goto out;
+
+	zif_progress_bar_end (priv->progressbar);
+
+	/* share them */
+	server = zif_server_new ();
+	if (values != NULL && values[0] != NULL)
+		zif_server_set_socket_path (server, values[0]);
+	zif_server_set_stores (server, priv->store_local, store_array);
+	ret = zif_server_start (server, error);
+	if (!ret)
+		goto out;
+
+	/* run until ctrl-c */
+	loop = g_main_loop_new (NULL, FALSE);
+	cancellable = zif_state_get_cancellable (priv->state);
+	cancelled_id = g_cancellable_connect (cancellable,
+					      G_CALLBACK (zif_cmd_server_cancelled_cb),
+					      loop, NULL);
+	g_main_loop_run (loop);
+	g_cancellable_disconnect (cancellable, cancelled_id);
+
+	/* TRANSLATORS: the number of queries that were answered */
+	g_print ("%s: %i\n", _("Requests answered"),
+		 zif_server_get_requests (server));
+	zif_server_stop (server);
+out:
+	if (loop != NULL)
+		g_main_loop_unref (loop);
+	if (server != NULL)
+		g_object_unref (server);
+	if (store_array != NULL)
+		g_ptr_array_unref (store_array);
+	return ret;
+}
+
+/**
+ * zif_cmd_shell_add_resolved:
+ *
+ * Failures for individual packages do not stop the others being added,
+ * but the command fails if any package could not be added.
+ **/
+static gboolean
+zif_cmd_shell_add_resolved (ZifTransaction *transaction,
+			    GPtrArray *array,
+			    gboolean (*add_func) (ZifTransaction *, ZifPackage *, GError **),
+			    GError **error)
+{
+	gboolean ret;
+	GError *error_local = NULL;
+	GError *error_first = NULL;
+	guint failed = 0;
+	guint i;
+	ZifPackage *package;
+
+	/* nothing to add */
+	if (array->len == 0) {
+		g_set_error_literal (error, 1, 0, "no packages found");
+		return FALSE;
+	}
+
+	for (i = 0; i < array->len; i++) {
+		package = g_ptr_array_index (array, i);
+		ret = add_func (transaction, package, &error_local);
+		if (!ret) {
+			if (error_first == NULL)
+				error_first = error_local;
+			else
+				g_error_free (error_local);
+			error_local = NULL;
+			failed++;
+		}
+	}
+	if (failed == 0)
+		return TRUE;
+	g_set_error (error, 1, 0,
+		     "failed to add %i of %i packages: %s",
+		     failed, array->len, error_first->message);
+	g_error_free (error_first);
+	return FALSE;
+}
+
+/**
+ * zif_cmd_shell_run:
+ **/
+static gboolean
+zif_cmd_shell_run (ZifCmdPrivate *priv,
+		   ZifTransaction *transaction,
+		   GPtrArray *stores_remote,
+		   gchar **split,
+		   gboolean batch,
+		   GError **error)
+{
+	gboolean ret = TRUE;
+	gboolean (*add_func) (ZifTransaction *, ZifPackage *, GError **);
+	GPtrArray *array;
+	ZifPackage *package;
+
+	/* reset the transaction */
+	if (g_strcmp0 (split[0], "reset") == 0) {
+		zif_transaction_reset (transaction);
+		goto out;
+	}
+
+	/* show the transaction */
+	if (g_strcmp0 (split[0], "show") == 0) {
+		zif_main_show_transaction (transaction);
+		goto out;
+	}
+
+	/* resolve the transaction */
+	if (g_strcmp0 (split[0], "resolve") == 0 &&
+	    split[1] == NULL) {
+		zif_state_reset (priv->state);
+		ret = zif_transaction_resolve (transaction, priv->state, error);
+		goto out;
+	}
+
+	/* prepare the transaction */
+	if (g_strcmp0 (split[0], "prepare") == 0) {
+		zif_state_reset (priv->state);
+		ret = zif_transaction_prepare (transaction, priv->state, error);
+		goto out;
+	}
+
+	/* commit the transaction */
+	if (g_strcmp0 (split[0], "commit") == 0) {
+		zif_state_reset (priv->state);
+		ret = zif_transaction_commit_full (transaction,
+						   0,
+						   priv->state,
+						   error);
+		zif_transaction_reset (transaction);
+		goto out;
+	}
+
+	/* install a package */
+	if (g_strcmp0 (split[0], "install") == 0) {
+		zif_state_reset (priv->state);
+		if (zif_package_id_check (split[1])) {
+			package = zif_store_array_find_package (stores_remote, split[1], priv->state, error);
+			if (package == NULL) {
+				ret = FALSE;
+				goto out;
+			}
+			ret = zif_transaction_add_install (transaction, package, error);
+			g_object_unref (package);
+			goto out;
+		}
+		array = zif_store_array_resolve_full (stores_remote,
+						      &split[1],
+						      ZIF_STORE_RESOLVE_FLAG_USE_ALL |
+						      ZIF_STORE_RESOLVE_FLAG_USE_GLOB,
+						      priv->state,
+						      error);
+		if (array == NULL) {
+			ret = FALSE;
+			goto out;
+		}
+		ret = zif_cmd_shell_add_resolved (transaction, array,
+						  zif_transaction_add_install,
+						  error);
+		g_ptr_array_unref (array);
+		goto out;
+	}
+
+	/* remove a package or install an update */
+	if (g_strcmp0 (split[0], "remove") == 0 ||
+	    g_strcmp0 (split[0], "update") == 0) {
+		if (g_strcmp0 (split[0], "remove") == 0)
+			add_func = zif_transaction_add_remove;
+		else
+			add_func = zif_transaction_add_update;
+		zif_state_reset (priv->state);
+		if (zif_package_id_check (split[1])) {
+			package = zif_store_find_package (priv->store_local, split[1], priv->state, error);
+			if (package == NULL) {
+				ret = FALSE;
+				goto out;
+			}
+			ret = add_func (transaction, package, error);
+			g_object_unref (package);
+			goto out;
+		}
+		array = zif_store_resolve (priv->store_local, &split[1], priv->state, error);
+		if (array == NULL) {
+			ret = FALSE;
+			goto out;
+		}
+		ret = zif_cmd_shell_add_resolved (transaction, array,
+						  add_func, error);
+		g_ptr_array_unref (array);
+		goto out;
+	}
+
+	/* try to run normal commands */
+	zif_state_reset (priv->state);
+	if (!batch)
+		g_print ("Warning: running non-native command, do not use for profiling...\n");
+	ret = zif_cmd_run (priv, split[0], &split[1], error);
+out:
+	return ret;
+}
+
+/**
+ * zif_cmd_shell_print_result:
+ *
+ * Prints a single line for each command in batch mode, which is easy to
+ * find in the output of the command, e.g.
+ * "@zif	3	error	12.4	no packages found"
+ **/
+static void
+zif_cmd_shell_print_result (guint count,
+			    const gchar *command,
+			    gdouble elapsed,
+			    const GError *error)
+{
+	gchar *tmp;
+
+	tmp = g_strdup (error != NULL ? error->message : command);
+	g_strdelimit (tmp, "\t\n", ' ');
+	g_print ("@zif\t%i\t%s\t%.1f\t%s\n",
+		 count,
+		 error != NULL ? "error" : "ok",
+		 elapsed * 1000,
+		 tmp);
+	g_free (tmp);
+}
+
+/**
+ * zif_cmd_shell_loop:
+ **/
+static gboolean
+zif_cmd_shell_loop (ZifCmdPrivate *priv, gboolean batch, GError **error)
 {
 	gboolean ret;
-	gchar buffer[1024];
+	gchar *buffer = NULL;
 	gchar *old_buffer = NULL;
 	gchar **split;
 	GError *error_local = NULL;
-	GPtrArray *array;
 	GPtrArray *stores_remote = NULL;
 	GTimer *timer;
-	guint i;
-	ZifPackage *package;
+	guint count = 0;
+	size_t buffer_size = 0;
 	ZifState *state_local;
 	ZifTransaction *transaction = NULL;
 
@@ -5648,11 +6025,20 @@ zif_cmd_shell (ZifCmdPrivate *priv, gchar **values, GError **error)
 	zif_transaction_set_verbose (transaction,
 				     g_getenv ("ZIF_DEPSOLVE_DEBUG") != NULL);
 
-	g_print ("\n");
-	g_print (_("Welcome to the shell. Type '%s' to finish."), "exit");
+	if (batch) {
+		zif_cmd_shell_print_result (count++, "ready",
+					    g_timer_elapsed (timer, NULL),
+					    NULL);
+		fflush (stdout);
+	} else {
+		g_print ("\n");
+		g_print (_("Welcome to the shell. Type '%s' to finish."), "exit");
+	}
 	do {
-		g_print ("\n(took %.1fms) Zif> ", g_timer_elapsed (timer, NULL) * 1000);
-		fgets (buffer, 1024, stdin);
+		if (!batch)
+			g_print ("\n(took %.1fms) Zif> ", g_timer_elapsed (timer, NULL) * 1000);
+		if (getline (&buffer, &buffer_size, stdin) < 0)
+			break;
 		g_strdelimit (buffer, "\n", '\0');
 
 		/* reset timer */
@@ -5664,7 +6050,11 @@ zif_cmd_shell (ZifCmdPrivate *priv, gchar **values, GError **error)
 
 		/* save this so "." works */
 		if (g_strcmp0 (buffer, ".") == 0) {
-			g_strlcpy (buffer, old_buffer, 1024);
+			if (old_buffer == NULL)
+				continue;
+			free (buffer);
+			buffer = strdup (old_buffer);
+			buffer_size = strlen (buffer) + 1;
 		} else {
 			g_free (old_buffer);
 			old_buffer = g_strdup (buffer);
@@ -5673,191 +6063,63 @@ zif_cmd_shell (ZifCmdPrivate *priv, gchar **values, GError **error)
 		/* parse commands */
 		split = g_strsplit (buffer, " ", -1);
 		if (g_strcmp0 (split[0], "exit") == 0) {
+			g_strfreev (split);
 			break;
 		}
-
-		/* reset the transaction */
-		if (g_strcmp0 (split[0], "reset") == 0) {
-			zif_transaction_reset (transaction);
-			continue;
-		}
-
-		/* show the transaction */
-		if (g_strcmp0 (split[0], "show") == 0) {
-			zif_main_show_transaction (transaction);
-			continue;
-		}
-
-		/* resolve the transaction */
-		if (g_strcmp0 (split[0], "resolve") == 0 &&
-		    split[1] == NULL) {
-			zif_state_reset (priv->state);
-			ret = zif_transaction_resolve (transaction, priv->state, &error_local);
-			if (!ret) {
-				g_print ("%s\n", error_local->message);
-				g_clear_error (&error_local);
-			}
-			continue;
-		}
-
-		/* prepare the transaction */
-		if (g_strcmp0 (split[0], "prepare") == 0) {
-			zif_state_reset (priv->state);
-			ret = zif_transaction_prepare (transaction, priv->state, &error_local);
-			if (!ret) {
-				g_print ("%s\n", error_local->message);
-				g_clear_error (&error_local);
-			}
-			continue;
-		}
-
-		/* commit the transaction */
-		if (g_strcmp0 (split[0], "commit") == 0) {
-			zif_state_reset (priv->state);
-			ret = zif_transaction_commit_full (transaction,
-							   0,
-							   priv->state,
-							   &error_local);
-			if (!ret) {
-				g_print ("%s\n", error_local->message);
-				g_clear_error (&error_local);
-			}
-			zif_transaction_reset (transaction);
-			continue;
-		}
-
-		/* install a package */
-		if (g_strcmp0 (split[0], "install") == 0) {
-			zif_state_reset (priv->state);
-			if (zif_package_id_check (split[1])) {
-				package = zif_store_array_find_package (stores_remote, split[1], priv->state, &error_local);
-				if (package == NULL) {
-					g_print ("%s\n", error_local->message);
-					g_clear_error (&error_local);
-				} else {
-					ret = zif_transaction_add_install (transaction, package, &error_local);
-					if (!ret) {
-						g_print ("%s\n", error_local->message);
-						g_clear_error (&error_local);
-					}
-					g_object_unref (package);
-				}
-			} else {
-				array = zif_store_array_resolve_full (stores_remote,
-								      &split[1],
-								      ZIF_STORE_RESOLVE_FLAG_USE_ALL |
-								      ZIF_STORE_RESOLVE_FLAG_USE_GLOB,
-								      priv->state,
-								      &error_local);
-				if (array == NULL) {
-					g_print ("%s\n", error_local->message);
-					g_clear_error (&error_local);
-					continue;
-				}
-				for (i = 0; i < array->len; i++) {
-					package = g_ptr_array_index (array, i);
-					ret = zif_transaction_add_install (transaction, package, &error_local);
-					if (!ret) {
-						g_print ("%s\n", error_local->message);
-						g_clear_error (&error_local);
-					}
-				}
-				g_ptr_array_unref (array);
-			}
-			continue;
-		}
-
-		/* remove a package */
-		if (g_strcmp0 (split[0], "remove") == 0) {
-			zif_state_reset (priv->state);
-			if (zif_package_id_check (split[1])) {
-				package = zif_store_find_package (priv->store_local, split[1], priv->state, &error_local);
-				if (package == NULL) {
-					g_print ("%s\n", error_local->message);
-					g_clear_error (&error_local);
-				} else {
-					ret = zif_transaction_add_remove (transaction, package, &error_local);
-					if (!ret) {
-						g_print ("%s\n", error_local->message);
-						g_clear_error (&error_local);
-					}
-					g_object_unref (package);
-				}
-			} else {
-				array = zif_store_resolve (priv->store_local, &split[1], priv->state, &error_local);
-				if (array == NULL) {
-					g_print ("%s\n", error_local->message);
-					g_clear_error (&error_local);
-					continue;
-				}
-				for (i = 0; i < array->len; i++) {
-					package = g_ptr_array_index (array, i);
-					ret = zif_transaction_add_remove (transaction, package, &error_local);
-					if (!ret) {
-						g_print ("%s\n", error_local->message);
-						g_clear_error (&error_local);
-					}
-				}
-				g_ptr_array_unref (array);
-			}
-			continue;
-		}
-
-		/* install an update */
-		if (g_strcmp0 (split[0], "update") == 0) {
-			zif_state_reset (priv->state);
-			if (zif_package_id_check (split[1])) {
-				package = zif_store_find_package (priv->store_local, split[1], priv->state, &error_local);
-				if (package == NULL) {
-					g_print ("%s\n", error_local->message);
-					g_clear_error (&error_local);
-				} else {
-					ret = zif_transaction_add_update (transaction, package, &error_local);
-					if (!ret) {
-						g_print ("%s\n", error_local->message);
-						g_clear_error (&error_local);
-					}
-					g_object_unref (package);
-				}
-			} else {
-				array = zif_store_resolve (priv->store_local, &split[1], priv->state, &error_local);
-				if (array == NULL) {
-					g_print ("%s\n", error_local->message);
-					g_clear_error (&error_local);
-					continue;
-				}
-				for (i = 0; i < array->len; i++) {
-					package = g_ptr_array_index (array, i);
-					ret = zif_transaction_add_update (transaction, package, &error_local);
-					if (!ret) {
-						g_print ("%s\n", error_local->message);
-						g_clear_error (&error_local);
-					}
-				}
-				g_ptr_array_unref (array);
-			}
-			continue;
-		}
-
-		/* try to run normal commands */
-		zif_state_reset (priv->state);
-		g_print ("Warning: running non-native command, do not use for profiling...\n");
-		ret = zif_cmd_run (priv, split[0], &split[1], &error_local);
-		if (!ret) {
+		ret = zif_cmd_shell_run (priv,
+					 transaction,
+					 stores_remote,
+					 split,
+					 batch,
+					 &error_local);
+		g_strfreev (split);
+
+		/* the stores are kept loaded between commands */
+		if (batch) {
+			zif_cmd_shell_print_result (count++, buffer,
+						    g_timer_elapsed (timer, NULL),
+						    error_local);
+			fflush (stdout);
+		} else if (!ret) {
 			g_print ("%s\n", error_local->message);
-			g_clear_error (&error_local);
 		}
+		g_clear_error (&error_local);
 	} while (TRUE);
+
+	/* success */
+	ret = TRUE;
 out:
 	if (transaction != NULL)
 		g_object_unref (transaction);
 	if (stores_remote != NULL)
 		g_ptr_array_unref (stores_remote);
 	g_timer_destroy (timer);
+	free (buffer);
 	g_free (old_buffer);
 	return ret;
 }
 
+/**
+ * zif_cmd_shell:
+ **/
+static gboolean
+zif_cmd_shell (ZifCmdPrivate *priv, gchar **values, GError **error)
+{
+	return zif_cmd_shell_loop (priv, FALSE, error);
+}
+
+/**
+ * zif_cmd_batch:
+ **/
+static gboolean
+zif_cmd_batch (ZifCmdPrivate *priv, gchar **values, GError **error)
+{
+	/* only the result records are printed to stdout */
+	priv->batch = TRUE;
+	zif_progress_bar_set_silent (priv->progressbar, TRUE);
+	return zif_cmd_shell_loop (priv, TRUE, error);
+}
+
 /**
  * zif_cmd_check:
  **/
@@ -6903,6 +7165,7 @@ main (int argc, char *argv[])
 	gboolean profile = FALSE;
 	gboolean ret;
 	gboolean skip_broken = FALSE;
+	gboolean sql_stats = FALSE;
 	gboolean verbose = FALSE;
 	gboolean version = FALSE;
 	gchar *cmd_descriptions = NULL;
@@ -6914,7 +7177,11 @@ main (int argc, char *argv[])
 	gchar *enablerepo = NULL;
 	gchar *disablerepo = NULL;
 	gchar *package_dump = NULL;
+	gchar *sql_report = NULL;
+	gchar *trace = NULL;
+	gchar *trace_filename = NULL;
 	GError *error = NULL;
+	GError *error_trace = NULL;
 	gint retval = 0;
 	gint terminal_cols = 0;
 	guint age = 0;
@@ -6925,6 +7192,10 @@ main (int argc, char *argv[])
 			_("Show extra debugging information"), NULL },
 		{ "profile", '\0', 0, G_OPTION_ARG_NONE, &profile,
 			_("Enable low level profiling of Zif"), NULL },
+		{ "trace", '\0', 0, G_OPTION_ARG_FILENAME, &trace_filename,
+			_("Save a timing trace in Chrome trace-event format"), NULL },
+		{ "sql-stats", '\0', 0, G_OPTION_ARG_NONE, &sql_stats,
+			_("Show statistics about the SQL statements that were run"), NULL },
 		{ "background", 'b', 0, G_OPTION_ARG_NONE, &background,
 			_("Enable background mode to run using less CPU"), NULL },
 		{ "offline", 'o', 0, G_OPTION_ARG_NONE, &offline,
@@ -7149,6 +7420,8 @@ main (int argc, char *argv[])
 	/* ZifState */
 	priv->state = zif_state_new ();
 	zif_state_set_enable_profile (priv->state, profile);
+	zif_state_set_enable_trace (priv->state, trace_filename != NULL);
+	zif_sql_stats_set_enabled (sql_stats);
 	zif_state_set_process_event_sources (priv->state, TRUE);
 	g_signal_connect (priv->state, "percentage-changed",
 			  G_CALLBACK (zif_state_percentage_changed_cb),
@@ -7301,6 +7574,11 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: command description */
 		     _("Dump a transaction manifest to a file"),
 		     zif_cmd_manifest_dump);
+	zif_cmd_add (priv->cmd_array,
+		     "memory-usage",
+		     /* TRANSLATORS: command description */
+		     _("Show the memory used by the loaded packages and metadata"),
+		     zif_cmd_memory_usage);
 	zif_cmd_add (priv->cmd_array,
 		     "refresh-cache,makecache",
 		     /* TRANSLATORS: command description */
@@ -7361,6 +7639,11 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: command description */
 		     _("Search package name for the given string"),
 		     zif_cmd_search_name);
+	zif_cmd_add (priv->cmd_array,
+		     "server",
+		     /* TRANSLATORS: command description */
+		     _("Share the loaded stores with other processes"),
+		     zif_cmd_server);
 	zif_cmd_add (priv->cmd_array,
 		     "shell",
 		     /* TRANSLATORS: command description */
@@ -7411,6 +7694,11 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: command description */
 		     _("Find what package requires the given value"),
 		     zif_cmd_what_requires);
+	zif_cmd_add (priv->cmd_array,
+		     "batch",
+		     /* TRANSLATORS: command description */
+		     _("Run shell commands from standard input"),
+		     zif_cmd_batch);
 	zif_cmd_add (priv->cmd_array,
 		     "check",
 		     /* TRANSLATORS: command description */
@@ -7686,6 +7974,19 @@ error:
 		goto out;
 	}
 out:
+	/* save the timing trace even if the command failed */
+	if (trace_filename != NULL) {
+		trace = zif_state_get_trace ();
+		ret = g_file_set_contents (trace_filename, trace, -1, &error_trace);
+		if (!ret) {
+			g_warning ("failed to save trace: %s", error_trace->message);
+			g_error_free (error_trace);
+		}
+	}
+	if (sql_stats) {
+		sql_report = zif_sql_stats_to_string ();
+		g_print ("%s", sql_report);
+	}
 	if (priv != NULL) {
 		g_object_unref (priv->progressbar);
 		if (priv->history != NULL)
@@ -7709,6 +8010,9 @@ out:
 
 	/* free state */
 	g_free (package_dump);
+	g_free (sql_report);
+	g_free (trace);
+	g_free (trace_filename);
 	g_free (enablerepo);
 	g_free (disablerepo);
 	g_free (root);
@@ -30,6 +30,7 @@ struct ZifProgressBarPrivate
 {
 	gboolean		 allow_cancel;
 	gboolean		 on_console;
+	gboolean		 silent;
 	gboolean		 started;
 	gchar			*action;
 	gchar			*detail;
@@ -126,6 +127,19 @@ zif_progress_bar_set_on_console (ZifProgressBar *progress_bar, gboolean on_conso
 	progress_bar->priv->on_console = on_console;
 }
 
+/**
+ * zif_progress_bar_set_silent:
+ *
+ * Stops the progress bar printing anything, for instance when stdout
+ * is being parsed by another program.
+ **/
+void
+zif_progress_bar_set_silent (ZifProgressBar *progress_bar, gboolean silent)
+{
+	g_return_if_fail (ZIF_IS_PROGRESS_BAR (progress_bar));
+	progress_bar->priv->silent = silent;
+}
+
 /**
  * zif_progress_bar_set_padding:
  *
@@ -163,6 +177,10 @@ zif_progress_bar_set_detail (ZifProgressBar *progress_bar, const gchar *detail)
 	g_free (progress_bar->priv->detail);
 	progress_bar->priv->detail = g_strdup (detail);
 
+	/* nothing to print */
+	if (progress_bar->priv->silent)
+		return;
+
 	/* no console */
 	if (!progress_bar->priv->on_console) {
 		if (detail != NULL)
@@ -186,6 +204,10 @@ zif_progress_bar_set_action (ZifProgressBar *progress_bar, const gchar *action)
 	g_free (progress_bar->priv->action);
 	progress_bar->priv->action = g_strdup (action);
 
+	/* nothing to print */
+	if (progress_bar->priv->silent)
+		return;
+
 	/* no console */
 	if (!progress_bar->priv->on_console) {
 		if (action != NULL)
@@ -211,6 +233,10 @@ zif_progress_bar_set_percentage (ZifProgressBar *progress_bar, guint percentage)
 		return;
 	progress_bar->priv->percentage = percentage;
 
+	/* nothing to print */
+	if (progress_bar->priv->silent)
+		return;
+
 	/* no console */
 	if (!progress_bar->priv->on_console) {
 		g_print ("Percentage: %i\n", percentage);
@@ -234,6 +260,10 @@ zif_progress_bar_set_allow_cancel (ZifProgressBar *progress_bar, gboolean allow_
 		return;
 	progress_bar->priv->allow_cancel = allow_cancel;
 
+	/* nothing to print */
+	if (progress_bar->priv->silent)
+		return;
+
 	/* no console */
 	if (!progress_bar->priv->on_console) {
 		g_print ("Allow cancel: %s\n", allow_cancel ? "TRUE" : "FALSE");
@@ -257,6 +287,10 @@ zif_progress_bar_set_speed (ZifProgressBar *progress_bar, guint64 speed)
 		return;
 	progress_bar->priv->speed = speed;
 
+	/* nothing to print */
+	if (progress_bar->priv->silent)
+		return;
+
 	/* no console */
 	if (!progress_bar->priv->on_console) {
 		g_print ("Speed: %" G_GUINT64_FORMAT " bytes/sec\n", speed);
@@ -281,7 +315,8 @@ zif_progress_bar_start (ZifProgressBar *progress_bar, const gchar *text)
 	zif_progress_bar_set_action (progress_bar, text);
 
 	/* no console */
-	if (!progress_bar->priv->on_console)
+	if (progress_bar->priv->silent ||
+	    !progress_bar->priv->on_console)
 		return;
 
 	zif_progress_bar_redraw (progress_bar);
@@ -64,6 +64,8 @@ void		 zif_progress_bar_set_speed		(ZifProgressBar	*progress_bar,
 							 guint64	 speed);
 void		 zif_progress_bar_set_on_console	(ZifProgressBar	*progress_bar,
 							 gboolean	 on_console);
+void		 zif_progress_bar_set_silent		(ZifProgressBar	*progress_bar,
+							 gboolean	 silent);
 
 void		 zif_progress_bar_start			(ZifProgressBar	*progress_bar,
 							 const gchar	*action);